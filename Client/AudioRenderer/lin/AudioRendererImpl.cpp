@@ -23,12 +23,13 @@ namespace AudioRenderer
 AudioRendererImpl::AudioRendererImpl(std::function<void(Transport::OwnedRTPPacket&)> pcmSource_)
 	: runned(false),
 	deviceName("default"),
-	sampleFreq(48000),
+	sampleFreq(48000), deviceFreq(48000),
 	volume(wui::config::get_int("AudioRenderer", "Volume", 100)),
     mute(wui::config::get_int("AudioRenderer", "Enabled", 1) == 0),
 	s(nullptr),
 	subFrame(0),
 	packet(480 * 2 * 4),
+	resampler(),
 	aecReceiver(nullptr),
 	pcmSource(pcmSource_),
 	thread(),
@@ -58,9 +59,13 @@ void AudioRendererImpl::Start(int32_t sampleFreq_)
 
 	sampleFreq = sampleFreq_;
 
-	static const pa_sample_spec ss = {
+	/// Play in the device's native rate and resample by ourselves instead of the PulseAudio
+	deviceFreq = wui::config::get_int("AudioRenderer", "DeviceSampleFreq", sampleFreq);
+	resampler.SetSampleFreq(sampleFreq, deviceFreq);
+
+	const pa_sample_spec ss = {
 			.format = PA_SAMPLE_S16LE,
-			.rate = static_cast<uint32_t>(sampleFreq),
+			.rate = static_cast<uint32_t>(deviceFreq),
 			.channels = 1
 	};
 
@@ -78,7 +83,7 @@ void AudioRendererImpl::Start(int32_t sampleFreq_)
 	runned = true;
 	thread = std::thread(std::bind(&AudioRendererImpl::Play, this));
 
-	sysLog->info("AudioRenderer {0} was started", deviceName);
+	sysLog->info("AudioRenderer {0} was started (freq: {1}, device freq: {2})", deviceName, sampleFreq, deviceFreq);
 }
 
 void AudioRendererImpl::Stop()
@@ -158,9 +163,12 @@ void AudioRendererImpl::Play()
 	using namespace std::chrono;
 	int64_t packetDuration = 40000;
 
-	const uint32_t writeCount = (sampleFreq / 100) * 2; // 10 ms frame
+	const uint32_t frameSize = (sampleFreq / 100) * 2 * 4; // 40 ms frame
+	const uint32_t writeCount = (deviceFreq / 100) * 2; // 10 ms frame of the device
 	
-	Transport::OwnedRTPPacket packet(writeCount * 4);	
+	Transport::OwnedRTPPacket packet(frameSize);
+	std::vector<int16_t> resampled(std::max(resampler.GetOutputCount(frameSize / 2), writeCount * 2));
+	const uint8_t *output = packet.data;
 	while (runned)
 	{
 		auto start = high_resolution_clock::now();		
@@ -177,12 +185,19 @@ void AudioRendererImpl::Play()
 				rtp.payloadSize = packet.size;
 				aecReceiver->Send(rtp);
 			}
+
+			if (deviceFreq != sampleFreq)
+			{
+				resampler.Resample(reinterpret_cast<const int16_t*>(packet.data), frameSize / 2,
+					resampled.data(), static_cast<uint32_t>(resampled.size()));
+				output = reinterpret_cast<const uint8_t*>(resampled.data());
+			}
 		}
 
 		if (!mute) /// We have to keep picking up packets from the jitter buffers
 		{
 			int error = 0;
-			if (pa_simple_write(s, packet.data + (subFrame * writeCount), writeCount, &error) < 0)
+			if (pa_simple_write(s, output + (subFrame * writeCount), writeCount, &error) < 0)
 			{
 				return errLog->critical("AudioRendererImpl :: pa_simple_write() failed: {0}", pa_strerror(error));
 			}
@@ -9,6 +9,7 @@
 
 #include <AudioRenderer/AudioRenderer.h>
 #include <Transport/ISocket.h>
+#include <Audio/Resampler.h>
 
 #include <pulse/simple.h>
 #include <pulse/error.h>
@@ -47,7 +48,7 @@ private:
     std::atomic_bool runned;
 
     std::string deviceName;
-    int32_t sampleFreq;
+    int32_t sampleFreq, deviceFreq;
 
     uint16_t volume;
 
@@ -58,6 +59,8 @@ private:
     size_t subFrame;
     Transport::OwnedRTPPacket packet;
 
+    Audio::Resampler resampler;
+
     Transport::ISocket* aecReceiver;
     std::function<void(Transport::OwnedRTPPacket&)> pcmSource;
 
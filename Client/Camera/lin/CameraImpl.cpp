@@ -13,6 +13,7 @@
 #include <wui/config/config.hpp>
 
 #include <Common/ShortSleep.h>
+#include <Common/Trace.h>
 
 #include <stdlib.h>
 #include <fcntl.h>
@@ -40,7 +41,7 @@ CameraImpl::CameraImpl(Common::TimeMeter &timeMeter_, Transport::ISocket &receiv
     buffer(), tmpBuffer(),
 	frameDuration(40000),
 	deviceNotifyCallback(),
-	statMeter(30),
+	processTimes(),
 	name(),
 	deviceId(0),
 	resolution(Video::rVGA),
@@ -197,12 +198,24 @@ void CameraImpl::run()
 			continue;
 		}
 
+		const auto captureBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
+
 		int idx = read_frame();
 		if (idx != -1)
 		{
-			Postprocess((uint8_t*)buffers[idx].data, rv.width * rv.height * 2);
+			const auto ts = static_cast<uint32_t>(timeMeter.Measure() / 1000);
+			if (captureBegin != 0)
+			{
+				Common::Trace::Record(Common::Trace::Stage::Capture, Common::Trace::Kind::Video, ssrc, ts, captureBegin, Common::Trace::Now());
+			}
+
+			{
+				Common::Trace::Span span(Common::Trace::Stage::Convert, Common::Trace::Kind::Video, ssrc, ts);
+				Postprocess((uint8_t*)buffers[idx].data, rv.width * rv.height * 2);
+			}
+
 			Transport::RTPPacket packet;
-			packet.rtpHeader.ts = timeMeter.Measure() / 1000;
+			packet.rtpHeader.ts = ts;
 			packet.rtpHeader.ssrc = ssrc;
 			packet.rtpHeader.seq = ++seq;
             packet.payload = buffer.get();
@@ -214,20 +227,24 @@ void CameraImpl::run()
 
         if (processTime != 0)
 		{
-			statMeter.PushVal(processTime);
+			processTimes.Record(processTime);
 		}
 
 		static bool prevOvertime = false;
 
-		if (statMeter.GetFill() == 25)
+		if (processTimes.GetCount() == 25)
 		{
-			uint64_t avg = statMeter.GetAvg();
-			if (avg > frameDuration * 0.75)
+			auto snapshot = processTimes.GetSnapshot();
+			processTimes.Clear();
+
+			/// The tail frames above the frame duration are the visible stalls even if the average is fine
+			uint64_t avg = snapshot.GetAvg(), tail = snapshot.GetPercentile(95);
+			if (avg > frameDuration * 0.75 || tail > frameDuration)
 			{
 				prevOvertime = true;
 				if (deviceNotifyCallback && runned)
 				{
-					sysLog->warn("Camera {0} :: Too slow encoding {1} ms", name, avg);
+					sysLog->warn("Camera {0} :: Too slow encoding (avg: {1} us, p95: {2} us, max: {3} us)", name, avg, tail, snapshot.max);
 
 					deviceNotifyCallback(name, Client::DeviceNotifyType::OvertimeCoding, Proto::DeviceType::Camera, deviceId, 0);
 				}
@@ -237,13 +254,12 @@ void CameraImpl::run()
 				if (prevOvertime && deviceNotifyCallback && runned)
 				{
 					prevOvertime = false;
-					sysLog->info("Camera {0} :: Too normalize encoding {1} ms", name, avg);
+					sysLog->info("Camera {0} :: Too normalize encoding (avg: {1} us, p95: {2} us)", name, avg, tail);
 
 					deviceNotifyCallback(name, Client::DeviceNotifyType::NormalizeCoding, Proto::DeviceType::Camera, deviceId, 0);
 				}
-				sysLog->trace("Camera {0} :: AVG encoding time: {1}", name, avg);
+				sysLog->trace("Camera {0} :: Encoding time (avg: {1} us, p95: {2} us, max: {3} us)", name, avg, tail, snapshot.max);
 			}
-			statMeter.Clear();
 		}
 
 		if (frameDuration > processTime) Common::ShortSleep(frameDuration - processTime);
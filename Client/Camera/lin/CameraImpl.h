@@ -10,7 +10,7 @@
 #include <Camera/ICamera.h>
 #include <Transport/ISocket.h>
 #include <Common/TimeMeter.h>
-#include <Common/StatMeter.h>
+#include <Common/Histogram.h>
 
 #include <thread>
 #include <atomic>
@@ -48,7 +48,7 @@ private:
 	
     Client::DeviceNotifyCallback deviceNotifyCallback;
 
-	Common::StatMeter statMeter;
+	Common::Histogram processTimes; /// Microseconds of capturing and encoding the frame
 
 	std::string name;
 	uint32_t deviceId;
@@ -11,6 +11,7 @@
 
 #include <Common/Common.h>
 #include <Common/ShortSleep.h>
+#include <Common/Trace.h>
 
 #include <Ks.h>
 #include <Ksmedia.h>
@@ -32,11 +33,12 @@ CameraImpl::CameraImpl(Common::TimeMeter &timeMeter_, Transport::ISocket &receiv
 	captureBuffer(), outputBuffer(), tmpBuffer(),
 	frameDuration(40000),
 	dataLength(0),
+	convertBegin(0), convertEnd(0),
 	streamConfig(),
 	ksPropertySet(),
 	cameraControl(),
 	mediaControl(),
-	statMeter(30),
+	processTimes(),
 	name(),
 	deviceId(0),
 	resolution(Video::rVGA),
@@ -477,6 +479,9 @@ void CALLBACK CameraImpl::OutputCallback(uint8_t* data, int len, void *instance_
     CameraImpl &instance = *static_cast<CameraImpl*>(instance_);
 
 	std::lock_guard<std::mutex> lock(instance.bufferMutex);
+
+	/// The frame's timestamp is given by the sending thread, so the conversion is recorded there
+	const auto convertBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
 	
 	switch (instance.colorSpace)
 	{
@@ -498,6 +503,9 @@ void CALLBACK CameraImpl::OutputCallback(uint8_t* data, int len, void *instance_
 	}
 
 	instance.dataLength = len;
+
+	instance.convertBegin = convertBegin;
+	instance.convertEnd = convertBegin != 0 ? Common::Trace::Now() : 0;
 }
 
 void CameraImpl::send()
@@ -509,6 +517,7 @@ void CameraImpl::send()
 		auto start = timeMeter.Measure();
 
 		uint32_t length = 0;
+		uint64_t converted[2] = { 0 };
 		{
 			std::lock_guard<std::mutex> lock(bufferMutex);
 
@@ -519,6 +528,10 @@ void CameraImpl::send()
 
 			length = dataLength;
 			memcpy(outputBuffer.get(), captureBuffer.get(), length);
+
+			converted[0] = convertBegin;
+			converted[1] = convertEnd;
+			convertBegin = convertEnd = 0;
 		}
 
 		Transport::RTPPacket packet;
@@ -529,26 +542,37 @@ void CameraImpl::send()
 		packet.payload = outputBuffer.get();
 		packet.payloadSize = length;
 
+		if (converted[0] != 0)
+		{
+			/// The capture is the waiting of the converted frame for the sending thread
+			Common::Trace::Record(Common::Trace::Stage::Convert, Common::Trace::Kind::Video, ssrc, packet.rtpHeader.ts, converted[0], converted[1]);
+			Common::Trace::Record(Common::Trace::Stage::Capture, Common::Trace::Kind::Video, ssrc, packet.rtpHeader.ts, converted[1], Common::Trace::Now());
+		}
+
 		receiver.Send(packet);
 
 		auto processTime = timeMeter.Measure() - start;
 
 		if (processTime != 0)
 		{
-			statMeter.PushVal(processTime);
+			processTimes.Record(processTime);
 		}
 
 		static bool prevOvertime = false;
 
-		if (statMeter.GetFill() == 25)
+		if (processTimes.GetCount() == 25)
 		{
-			uint64_t avg = statMeter.GetAvg();
-			if (avg > frameDuration * 0.85)
+			auto snapshot = processTimes.GetSnapshot();
+			processTimes.Clear();
+
+			/// The tail frames above the frame duration are the visible stalls even if the average is fine
+			uint64_t avg = snapshot.GetAvg(), tail = snapshot.GetPercentile(95);
+			if (avg > frameDuration * 0.85 || tail > frameDuration)
 			{
 				prevOvertime = true;
 				if (deviceNotifyCallback && runned)
 				{
-					sysLog->warn("Camera {0} :: Too slow encoding {1} ms", name, avg);
+					sysLog->warn("Camera {0} :: Too slow encoding (avg: {1} us, p95: {2} us, max: {3} us)", name, avg, tail, snapshot.max);
 					
 					deviceNotifyCallback(name, Client::DeviceNotifyType::OvertimeCoding, Proto::DeviceType::Camera, deviceId, 0);
 				}
@@ -558,13 +582,12 @@ void CameraImpl::send()
 				if (prevOvertime && deviceNotifyCallback && runned)
 				{
 					prevOvertime = false;
-					sysLog->info("Camera {0} :: Too normalize encoding {1} ms", name, avg);
+					sysLog->info("Camera {0} :: Too normalize encoding (avg: {1} us, p95: {2} us)", name, avg, tail);
 					
 					deviceNotifyCallback(name, Client::DeviceNotifyType::NormalizeCoding, Proto::DeviceType::Camera, deviceId, 0);
 				}
-				sysLog->trace("Camera {0} :: AVG encoding time: {1}", name, avg);
+				sysLog->trace("Camera {0} :: Encoding time (avg: {1} us, p95: {2} us, max: {3} us)", name, avg, tail, snapshot.max);
 			}
-			statMeter.Clear();
 		}
 
 		if (frameDuration > processTime) Common::ShortSleep(frameDuration - processTime);
@@ -10,7 +10,7 @@
 #include <Camera/ICamera.h>
 #include <Transport/ISocket.h>
 #include <Common/TimeMeter.h>
-#include <Common/StatMeter.h>
+#include <Common/Histogram.h>
 
 #include <Camera/win/CameraDSG.h>
 
@@ -57,13 +57,15 @@ private:
 
 	uint32_t dataLength;
 
+	uint64_t convertBegin, convertEnd; /// Trace times of the last frame's conversion, 0 if it's already sent or not traced
+
 	StreamConfigPtr streamConfig;
 	KsPropertySetPtr ksPropertySet;
 	AMCameraControlPtr cameraControl;
 
 	CComQIPtr<IMediaControl, &IID_IMediaControl> mediaControl;
 
-	Common::StatMeter statMeter;
+	Common::Histogram processTimes; /// Microseconds of capturing and encoding the frame
 
 	std::string name;
 	uint32_t deviceId;
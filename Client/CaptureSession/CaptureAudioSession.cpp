@@ -34,7 +34,7 @@ CaptureAudioSession::CaptureAudioSession(Common::TimeMeter &timeMeter_)
 	silentSplitter(),
 	aec(),
 	microphone(timeMeter_, *aec.GetMicrophoneReceiver()),
-	runned(false),
+	runned(false), dtx(wui::config::get_int("CaptureDevices", "MicrophoneDTX", 1) != 0),
 	ssrc(0), deviceId(0),
 	name(),
 	encoderType(Audio::CodecType::Opus),
@@ -49,6 +49,8 @@ CaptureAudioSession::CaptureAudioSession(Common::TimeMeter &timeMeter_)
 	encryptor.SetReceiver(&rtpSocket);
 	rtpSocket.SetReceiver(nullptr, this);
 	wsmSocket.SetReceiver(nullptr, this);
+
+	encoder.SetDTX(dtx); /// Opus decides per frame which ones are silent
 }
 
 CaptureAudioSession::~CaptureAudioSession()
@@ -87,7 +87,7 @@ namespace CaptureSession
 		AEC::AEC aec;
 		MicrophoneNS::Microphone microphone;
 
-		bool runned;
+		bool runned, dtx;
 
 		uint32_t ssrc, deviceId;
 
@@ -39,6 +39,8 @@
 #include <Transport/NetworkInit.h>
 #include <Common/Logger.h>
 #include <Common/FSHelpers.h>
+#include <Common/MetricsServer.h>
+#include <Common/Trace.h>
 
 #include <iostream>
 
@@ -316,6 +318,18 @@ int main(int argc, char *argv[])
 #endif
     );
 
+    /// Off by default, Endpoint is the loopback port or the unix socket path
+    Common::MetricsServer metricsServer;
+    metricsServer.Start(wui::config::get_string("Metrics", "Endpoint", ""));
+    metricsServer.StartDump(wui::config::get_string("Metrics", "DumpFile", ""), std::chrono::milliseconds(wui::config::get_int("Metrics", "DumpInterval", 10000)));
+
+    /// Off by default, the pipeline's spans of the last seconds are written at exit for chrome://tracing or ui.perfetto.dev
+    const auto traceFile = wui::config::get_string("Trace", "File", "");
+    if (!traceFile.empty())
+    {
+        Common::Trace::Start(static_cast<uint32_t>(wui::config::get_int("Trace", "EventsPerThread", 1 << 16)));
+    }
+
     wui::error err;
 
     wui::set_app_locales({
@@ -398,5 +412,11 @@ int main(int argc, char *argv[])
     boost::interprocess::shared_memory_object::remove(SYSTEM_NAME "ClientRunned");
 #endif
 
+    if (!traceFile.empty())
+    {
+        Common::Trace::Stop();
+        Common::Trace::Export(traceFile);
+    }
+
     return 0;
 }
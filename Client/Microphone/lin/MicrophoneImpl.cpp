@@ -11,10 +11,12 @@
 #include <Transport/RTP/RTPPayloadType.h>
 
 #include <Common/ShortSleep.h>
+#include <Common/Trace.h>
 
 #include <Version.h>
 
 #include <assert.h>
+#include <vector>
 
 #include <wui/config/config.hpp>
 
@@ -29,8 +31,10 @@ MicrophoneImpl::MicrophoneImpl(Common::TimeMeter &timeMeter_, Transport::ISocket
 	ssrc(0),
 	seq(0),
 	sampleFreq(wui::config::get_int("SoundSystem", "SampleFreq", 48000)),
+	deviceFreq(sampleFreq),
     gain(wui::config::get_int("CaptureDevices", "MicrophoneGain", 100)),
 	mute(false),
+	resampler(),
 	runned(false),
 	thread(),
 	s(nullptr),
@@ -68,9 +72,13 @@ void MicrophoneImpl::Start(ssrc_t ssrc_)
 	ssrc = ssrc_;
 	seq = 0;
 
-	static const pa_sample_spec ss = {
+	/// Capture in the device's native rate and resample by ourselves instead of the PulseAudio
+	deviceFreq = wui::config::get_int("CaptureDevices", "MicrophoneDeviceSampleFreq", sampleFreq);
+	resampler.SetSampleFreq(deviceFreq, sampleFreq);
+
+	const pa_sample_spec ss = {
 			.format = PA_SAMPLE_S16LE,
-			.rate = static_cast<uint32_t>(sampleFreq),
+			.rate = static_cast<uint32_t>(deviceFreq),
 			.channels = 1
 	};
 
@@ -81,7 +89,7 @@ void MicrophoneImpl::Start(ssrc_t ssrc_)
     	.tlength = (uint32_t) -1,
     	.prebuf = (uint32_t) -1,
     	.minreq = (uint32_t) -1,
-    	.fragsize = static_cast<uint32_t>((sampleFreq / 100) * 2)
+    	.fragsize = static_cast<uint32_t>((deviceFreq / 100) * 2)
 	};
 	// Create a new record stream
 	if (!(s = pa_simple_new(NULL, SYSTEM_NAME "Client", PA_STREAM_RECORD, NULL, "record", &ss, NULL, &ba, &error)))
@@ -92,7 +100,7 @@ void MicrophoneImpl::Start(ssrc_t ssrc_)
 	runned = true;
 	thread = std::thread(&MicrophoneImpl::run, this);
 
-	sysLog->info("Microphone {0} was started", deviceName);
+	sysLog->info("Microphone {0} was started (device freq: {1}, freq: {2})", deviceName, deviceFreq, sampleFreq);
 }
 
 void MicrophoneImpl::Stop()
@@ -157,17 +165,24 @@ void MicrophoneImpl::run()
 	using namespace std::chrono;
 	int64_t packetDuration = 40000;
 	
-	const uint32_t readCount = (sampleFreq / 100) * 2; // 10 ms frame
+	const uint32_t readCount = (deviceFreq / 100) * 2; // 10 ms frame
 
 	int error = 0;
 
-	uint8_t buf[readCount * 4] = { 0 };
+	std::vector<uint8_t> buf(readCount * 4);
+	std::vector<int16_t> resampled(resampler.GetOutputCount(readCount * 2));
 	int32_t subFrame = 0;
+	uint64_t captureBegin = 0; /// The frame is captured by the 4 reads
 	while (runned)
 	{
 		auto start = high_resolution_clock::now();
 
-		if (pa_simple_read(s, buf + (subFrame * readCount), readCount, &error) < 0)
+		if (subFrame == 0)
+		{
+			captureBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
+		}
+
+		if (pa_simple_read(s, buf.data() + (subFrame * readCount), readCount, &error) < 0)
 		{
         	return errLog->critical("MicrophoneImpl :: pa_simple_read() failed: {0}", pa_strerror(error));
 		}
@@ -182,12 +197,27 @@ void MicrophoneImpl::run()
 				packet.rtpHeader.ssrc = ssrc;
 				packet.rtpHeader.seq = ++seq;
 				packet.rtpHeader.pt = static_cast<uint32_t>(Transport::RTPPayloadType::ptPCM);
-				packet.payload = buf;
+				packet.payload = buf.data();
 				packet.payloadSize = readCount * 4;
+
+				if (captureBegin != 0)
+				{
+					Common::Trace::Record(Common::Trace::Stage::Capture, Common::Trace::Kind::Audio, ssrc, packet.rtpHeader.ts, captureBegin, Common::Trace::Now());
+				}
+
+				if (deviceFreq != sampleFreq)
+				{
+					Common::Trace::Span span(Common::Trace::Stage::Convert, Common::Trace::Kind::Audio, ssrc, packet.rtpHeader.ts);
+					auto count = resampler.Resample(reinterpret_cast<const int16_t*>(buf.data()), readCount * 2,
+						resampled.data(), static_cast<uint32_t>(resampled.size()));
+					packet.payload = reinterpret_cast<const uint8_t*>(resampled.data());
+					packet.payloadSize = count * sizeof(int16_t);
+				}
+
 				receiver.Send(packet);
 			}
 			subFrame = 0;
-			memset(buf, 0, readCount);
+			memset(buf.data(), 0, readCount);
 		}
 	}
 }
@@ -10,6 +10,7 @@
 #include <Microphone/IMicrophone.h>
 #include <Transport/ISocket.h>
 #include <Common/TimeMeter.h>
+#include <Audio/Resampler.h>
 
 #include <UI/DeviceNotifies.h>
 
@@ -58,9 +59,11 @@ private:
     ssrc_t ssrc;
     uint32_t seq;
 
-    int32_t sampleFreq, gain;
+    int32_t sampleFreq, deviceFreq, gain;
     bool mute;
 
+    Audio::Resampler resampler;
+
     std::atomic_bool runned;
     std::thread thread;
 
@@ -42,6 +42,7 @@
 #include <Device/DS/DSCommon.h>
 
 #include <Common/ShortSleep.h>
+#include <Common/Trace.h>
 
 #define SAFE_ARRAYDELETE(p) {if (p) delete[] (p); (p) = NULL;}
 #define SAFE_RELEASE(p) {if (NULL != p) {(p)->Release(); (p) = NULL;}}
@@ -316,6 +317,8 @@ HRESULT MicrophoneDMO::Run()
 
         do
         {
+            const auto captureBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0; /// Includes the echo cancellation of the DMO
+
             outputBuffer.Init((byte*)pbOutputBuffer, cOutputBufLen, 0);
             OutputBufferStruct.dwStatus = 0;
             hr = pDMO->ProcessOutput(0, 1, &OutputBufferStruct, &dwStatus);
@@ -345,6 +348,11 @@ HRESULT MicrophoneDMO::Run()
                 packet.payload = pbOutputBuffer;
                 packet.payloadSize = cbProduced;
 
+                if (captureBegin != 0)
+                {
+                    Common::Trace::Record(Common::Trace::Stage::Capture, Common::Trace::Kind::Audio, ssrc, packet.rtpHeader.ts, captureBegin, Common::Trace::Now());
+                }
+
                 receiver.Send(packet);
             }
         }
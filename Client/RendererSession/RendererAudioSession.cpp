@@ -4,10 +4,10 @@
  * Author: Anton (ud) Golovkov, udattsk@gmail.com
  * Copyright (C), Infinity Video Soft LLC, 2014 - 2024
  *
- *                                                               ,-> [JitterBuffer] <-> [AudioMixer] <- [AudioRenderer]
- * [NetSocket] -> [Decryptor] -> [Decoder] -> [RecordSplitter] -<
- *                                                  ^            `-> [Recorder]
- *                                                  '- <- [Local Capturer]
+ *                                                                                 ,-> [JitterBuffer] <-> [AudioMixer] <- [AudioRenderer]
+ * [NetSocket] -> [Decryptor] -> [WireSplitter] -> [Decoder] -> [RecordSplitter] -<
+ *                                     `-> [Recorder] (Opus)          ^            `-> [Recorder] (PCM)
+ *                                                                    '- <- [Local Capturer]
  */
 
 #include "RendererAudioSession.h"
@@ -28,6 +28,7 @@ RendererAudioSession::RendererAudioSession(Common::TimeMeter &timeMeter_, Audio:
 	jitterBuffer(timeMeter_),
 	recordSplitter(),
 	decoder(),
+	wireSplitter(),
 	decryptor(),
 	rtpSocket(),
 	wsmSocket(),
@@ -46,7 +47,8 @@ RendererAudioSession::RendererAudioSession(Common::TimeMeter &timeMeter_, Audio:
 {
     rtpSocket.SetReceiver(&decryptor, nullptr);
 	wsmSocket.SetReceiver(&decryptor, nullptr);
-	decryptor.SetReceiver(&decoder);
+	decryptor.SetReceiver(&wireSplitter);
+	wireSplitter.SetReceiver1(&decoder);
 	decoder.SetReceiver(&recordSplitter);
 	recordSplitter.SetReceiver0(&jitterBuffer);
 }
@@ -139,6 +141,7 @@ void RendererAudioSession::SetRecorder(Recorder::Recorder* recorder_)
 {
 	recorder = recorder_;
 	recordSplitter.SetReceiver1(recorder);
+	wireSplitter.SetReceiver0(recorder); /// Before the decoder, so the recorder knows the stream is Opus before its PCM
 }
 
 void RendererAudioSession::SetClientId(int64_t clientId_)
@@ -193,7 +196,8 @@ void RendererAudioSession::Start(uint32_t receiverSSRC_, uint32_t authorSSRC_, u
 
 	if (recorder)
 	{
-		recorder->AddAudio(authorSSRC, clientId);
+		/// The own sound comes from the microphone at the capture rate, the decoded one is always 48 kHz
+		recorder->AddAudio(authorSSRC, clientId, my ? wui::config::get_int("SoundSystem", "SampleFreq", 48000) : 48000);
 	}
 
 	jitterBuffer.Start(JB::Mode::Sound, name);
@@ -4,10 +4,10 @@
  * Author: Anton (ud) Golovkov, udattsk@gmail.com
  * Copyright (C), Infinity Video Soft LLC, 2014, 2024
  *  
- *                                                               ,-> [JitterBuffer] <-> [AudioMixer] <- [AudioRenderer]
- * [NetSocket] -> [Decryptor] -> [Decoder] -> [RecordSplitter] -<
- *                                                  ^            `-> [Recorder]
- *                                                  '- <- [Local Capturer] 
+ *                                                                                 ,-> [JitterBuffer] <-> [AudioMixer] <- [AudioRenderer]
+ * [NetSocket] -> [Decryptor] -> [WireSplitter] -> [Decoder] -> [RecordSplitter] -<
+ *                                     `-> [Recorder] (Opus)          ^            `-> [Recorder] (PCM)
+ *                                                                    '- <- [Local Capturer] 
  */
 
 #pragma once
@@ -83,6 +83,7 @@ namespace RendererSession
 		JB::JB jitterBuffer;
 		Transport::SocketSplitter recordSplitter;
 		Audio::Decoder decoder;
+		Transport::SocketSplitter wireSplitter;
 		Crypto::Decryptor decryptor;      
 
 		Transport::RTPSocket rtpSocket;
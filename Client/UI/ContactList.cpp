@@ -54,10 +54,11 @@ ContactList::ContactList(Storage::Storage &storage_, Controller::IController &co
     contactDialog(storage, controller, std::bind(&ContactList::ContactDialogCallback, this, std::placeholders::_1, std::placeholders::_2)),
     itemsMutex(),
     items(),
+    contactsSnapshot(),
     sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
 {
     storage.SubscribeMessagesReceiver([this](Storage::MessageAction, const Storage::Messages&) { UpdateItems(); });
-    storage.SubscribeContactsReceiver([this](const Storage::Contacts&) { UpdateItems(); });
+    storage.SubscribeContactsChanges(std::bind(&ContactList::ContactsChanged, this, std::placeholders::_1));
     storage.SubscribeGroupsReceiver([this](const Storage::Groups&) { UpdateItems(); });
     storage.SubscribeConferencesReceiver([this](const Storage::Conferences&) { UpdateItems(); });
 
@@ -237,6 +238,8 @@ void ContactList::UpdateItems()
 
     items.clear();
 
+    contactsSnapshot = storage.GetContactsSnapshot();
+
     MakeGroups();
     MakeConferences();
 
@@ -341,6 +344,61 @@ void ContactList::UpdateItems()
     }
 }
 
+void ContactList::ContactsChanged(const Storage::ContactsChanges &changes)
+{
+    {
+        std::lock_guard<std::mutex> lock(itemsMutex);
+
+        /// The presence flips only change the images of the contacts, the rest needs the rebuilding
+        bool onlyStates = !changes.reset && changes.inserted.empty() && changes.removed.empty() && contactsSnapshot.items;
+        for (size_t i = 0; onlyStates && i != changes.items.size(); ++i)
+        {
+            const auto &contact = changes.items[i];
+            auto prev = std::find_if(contactsSnapshot.items->begin(), contactsSnapshot.items->end(), [&contact](const Proto::Member &m) { return m.id == contact.id; });
+            onlyStates = prev != contactsSnapshot.items->end() &&
+                prev->name == contact.name &&
+                prev->number == contact.number &&
+                prev->unreaded_count == contact.unreaded_count &&
+                std::equal(prev->groups.begin(), prev->groups.end(), contact.groups.begin(), contact.groups.end(),
+                    [](const Proto::Group &a, const Proto::Group &b) { return a.id == b.id; });
+        }
+
+        if (onlyStates)
+        {
+            for (const auto &contact : changes.items)
+            {
+                for (auto &item : items)
+                {
+                    if ((item.type == ItemType::Contact || item.type == ItemType::GroupUser) && item.id == contact.id)
+                    {
+                        item.image = GetStateImage(contact.state);
+                    }
+                }
+            }
+
+            contactsSnapshot = storage.GetContactsSnapshot();
+            list->set_item_count(static_cast<int32_t>(items.size())); /// Redraw
+
+            return;
+        }
+    }
+
+    UpdateItems();
+}
+
+std::shared_ptr<wui::image> ContactList::GetStateImage(Proto::MemberState state)
+{
+    switch (state)
+    {
+        case Proto::MemberState::Offline:
+            return accountOfflineImg;
+        case Proto::MemberState::Online: case Proto::MemberState::Conferencing:
+            return accountOnlineImg;
+        default:
+            return accountDeletedImg;
+    }
+}
+
 void ContactList::MakeGroups()
 {
     std::lock_guard<std::recursive_mutex> lock(storage.GetGroupsMutex());
@@ -367,23 +425,10 @@ void ContactList::MakeGroups()
 
         if (!rolled)
         {
-            std::lock_guard<std::recursive_mutex> lock(storage.GetContactsMutex());
-
-            for (const auto &contact : storage.GetContacts())
+            for (const auto &contact : *contactsSnapshot.items)
             {
                 if (std::find(contact.groups.begin(), contact.groups.end(), group.id) != contact.groups.end())
                 {
-                    std::shared_ptr<wui::image> img = accountDeletedImg;
-                    switch (contact.state)
-                    {
-                        case Proto::MemberState::Offline:
-                            img = accountOfflineImg;
-                        break;
-                        case Proto::MemberState::Online: case Proto::MemberState::Conferencing:
-                            img = accountOnlineImg;
-                        break;
-                    }
-
                     items.emplace_back(Item(contact.id,
                         group.id,
                         my_group ? ItemType::Contact : ItemType::GroupUser,
@@ -391,7 +436,7 @@ void ContactList::MakeGroups()
                         contact.number,
                         "",
                         group.level,
-                        img,
+                        GetStateImage(contact.state),
                         contact.unreaded_count,
                         my_group,
                         false));
@@ -131,10 +131,13 @@ private:
 
     std::mutex itemsMutex;
     std::vector<Item> items;
+    Storage::Snapshot<Proto::Member> contactsSnapshot; /// The contacts the items were made of
 
     std::shared_ptr<spdlog::logger> sysLog, errLog;
 
     void UpdateItems();
+    void ContactsChanged(const Storage::ContactsChanges &changes);
+    std::shared_ptr<wui::image> GetStateImage(Proto::MemberState state);
     void MakeGroups();
     void MakeConferences();
 
@@ -154,6 +154,15 @@ std::string GetRecordName()
     return out;
 }
 
+Recorder::Mode GetRecordMode()
+{
+    if (wui::config::get_int("Record", "MP3Mode", 0) != 0)
+    {
+        return Recorder::Mode::MP3;
+    }
+    return wui::config::get_int("Record", "MultiTrack", 0) != 0 ? Recorder::Mode::MultiTrack : Recorder::Mode::Mixed;
+}
+
 MainFrame::MainFrame()
     : window(std::make_shared<wui::window>()),
     messageBox(std::make_shared<wui::message>(window)),
@@ -282,6 +291,9 @@ MainFrame::MainFrame()
 
     storage.SubscribeMessagesReceiver(std::bind(&MainFrame::MessagesUpdatedCallback, this, std::placeholders::_1, std::placeholders::_2));
 
+    /// The bursts of the lists changes (presence, sync) come to the views once per the interval
+    storage.SetNotifyInterval(std::chrono::milliseconds(wui::config::get_int("Storage", "NotifyInterval", 40)));
+
     if (!wui::config::get_string("Connection", "Address", "").empty() && !wui::config::get_string("Credentials", "Login", "").empty())
     {
         storage.Connect(GetAppDataPath() + "local.db");
@@ -833,7 +845,7 @@ void MainFrame::ActionTurnRecord()
         {
             if (IsRecordAllowed())
             {
-                recorder.Start(GetRecordName(), wui::config::get_int("Record", "MP3Mode", 0) != 0);
+                recorder.Start(GetRecordName(), GetRecordMode());
             }
         }
         else
@@ -1726,7 +1738,7 @@ void MainFrame::ProcessControllerEvent()
 
                 if (wui::config::get_int("Record", "Enabled", 0) != 0 && IsRecordAllowed())
                 {
-                    recorder.Start(GetRecordName(), wui::config::get_int("Record", "MP3Mode", 0) != 0);
+                    recorder.Start(GetRecordName(), GetRecordMode());
                 }
 
                 timeMeter.Reset();
@@ -2527,6 +2539,7 @@ void MainFrame::InitAudio()
     audioRenderer.Stop();
     audioRenderer.Start(wui::config::get_int("SoundSystem", "SampleFreq", 48000));
     audioRenderer.SetMute(wui::config::get_int("AudioRenderer", "Enabled", 1) == 0);
+    audioMixer.SetMaxActiveInputs(wui::config::get_int("AudioRenderer", "MaxSpeakers", 3));
     audioMixer.Start();
 }
 
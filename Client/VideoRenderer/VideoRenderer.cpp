@@ -13,6 +13,7 @@
 
 #include <Transport/RTP/RTPPacket.h>
 #include <Common/WindowsVersion.h>
+#include <Common/Trace.h>
 
 #include <wui/window/window.hpp>
 #include <wui/system/tools.hpp>
@@ -80,6 +81,8 @@ void VideoRenderer::draw(wui::graphic &gr, const wui::rect &)
 		Transport::OwnedRTPPacket packet;
 		rgbSource(packet);
 
+        const auto drawBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
+
         int32_t size = pos.width() * pos.height() * 4;
         if (packet.size == size)
         {
@@ -89,6 +92,11 @@ void VideoRenderer::draw(wui::graphic &gr, const wui::rect &)
         gr.draw_buffer(pos,
             flickerBuffer.get(),
             0, 0);
+
+        if (drawBegin != 0 && packet.size == size) /// The new frame is drawn, not the previous one again
+        {
+            Common::Trace::Record(Common::Trace::Stage::Draw, Common::Trace::Kind::Video, packet.header.ssrc, packet.header.ts, drawBegin, Common::Trace::Now());
+        }
     }
     else
     {
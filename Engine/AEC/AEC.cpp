@@ -2,7 +2,7 @@
  * AEC.cpp - Contains acoustic echo canceller impl
  *
  * Author: Anton (ud) Golovkov, udattsk@gmail.com
- * Copyright (C), Infinity Video Soft LLC, 2016 - 2018
+ * Copyright (C), Infinity Video Soft LLC, 2016 - 2018, 2024
  */
 
 #include <AEC/AEC.h>
@@ -21,6 +21,9 @@ extern "C" {
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 #include "webrtc/modules/audio_processing/agc/legacy/gain_control.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace AEC
 {
 
@@ -30,9 +33,20 @@ enum
 
 	FRAMES_COUNT = 4, /// Two 10 ms frames in one input / output packet
 	BANDS_COUNT = 3,  /// Three bands of 16 kHz (16 + 16 + 16 = 48)
-	BAND_SIZE = 160   /// One 16KHz band has 160 samples (duration 10 ms)
+	BAND_SIZE = 160,  /// One 16KHz band has 160 samples (duration 10 ms)
+
+	FRAME_SIZE = FRAMES_COUNT * BANDS_COUNT * BAND_SIZE, /// Samples in one packet
+	SAMPLES_IN_MS = SAMPLING_FREQ / 1000,
+
+	WARM_UP_FRAMES = 50,      /// 2 s to settle the far-end level before fixing the target
+	MAX_FAR_BACKLOG = 12000,  /// 250 ms, more means the render thread was stalled, so realign
+	MAX_DELAY = 500           /// Upper limit of the WebRtcAec_Process's msInSndCardBuf
 };
 
+static const double LEVEL_SMOOTHING = 1.0 / 64; /// ~2.5 s of the level averaging
+static const double SKEW_GAIN = 0.001 / 960; /// 0.1 % of the skew per 20 ms of the level error
+static const double MAX_SKEW = 0.005; /// Real clocks differ much less, it's the limit for the control loop
+
 /// Wrappers
 
 AEC::MicrophoneReceiver::MicrophoneReceiver(AEC &aec_)
@@ -53,6 +67,8 @@ void AEC::MicrophoneReceiver::Send(const Transport::IPacket &packet_, const Tran
 		return;
 	}
 
+	const auto delay = aec.aecEnabled ? aec.speakerSource.BufferFarend() : aec.renderLatency.load();
+
 	if (!aec.nsEnabled && !aec.aecEnabled && !aec.agcEnabled)
 	{
 		return aec.resultReceiver->Send(packet_);
@@ -100,7 +116,7 @@ void AEC::MicrophoneReceiver::Send(const Transport::IPacket &packet_, const Tran
 				aecIn[j] = bufOut->fbuf_const()->bands(0)[j] + (BAND_SIZE * i);
 				aecOut[j] = _aecOut[j] + (BAND_SIZE * i);
 			}
-			webrtc::WebRtcAec_Process(aec.aecInst, aecIn, BANDS_COUNT, aecOut, BAND_SIZE, aec.renderLatency, 0);
+			webrtc::WebRtcAec_Process(aec.aecInst, aecIn, BANDS_COUNT, aecOut, BAND_SIZE, delay, 0);
 		}
 				
 		memcpy(bufOut->fbuf()->bands(0)[0], _aecOut[0], BAND_SIZE * FRAMES_COUNT * sizeof(float));
@@ -169,50 +185,131 @@ void AEC::MicrophoneReceiver::Stop()
 AEC::SpeakerReceiver::SpeakerReceiver(AEC &aec_)
 	: aec(aec_),
 	runned(false),
-	mutex(),
+	ring(),
+	frame(),
+	received(),
 	splittingFilter(),
 	splittingFilterIn(),
-	splittingFilterOut()
+	splittingFilterOut(),
+	fifo(),
+	position(0),
+	level(0), targetLevel(0),
+	warmUpFrames(0),
+	lastTime(),
+	delay(0)
 {}
 
 void AEC::SpeakerReceiver::Send(const Transport::IPacket &packet_, const Transport::Address *)
 {
-	std::lock_guard<std::mutex> lock(mutex);
-
 	if (runned && aec.aecEnabled)
 	{
 		const auto &packet = *static_cast<const Transport::RTPPacket*>(&packet_);
 
-		memcpy(splittingFilterIn->ibuf()->bands(0)[0], packet.payload, packet.payloadSize);
-		splittingFilter->Analysis(splittingFilterIn.get(), splittingFilterOut.get());
+		const auto size = std::min<uint32_t>(packet.payloadSize, sizeof(frame.samples));
+		memcpy(frame.samples, packet.payload, size);
+		memset(reinterpret_cast<uint8_t*>(frame.samples) + size, 0, sizeof(frame.samples) - size);
+		frame.time = std::chrono::steady_clock::now();
 
-		for (int i = 0; i != FRAMES_COUNT; ++i)
-		{
-			webrtc::WebRtcAec_BufferFarend(aec.aecInst, splittingFilterOut->fbuf_const()->bands(0)[0] + (BAND_SIZE * i), BAND_SIZE);
-		}
+		ring.push(frame); /// The frame is lost if the capture thread is stalled, the AEC will realign
 	}
 }
 
-void AEC::SpeakerReceiver::Start()
+int16_t AEC::SpeakerReceiver::BufferFarend()
 {
-	std::lock_guard<std::mutex> lock(mutex);
+	while (ring.pop(received))
+	{
+		fifo.insert(fifo.end(), received.samples, received.samples + FRAME_SIZE);
+		lastTime = received.time;
+	}
+
+	if (fifo.size() > MAX_FAR_BACKLOG)
+	{
+		fifo.erase(fifo.begin(), fifo.end() - FRAME_SIZE);
+		position = 0;
+		warmUpFrames = 0;
+		aec.sysLog->trace("AEC :: far-end backlog was dropped");
+	}
+
+	/// The render and the capture clocks are drifted, so the far-end level is slowly moves,
+	/// keep it at the target by reading the far-end a bit faster or slower than the near-end
+	const auto currentLevel = static_cast<double>(fifo.size()) - position;
+	if (warmUpFrames < WARM_UP_FRAMES)
+	{
+		level = warmUpFrames == 0 ? currentLevel : level + (currentLevel - level) * LEVEL_SMOOTHING * 4;
+		targetLevel = level;
+		++warmUpFrames;
+	}
+	else
+	{
+		level += (currentLevel - level) * LEVEL_SMOOTHING;
+	}
+	const auto ratio = 1.0 + std::max(-MAX_SKEW, std::min(MAX_SKEW, (level - targetLevel) * SKEW_GAIN));
+
+	/// Not enough far-end yet, the AEC holds its own far buffer, so just skip the frame
+	const auto needed = static_cast<size_t>(position + FRAME_SIZE * ratio) + 2;
+	if (fifo.size() < needed)
+	{
+		return delay;
+	}
+
+	/// Linear interpolation is enough here, the AEC takes only the low band of the far-end
+	auto out = splittingFilterIn->ibuf()->bands(0)[0];
+	for (int i = 0; i != FRAME_SIZE; ++i)
+	{
+		const auto x = position + i * ratio;
+		const auto index = static_cast<size_t>(x);
+		const auto fraction = x - index;
+		out[i] = static_cast<int16_t>(lround(fifo[index] + (fifo[index + 1] - fifo[index]) * fraction));
+	}
+
+	position += FRAME_SIZE * ratio;
+	const auto consumed = static_cast<size_t>(position);
+	fifo.erase(fifo.begin(), fifo.begin() + consumed);
+	position -= consumed;
+
+	splittingFilter->Analysis(splittingFilterIn.get(), splittingFilterOut.get());
+
+	for (int i = 0; i != FRAMES_COUNT; ++i)
+	{
+		webrtc::WebRtcAec_BufferFarend(aec.aecInst, splittingFilterOut->fbuf_const()->bands(0)[0] + (BAND_SIZE * i), BAND_SIZE);
+	}
 
+	/// The buffered frame will be heard through the device's latency after it was handed to the renderer,
+	/// part of this time has already been spent in the ring and in the fifo
+	const auto age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastTime).count() +
+		static_cast<int64_t>(fifo.size() / SAMPLES_IN_MS);
+	delay = static_cast<int16_t>(std::max<int64_t>(0, std::min<int64_t>(MAX_DELAY, aec.renderLatency - age)));
+
+	return delay;
+}
+
+void AEC::SpeakerReceiver::Start()
+{
 	if (!runned)
 	{
-		runned = true;
+		while (ring.pop(received)); /// Drop the frames of the previous run
 
 		splittingFilter = std::unique_ptr<webrtc::SplittingFilter>(new webrtc::SplittingFilter(1, BANDS_COUNT, FRAMES_COUNT * BANDS_COUNT * BAND_SIZE));
 		splittingFilterIn = std::unique_ptr<webrtc::IFChannelBuffer>(new webrtc::IFChannelBuffer(FRAMES_COUNT * BANDS_COUNT * BAND_SIZE, 1, BANDS_COUNT));
 		splittingFilterOut = std::unique_ptr<webrtc::IFChannelBuffer>(new webrtc::IFChannelBuffer(FRAMES_COUNT * BANDS_COUNT * BAND_SIZE, 1, BANDS_COUNT));
+
+		fifo.clear();
+		fifo.reserve(MAX_FAR_BACKLOG + FRAME_SIZE * 16);
+		position = 0;
+		level = targetLevel = 0;
+		warmUpFrames = 0;
+		lastTime = std::chrono::steady_clock::now();
+		delay = aec.renderLatency;
+
+		runned = true;
 	}
 }
 
 void AEC::SpeakerReceiver::Stop()
 {
-	std::lock_guard<std::mutex> lock(mutex);
-
 	runned = false;
 
+	/// The microphone receiver is already stopped, so nobody calls BufferFarend()
 	splittingFilter.reset(nullptr);
 	splittingFilterIn.reset(nullptr);
 	splittingFilterOut.reset(nullptr);
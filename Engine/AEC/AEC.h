@@ -2,7 +2,7 @@
  * AEC.h - Contains acoustic echo canceller header
  *
  * Author: Anton (ud) Golovkov, udattsk@gmail.com
- * Copyright (C), Infinity Video Soft LLC, 2016
+ * Copyright (C), Infinity Video Soft LLC, 2016, 2024
  */
 
 #pragma once
@@ -10,11 +10,15 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <chrono>
+#include <vector>
 
 #include "IAEC.h"
 
 #include <Transport/ISocket.h>
 
+#include <mt/wf_ring_buffer.h>
+
 #include <spdlog/spdlog.h>
 
 namespace webrtc
@@ -66,21 +70,43 @@ private:
 		void Stop();
 	};
 
+	/// Far-end frame as it was handed to the renderer's device
+	struct FarFrame
+	{
+		int16_t samples[1920]; /// 40 ms of 48 k mono
+		std::chrono::steady_clock::time_point time;
+	};
+
+	/// Send() is called from the render thread and only puts the frame to the lock-free ring,
+	/// the rest is done on the capture thread by BufferFarend(), so the audio threads never wait for each other
 	class SpeakerReceiver : public Transport::ISocket
 	{
 		AEC &aec;
-		bool runned;
+		std::atomic<bool> runned;
 
-		std::mutex mutex;
+		mt::ringbuffer<FarFrame, 16> ring;
+		FarFrame frame; /// Render thread side
+		FarFrame received; /// Capture thread side
 
 		std::unique_ptr<webrtc::SplittingFilter> splittingFilter;
 		std::unique_ptr<webrtc::IFChannelBuffer> splittingFilterIn;
 		std::unique_ptr<webrtc::IFChannelBuffer> splittingFilterOut;
+
+		std::vector<int16_t> fifo; /// Received, but not buffered to the AEC samples
+		double position; /// Fractional read position in the fifo
+		double level, targetLevel; /// Smoothed fifo level and the level fixed after the warm up, in samples
+		uint32_t warmUpFrames;
+		std::chrono::steady_clock::time_point lastTime;
+		int16_t delay;
 	public:
 		SpeakerReceiver(AEC &aec_);
 		virtual void Send(const Transport::IPacket &packet_, const Transport::Address *address = nullptr) final;
 		void Start();
 		void Stop();
+
+		/// Called from the capture thread before each near-end frame,
+		/// buffers one frame of the far-end to the AEC and returns the delay for WebRtcAec_Process
+		int16_t BufferFarend();
 	};
 
 	friend MicrophoneReceiver;
@@ -92,7 +118,7 @@ private:
 	std::atomic<bool> agcEnabled;
 
 	int32_t micLevel;
-	int16_t renderLatency;
+	std::atomic<int16_t> renderLatency;
 
 	MicrophoneReceiver microphoneSource;
 	SpeakerReceiver speakerSource;
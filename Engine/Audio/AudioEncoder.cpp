@@ -18,7 +18,8 @@ Encoder::Encoder()
 	sampleFreq(48000),
 	quality(10),
 	bitrate(30),
-	packetLoss(0)
+	packetLoss(0),
+	dtx(false)
 {
 }
 
@@ -91,6 +92,7 @@ void Encoder::Start(CodecType type_)
 			impl->SetQuality(quality);
 			impl->SetBitrate(bitrate);
 			impl->SetSampleFreq(sampleFreq);
+			impl->SetDTX(dtx);
 			impl->Start(type);
 		}
 	}
@@ -119,6 +121,15 @@ void Encoder::SetPacketLoss(int32_t val)
 	}
 }
 
+void Encoder::SetDTX(bool yes)
+{
+	dtx = yes;
+	if (impl)
+	{
+		impl->SetDTX(yes);
+	}
+}
+
 void Encoder::Encode(const Transport::IPacket& in, Transport::IPacket& out)
 {
 	if (impl)
@@ -31,6 +31,7 @@ public:
 	virtual void Stop();
 	virtual bool IsStarted() const;
 	virtual void SetPacketLoss(int32_t val);
+	virtual void SetDTX(bool yes);
 	virtual void Encode(const Transport::IPacket& in, Transport::IPacket& out);
 
 	/// Derived from Transport::ISocket (input method)
@@ -44,6 +45,7 @@ private:
     int32_t sampleFreq, quality;
     int32_t bitrate;
     int32_t packetLoss;
+    bool dtx;
 };
 
 }
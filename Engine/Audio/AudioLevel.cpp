@@ -0,0 +1,60 @@
+/**
+ * AudioLevel.cpp - Contains the RFC 6464 audio level helpers impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Audio/AudioLevel.h>
+
+#include <cmath>
+
+namespace Audio
+{
+
+uint8_t CalcAudioLevel(const int16_t *samples, uint32_t count)
+{
+	if (count == 0)
+	{
+		return AUDIO_LEVEL_SILENT;
+	}
+
+	uint64_t power = 0;
+	for (uint32_t i = 0; i != count; ++i)
+	{
+		power += static_cast<int32_t>(samples[i]) * samples[i];
+	}
+
+	const double rms = sqrt(static_cast<double>(power) / count);
+	if (rms < 1.0)
+	{
+		return AUDIO_LEVEL_SILENT;
+	}
+
+	const auto dBov = -20.0 * log10(rms / 32768.0);
+	return dBov > AUDIO_LEVEL_SILENT ? AUDIO_LEVEL_SILENT : (dBov < 0 ? 0 : static_cast<uint8_t>(dBov));
+}
+
+void SetAudioLevel(Transport::RTPPacket::RTPHeader &header, uint8_t level, bool voiceActivity)
+{
+	header.x = 1;
+	header.eXLength = 2;
+	header.eX[1] = (static_cast<uint32_t>(AUDIO_LEVEL_EXT_ID) << 28) |
+		(static_cast<uint32_t>(voiceActivity ? 1 : 0) << 23) |
+		(static_cast<uint32_t>(level & 0x7F) << 16);
+}
+
+bool GetAudioLevel(const Transport::RTPPacket::RTPHeader &header, uint8_t &level, bool &voiceActivity)
+{
+	if (!header.x || header.eXLength < 2 || (header.eX[1] >> 28) != AUDIO_LEVEL_EXT_ID)
+	{
+		return false;
+	}
+
+	voiceActivity = ((header.eX[1] >> 23) & 0x1) != 0;
+	level = (header.eX[1] >> 16) & 0x7F;
+
+	return true;
+}
+
+}
@@ -0,0 +1,36 @@
+/**
+ * AudioLevel.h - Contains the RFC 6464 audio level helpers
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <Transport/RTP/RTPPacket.h>
+
+namespace Audio
+{
+
+/// The audio level is carried in the second RTP header extension word as
+/// the one-byte header element (RFC 8285): | ID | len=0 | V | level | 0 | 0 |
+static const uint8_t AUDIO_LEVEL_EXT_ID = 1;
+
+/// Level in -dBov, 0 - the loudest, 127 - the silence
+static const uint8_t AUDIO_LEVEL_SILENT = 127;
+
+/// The frames louder than -50 dBov are marked as the voice
+static const uint8_t AUDIO_LEVEL_VOICE = 50;
+
+/// Calculate the level of 16 bit PCM samples
+uint8_t CalcAudioLevel(const int16_t *samples, uint32_t count);
+
+/// Put the level to the header extension
+void SetAudioLevel(Transport::RTPPacket::RTPHeader &header, uint8_t level, bool voiceActivity);
+
+/// Return false if the header has no audio level extension
+bool GetAudioLevel(const Transport::RTPPacket::RTPHeader &header, uint8_t &level, bool &voiceActivity);
+
+}
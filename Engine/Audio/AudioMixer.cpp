@@ -15,27 +15,210 @@
 
 #include "AudioMixer.h"
 
+#include <Common/TimeMeter.h>
+#include <Common/Trace.h>
+
 #include <iostream>
 #include <algorithm>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_MIXER_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Audio
 {
 
+/// Mixing kernels, the accumulator is int32 so any reasonable count of inputs can't overflow it
+
+/// acc += in
+static void AccumulateUnity(int32_t *acc, const int16_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        auto x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi32(a, x));
+    }
+#elif defined(AUDIO_MIXER_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        auto sign = _mm_srai_epi16(x, 15);
+        auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi32(a0, _mm_unpacklo_epi16(x, sign)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i + 4), _mm_add_epi32(a1, _mm_unpackhi_epi16(x, sign)));
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        acc[i] += in[i];
+    }
+}
+
+/// acc += (in * gain) >> 15, gain is Q15 less than unity
+static void AccumulateGain(int32_t *acc, const int16_t *in, size_t count, int16_t gain)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const auto g = _mm256_set1_epi32(gain);
+    for (; i + 8 <= count; i += 8)
+    {
+        auto x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi32(a, _mm256_srai_epi32(_mm256_mullo_epi32(x, g), 15)));
+    }
+#elif defined(AUDIO_MIXER_SSE2)
+    const auto g = _mm_set1_epi32(static_cast<uint16_t>(gain)); /// [gain, 0] pairs for madd
+    const auto zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4));
+        auto p0 = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, zero), g), 15);
+        auto p1 = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, zero), g), 15);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi32(a0, p0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i + 4), _mm_add_epi32(a1, p1));
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        acc[i] += (static_cast<int32_t>(in[i]) * gain) >> 15;
+    }
+}
+
+/// acc += (in * gain) >> 15, gain is Q15 up to unity
+static void Accumulate(int32_t *acc, const int16_t *in, size_t count, int32_t gain)
+{
+    if (gain == (1 << 15))
+    {
+        AccumulateUnity(acc, in, count);
+    }
+    else if (gain != 0)
+    {
+        AccumulateGain(acc, in, count, static_cast<int16_t>(gain));
+    }
+}
+
+/// Mean square of every 4th sample, enough to rank the speakers
+static uint64_t CalcEnergy(const int16_t *in, size_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        sum += static_cast<int32_t>(in[i]) * in[i];
+    }
+    return sum / ((count + 3) / 4);
+}
+
+/// out = sat16(out + sat16(acc))
+static void MixOut(int16_t *out, const int32_t *acc, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        auto a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        auto a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 8));
+        auto p = _mm256_permute4x64_epi64(_mm256_packs_epi32(a0, a1), 0xD8); /// packs works within 128 bit lanes
+        auto o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_adds_epi16(o, p));
+    }
+#elif defined(AUDIO_MIXER_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4));
+        auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_adds_epi16(o, _mm_packs_epi32(a0, a1)));
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        auto sample = WEBRTC_SPL_SAT(static_cast<int32_t>(32767), acc[i], static_cast<int32_t>(-32768));
+        out[i] = static_cast<int16_t>(WEBRTC_SPL_SAT(static_cast<int32_t>(32767), out[i] + sample, static_cast<int32_t>(-32768)));
+    }
+}
+
 /// AudioMixer
 
 using namespace std::chrono;
 
+AudioMixer::Input::Input(uint32_t ssrc_, int64_t clientId_, std::function<void(Transport::OwnedRTPPacket&)> pcmCallback_, int32_t gain_)
+    : ssrc(ssrc_),
+    clientId(clientId_),
+    pcmCallback(pcmCallback_),
+    gain(gain_),
+    buffer(),
+    bufferCapacity(0),
+    energy(0),
+    hangover(0),
+    fade(0),
+    selected(false)
+{
+}
+
 AudioMixer::AudioMixer()
     : mutex(),
+    inputs(new Inputs()),
+    readers(0),
     frameSize(0),
-    inputs(),
-    runned(false)
+    accumulator(),
+    maxActiveInputs(0),
+    candidates(),
+    runned(false),
+    mixTime(Common::Metrics::Registry::Instance().GetHistogram("mixer_mix_time_us", "Time of the mixing of the frame")),
+    inputsCount(Common::Metrics::Registry::Instance().GetGauge("mixer_inputs", "Inputs of the mixer")),
+    mixedCount(Common::Metrics::Registry::Instance().GetGauge("mixer_mixed_inputs", "Inputs mixed to the last frame")),
+    emptyFrames(Common::Metrics::Registry::Instance().GetCounter("mixer_empty_frames_total", "Frames not given by the inputs"))
 {
 }
 
 AudioMixer::~AudioMixer()
 {
     Stop();
+    delete inputs.load();
+}
+
+int32_t AudioMixer::CalcGain(int32_t volume)
+{
+    if (volume == -1)
+    {
+        return GAIN_UNITY;
+    }
+    if (volume <= 0)
+    {
+        return 0;
+    }
+
+    auto gain = exp((double)std::min(volume, 100) / 100) / 2.718281828;
+    return std::min(static_cast<int32_t>(gain * GAIN_UNITY + 0.5), GAIN_UNITY);
+}
+
+void AudioMixer::Publish(Inputs *updated)
+{
+    auto old = inputs.exchange(updated);
+
+    /// Grace period: wait for GetSound to leave the old list,
+    /// after it returns the removed callbacks are never called again
+    while (readers.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    delete old;
 }
 
 void AudioMixer::AddInput(uint32_t ssrc,
@@ -45,9 +228,12 @@ void AudioMixer::AddInput(uint32_t ssrc,
 {
     std::lock_guard<std::mutex> lock(mutex);
 
-    if (std::find_if(inputs.begin(), inputs.end(), [ssrc](const Input& p) { return p.ssrc == ssrc; }) == inputs.end())
+    auto current = inputs.load();
+    if (std::find_if(current->begin(), current->end(), [ssrc](const std::shared_ptr<Input>& p) { return p->ssrc == ssrc; }) == current->end())
     {
-        inputs.emplace_back(Input{ ssrc, clientId, pcmCallback, volume });
+        auto updated = new Inputs(*current);
+        updated->emplace_back(std::make_shared<Input>(ssrc, clientId, pcmCallback, CalcGain(volume)));
+        Publish(updated);
     }
 }
 
@@ -55,10 +241,11 @@ void AudioMixer::SetInputVolume(uint32_t ssrc, int32_t volume)
 {
     std::lock_guard<std::mutex> lock(mutex);
 
-    auto input = std::find_if(inputs.begin(), inputs.end(), [ssrc](const Input& p) { return p.ssrc == ssrc; });
-    if (input != inputs.end())
+    auto current = inputs.load();
+    auto input = std::find_if(current->begin(), current->end(), [ssrc](const std::shared_ptr<Input>& p) { return p->ssrc == ssrc; });
+    if (input != current->end())
     {
-        input->volume = volume;
+        (*input)->gain = CalcGain(volume);
     }
 }
 
@@ -66,13 +253,22 @@ void AudioMixer::DeleteInput(uint32_t ssrc)
 {
     std::lock_guard<std::mutex> lock(mutex);
 
-    auto input = std::find_if(inputs.begin(), inputs.end(), [ssrc](const Input& p) { return p.ssrc == ssrc; });
-    if (input != inputs.end())
+    auto current = inputs.load();
+    auto input = std::find_if(current->begin(), current->end(), [ssrc](const std::shared_ptr<Input>& p) { return p->ssrc == ssrc; });
+    if (input != current->end())
     {
-        inputs.erase(input);
+        auto updated = new Inputs();
+        updated->reserve(current->size() - 1);
+        std::copy_if(current->begin(), current->end(), std::back_inserter(*updated), [ssrc](const std::shared_ptr<Input>& p) { return p->ssrc != ssrc; });
+        Publish(updated);
     }
 }
 
+void AudioMixer::SetMaxActiveInputs(uint32_t count)
+{
+    maxActiveInputs = count;
+}
+
 void AudioMixer::Start(uint32_t sampleFreq)
 {
     if (!runned)
@@ -92,29 +288,162 @@ void AudioMixer::Stop()
 
 void AudioMixer::GetSound(Transport::OwnedRTPPacket& outputBuffer)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    Common::TimeMeter timeMeter;
+    const auto traceBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
+
+    ++readers;
+    const auto &current = *inputs.load();
 
-    for (auto& input : inputs)
+    const uint32_t frameBytes = std::min(static_cast<uint32_t>(frameSize), outputBuffer.size);
+    const size_t samples = frameBytes / 2;
+
+    if (accumulator.size() < samples)
     {
-        Transport::OwnedRTPPacket inputPacket(frameSize);
-        input.pcmCallback(inputPacket);
+        accumulator.resize(samples); /// Only on first call or sample rate change
+    }
+    std::fill(accumulator.begin(), accumulator.begin() + samples, 0);
 
-        if (inputPacket.size == 0 || input.volume == 0) continue;
+    const auto maxActive = maxActiveInputs.load(std::memory_order_relaxed);
 
-        auto volume = input.volume != -1 ? (exp((double)input.volume / 100) / 2.718281828) : 1;
-        for (uint16_t i = 0; i != frameSize; i += 2)
+    /// Pull a frame from every input, this also drains the jitter buffers of the inputs that will not be mixed
+    for (auto &input : current)
+    {
+        auto &buffer = input->buffer;
+        if (input->bufferCapacity < frameSize)
         {
-            const auto availableFrame = *reinterpret_cast<const int16_t*>(outputBuffer.data + i);
-            const auto addingFrame = static_cast<int16_t>(*reinterpret_cast<const int16_t*>(inputPacket.data + i) * volume);
+            buffer = Transport::OwnedRTPPacket(frameSize);
+            input->bufferCapacity = frameSize;
+        }
 
-            int32_t resultFrame = availableFrame + addingFrame;
+        /// Source either fills the buffer in place or moves its own frame into it
+        const auto data = buffer.data;
+        buffer.size = 0;
+        input->pcmCallback(buffer);
+        if (buffer.data != data)
+        {
+            input->bufferCapacity = buffer.size;
+        }
+        if (buffer.size == 0)
+        {
+            emptyFrames->Add();
+        }
 
-            // Saturate (to 32767) so that the signal does not overflow
-            resultFrame = WEBRTC_SPL_SAT(static_cast<int32_t>(32767), resultFrame, static_cast<int32_t>(-32768));
+        if (maxActive != 0)
+        {
+            const auto frameEnergy = CalcEnergy(reinterpret_cast<const int16_t*>(buffer.data), std::min(static_cast<size_t>(buffer.size / 2), samples));
+            input->energy = (input->energy * 3 + frameEnergy) / 4;
 
-            *reinterpret_cast<int16_t*>(outputBuffer.data + i) = resultFrame;
+            if (frameEnergy >= SPEAK_ENERGY)
+            {
+                input->hangover = HANGOVER_FRAMES;
+            }
+            else if (input->hangover != 0)
+            {
+                --input->hangover;
+            }
         }
     }
+
+    SelectSpeakers(current, maxActive);
+
+    int64_t mixedInputs = 0;
+    for (auto &input : current)
+    {
+        mixedInputs += MixInput(*input, samples) ? 1 : 0;
+    }
+    inputsCount->Set(current.size());
+
+    if (traceBegin != 0)
+    {
+        const auto traceEnd = Common::Trace::Now();
+        for (auto &input : current)
+        {
+            if (input->buffer.size != 0)
+            {
+                Common::Trace::Record(Common::Trace::Stage::Play, Common::Trace::Kind::Audio, input->buffer.header.ssrc, input->buffer.header.ts, traceBegin, traceEnd);
+            }
+        }
+    }
+
+    --readers;
+
+    if (mixedInputs != 0)
+    {
+        MixOut(reinterpret_cast<int16_t*>(outputBuffer.data), accumulator.data(), samples);
+    }
+
+    mixedCount->Set(mixedInputs);
+    mixTime->Record(timeMeter.Measure());
+}
+
+void AudioMixer::SelectSpeakers(const Inputs &current, uint32_t maxActive)
+{
+    if (maxActive == 0 || current.size() <= maxActive)
+    {
+        for (auto &input : current)
+        {
+            input->selected = true;
+        }
+        return;
+    }
+
+    candidates.clear(); /// Keeps the capacity, grows only with the conference
+    for (auto &input : current)
+    {
+        if (input->hangover != 0 && input->gain.load(std::memory_order_relaxed) != 0)
+        {
+            candidates.emplace_back(input.get());
+        }
+    }
+
+    /// Current speakers get a bonus, so a slightly louder one does not make them flap
+    auto score = [](const Input *input) { return input->selected ? input->energy * 2 : input->energy; };
+    auto last = candidates.begin() + std::min(static_cast<size_t>(maxActive), candidates.size());
+    std::partial_sort(candidates.begin(), last, candidates.end(), [&score](const Input *a, const Input *b) { return score(a) > score(b); });
+
+    for (auto &input : current)
+    {
+        input->selected = false;
+    }
+    for (auto it = candidates.begin(); it != last; ++it)
+    {
+        (*it)->selected = true;
+    }
+}
+
+bool AudioMixer::MixInput(Input &input, size_t samples)
+{
+    const auto gain = input.gain.load(std::memory_order_relaxed);
+    const int32_t target = input.selected ? GAIN_UNITY : 0;
+
+    if (input.buffer.size == 0 || gain == 0 || (input.fade == 0 && target == 0))
+    {
+        input.fade = 0; /// Nothing was played, next frame fades in from silence
+        return false;
+    }
+
+    const auto count = std::min(static_cast<size_t>(input.buffer.size / 2), samples);
+    const auto pcm = reinterpret_cast<const int16_t*>(input.buffer.data);
+
+    if (input.fade == target)
+    {
+        Accumulate(accumulator.data(), pcm, count, gain);
+        return true;
+    }
+
+    /// Linear fade in / out spread over the frame by steps
+    const auto step = count / FADE_STEPS;
+    size_t pos = 0;
+    for (uint32_t i = 1; i <= FADE_STEPS; ++i)
+    {
+        const int32_t fade = input.fade + (target - input.fade) * static_cast<int32_t>(i) / static_cast<int32_t>(FADE_STEPS);
+        const auto end = i == FADE_STEPS ? count : pos + step;
+        Accumulate(accumulator.data() + pos, pcm + pos, end - pos, (gain * fade) >> 15);
+        pos = end;
+    }
+    input.fade = target;
+
+    return true;
 }
 
 }
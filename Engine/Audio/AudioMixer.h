@@ -9,12 +9,16 @@
 
 #include <atomic>
 #include <array>
+#include <vector>
+#include <memory>
 #include <functional>
 #include <mutex>
 
 #include <Transport/RTP/OwnedRTPPacket.h>
 #include <Audio/SoundBlock.h>
 
+#include <Common/Metrics.h>
+
 namespace Audio
 {
 
@@ -23,7 +27,7 @@ class AudioMixer
 public:
 	AudioMixer();
 	~AudioMixer();
-	
+
 	/// Input must provide a method that gives PCM data 48000, 16, 1
 	void AddInput(uint32_t ssrc,
 		int64_t clientId,
@@ -33,28 +37,71 @@ public:
 	void SetInputVolume(uint32_t ssrc, int32_t volume);
 	void DeleteInput(uint32_t ssrc);
 
+	/// Mix only the N loudest speaking inputs, 0 - mix all inputs
+	void SetMaxActiveInputs(uint32_t count);
+
 	void Start(uint32_t sampleFreq = 48000);
 	void Stop();
 
-	/// Return PCM data 48000, 16, 1 
+	/// Return PCM data 48000, 16, 1
+	/// Called from the real-time audio thread, never blocks on the inputs mutex
 	void GetSound(Transport::OwnedRTPPacket& outputBuffer);
 
 private:
-	std::mutex mutex;
-
-	uint16_t frameSize; // 4 frames of 48 k mono
-
 	struct Input
 	{
 		uint32_t ssrc;
 		int64_t clientId;
 		std::function<void(Transport::OwnedRTPPacket&)> pcmCallback;
-		int32_t volume;
+
+		std::atomic<int32_t> gain; /// Q15, GAIN_UNITY - no change volume
+
+		/// Owned by GetSound only, reused from frame to frame
+		Transport::OwnedRTPPacket buffer;
+		uint32_t bufferCapacity;
+
+		/// Speaker selection state, owned by GetSound only
+		uint64_t energy; /// Smoothed mean square of the samples
+		uint32_t hangover; /// Frames left until the input is treated as silent
+		int32_t fade; /// Q15, current fade in / out gain
+		bool selected;
+
+		Input(uint32_t ssrc, int64_t clientId, std::function<void(Transport::OwnedRTPPacket&)> pcmCallback, int32_t gain);
 	};
 
-	std::vector<Input> inputs;
+	typedef std::vector<std::shared_ptr<Input>> Inputs;
+
+	/// Writers (Add/Set/Delete) are serialized by the mutex and publish a new copy of the inputs list,
+	/// GetSound reads the current copy without locking
+	std::mutex mutex;
+	std::atomic<Inputs*> inputs;
+	std::atomic<uint32_t> readers;
+
+	uint16_t frameSize; // 4 frames of 48 k mono
+
+	std::vector<int32_t> accumulator;
+
+	std::atomic<uint32_t> maxActiveInputs;
+	std::vector<Input*> candidates;
 
 	std::atomic_bool runned;
+
+	std::shared_ptr<Common::Metrics::Histogram> mixTime;
+	std::shared_ptr<Common::Metrics::Gauge> inputsCount, mixedCount;
+	std::shared_ptr<Common::Metrics::Counter> emptyFrames;
+
+	static const int32_t GAIN_UNITY = 1 << 15;
+
+	static const uint64_t SPEAK_ENERGY = 300 * 300; /// ~ -40 dBFS
+	static const uint32_t HANGOVER_FRAMES = 15; /// 600 ms
+	static const uint32_t FADE_STEPS = 8; /// Fade is spread over one frame
+
+	void SelectSpeakers(const Inputs &current, uint32_t maxActive);
+	bool MixInput(Input &input, size_t samples);
+
+	void Publish(Inputs *updated);
+
+	static int32_t CalcGain(int32_t volume);
 };
 
 }
@@ -38,6 +38,9 @@ public:
 
 	virtual void SetPacketLoss(int32_t val) = 0;
 
+	/// Enable the discontinuous transmission, the silent frames are not sent
+	virtual void SetDTX(bool yes) = 0;
+
 	/// Change buffer here
 	virtual void Encode(const Transport::IPacket &in, Transport::IPacket& out) = 0;
 
@@ -8,6 +8,8 @@
 #include <Audio/OpusDecoderImpl.h>
 
 #include <Common/Common.h>
+#include <Common/TimeMeter.h>
+#include <Common/Trace.h>
 
 #include <Transport/RTP/RTPPayloadType.h>
 
@@ -21,7 +23,9 @@ OpusDecoderImpl::OpusDecoderImpl()
 	channels(1),
 	lastSeq(0),
 	produceBuffer(),
-	opusDecoder(nullptr)
+	opusDecoder(nullptr),
+	decodeTime(Common::Metrics::Registry::Instance().GetHistogram("codec_decode_time_us", "Time of the decoding of the frame", { { "codec", "opus" } })),
+	decodeErrors(Common::Metrics::Registry::Instance().GetCounter("codec_decode_errors_total", "Frames failed to decode", { { "codec", "opus" } }))
 {
 }
 
@@ -121,7 +125,16 @@ void OpusDecoderImpl::Decode(const Transport::IPacket& in_, Transport::IPacket&
 	}
 
 	int32_t frameSize = (sample_freq / 100) * channels * 2 * 4;
+	Common::Trace::Span span(Common::Trace::Stage::Decode, Common::Trace::Kind::Audio, in.rtpHeader.ssrc, in.rtpHeader.ts);
+	Common::TimeMeter timeMeter;
 	int outframeSize = opus_decode(opusDecoder, in.payload, in.payloadSize, reinterpret_cast<opus_int16*>(produceBuffer.get()), frameSize, 0);
+	decodeTime->Record(timeMeter.Measure());
+	span.End();
+
+	if (outframeSize < 0)
+	{
+		decodeErrors->Add();
+	}
 
 	if (outframeSize > 0)
 	{
@@ -15,6 +15,8 @@
 
 #include <opus/opus.h>
 
+#include <Common/Metrics.h>
+
 namespace Audio
 {
 	class OpusDecoderImpl : public IDecoder, public Transport::ISocket
@@ -48,5 +50,8 @@ namespace Audio
 		std::unique_ptr<uint8_t[]> produceBuffer;
 
 		OpusDecoder *opusDecoder;
+
+		std::shared_ptr<Common::Metrics::Histogram> decodeTime;
+		std::shared_ptr<Common::Metrics::Counter> decodeErrors;
 	};
 }
@@ -8,12 +8,16 @@
 #include <Audio/OpusEncoderImpl.h>
 
 #include <Common/Common.h>
+#include <Common/TimeMeter.h>
+#include <Common/Trace.h>
 
 #include <Transport/RTP/RTPPacket.h>
 #include <Transport/RTP/RTPPayloadType.h>
 
 #include <Common/CRC32.h>
 
+#include <Audio/AudioLevel.h>
+
 namespace Audio
 {
 
@@ -26,8 +30,12 @@ OpusEncoderImpl::OpusEncoderImpl()
 	quality(0),
 	bitrate(30),
 	packetLoss(0),
+	dtx(false),
+	seq(0),
 	produceBuffer(),
-	opusEncoder()
+	opusEncoder(),
+	encodeTime(Common::Metrics::Registry::Instance().GetHistogram("codec_encode_time_us", "Time of the encoding of the frame", { { "codec", "opus" } })),
+	encodeErrors(Common::Metrics::Registry::Instance().GetCounter("codec_encode_errors_total", "Frames failed to encode", { { "codec", "opus" } }))
 {
 }
 
@@ -133,6 +141,12 @@ void OpusEncoderImpl::Start(CodecType)
 		return;
 	}
 
+	opus_err = opus_encoder_ctl(opusEncoder, OPUS_SET_DTX(dtx ? 1 : 0));
+	if (opus_err != OPUS_OK)
+	{
+		return;
+	}
+
 	runned = true;
 }
 
@@ -163,19 +177,39 @@ void OpusEncoderImpl::SetPacketLoss(int val)
 	}
 }
 
+void OpusEncoderImpl::SetDTX(bool yes)
+{
+	dtx = yes;
+	if (runned)
+	{
+		opus_encoder_ctl(opusEncoder, OPUS_SET_DTX(yes ? 1 : 0));
+	}
+}
+
 void OpusEncoderImpl::Encode(const Transport::IPacket& in_, Transport::IPacket& out_)
 {
 	const auto& in = *static_cast<const Transport::RTPPacket*>(&in_);
 
 	int32_t frameSize = in.payloadSize / (1 * sizeof(opus_int16));
+	Common::Trace::Span span(Common::Trace::Stage::Encode, Common::Trace::Kind::Audio, in.rtpHeader.ssrc, in.rtpHeader.ts);
+	Common::TimeMeter timeMeter;
 	int32_t compressedSize = opus_encode(opusEncoder, (const opus_int16*)in.payload, frameSize, produceBuffer.get(), BUFFER_SIZE);
+	encodeTime->Record(timeMeter.Measure());
+	span.End();
+
+	if (compressedSize < 0)
+	{
+		encodeErrors->Add();
+	}
 
 	auto& out = *static_cast<Transport::RTPPacket*>(&out_);
 	out.rtpHeader = in.rtpHeader;
 	out.rtpHeader.pt = static_cast<uint8_t>(Transport::RTPPayloadType::ptOpus);
 	out.rtpHeader.x = 1;
-	out.rtpHeader.eXLength = 1;
 	out.rtpHeader.eX[0] = Common::crc32(0, produceBuffer.get(), compressedSize);
+	/// The voice activity is of this frame, DTX only lets the encoder drop the silent ones
+	const auto level = CalcAudioLevel((const int16_t*)in.payload, frameSize);
+	SetAudioLevel(out.rtpHeader, level, level <= AUDIO_LEVEL_VOICE && compressedSize > 2);
 	out.payload = produceBuffer.get();
 	out.payloadSize = compressedSize;
 }
@@ -191,8 +225,10 @@ void OpusEncoderImpl::Send(const Transport::IPacket &in, const Transport::Addres
 
 	Encode(in, out);
 
-	if (out.payloadSize > 0)
+	/// In DTX mode the encoder gives 1 - 2 bytes frames on silence, they don't need to be transmitted
+	if (out.payloadSize > (dtx ? 2u : 0u))
 	{
+		out.rtpHeader.seq = ++seq;
 		receiver->Send(out);
 	}
 }
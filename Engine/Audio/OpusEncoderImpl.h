@@ -15,6 +15,8 @@
 
 #include <opus/opus.h>
 
+#include <Common/Metrics.h>
+
 namespace Audio
 {
 	class OpusEncoderImpl : public IEncoder, public Transport::ISocket
@@ -34,6 +36,7 @@ namespace Audio
 		virtual void Stop();
 		virtual bool IsStarted() const;
 		virtual void SetPacketLoss(int32_t val);
+		virtual void SetDTX(bool yes);
 		virtual void Encode(const Transport::IPacket& in, Transport::IPacket& out);
 
 		/// Derived from Transport::ISocket (input method)
@@ -48,9 +51,15 @@ namespace Audio
 		int32_t quality;
 		int32_t bitrate;
 		int32_t packetLoss;
+		bool dtx;
+
+		uint16_t seq; /// Of the sent packets, so the frames dropped by DTX don't look like the losses
 
 		std::unique_ptr<uint8_t[]> produceBuffer;
 
 		OpusEncoder *opusEncoder;
+
+		std::shared_ptr<Common::Metrics::Histogram> encodeTime;
+		std::shared_ptr<Common::Metrics::Counter> encodeErrors;
 	};
 }
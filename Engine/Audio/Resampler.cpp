@@ -7,66 +7,210 @@
 
 #include <Audio/Resampler.h>
 
-#include <cstdlib>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Audio
 {
 
+static const double PI = 3.14159265358979323846;
+static const double KAISER_BETA = 8.0; /// ~80 dB of the stop band attenuation
+static const double ROLLOFF = 0.9; /// Cutoff relative to the Nyquist of the lower rate
+
+/// Sum of x[i] * h[i], count is multiple of 16
+static int32_t DotProduct(const int16_t *x, const int16_t *h, uint32_t count)
+{
+#if defined(__AVX2__)
+    auto acc = _mm256_setzero_si256();
+    for (uint32_t i = 0; i != count; i += 16)
+    {
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i))));
+    }
+    auto sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#elif defined(RESAMPLER_SSE2)
+    auto acc = _mm_setzero_si128();
+    for (uint32_t i = 0; i != count; i += 8)
+    {
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i))));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    return _mm_cvtsi128_si32(acc);
+#else
+    int32_t sum = 0;
+    for (uint32_t i = 0; i != count; ++i)
+    {
+        sum += static_cast<int32_t>(x[i]) * h[i];
+    }
+    return sum;
+#endif
+}
+
+/// Zero order modified Bessel function of the first kind, for the Kaiser window
+static double BesselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k != 32; ++k)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
 Resampler::Resampler()
 	: inFreq(48000),
-    outFreq(16000),
-    resamplingState16_48(), resamplingState48_16(),
-    tmpMem(static_cast<int32_t*>(malloc(3 * 336 * sizeof(int32_t)))),
-    resampledOut(static_cast<int16_t*>(malloc(480 * sizeof(int16_t) * 4)))
+    outFreq(48000),
+    upFactor(1), downFactor(1),
+    coefs(),
+    work(),
+    resampled(),
+    position(0)
 {
 }
 
 Resampler::~Resampler()
 {
-    free(tmpMem);
-    free(resampledOut);
 }
 
 void Resampler::SetSampleFreq(int32_t inFreq_, int32_t outFreq_)
 {
+    if (inFreq_ <= 0 || outFreq_ <= 0)
+    {
+        return;
+    }
+
     inFreq = inFreq_;
     outFreq = outFreq_;
+
+    const auto divisor = std::gcd(inFreq, outFreq);
+    upFactor = outFreq / divisor;
+    downFactor = inFreq / divisor;
+
+    DesignFilter();
+    Reset();
 }
 
-void Resampler::Resample(const Transport::RTPPacket& inPacket, Transport::RTPPacket& out)
+void Resampler::Reset()
+{
+    work.assign(TAPS - 1, 0);
+    position = 0;
+}
+
+uint32_t Resampler::GetOutputCount(uint32_t inCount) const
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(inCount) * upFactor + position) / downFactor + 1);
+}
+
+uint32_t Resampler::GetLatency() const
+{
+    return TAPS / 2;
+}
+
+void Resampler::DesignFilter()
 {
     if (inFreq == outFreq)
     {
-        out = inPacket;
+        coefs.clear();
+        return;
+    }
+
+    /// Windowed sinc prototype at the upsampled rate, cut at the Nyquist of the lower rate
+    const auto length = TAPS * upFactor;
+    const auto center = (length - 1) / 2.0;
+    const auto cutoff = ROLLOFF * 0.5 / std::max(upFactor, downFactor);
+    const auto windowNorm = BesselI0(KAISER_BETA);
+
+    std::vector<double> prototype(length);
+    double sum = 0;
+    for (uint32_t n = 0; n != length; ++n)
+    {
+        const auto t = n - center;
+        const auto sinc = t == 0 ? 2 * cutoff : sin(2 * PI * cutoff * t) / (PI * t);
+        const auto r = t / (center + 1);
+        const auto window = BesselI0(KAISER_BETA * sqrt(std::max(0.0, 1 - r * r))) / windowNorm;
+        prototype[n] = sinc * window;
+        sum += prototype[n];
     }
-    else if (inFreq == 16000 && outFreq == 48000)
+
+    /// Each phase gets the unity gain after the zero stuffing
+    const auto scale = upFactor / sum;
+
+    coefs.resize(length);
+    for (uint32_t phase = 0; phase != upFactor; ++phase)
     {
-        for (int i = 0; i != inPacket.payloadSize / 3; i += 160)
+        for (uint32_t j = 0; j != TAPS; ++j)
         {
-            WebRtcSpl_Resample16khzTo48khz(reinterpret_cast<const int16_t*>(inPacket.payload) + i,
-                resampledOut + i * 3,
-                &resamplingState16_48,
-                tmpMem);
+            const auto value = prototype[phase + (TAPS - 1 - j) * upFactor] * scale * 32768.0;
+            coefs[phase * TAPS + j] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, round(value))));
         }
+    }
+}
 
-        out = inPacket;
-        out.payload = reinterpret_cast<uint8_t*>(resampledOut);
-        out.payloadSize = inPacket.payloadSize * 3;
+uint32_t Resampler::Resample(const int16_t *in, uint32_t inCount, int16_t *out, uint32_t outCapacity)
+{
+    if (inFreq == outFreq)
+    {
+        const auto count = std::min(inCount, outCapacity);
+        std::copy(in, in + count, out);
+        return count;
     }
-    else if (inFreq == 48000 && outFreq == 16000)
+
+    /// The history is in front of the input, so the filter window is always contiguous
+    work.resize(TAPS - 1 + inCount);
+    std::copy(in, in + inCount, work.begin() + (TAPS - 1));
+
+    uint32_t outCount = 0;
+    const uint64_t end = static_cast<uint64_t>(inCount) * upFactor;
+    uint64_t t = position;
+    while (t < end && outCount != outCapacity)
     {
-        for (int i = 0; i != inPacket.payloadSize; i += 480)
-        {
-            WebRtcSpl_Resample48khzTo16khz(reinterpret_cast<const int16_t*>(inPacket.payload) + i,
-                resampledOut + i / 3,
-                &resamplingState48_16,
-                tmpMem);
-        }
+        const auto index = static_cast<uint32_t>(t / upFactor);
+        const auto phase = static_cast<uint32_t>(t % upFactor);
+
+        auto sample = (DotProduct(&work[index], &coefs[phase * TAPS], TAPS) + (1 << 14)) >> 15;
+        out[outCount++] = static_cast<int16_t>(std::max(-32768, std::min(32767, sample)));
+
+        t += downFactor;
+    }
+
+    position = t > end ? static_cast<uint32_t>(t - end) : 0;
+
+    std::copy(work.end() - (TAPS - 1), work.end(), work.begin());
+    work.resize(TAPS - 1);
+
+    return outCount;
+}
 
+void Resampler::Resample(const Transport::RTPPacket& inPacket, Transport::RTPPacket& out)
+{
+    if (inFreq == outFreq)
+    {
         out = inPacket;
-        out.payload = reinterpret_cast<uint8_t*>(resampledOut);
-        out.payloadSize = inPacket.payloadSize / 3;
+        return;
     }
+
+    const auto inCount = inPacket.payloadSize / sizeof(int16_t);
+    resampled.resize(GetOutputCount(inCount));
+
+    const auto outCount = Resample(reinterpret_cast<const int16_t*>(inPacket.payload), inCount, resampled.data(), static_cast<uint32_t>(resampled.size()));
+
+    out = inPacket;
+    out.payload = reinterpret_cast<uint8_t*>(resampled.data());
+    out.payloadSize = outCount * sizeof(int16_t);
 }
 
 }
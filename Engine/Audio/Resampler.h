@@ -9,11 +9,14 @@
 
 #include <Transport/RTP/RTPPacket.h>
 
-#include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
+#include <cstdint>
+#include <vector>
 
 namespace Audio
 {
 
+/// Polyphase FIR resampler for any rational ratio of the rates (48000, 44100, 32000, 16000, 8000...)
+/// Works in the streaming mode, the filter state is kept between the calls
 class Resampler
 {
 public:
@@ -22,15 +25,33 @@ public:
 
     void SetSampleFreq(int32_t inFreq, int32_t outFreq);
 
+    /// The output points to the internal buffer, valid until the next call
 	void Resample(const Transport::RTPPacket& in, Transport::RTPPacket& out);
 
+    /// Return the count of samples was written to out
+    uint32_t Resample(const int16_t *in, uint32_t inCount, int16_t *out, uint32_t outCapacity);
+
+    /// Return the max count of output samples for inCount input samples
+    uint32_t GetOutputCount(uint32_t inCount) const;
+
+    /// Constant delay of the filter in input samples
+    uint32_t GetLatency() const;
+
+    void Reset();
+
 private:
+    static const uint32_t TAPS = 32; /// Per phase, multiple of 16 for the vector kernels
+
     int32_t inFreq, outFreq;
+    uint32_t upFactor, downFactor;
+
+    std::vector<int16_t> coefs; /// upFactor phases of TAPS Q15 coefficients
+    std::vector<int16_t> work; /// TAPS - 1 samples of the history followed by the input
+    std::vector<int16_t> resampled;
+
+    uint32_t position; /// Position of the next output sample, in 1 / upFactor parts of the input sample
 
-    WebRtcSpl_State16khzTo48khz resamplingState16_48;
-    WebRtcSpl_State48khzTo16khz resamplingState48_16;
-    int32_t *tmpMem;
-    int16_t *resampledOut;
+    void DesignFilter();
 };
 
 }
@@ -0,0 +1,289 @@
+/**
+ * Histogram.cpp - Contains the lock-free log bucketed histogram impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Common/Histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Common
+{
+
+/// The value is not zero and fits to 32 bits
+inline uint32_t MostSignificantBit(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index = 0;
+	_BitScanReverse(&index, value);
+	return index;
+#else
+	return 31 - __builtin_clz(value);
+#endif
+}
+
+Histogram::Snapshot::Snapshot()
+	: count(0), sum(0), max(0), buckets{}
+{
+}
+
+void Histogram::Snapshot::Merge(const Snapshot &other)
+{
+	count += other.count;
+	sum += other.sum;
+	max = std::max(max, other.max);
+	for (size_t i = 0; i != BUCKETS; ++i)
+	{
+		buckets[i] += other.buckets[i];
+	}
+}
+
+uint64_t Histogram::Snapshot::GetPercentile(double p) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	auto rank = static_cast<uint64_t>(std::ceil(std::min(std::max(p, 0.0), 100.0) / 100.0 * count));
+	if (rank == 0)
+	{
+		rank = 1;
+	}
+
+	uint64_t accumulated = 0;
+	for (size_t i = 0; i != BUCKETS; ++i)
+	{
+		accumulated += buckets[i];
+		if (accumulated >= rank)
+		{
+			return std::min(GetUpperBound(i), max);
+		}
+	}
+
+	return max;
+}
+
+uint64_t Histogram::Snapshot::GetAvg() const
+{
+	return count != 0 ? sum / count : 0;
+}
+
+Histogram::Histogram()
+	: buckets{}, count(0), sum(0), max(0)
+{
+}
+
+void Histogram::Record(uint64_t value)
+{
+	buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+
+	auto max_ = max.load(std::memory_order_relaxed);
+	while (value > max_ && !max.compare_exchange_weak(max_, value, std::memory_order_relaxed));
+}
+
+void Histogram::Merge(const Snapshot &snapshot)
+{
+	for (size_t i = 0; i != BUCKETS; ++i)
+	{
+		if (snapshot.buckets[i] != 0)
+		{
+			buckets[i].fetch_add(snapshot.buckets[i], std::memory_order_relaxed);
+		}
+	}
+	sum.fetch_add(snapshot.sum, std::memory_order_relaxed);
+	count.fetch_add(snapshot.count, std::memory_order_relaxed);
+
+	auto max_ = max.load(std::memory_order_relaxed);
+	while (snapshot.max > max_ && !max.compare_exchange_weak(max_, snapshot.max, std::memory_order_relaxed));
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const
+{
+	Snapshot snapshot;
+
+	for (size_t i = 0; i != BUCKETS; ++i)
+	{
+		snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.buckets[i]; /// Consistent with the buckets, unlike the racing count
+	}
+	snapshot.sum = sum.load(std::memory_order_relaxed);
+	snapshot.max = max.load(std::memory_order_relaxed);
+
+	return snapshot;
+}
+
+void Histogram::Clear()
+{
+	for (auto &b : buckets)
+	{
+		b.store(0, std::memory_order_relaxed);
+	}
+	count.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetCount() const
+{
+	return count.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetSum() const
+{
+	return sum.load(std::memory_order_relaxed);
+}
+
+size_t Histogram::GetBucket(uint64_t value)
+{
+	if (value < SUB_COUNT)
+	{
+		return static_cast<size_t>(value);
+	}
+	if ((value >> MAX_BITS) != 0)
+	{
+		return BUCKETS - 1;
+	}
+
+	auto msb = MostSignificantBit(static_cast<uint32_t>(value));
+	return (msb - SUB_BITS + 1) * SUB_COUNT + static_cast<size_t>((value >> (msb - SUB_BITS)) - SUB_COUNT);
+}
+
+uint64_t Histogram::GetLowerBound(size_t bucket)
+{
+	if (bucket < SUB_COUNT)
+	{
+		return bucket;
+	}
+
+	auto msb = static_cast<uint32_t>(bucket / SUB_COUNT) + SUB_BITS - 1;
+	return static_cast<uint64_t>(SUB_COUNT + bucket % SUB_COUNT) << (msb - SUB_BITS);
+}
+
+uint64_t Histogram::GetUpperBound(size_t bucket)
+{
+	return bucket < BUCKETS - 1 ? GetLowerBound(bucket + 1) - 1 : UINT64_MAX;
+}
+
+WindowedHistogram::Slot::Slot()
+	: epoch(0), histogram()
+{
+}
+
+WindowedHistogram::WindowedHistogram(std::chrono::milliseconds window, uint32_t slots_)
+	: slotDuration(std::max<uint64_t>(window.count() / std::max<uint32_t>(slots_, 1), 1)),
+	slotsCount(std::max<uint32_t>(slots_, 1)),
+	slots(new Slot[slotsCount])
+{
+}
+
+void WindowedHistogram::Record(uint64_t value, uint64_t now)
+{
+	const uint64_t epoch = now / slotDuration + 1; /// Zero is the never used slot
+	auto &slot = slots[epoch % slotsCount];
+
+	auto slotEpoch = slot.epoch.load(std::memory_order_acquire);
+	if (slotEpoch != epoch)
+	{
+		if (slotEpoch > epoch)
+		{
+			return; /// Too late, the slot already holds the newer values
+		}
+		/// One of the recorders reuses the slot, the values recorded meanwhile by others may be lost
+		if (slot.epoch.compare_exchange_strong(slotEpoch, epoch, std::memory_order_acq_rel))
+		{
+			slot.histogram.Clear();
+		}
+	}
+
+	slot.histogram.Record(value);
+}
+
+void WindowedHistogram::Record(uint64_t value)
+{
+	Record(value, Now());
+}
+
+bool WindowedHistogram::IsLive(const Slot &slot, uint64_t now) const
+{
+	const uint64_t epoch = now / slotDuration + 1;
+	const auto slotEpoch = slot.epoch.load(std::memory_order_acquire);
+
+	return slotEpoch != 0 && slotEpoch <= epoch && slotEpoch + slotsCount > epoch;
+}
+
+Histogram::Snapshot WindowedHistogram::GetSnapshot(uint64_t now) const
+{
+	Histogram::Snapshot snapshot;
+
+	for (uint32_t i = 0; i != slotsCount; ++i)
+	{
+		if (IsLive(slots[i], now))
+		{
+			snapshot.Merge(slots[i].histogram.GetSnapshot());
+		}
+	}
+
+	return snapshot;
+}
+
+Histogram::Snapshot WindowedHistogram::GetSnapshot() const
+{
+	return GetSnapshot(Now());
+}
+
+uint64_t WindowedHistogram::GetAvg(uint64_t now) const
+{
+	uint64_t count = 0, sum = 0;
+
+	for (uint32_t i = 0; i != slotsCount; ++i)
+	{
+		if (IsLive(slots[i], now))
+		{
+			count += slots[i].histogram.GetCount();
+			sum += slots[i].histogram.GetSum();
+		}
+	}
+
+	return count != 0 ? sum / count : 0;
+}
+
+uint64_t WindowedHistogram::GetCount(uint64_t now) const
+{
+	uint64_t count = 0;
+
+	for (uint32_t i = 0; i != slotsCount; ++i)
+	{
+		if (IsLive(slots[i], now))
+		{
+			count += slots[i].histogram.GetCount();
+		}
+	}
+
+	return count;
+}
+
+void WindowedHistogram::Clear()
+{
+	for (uint32_t i = 0; i != slotsCount; ++i)
+	{
+		slots[i].epoch.store(0, std::memory_order_release);
+		slots[i].histogram.Clear();
+	}
+}
+
+uint64_t WindowedHistogram::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}
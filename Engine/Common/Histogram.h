@@ -0,0 +1,108 @@
+/**
+ * Histogram.h - Contains the lock-free log bucketed histogram
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+namespace Common
+{
+
+/// Distribution of the values in the fixed memory.
+/// The values below 16 have own buckets, the bigger ones go to 16 buckets per power of two (~6% error),
+/// the values above 2^32 are counted in the last bucket. Record() is a few relaxed atomic adds, no locks
+class Histogram
+{
+public:
+	static const uint32_t SUB_BITS = 4;
+	static const uint32_t SUB_COUNT = 1 << SUB_BITS;
+	static const uint32_t MAX_BITS = 32;
+	static const size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+	/// Plain copy of the histogram, can be merged with others and queried
+	struct Snapshot
+	{
+		uint64_t count, sum, max;
+		std::array<uint64_t, BUCKETS> buckets;
+
+		Snapshot();
+
+		void Merge(const Snapshot &other);
+
+		/// p is 0 - 100, the result is the upper bound of the bucket, never above the max
+		uint64_t GetPercentile(double p) const;
+		uint64_t GetAvg() const;
+	};
+
+	Histogram();
+
+	void Record(uint64_t value);
+
+	/// Adds the snapshot (of other thread's or other stream's histogram)
+	void Merge(const Snapshot &snapshot);
+
+	/// The concurrent records may be partially included
+	Snapshot GetSnapshot() const;
+
+	void Clear();
+
+	uint64_t GetCount() const;
+	uint64_t GetSum() const;
+
+	static size_t GetBucket(uint64_t value);
+	static uint64_t GetLowerBound(size_t bucket);
+	static uint64_t GetUpperBound(size_t bucket); /// Inclusive
+
+private:
+	std::array<std::atomic<uint64_t>, BUCKETS> buckets;
+	std::atomic<uint64_t> count, sum, max;
+};
+
+/// The histogram of the last window, made of the slots rotated by the time.
+/// The window covers (slots - 1) to slots of the slot's durations
+class WindowedHistogram
+{
+public:
+	WindowedHistogram(std::chrono::milliseconds window, uint32_t slots = 4);
+
+	/// now is ms of any monotonic clock, the caller usually has it already
+	void Record(uint64_t value, uint64_t now);
+	void Record(uint64_t value);
+
+	Histogram::Snapshot GetSnapshot(uint64_t now) const;
+	Histogram::Snapshot GetSnapshot() const;
+
+	/// Only the counters of the slots are read, so it's cheap enough for the every sample
+	uint64_t GetAvg(uint64_t now) const;
+	uint64_t GetCount(uint64_t now) const;
+
+	void Clear();
+
+	static uint64_t Now();
+
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> epoch;
+		Histogram histogram;
+
+		Slot();
+	};
+
+	uint64_t slotDuration;
+	uint32_t slotsCount;
+	std::unique_ptr<Slot[]> slots;
+
+	bool IsLive(const Slot &slot, uint64_t now) const;
+};
+
+}
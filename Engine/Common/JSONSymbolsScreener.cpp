@@ -5,7 +5,7 @@
  * Copyright (C), Infinity Video Soft LLC, 2017
  */
 
-#include <string>
+#include <Common/JSONSymbolsScreener.h>
 
 namespace Common
 {
@@ -17,8 +17,32 @@ std::string Screen(std::string_view value)
 {
 	std::string buffer;
 	buffer.reserve(value.size());
-	for (size_t pos = 0; pos != value.size(); ++pos)
+	Screen(value, buffer);
+	return buffer;
+}
+
+static inline bool NeedScreen(char c)
+{
+	return static_cast<unsigned char>(c) < 32 || c == '\"' || c == '\\' || c == '/';
+}
+
+void Screen(std::string_view value, std::string &buffer)
+{
+	size_t pos = 0;
+	while (pos != value.size())
 	{
+		/// Most of the text needs no screening, append it by the runs
+		auto start = pos;
+		while (pos != value.size() && !NeedScreen(value[pos]))
+		{
+			++pos;
+		}
+		buffer.append(value.data() + start, pos - start);
+		if (pos == value.size())
+		{
+			break;
+		}
+
 		switch (value[pos])
 		{
 			case '\b': buffer.append("\\b");  break;
@@ -58,9 +82,8 @@ std::string Screen(std::string_view value)
 			case 31: buffer.append("\\u0031"); break;
 			default:   buffer.append(&value[pos], 1); break;
 		}
+		++pos;
 	}
-
-	return buffer;
 }
 
 }
@@ -17,6 +17,9 @@ namespace JSON
 
 std::string Screen(std::string_view value);
 
+/// Appends the screened value to the out
+void Screen(std::string_view value, std::string &out);
+
 }
 
 }
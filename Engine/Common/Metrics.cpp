@@ -0,0 +1,256 @@
+/**
+ * Metrics.cpp - Contains the registry of the operational metrics impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Common/Metrics.h>
+#include <Common/JSONSymbolsScreener.h>
+
+#include <chrono>
+
+namespace Common
+{
+
+namespace Metrics
+{
+
+Registry::Registry()
+	: mutex(), series()
+{
+}
+
+Registry &Registry::Instance()
+{
+	static Registry registry;
+	return registry;
+}
+
+std::string MakeKey(std::string_view name, const Labels &labels)
+{
+	std::string key(name);
+	key += '{';
+	for (auto &l : labels)
+	{
+		key += l.first + "=\"" + l.second + "\",";
+	}
+	key += '}';
+	return key;
+}
+
+template <typename T>
+std::shared_ptr<T> Registry::Get(std::string_view name, std::string_view help, const Labels &labels, Type type)
+{
+	auto key = MakeKey(name, labels);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = series.find(key);
+	if (it != series.end() && it->second.type == type)
+	{
+		auto metric = it->second.metric.lock();
+		if (metric)
+		{
+			return std::static_pointer_cast<T>(metric);
+		}
+	}
+
+	auto metric = std::make_shared<T>();
+	series[key] = Series{ std::string(name), std::string(help), type, labels, metric };
+
+	return metric;
+}
+
+std::shared_ptr<Counter> Registry::GetCounter(std::string_view name, std::string_view help, const Labels &labels)
+{
+	return Get<Counter>(name, help, labels, Type::Counter);
+}
+
+std::shared_ptr<Gauge> Registry::GetGauge(std::string_view name, std::string_view help, const Labels &labels)
+{
+	return Get<Gauge>(name, help, labels, Type::Gauge);
+}
+
+std::shared_ptr<Histogram> Registry::GetHistogram(std::string_view name, std::string_view help, const Labels &labels)
+{
+	return Get<Histogram>(name, help, labels, Type::Histogram);
+}
+
+std::map<std::string, std::pair<Registry::Series, std::shared_ptr<void>>> Registry::Collect()
+{
+	std::map<std::string, std::pair<Series, std::shared_ptr<void>>> out;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto it = series.begin(); it != series.end();)
+	{
+		auto metric = it->second.metric.lock();
+		if (metric)
+		{
+			out.emplace(it->first, std::make_pair(it->second, metric));
+			++it;
+		}
+		else
+		{
+			it = series.erase(it);
+		}
+	}
+
+	return out;
+}
+
+std::string PrometheusValue(std::string_view value)
+{
+	std::string out;
+	for (auto ch : value)
+	{
+		switch (ch)
+		{
+			case '\\': out += "\\\\"; break;
+			case '"': out += "\\\""; break;
+			case '\n': out += "\\n"; break;
+			default: out += ch; break;
+		}
+	}
+	return out;
+}
+
+std::string PrometheusLabels(const Labels &labels, std::string_view le = "")
+{
+	if (labels.empty() && le.empty())
+	{
+		return "";
+	}
+
+	std::string out = "{";
+	for (auto &l : labels)
+	{
+		if (out.size() > 1) out += ',';
+		out += l.first + "=\"" + PrometheusValue(l.second) + "\"";
+	}
+	if (!le.empty())
+	{
+		if (out.size() > 1) out += ',';
+		out += "le=\"" + std::string(le) + "\"";
+	}
+	out += '}';
+
+	return out;
+}
+
+std::string Registry::ExportPrometheus()
+{
+	std::string out;
+
+	std::string prevName;
+	for (auto &s : Collect())
+	{
+		auto &series_ = s.second.first;
+		auto &metric = s.second.second;
+
+		if (series_.name != prevName)
+		{
+			prevName = series_.name;
+			out += "# HELP " + series_.name + " " + series_.help + "\n";
+			out += "# TYPE " + series_.name + (series_.type == Type::Counter ? " counter\n" : series_.type == Type::Gauge ? " gauge\n" : " histogram\n");
+		}
+
+		switch (series_.type)
+		{
+			case Type::Counter:
+				out += series_.name + PrometheusLabels(series_.labels) + " " + std::to_string(std::static_pointer_cast<Counter>(metric)->Get()) + "\n";
+			break;
+			case Type::Gauge:
+				out += series_.name + PrometheusLabels(series_.labels) + " " + std::to_string(std::static_pointer_cast<Gauge>(metric)->Get()) + "\n";
+			break;
+			case Type::Histogram:
+			{
+				auto snapshot = std::static_pointer_cast<Histogram>(metric)->GetSnapshot();
+
+				/// The Prometheus buckets are the powers of two, each one is 16 buckets of the histogram
+				uint64_t cumulative = 0, written = UINT64_MAX;
+				for (size_t i = 0; i != Histogram::BUCKETS; ++i)
+				{
+					cumulative += snapshot.buckets[i];
+					if (i % Histogram::SUB_COUNT != Histogram::SUB_COUNT - 1)
+					{
+						continue;
+					}
+					/// The empty tail is skipped, the +Inf bucket is always written
+					if (written == snapshot.count && i != Histogram::BUCKETS - 1)
+					{
+						continue;
+					}
+					written = cumulative;
+					out += series_.name + "_bucket" + PrometheusLabels(series_.labels, i != Histogram::BUCKETS - 1 ? std::to_string(Histogram::GetUpperBound(i)) : "+Inf") + " " + std::to_string(cumulative) + "\n";
+				}
+				out += series_.name + "_sum" + PrometheusLabels(series_.labels) + " " + std::to_string(snapshot.sum) + "\n";
+				out += series_.name + "_count" + PrometheusLabels(series_.labels) + " " + std::to_string(snapshot.count) + "\n";
+			}
+			break;
+		}
+	}
+
+	return out;
+}
+
+std::string Registry::ExportJSON()
+{
+	std::string out = "{\"time\":" + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()) + ",\"metrics\":[";
+
+	bool first = true;
+	for (auto &s : Collect())
+	{
+		auto &series_ = s.second.first;
+		auto &metric = s.second.second;
+
+		if (!first) out += ',';
+		first = false;
+
+		out += "{\"name\":\"" + series_.name + "\",\"labels\":{";
+		for (auto l = series_.labels.begin(); l != series_.labels.end(); ++l)
+		{
+			if (l != series_.labels.begin()) out += ',';
+			out += "\"" + l->first + "\":\"";
+			JSON::Screen(l->second, out);
+			out += "\"";
+		}
+		out += "},";
+
+		switch (series_.type)
+		{
+			case Type::Counter:
+				out += "\"type\":\"counter\",\"value\":" + std::to_string(std::static_pointer_cast<Counter>(metric)->Get());
+			break;
+			case Type::Gauge:
+				out += "\"type\":\"gauge\",\"value\":" + std::to_string(std::static_pointer_cast<Gauge>(metric)->Get());
+			break;
+			case Type::Histogram:
+			{
+				auto snapshot = std::static_pointer_cast<Histogram>(metric)->GetSnapshot();
+
+				out += "\"type\":\"histogram\",\"count\":" + std::to_string(snapshot.count) +
+					",\"sum\":" + std::to_string(snapshot.sum) +
+					",\"max\":" + std::to_string(snapshot.max) +
+					",\"p50\":" + std::to_string(snapshot.GetPercentile(50)) +
+					",\"p95\":" + std::to_string(snapshot.GetPercentile(95)) +
+					",\"p99\":" + std::to_string(snapshot.GetPercentile(99));
+			}
+			break;
+		}
+		out += "}";
+	}
+	out += "]}";
+
+	return out;
+}
+
+Labels StreamLabels(std::string_view kind, uint32_t ssrc)
+{
+	return Labels{ { "kind", std::string(kind) }, { "ssrc", std::to_string(ssrc) } };
+}
+
+}
+
+}
@@ -0,0 +1,124 @@
+/**
+ * Metrics.h - Contains the registry of the operational metrics
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include <Common/Histogram.h>
+
+namespace Common
+{
+
+namespace Metrics
+{
+
+/// The series of the metric, like { "ssrc", "12345" }, { "device", "7" }
+typedef std::map<std::string, std::string> Labels;
+
+/// Only grows
+class Counter
+{
+public:
+	void Add(uint64_t value = 1)
+	{
+		count.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	uint64_t Get() const
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> count{ 0 };
+};
+
+/// Current value, the depth of the queue, the interval, etc.
+class Gauge
+{
+public:
+	void Set(int64_t value_)
+	{
+		value.store(value_, std::memory_order_relaxed);
+	}
+
+	void Add(int64_t delta)
+	{
+		value.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	int64_t Get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> value{ 0 };
+};
+
+/// Distribution of the values (the time of the encoding in microseconds, the sizes, ...)
+typedef Common::Histogram Histogram;
+
+/// The process wide set of the metrics.
+/// The registry doesn't own the metrics, the series disappears from the export together with its stream
+class Registry
+{
+public:
+	static Registry &Instance();
+
+	/// The same object is returned for the same name and labels while somebody holds it
+	std::shared_ptr<Counter> GetCounter(std::string_view name, std::string_view help, const Labels &labels = Labels());
+	std::shared_ptr<Gauge> GetGauge(std::string_view name, std::string_view help, const Labels &labels = Labels());
+	std::shared_ptr<Histogram> GetHistogram(std::string_view name, std::string_view help, const Labels &labels = Labels());
+
+	/// Prometheus text exposition format 0.0.4
+	std::string ExportPrometheus();
+
+	/// { "time": ..., "metrics": [ { "name": ..., "type": ..., "labels": { }, "value": ... }, ... ] }
+	std::string ExportJSON();
+
+private:
+	enum class Type
+	{
+		Counter,
+		Gauge,
+		Histogram
+	};
+
+	struct Series
+	{
+		std::string name, help;
+		Type type;
+		Labels labels;
+		std::weak_ptr<void> metric;
+	};
+
+	std::mutex mutex;
+	std::map<std::string, Series> series; /// By the name and the labels, so the series of one metric go together
+
+	Registry();
+
+	template <typename T>
+	std::shared_ptr<T> Get(std::string_view name, std::string_view help, const Labels &labels, Type type);
+
+	/// Copy of the live series, the expired ones are erased
+	std::map<std::string, std::pair<Series, std::shared_ptr<void>>> Collect();
+};
+
+/// Labels of the media stream
+Labels StreamLabels(std::string_view kind, uint32_t ssrc);
+
+}
+
+}
@@ -0,0 +1,302 @@
+/**
+ * MetricsServer.cpp - Contains the local endpoint of the metrics impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Common/MetricsServer.h>
+#include <Common/Metrics.h>
+
+#include <boost/asio.hpp>
+
+#include <fstream>
+#include <cstdio>
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+#include <sys/stat.h>
+#endif
+
+namespace Common
+{
+
+template <typename Protocol>
+class metrics_session : public std::enable_shared_from_this<metrics_session<Protocol>>
+{
+    typename Protocol::socket socket_;
+    boost::asio::streambuf request_;
+    std::string response_;
+
+public:
+    metrics_session(boost::asio::io_context &io_context)
+        : socket_(io_context), request_(MAX_REQUEST), response_()
+    {
+    }
+
+    typename Protocol::socket &socket()
+    {
+        return socket_;
+    }
+
+    void start()
+    {
+        auto self = this->shared_from_this();
+        boost::asio::async_read_until(socket_, request_, "\r\n\r\n",
+            [self](const boost::system::error_code &error, size_t) { self->handle_read(error); });
+    }
+
+private:
+    static const size_t MAX_REQUEST = 8192;
+
+    void handle_read(const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            return;
+        }
+
+        std::string line;
+        std::istream stream(&request_);
+        std::getline(stream, line);
+
+        std::string method, target;
+        auto space = line.find(' ');
+        if (space != std::string::npos)
+        {
+            method = line.substr(0, space);
+            auto space_ = line.find(' ', space + 1);
+            target = line.substr(space + 1, space_ != std::string::npos ? space_ - space - 1 : std::string::npos);
+        }
+
+        if (method != "GET")
+        {
+            respond("405 Method Not Allowed", "text/plain", "");
+        }
+        else if (target == "/metrics")
+        {
+            respond("200 OK", "text/plain; version=0.0.4", Metrics::Registry::Instance().ExportPrometheus());
+        }
+        else if (target == "/metrics.json")
+        {
+            respond("200 OK", "application/json", Metrics::Registry::Instance().ExportJSON());
+        }
+        else
+        {
+            respond("404 Not Found", "text/plain", "");
+        }
+    }
+
+    void respond(std::string_view status, std::string_view contentType, const std::string &body)
+    {
+        response_ = "HTTP/1.1 " + std::string(status) + "\r\n"
+            "Content-Type: " + std::string(contentType) + "\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+
+        auto self = this->shared_from_this();
+        boost::asio::async_write(socket_, boost::asio::buffer(response_),
+            [self](const boost::system::error_code &, size_t)
+            {
+                boost::system::error_code error_;
+                self->socket_.shutdown(Protocol::socket::shutdown_both, error_);
+                self->socket_.close(error_);
+            });
+    }
+};
+
+class metrics_listener
+{
+public:
+    virtual ~metrics_listener() {}
+};
+
+template <typename Protocol>
+class metrics_acceptor : public metrics_listener
+{
+public:
+    metrics_acceptor(boost::asio::io_context &io_context, const typename Protocol::endpoint &endpoint)
+        : io_context_(io_context), acceptor_(io_context, endpoint)
+    {
+        start_accept();
+    }
+
+private:
+    boost::asio::io_context &io_context_;
+    typename Protocol::acceptor acceptor_;
+
+    void start_accept()
+    {
+        auto session = std::make_shared<metrics_session<Protocol>>(io_context_);
+        acceptor_.async_accept(session->socket(),
+            [this, session](const boost::system::error_code &error)
+            {
+                if (error == boost::asio::error::operation_aborted)
+                {
+                    return;
+                }
+                if (!error)
+                {
+                    session->start();
+                }
+                start_accept();
+            });
+    }
+};
+
+MetricsServer::MetricsServer()
+    : io_context(),
+    listener(),
+    thread(),
+    unixPath(),
+    dumpPath(),
+    dumpInterval(0),
+    dumpMutex(),
+    dumpCV(),
+    dumpRunned(false),
+    dumpThread(),
+    sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    Stop();
+}
+
+bool MetricsServer::Start(std::string_view endpoint)
+{
+    if (listener || endpoint.empty())
+    {
+        return false;
+    }
+
+    try
+    {
+        io_context = std::make_unique<boost::asio::io_context>();
+
+        if (endpoint.find_first_not_of("0123456789") == std::string::npos)
+        {
+            using boost::asio::ip::tcp;
+            tcp::endpoint endpoint_(boost::asio::ip::address_v4::loopback(), static_cast<uint16_t>(std::stoi(std::string(endpoint))));
+            listener = std::make_unique<metrics_acceptor<tcp>>(*io_context, endpoint_);
+        }
+        else
+        {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+            using boost::asio::local::stream_protocol;
+            const std::string path(endpoint);
+
+            struct stat st = {};
+            if (stat(path.c_str(), &st) == 0)
+            {
+                boost::system::error_code ec;
+                if (S_ISSOCK(st.st_mode))
+                {
+                    stream_protocol::socket probe(*io_context);
+                    probe.connect(stream_protocol::endpoint(path), ec);
+                }
+                if (!S_ISSOCK(st.st_mode) || !ec)
+                {
+                    if (errLog) errLog->error("MetricsServer :: The endpoint {0} is taken by another file or a running process", endpoint);
+                    io_context.reset(nullptr);
+                    return false;
+                }
+                std::remove(path.c_str()); /// Nobody listens, left by the crashed process
+            }
+
+            listener = std::make_unique<metrics_acceptor<stream_protocol>>(*io_context, stream_protocol::endpoint(path));
+            unixPath = path;
+#else
+            if (errLog) errLog->error("MetricsServer :: Unix sockets are not supported, endpoint: {0}", endpoint);
+            io_context.reset(nullptr);
+            return false;
+#endif
+        }
+
+        thread = std::thread([this]() { io_context->run(); });
+
+        if (sysLog) sysLog->info("MetricsServer :: Started on {0}", endpoint);
+
+        return true;
+    }
+    catch (std::exception &e)
+    {
+        if (errLog) errLog->critical("MetricsServer :: Start on {0} error: {1}", endpoint, e.what());
+    }
+
+    listener.reset(nullptr);
+    io_context.reset(nullptr);
+
+    return false;
+}
+
+void MetricsServer::StartDump(std::string_view path, std::chrono::milliseconds interval)
+{
+    if (dumpRunned || path.empty() || interval.count() <= 0)
+    {
+        return;
+    }
+
+    dumpPath = std::string(path);
+    dumpInterval = interval;
+    dumpRunned = true;
+    dumpThread = std::thread([this]()
+    {
+        std::unique_lock<std::mutex> lock(dumpMutex);
+        while (dumpRunned)
+        {
+            dumpCV.wait_for(lock, dumpInterval);
+            Dump();
+        }
+    });
+}
+
+void MetricsServer::Stop()
+{
+    if (listener)
+    {
+        io_context->stop();
+        thread.join();
+
+        listener.reset(nullptr);
+        io_context.reset(nullptr);
+
+        if (!unixPath.empty())
+        {
+            std::remove(unixPath.c_str());
+            unixPath.clear();
+        }
+    }
+
+    if (dumpThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(dumpMutex);
+            dumpRunned = false;
+        }
+        dumpCV.notify_one();
+        dumpThread.join();
+    }
+}
+
+void MetricsServer::Dump()
+{
+    /// The reader never sees the half written file
+    auto tmpPath = dumpPath + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file)
+        {
+            if (errLog) errLog->error("MetricsServer :: Can't write the dump to {0}", tmpPath);
+            return;
+        }
+        file << Metrics::Registry::Instance().ExportJSON() << std::endl;
+    }
+
+#ifdef _WIN32
+    std::remove(dumpPath.c_str());
+#endif
+    std::rename(tmpPath.c_str(), dumpPath.c_str());
+}
+
+}
@@ -0,0 +1,61 @@
+/**
+ * MetricsServer.h - Contains the local endpoint of the metrics
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+namespace boost { namespace asio { class io_context; } }
+
+namespace Common
+{
+
+class metrics_listener;
+
+/// Exposes the registry's snapshots:
+/// GET /metrics - Prometheus text, GET /metrics.json - JSON, on the loopback port or the Unix socket,
+/// and the periodic JSON dumps to the file, rewritten atomically
+class MetricsServer
+{
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    /// endpoint is the port ("9100", bound to 127.0.0.1 only) or the path of the Unix socket ("/tmp/client.metrics")
+    bool Start(std::string_view endpoint);
+
+    /// Writes the snapshot to the path each interval, zero interval disables the dumps
+    void StartDump(std::string_view path, std::chrono::milliseconds interval);
+
+    void Stop();
+
+private:
+    std::unique_ptr<boost::asio::io_context> io_context;
+    std::unique_ptr<metrics_listener> listener;
+    std::thread thread;
+    std::string unixPath;
+
+    std::string dumpPath;
+    std::chrono::milliseconds dumpInterval;
+    std::mutex dumpMutex;
+    std::condition_variable dumpCV;
+    bool dumpRunned;
+    std::thread dumpThread;
+
+    std::shared_ptr<spdlog::logger> sysLog, errLog;
+
+    void Dump();
+};
+
+}
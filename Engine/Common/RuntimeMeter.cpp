@@ -18,34 +18,40 @@ namespace Common
 RuntimeMeter::RuntimeMeter(int64_t triggerMS_,
 	std::function<void(int64_t)> callback_,
 	Transport::ISocket &receiver_)
-	: triggerMS(triggerMS_), callback(callback_), receiver(receiver_), statMeter(50)
+	: triggerMS(triggerMS_), callback(callback_), receiver(receiver_), runtimes()
 {
 }
 
 void RuntimeMeter::Send(const Transport::IPacket& packet_, const Transport::Address*)
 {
-	auto start = std::chrono::high_resolution_clock::now();
+	auto start = std::chrono::steady_clock::now();
 
 	receiver.Send(packet_);
 
-	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 
-	if (duration == 0)
+	if (duration < 1000) /// The packets not leading to the work (not completed frames) are not counted
 	{
 		return;
 	}
 
-	statMeter.PushVal(duration);
+	runtimes.Record(static_cast<uint64_t>(duration));
 
 	//subtle_trace("statmeter duration: ", duration);
 
-	if (statMeter.GetFill() == 40 && statMeter.GetAvg() > triggerMS)
+	if (runtimes.GetCount() == 40)
 	{
-		//subtle_trace("statmeter triggered, avg: ", statMeter.GetAvg());
+		auto snapshot = runtimes.GetSnapshot();
+		runtimes.Clear();
 
-		statMeter.Clear();
-		
-		callback(duration);
+		auto median = static_cast<int64_t>(snapshot.GetPercentile(50) / 1000), tail = static_cast<int64_t>(snapshot.GetPercentile(95) / 1000);
+
+		//subtle_trace("statmeter median: ", median);
+
+		if (median > triggerMS || tail > triggerMS * 2)
+		{
+			callback(tail);
+		}
 	}
 }
 
@@ -8,7 +8,7 @@
 #pragma once
 
 #include <Transport/ISocket.h>
-#include <Common/StatMeter.h>
+#include <Common/Histogram.h>
 #include <functional>
 
 namespace Common
@@ -17,6 +17,8 @@ namespace Common
 class RuntimeMeter : public Transport::ISocket
 {
 public:
+	/// The callback is called with the 95th percentile (ms) when the median of the runtimes exceeds the trigger
+	/// or the tail exceeds the twice of the trigger
 	RuntimeMeter(int64_t triggerMS,
 		std::function<void(int64_t)> callback,
 		Transport::ISocket &receiver);
@@ -28,7 +30,7 @@ private:
 	std::function<void(int64_t)> callback;
 	Transport::ISocket& receiver;
 
-	StatMeter statMeter;
+	Histogram runtimes; /// Microseconds
 };
 
 }
@@ -7,56 +7,63 @@
 
 #include <Common/StatMeter.h>
 
+#include <algorithm>
+
 namespace Common
 {
 
 StatMeter::StatMeter(size_t size_)
-    : vals(), size(size_)
+    : size(std::max<size_t>(size_, 1)), generations(), current(0)
 {
 }
 
 void StatMeter::PushVal(int64_t val)
 {
-    vals.push_front(val);
+    auto current_ = current.load(std::memory_order_acquire);
+
+    generations[current_].Record(val > 0 ? static_cast<uint64_t>(val) : 0);
 
-    if (vals.size() > size) vals.pop_back();
+    if (generations[current_].GetCount() >= size &&
+        current.compare_exchange_strong(current_, current_ ^ 1, std::memory_order_acq_rel))
+    {
+        generations[current_ ^ 1].Clear(); /// The oldest generation goes away
+    }
 }
 
 void StatMeter::Clear()
 {
-    vals.clear();
+    generations[0].Clear();
+    generations[1].Clear();
 }
 
-int64_t StatMeter::GetMax() const
+Histogram::Snapshot StatMeter::GetSnapshot() const
 {
-    int64_t max_ = 0;
-
-    for (auto v : vals)
-    {
-        if (v > max_)
-        {
-            max_ = v;
-        }
-    }
+    auto snapshot = generations[0].GetSnapshot();
+    snapshot.Merge(generations[1].GetSnapshot());
+    return snapshot;
+}
 
-    return max_;
+int64_t StatMeter::GetMax() const
+{
+    return static_cast<int64_t>(GetSnapshot().max);
 }
 
 int64_t StatMeter::GetAvg() const
 {
-    int64_t summ_ = 0;
+    auto count = generations[0].GetCount() + generations[1].GetCount();
+    auto sum = generations[0].GetSum() + generations[1].GetSum();
 
-    for (auto v : vals)
-    {
-        summ_ += v;
-    }
+    return count != 0 ? static_cast<int64_t>((double)sum / count) : 0;
+}
 
-    return vals.size() != 0 ? static_cast<int64_t>((double)summ_ / vals.size()) : 0;
+int64_t StatMeter::GetPercentile(double p) const
+{
+    return static_cast<int64_t>(GetSnapshot().GetPercentile(p));
 }
 
 size_t StatMeter::GetFill() const
 {
-    return vals.size();
+    return std::min<size_t>(generations[0].GetCount() + generations[1].GetCount(), size);
 }
 
 }
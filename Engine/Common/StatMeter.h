@@ -7,28 +7,38 @@
 
 #pragma once
 
-#include <deque>
+#include <cstddef>
 #include <cstdint>
+#include <atomic>
+
+#include <Common/Histogram.h>
 
 namespace Common
 {
 
+/// Statistics of the last values, made of two generations of the histogram,
+/// so the window is the last size to 2 * size values and the push is O(1)
 class StatMeter
 {
 public:
 	StatMeter(size_t size);
 
-	void PushVal(int64_t val);
+	void PushVal(int64_t val); /// The negative values are counted as zero
 
 	void Clear();
 
 	int64_t GetMax() const;
 	int64_t GetAvg() const;
+	int64_t GetPercentile(double p) const;
+
+	Histogram::Snapshot GetSnapshot() const;
 
 	size_t GetFill() const;
 private:
-	std::deque<int64_t> vals;
 	size_t size;
+
+	Histogram generations[2];
+	std::atomic<uint32_t> current;
 };
 
 }
@@ -31,13 +31,13 @@ public:
 
 	void Reset()
 	{
-		clock_gettime(CLOCK_REALTIME, &startTime);
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
 	}
 
 	uint64_t Measure() /// microseconds
 	{
 		struct timespec now;
-		clock_gettime(CLOCK_REALTIME, &now);
+		clock_gettime(CLOCK_MONOTONIC, &now);
 
 		long long measure = ((now.tv_sec * 1000000) + (now.tv_nsec / 1000)) - ((startTime.tv_sec * 1000000) + (startTime.tv_nsec / 1000));
 
@@ -0,0 +1,250 @@
+/**
+ * Trace.cpp - Contains the per frame tracing of the media pipeline impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Common/Trace.h>
+
+#include <Transport/RTP/RTPPayloadType.h>
+
+#include <spdlog/details/os.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+namespace Common
+{
+namespace Trace
+{
+
+std::atomic_bool enabled(false);
+
+namespace
+{
+
+struct Event
+{
+	uint64_t begin;
+	uint32_t duration, ssrc, frame;
+	Stage stage;
+	Kind kind;
+};
+
+/// Written by the owner thread only, the exporter skips the events overwritten while copying
+struct ThreadBuffer
+{
+	uint32_t session;
+	size_t tid;
+	uint32_t capacity;
+	std::unique_ptr<Event[]> events;
+	std::atomic<uint64_t> head;
+
+	ThreadBuffer(uint32_t session_, uint32_t capacity_)
+		: session(session_),
+		tid(spdlog::details::os::thread_id()),
+		capacity(capacity_),
+		events(new Event[capacity_]),
+		head(0)
+	{
+	}
+};
+
+std::mutex mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+std::atomic<uint32_t> session(0), capacity(1 << 16);
+std::atomic<int64_t> wallClockOffset(0);
+
+thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+
+std::shared_ptr<ThreadBuffer> Register(uint32_t session_)
+{
+	auto buffer = std::make_shared<ThreadBuffer>(session_, capacity.load(std::memory_order_relaxed));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	buffers.emplace_back(buffer);
+
+	return buffer;
+}
+
+}
+
+std::string_view to_string(Stage stage)
+{
+	switch (stage)
+	{
+		case Stage::Capture: return "capture";
+		case Stage::Convert: return "convert";
+		case Stage::Encode: return "encode";
+		case Stage::Split: return "split";
+		case Stage::Encrypt: return "encrypt";
+		case Stage::Send: return "send";
+		case Stage::Receive: return "receive";
+		case Stage::Decrypt: return "decrypt";
+		case Stage::Collect: return "collect";
+		case Stage::Decode: return "decode";
+		case Stage::Resize: return "resize";
+		case Stage::JBWait: return "jb_wait";
+		case Stage::Draw: return "draw";
+		case Stage::Play: return "play";
+	}
+	return "";
+}
+
+std::string_view to_string(Kind kind)
+{
+	return kind == Kind::Audio ? "audio" : "video";
+}
+
+Kind GetKind(uint8_t payloadType)
+{
+	switch (static_cast<Transport::RTPPayloadType>(payloadType))
+	{
+		case Transport::RTPPayloadType::ptOpus: case Transport::RTPPayloadType::ptPCM:
+			return Kind::Audio;
+		default:
+			return Kind::Video;
+	}
+}
+
+void Start(uint32_t eventsPerThread)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers.clear();
+	}
+
+	capacity = eventsPerThread != 0 ? eventsPerThread : 1;
+	wallClockOffset = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - static_cast<int64_t>(Now());
+	session.fetch_add(1, std::memory_order_release);
+
+	enabled = true;
+}
+
+void Stop()
+{
+	enabled = false;
+}
+
+uint64_t Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Record(Stage stage, Kind kind, uint32_t ssrc, uint32_t frame, uint64_t begin, uint64_t end)
+{
+	if (!Enabled())
+	{
+		return;
+	}
+
+	auto &buffer = threadBuffer;
+	const auto session_ = session.load(std::memory_order_acquire);
+	if (!buffer || buffer->session != session_)
+	{
+		buffer = Register(session_);
+	}
+
+	const auto head = buffer->head.load(std::memory_order_relaxed);
+	buffer->events[head % buffer->capacity] = Event{ begin, static_cast<uint32_t>(end > begin ? end - begin : 0), ssrc, frame, stage, kind };
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+std::string ExportJSON()
+{
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers_ = buffers;
+	}
+
+	const auto session_ = session.load(std::memory_order_acquire);
+	const auto offset = wallClockOffset.load();
+	const auto pid = std::to_string(spdlog::details::os::pid());
+
+	std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+	std::vector<Event> events;
+	for (auto &buffer : buffers_)
+	{
+		if (buffer->session != session_)
+		{
+			continue;
+		}
+
+		const auto head = buffer->head.load(std::memory_order_acquire);
+		const auto from = head > buffer->capacity ? head - buffer->capacity : 0;
+
+		events.clear();
+		for (auto i = from; i != head; ++i)
+		{
+			events.emplace_back(buffer->events[i % buffer->capacity]);
+		}
+
+		/// The owner could overwrite the oldest events while they were copied
+		const auto headAfter = buffer->head.load(std::memory_order_acquire);
+		const auto valid = headAfter > buffer->capacity ? headAfter - buffer->capacity : 0;
+
+		const auto tid = std::to_string(buffer->tid);
+		for (auto i = std::max(from, valid); i < head; ++i)
+		{
+			const auto &e = events[i - from];
+
+			if (!first) out += ',';
+			first = false;
+
+			out += "{\"name\":\"" + std::string(to_string(e.stage)) +
+				"\",\"cat\":\"" + std::string(to_string(e.kind)) +
+				"\",\"ph\":\"X\",\"ts\":" + std::to_string(static_cast<int64_t>(e.begin) + offset) +
+				",\"dur\":" + std::to_string(e.duration) +
+				",\"pid\":" + pid +
+				",\"tid\":" + tid +
+				",\"args\":{\"ssrc\":" + std::to_string(e.ssrc) + ",\"frame\":" + std::to_string(e.frame) + "}}";
+		}
+	}
+	out += "]}";
+
+	return out;
+}
+
+bool Export(std::string_view path)
+{
+	std::ofstream file(std::string(path), std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << ExportJSON();
+
+	return file.good();
+}
+
+Span::Span(Stage stage_, Kind kind_, uint32_t ssrc_, uint32_t frame_)
+	: stage(stage_), kind(kind_), ssrc(ssrc_), frame(frame_), begin(Enabled() ? Now() : 0)
+{
+}
+
+Span::~Span()
+{
+	End();
+}
+
+void Span::End()
+{
+	if (begin != 0)
+	{
+		Record(stage, kind, ssrc, frame, begin, Now());
+		begin = 0;
+	}
+}
+
+}
+}
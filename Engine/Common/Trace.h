@@ -0,0 +1,92 @@
+/**
+ * Trace.h - Contains the per frame tracing of the media pipeline
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+namespace Common
+{
+namespace Trace
+{
+
+/// The stages of the pipeline, from the camera / microphone to the screen / speaker
+enum class Stage : uint8_t
+{
+	Capture,
+	Convert,
+	Encode,
+	Split,
+	Encrypt,
+	Send,
+	Receive,
+	Decrypt,
+	Collect,
+	Decode,
+	Resize,
+	JBWait,
+	Draw,
+	Play
+};
+
+enum class Kind : uint8_t
+{
+	Audio,
+	Video
+};
+
+std::string_view to_string(Stage stage);
+std::string_view to_string(Kind kind);
+
+/// The audio payloads are Opus and PCM, all others are the video
+Kind GetKind(uint8_t payloadType);
+
+/// Starts the new session of the recording, the spans of the previous one are dropped.
+/// Each thread writes own ring buffer of the eventsPerThread spans, the oldest spans are overwritten
+void Start(uint32_t eventsPerThread = 1 << 16);
+void Stop();
+
+extern std::atomic_bool enabled;
+
+inline bool Enabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/// Microseconds of the monotonic clock
+uint64_t Now();
+
+/// frame is the rtpHeader.ts given by the capturer, it's kept by all the stages, so the spans of the frame
+/// can be found on both sides. Lock-free, only the first call on the thread registers the thread's buffer
+void Record(Stage stage, Kind kind, uint32_t ssrc, uint32_t frame, uint64_t begin, uint64_t end);
+
+/// Chrome Trace Event format (chrome://tracing, ui.perfetto.dev), the times are shifted to the wall clock,
+/// so the traces of the sender and the receiver having the synchronized clocks can be opened together
+std::string ExportJSON();
+bool Export(std::string_view path);
+
+/// Measures the scope or the part of the scope until End(), does nothing if the tracing is disabled
+class Span
+{
+public:
+	Span(Stage stage, Kind kind, uint32_t ssrc, uint32_t frame);
+	~Span();
+
+	void End();
+
+private:
+	Stage stage;
+	Kind kind;
+	uint32_t ssrc, frame;
+	uint64_t begin;
+};
+
+}
+}
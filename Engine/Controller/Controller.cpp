@@ -12,6 +12,8 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <wui/config/config.hpp>
+
 #include <Version.h>
 
 #include <Common/BitHelpers.h>
@@ -125,6 +127,8 @@ Controller::Controller(Storage::Storage &storage_, IMemberList &memberList_)
     callStart(0),
     currentConference(),
     subscriberId(0),
+    workQueue(),
+    workersCount(0),
     baseURL(),
     webSocket(std::bind(&Controller::OnWebSocket, this, std::placeholders::_1, std::placeholders::_2)),
     serverAddress(), secureConnection(false),
@@ -145,6 +149,8 @@ Controller::~Controller()
 {
     Disconnect();
 
+    workQueue.Stop();
+
     if (updater.joinable()) updater.join();
 }
 
@@ -183,6 +189,23 @@ void Controller::Connect(std::string_view serverAddress_, bool secureConnection_
 
     baseURL = (secureConnection ? std::string("https://") : std::string("http://")) + serverAddress;
 
+    /// The first worker is for the session lane only, the lists share the rest
+    if (workersCount == 0)
+    {
+        workersCount = static_cast<uint32_t>(std::max(wui::config::get_int("Controller", "Workers", 2), 1));
+        workQueue.Start(workersCount);
+    }
+
+    /// The lists of the contacts, the conferences and the messages are big JSONs, compress them.
+    /// The media sockets (WSM) stay uncompressed, their payload is already compressed by the codecs
+    Transport::WSDeflate deflate;
+    deflate.enabled = wui::config::get_int("Connection", "Deflate", 1) != 0;
+    deflate.windowBits = wui::config::get_int("Connection", "DeflateWindowBits", 15);
+    deflate.memLevel = wui::config::get_int("Connection", "DeflateMemLevel", 4);
+    deflate.threshold = wui::config::get_int("Connection", "DeflateThreshold", 1024);
+    deflate.contextTakeover = wui::config::get_int("Connection", "DeflateContextTakeover", 1) != 0;
+    webSocket.SetDeflate(deflate);
+
     webSocket.Connect(baseURL);
 }
 
@@ -626,13 +649,15 @@ Proto::Conference &Controller::GetCurrentConference()
 
 void Controller::OnWebSocket(Transport::WSMethod method, std::string_view message)
 {
+    /// Runned on the WebSocket thread, which has to be free for the next messages,
+    /// so only the lane is chosen here and the rest is made by the work queue
     switch (method)
     {
         case Transport::WSMethod::Open:
         {
             sysLog->info("Controller :: Connection to server established");
 
-            Logon();
+            Post(Lane::Session, [this]() { Logon(); });
         }
         break;
         case Transport::WSMethod::Message:
@@ -640,790 +665,844 @@ void Controller::OnWebSocket(Transport::WSMethod method, std::string_view messag
             //sysLog->trace("Controller::WebSocket recv message: {0}", message);
 
             auto commandType = Proto::GetCommandType(message);
-            switch (commandType)
+            if (commandType == Proto::CommandType::Ping)
             {
-                case Proto::CommandType::ConnectResponse:
-                {
-                    Proto::CONNECT_RESPONSE::Command cmd;
-                    cmd.Parse(message);
+                SendCommand(Proto::PING::Command().Serialize()); /// Without waiting for the queue
+            }
 
-                    switch (cmd.result)
+            Post(GetLane(commandType), [this, commandType, message_ = std::string(message)]() { OnCommand(commandType, message_); });
+        }
+        break;
+        case Transport::WSMethod::Close:
+            Post(Lane::Session, [this, message_ = std::string(message)]() {
+                auto queueStats = workQueue.GetStats();
+                sysLog->info("Controller :: Work queue stats (executed: {0}, avg wait: {1} us, max wait: {2} us, max depth: {3})",
+                    queueStats.executed, queueStats.avgWait, queueStats.maxWait, queueStats.maxDepth);
+
+                sysLog->info("Controller :: WebSocket closed (message: \"{0}\", reason: {1})", message_, toString(disconnectReason));
+                switch (disconnectReason)
+                {
+                    case DisconnectReason::NetworkError: case DisconnectReason::Redirected:
+                        eventHandler(Event(Event::Type::Disconnected));
+                    break;
+                    case DisconnectReason::AuthNeeded:
                     {
-                        case Proto::CONNECT_RESPONSE::Result::OK:
-                            if (cmd.server_version < SERVER_VERSION)
-                            {
-                                ChangeState(State::ServerError);
-                                errLog->critical("Controller :: Server version is outdated\n");
-                                return Disconnect(DisconnectReason::ServerOutdated);
-                            }
+                        Event event_;
+                        event_.type = Event::Type::AuthNeeded;
+                        event_.iData = 2;
+                        eventHandler(event_);
+                    }
+                    break;
+                    case DisconnectReason::InvalidCredentionals:
+                    {
+                        Event event_;
+                        event_.type = Event::Type::AuthNeeded;
+                        event_.iData = 1;
+                        eventHandler(event_);
+                    }
+                    break;
+                    case DisconnectReason::UpdateRequired:
+                        eventHandler(Event(Event::Type::UpdateRequired));
+                    break;
+                    case DisconnectReason::ServerOutdated:
+                        eventHandler(Event(Event::Type::ServerOutdated));
+                    break;
+                    case DisconnectReason::ServerFull:
+                        eventHandler(Event(Event::Type::ServerFull));
+                    break;
+                    case DisconnectReason::InternalServerError:
+                        eventHandler(Event(Event::Type::ServerInternalError));
+                    break;
+                    default:
+                    break;
+                }
+                disconnectReason = DisconnectReason::NetworkError;
+            });
+        break;
+        case Transport::WSMethod::Error:
+            errLog->critical("Controller :: WebSocket error (message: \"{0}\")", message);
 
-                            if (!secureConnection && !cmd.secure_key.empty())
-                            {
-                                secureConnection = true;
-                                
-                                Event event_;
-                                event_.type = Event::Type::ServerChanged;
-                                event_.data = serverAddress;
-                                event_.iData = secureConnection ? 1 : 0;
-                                eventHandler(event_);
-
-                                return Disconnect(DisconnectReason::Redirected);
-                            }
-                            else if (secureConnection == 1 && cmd.secure_key.empty())
-                            {
-                                secureConnection = false;
-                                
-                                Event event_;
-                                event_.type = Event::Type::ServerChanged;
-                                event_.data = serverAddress;
-                                event_.iData = secureConnection ? 1 : 0;
-                                eventHandler(event_);
-
-                                return Disconnect(DisconnectReason::Redirected);
-                            }
+            /// The pause before the reconnection holds only the session lane
+            Post(Lane::Session, [this]() { eventHandler(Event(Event::Type::NetworkError)); }, std::chrono::milliseconds(500));
+        break;
+    }
+}
 
-                            clientId = cmd.id;
-                            connectionId = cmd.connection_id;
-                            accessToken = cmd.access_token;
-                            clientName = cmd.name;
-                            secureKey = cmd.secure_key;
-                            serverName = cmd.server_name;
-                            grants = cmd.grants;
-                            maxOutputBitrate = cmd.max_output_bitrate;
-                            
-                            ChangeState(State::Ready);
-
-                            eventHandler(Event(Event::Type::LogonSuccess));
-                        break;
-                        case Proto::CONNECT_RESPONSE::Result::InvalidCredentials:
-                        {
-                            ChangeState(State::CredentialsError);
-                            errLog->critical("Controller :: Credentials error in connecting to server\n");
-                            Disconnect(DisconnectReason::InvalidCredentionals);
-                        }
-                        break;
-                        case Proto::CONNECT_RESPONSE::Result::UpdateRequired:
-                            ChangeState(State::UpdateRequired);
-                            sysLog->critical("Controller :: Update required\n");
-                            Disconnect(DisconnectReason::UpdateRequired);
-                        break;
-                        case Proto::CONNECT_RESPONSE::Result::Redirect:
-                        {
-                            std::string proto, host, port;
-                            Transport::ParseURI(cmd.redirect_url, proto, host, port);
-                            if (!proto.empty())
-                            {
-                                serverAddress = host + ":" + port;
-                                secureConnection = proto == "https";
-                                
-                                Event event_;
-                                event_.type = Event::Type::ServerChanged;
-                                event_.data = serverAddress;
-                                event_.iData = secureConnection ? 1 : 0;
-                                eventHandler(event_);
-
-                                return Disconnect(DisconnectReason::Redirected);;
-                            }
-                            else
-                            {
-                                ChangeState(State::ServerError);
-                                errLog->critical("Controller :: Server sent incorrect redirect URL\n");
-                                return Disconnect(DisconnectReason::InternalServerError);
-                            }
-                        }
-                        break;
-                        case Proto::CONNECT_RESPONSE::Result::ServerFull:
-                            ChangeState(State::ServerError);
-                            sysLog->critical("Controller :: Server full\n");
-                            Disconnect(DisconnectReason::ServerFull);
-                        break;
-                        case Proto::CONNECT_RESPONSE::Result::InternalServerError:
-                            ChangeState(State::ServerError);
-                            sysLog->critical("Controller :: Internal server error\n");
-                            Disconnect(DisconnectReason::InternalServerError);
-                        break;
+void Controller::OnCommand(Proto::CommandType commandType, std::string_view message)
+{
+    switch (commandType)
+    {
+        case Proto::CommandType::ConnectResponse:
+        {
+            Proto::CONNECT_RESPONSE::Command cmd;
+            cmd.Parse(message);
+
+            switch (cmd.result)
+            {
+                case Proto::CONNECT_RESPONSE::Result::OK:
+                    if (cmd.server_version < SERVER_VERSION)
+                    {
+                        ChangeState(State::ServerError);
+                        errLog->critical("Controller :: Server version is outdated\n");
+                        return Disconnect(DisconnectReason::ServerOutdated);
                     }
-                }
-                break;
-                case Proto::CommandType::UserUpdateResponse:
-                {
-                    Proto::USER_UPDATE_RESPONSE::Command cmd;
-                    cmd.Parse(message);
 
-                    Event event_;
-                    event_.type = Event::Type::UserUpdateResponse;
-                    event_.deviceValues.pos = static_cast<int32_t>(cmd.action);
-                    event_.deviceValues.clientId = cmd.user_id;
-                    event_.iData = static_cast<int32_t>(cmd.result);
-                    event_.data = cmd.message;
+                    if (!secureConnection && !cmd.secure_key.empty())
+                    {
+                        secureConnection = true;
+                        
+                        Event event_;
+                        event_.type = Event::Type::ServerChanged;
+                        event_.data = serverAddress;
+                        event_.iData = secureConnection ? 1 : 0;
+                        eventHandler(event_);
 
-                    eventHandler(event_);
-                }
-                break;
-                case Proto::CommandType::UpdateGrants:
-                {
-                    Proto::UPDATE_GRANTS::Command cmd;
-                    cmd.Parse(message);
+                        return Disconnect(DisconnectReason::Redirected);
+                    }
+                    else if (secureConnection == 1 && cmd.secure_key.empty())
+                    {
+                        secureConnection = false;
+                        
+                        Event event_;
+                        event_.type = Event::Type::ServerChanged;
+                        event_.data = serverAddress;
+                        event_.iData = secureConnection ? 1 : 0;
+                        eventHandler(event_);
 
-                    grants = cmd.grants;
+                        return Disconnect(DisconnectReason::Redirected);
+                    }
 
-                    Event event_;
-                    event_.type = Event::Type::GrantsUpdated;
-                    event_.iData = grants;
+                    clientId = cmd.id;
+                    connectionId = cmd.connection_id;
+                    accessToken = cmd.access_token;
+                    clientName = cmd.name;
+                    secureKey = cmd.secure_key;
+                    serverName = cmd.server_name;
+                    grants = cmd.grants;
+                    maxOutputBitrate = cmd.max_output_bitrate;
+                    
+                    ChangeState(State::Ready);
 
-                    eventHandler(event_);
-                }
+                    eventHandler(Event(Event::Type::LogonSuccess));
                 break;
-                case Proto::CommandType::DeviceParams:
+                case Proto::CONNECT_RESPONSE::Result::InvalidCredentials:
                 {
-                    Proto::DEVICE_PARAMS::Command cmd;
-                    cmd.Parse(message);
-
-                    sysLog->info("Controller :: Received device params device_type {0:d} id {1:d}", static_cast<int32_t>(cmd.device_type), cmd.id);
-
-                    Event event_;
-                    event_.type = cmd.device_type == Proto::DeviceType::Microphone ? Event::Type::MicrophoneCreated : Event::Type::CameraCreated;
-                    event_.deviceValues.deviceId = cmd.id;
-                    event_.deviceValues.authorSSRC = cmd.ssrc;
-                    event_.deviceValues.type = cmd.device_type;
-                    event_.deviceValues.pos = cmd.ord;
-                    event_.deviceValues.name = cmd.name;
-                    event_.deviceValues.metadata = cmd.metadata;
-                    event_.deviceValues.resolution = static_cast<Video::Resolution>(cmd.resolution);
-                    event_.deviceValues.colorSpace = static_cast<Video::ColorSpace>(cmd.color_space);
-                    eventHandler(event_);
+                    ChangeState(State::CredentialsError);
+                    errLog->critical("Controller :: Credentials error in connecting to server\n");
+                    Disconnect(DisconnectReason::InvalidCredentionals);
                 }
                 break;
-                case Proto::CommandType::DeviceConnect:
+                case Proto::CONNECT_RESPONSE::Result::UpdateRequired:
+                    ChangeState(State::UpdateRequired);
+                    sysLog->critical("Controller :: Update required\n");
+                    Disconnect(DisconnectReason::UpdateRequired);
+                break;
+                case Proto::CONNECT_RESPONSE::Result::Redirect:
                 {
-                    Proto::DEVICE_CONNECT::Command cmd;
-                    cmd.Parse(message);
-
-                    sysLog->info("Controller :: Received device connect (connect_type: {0:d} device_id {1:d}, client_id: {2:d})", static_cast<int32_t>(cmd.connect_type), cmd.device_id, cmd.client_id);
-
-                    switch (cmd.connect_type)
+                    std::string proto, host, port;
+                    Transport::ParseURI(cmd.redirect_url, proto, host, port);
+                    if (!proto.empty())
                     {
-                        case Proto::DEVICE_CONNECT::ConnectType::CreatedDevice:
-                        {
-                            if (cmd.address.empty() || cmd.address == "0.0.0.0" || cmd.address == "::/")
-                            {
-                                cmd.address = GetDefaultAddress(serverAddress);
-                            }
-
-                            Event event_;
-                            event_.type = cmd.device_type == Proto::DeviceType::Microphone ? Event::Type::MicrophoneStarted : Event::Type::CameraStarted;
-
-                            event_.deviceValues.type = cmd.device_type;
-                            event_.deviceValues.deviceId = cmd.device_id;
-                            event_.deviceValues.authorSSRC = cmd.author_ssrc;
-                            event_.deviceValues.colorSpace = static_cast<Video::ColorSpace>(cmd.color_space);
-                            event_.deviceValues.addr = cmd.address;
-                            event_.deviceValues.port = cmd.port;
-                            event_.deviceValues.secureKey = secureKey;
-                            eventHandler(event_);
-                        }
-                        break;
-                        case Proto::DEVICE_CONNECT::ConnectType::ConnectRenderer:
-                        {
-                            Event event_;
-                            event_.type = Event::Type::DeviceConnect;
-                            event_.deviceValues.type = cmd.device_type;
-                            event_.deviceValues.deviceId = cmd.device_id;
-                            event_.deviceValues.clientId = cmd.client_id;
-                            event_.deviceValues.metadata = cmd.metadata;
-                            event_.deviceValues.receiverSSRC = cmd.receiver_ssrc;
-                            event_.deviceValues.authorSSRC = cmd.author_ssrc;
-                            event_.deviceValues.port = cmd.port;
-                            event_.deviceValues.name = cmd.name;
-                            event_.deviceValues.resolution = (Video::Resolution)cmd.resolution;
-                            event_.deviceValues.mySource = cmd.my;
-                            event_.deviceValues.addr = cmd.address;
-                            event_.deviceValues.secureKey = cmd.secure_key;
-
-                            if (event_.deviceValues.addr.empty() || event_.deviceValues.addr == "0.0.0.0" || event_.deviceValues.addr == "::/")
-                            {
-                                event_.deviceValues.addr = GetDefaultAddress(serverAddress);
-                            }
+                        serverAddress = host + ":" + port;
+                        secureConnection = proto == "https";
+                        
+                        Event event_;
+                        event_.type = Event::Type::ServerChanged;
+                        event_.data = serverAddress;
+                        event_.iData = secureConnection ? 1 : 0;
+                        eventHandler(event_);
 
-                            eventHandler(event_);
-                        }
-                        break;
-                        default: break;
+                        return Disconnect(DisconnectReason::Redirected);;
+                    }
+                    else
+                    {
+                        ChangeState(State::ServerError);
+                        errLog->critical("Controller :: Server sent incorrect redirect URL\n");
+                        return Disconnect(DisconnectReason::InternalServerError);
                     }
                 }
                 break;
-                case Proto::CommandType::DeviceDisconnect:
+                case Proto::CONNECT_RESPONSE::Result::ServerFull:
+                    ChangeState(State::ServerError);
+                    sysLog->critical("Controller :: Server full\n");
+                    Disconnect(DisconnectReason::ServerFull);
+                break;
+                case Proto::CONNECT_RESPONSE::Result::InternalServerError:
+                    ChangeState(State::ServerError);
+                    sysLog->critical("Controller :: Internal server error\n");
+                    Disconnect(DisconnectReason::InternalServerError);
+                break;
+            }
+        }
+        break;
+        case Proto::CommandType::UserUpdateResponse:
+        {
+            Proto::USER_UPDATE_RESPONSE::Command cmd;
+            cmd.Parse(message);
+
+            Event event_;
+            event_.type = Event::Type::UserUpdateResponse;
+            event_.deviceValues.pos = static_cast<int32_t>(cmd.action);
+            event_.deviceValues.clientId = cmd.user_id;
+            event_.iData = static_cast<int32_t>(cmd.result);
+            event_.data = cmd.message;
+
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::UpdateGrants:
+        {
+            Proto::UPDATE_GRANTS::Command cmd;
+            cmd.Parse(message);
+
+            grants = cmd.grants;
+
+            Event event_;
+            event_.type = Event::Type::GrantsUpdated;
+            event_.iData = grants;
+
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::DeviceParams:
+        {
+            Proto::DEVICE_PARAMS::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received device params device_type {0:d} id {1:d}", static_cast<int32_t>(cmd.device_type), cmd.id);
+
+            Event event_;
+            event_.type = cmd.device_type == Proto::DeviceType::Microphone ? Event::Type::MicrophoneCreated : Event::Type::CameraCreated;
+            event_.deviceValues.deviceId = cmd.id;
+            event_.deviceValues.authorSSRC = cmd.ssrc;
+            event_.deviceValues.type = cmd.device_type;
+            event_.deviceValues.pos = cmd.ord;
+            event_.deviceValues.name = cmd.name;
+            event_.deviceValues.metadata = cmd.metadata;
+            event_.deviceValues.resolution = static_cast<Video::Resolution>(cmd.resolution);
+            event_.deviceValues.colorSpace = static_cast<Video::ColorSpace>(cmd.color_space);
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::DeviceConnect:
+        {
+            Proto::DEVICE_CONNECT::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received device connect (connect_type: {0:d} device_id {1:d}, client_id: {2:d})", static_cast<int32_t>(cmd.connect_type), cmd.device_id, cmd.client_id);
+
+            switch (cmd.connect_type)
+            {
+                case Proto::DEVICE_CONNECT::ConnectType::CreatedDevice:
                 {
-                    Proto::DEVICE_DISCONNECT::Command cmd;
-                    cmd.Parse(message);
-                    
-                    sysLog->info("Controller :: Received disconnect device (device_id: {0:d}), client_id: {1:d})", cmd.device_id, cmd.client_id);
+                    if (cmd.address.empty() || cmd.address == "0.0.0.0" || cmd.address == "::/")
+                    {
+                        cmd.address = GetDefaultAddress(serverAddress);
+                    }
 
                     Event event_;
-                    event_.type = Event::Type::DeviceDisconnect;
+                    event_.type = cmd.device_type == Proto::DeviceType::Microphone ? Event::Type::MicrophoneStarted : Event::Type::CameraStarted;
+
                     event_.deviceValues.type = cmd.device_type;
                     event_.deviceValues.deviceId = cmd.device_id;
-                    event_.deviceValues.clientId = cmd.client_id;
-                    eventHandler(event_);
-                }
-                break;
-                case Proto::CommandType::ResolutionChange:
-                {
-                    Proto::RESOLUTION_CHANGE::Command cmd;
-                    cmd.Parse(message);
-
-                    sysLog->info("Controller :: Received resolution changed (device_id: {0:d}, resolution: {1:d})", cmd.id, static_cast<uint32_t>(cmd.resolution));
-                    Event event_;
-                    event_.type = Event::Type::ResolutionChanged;
-                    event_.deviceValues.deviceId = cmd.id;
-                    event_.deviceValues.resolution = cmd.resolution;
+                    event_.deviceValues.authorSSRC = cmd.author_ssrc;
+                    event_.deviceValues.colorSpace = static_cast<Video::ColorSpace>(cmd.color_space);
+                    event_.deviceValues.addr = cmd.address;
+                    event_.deviceValues.port = cmd.port;
+                    event_.deviceValues.secureKey = secureKey;
                     eventHandler(event_);
                 }
                 break;
-                case Proto::CommandType::MicrophoneActive:
+                case Proto::DEVICE_CONNECT::ConnectType::ConnectRenderer:
                 {
-                    Proto::MICROPHONE_ACTIVE::Command cmd;
-                    cmd.Parse(message);
-
-                    sysLog->info("Controller :: Received microphone active (client_id: {0:d}, device_id: {1:d}, value: {2:d})", cmd.client_id, cmd.device_id, static_cast<uint32_t>(cmd.active_type));
                     Event event_;
-                    event_.type = Event::Type::MicrophoneActive;
-                    event_.deviceValues.clientId = cmd.client_id;
+                    event_.type = Event::Type::DeviceConnect;
+                    event_.deviceValues.type = cmd.device_type;
                     event_.deviceValues.deviceId = cmd.device_id;
-                    event_.iData = static_cast<int32_t>(cmd.active_type);
-                    eventHandler(event_);
-                }
-                break;
-                case Proto::CommandType::CallRequest:
-                {
-                    Proto::CALL_REQUEST::Command cmd;
-                    cmd.Parse(message);
+                    event_.deviceValues.clientId = cmd.client_id;
+                    event_.deviceValues.metadata = cmd.metadata;
+                    event_.deviceValues.receiverSSRC = cmd.receiver_ssrc;
+                    event_.deviceValues.authorSSRC = cmd.author_ssrc;
+                    event_.deviceValues.port = cmd.port;
+                    event_.deviceValues.name = cmd.name;
+                    event_.deviceValues.resolution = (Video::Resolution)cmd.resolution;
+                    event_.deviceValues.mySource = cmd.my;
+                    event_.deviceValues.addr = cmd.address;
+                    event_.deviceValues.secureKey = cmd.secure_key;
 
-                    sysLog->info("Controller :: Received call request (subscriber_id: {0:d}, type: {1:d})", cmd.id, static_cast<int32_t>(cmd.type));
-                    
-                    subscriberId = cmd.id;
+                    if (event_.deviceValues.addr.empty() || event_.deviceValues.addr == "0.0.0.0" || event_.deviceValues.addr == "::/")
+                    {
+                        event_.deviceValues.addr = GetDefaultAddress(serverAddress);
+                    }
 
-                    Event event_;
-                    event_.type = Event::Type::CallRequest;
-                    event_.callValues.name = cmd.name;
-                    event_.callValues.subscriberId = cmd.id;
-                    event_.callValues.subscriberConnectionId = cmd.connection_id;
-                    event_.callValues.requestType = cmd.type;
-                    event_.callValues.timeLimit = cmd.time_limit;
                     eventHandler(event_);
                 }
                 break;
-                case Proto::CommandType::CallResponse:
-                {
-                    Proto::CALL_RESPONSE::Command cmd;
-                    cmd.Parse(message);
-                    
-                    sysLog->info("Controller :: Received call response (subscriber_id: {0:d}, type: {1:d})", cmd.id, static_cast<int32_t>(cmd.type));
+                default: break;
+            }
+        }
+        break;
+        case Proto::CommandType::DeviceDisconnect:
+        {
+            Proto::DEVICE_DISCONNECT::Command cmd;
+            cmd.Parse(message);
+            
+            sysLog->info("Controller :: Received disconnect device (device_id: {0:d}), client_id: {1:d})", cmd.device_id, cmd.client_id);
+
+            Event event_;
+            event_.type = Event::Type::DeviceDisconnect;
+            event_.deviceValues.type = cmd.device_type;
+            event_.deviceValues.deviceId = cmd.device_id;
+            event_.deviceValues.clientId = cmd.client_id;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::ResolutionChange:
+        {
+            Proto::RESOLUTION_CHANGE::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received resolution changed (device_id: {0:d}, resolution: {1:d})", cmd.id, static_cast<uint32_t>(cmd.resolution));
+            Event event_;
+            event_.type = Event::Type::ResolutionChanged;
+            event_.deviceValues.deviceId = cmd.id;
+            event_.deviceValues.resolution = cmd.resolution;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::MicrophoneActive:
+        {
+            Proto::MICROPHONE_ACTIVE::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received microphone active (client_id: {0:d}, device_id: {1:d}, value: {2:d})", cmd.client_id, cmd.device_id, static_cast<uint32_t>(cmd.active_type));
+            Event event_;
+            event_.type = Event::Type::MicrophoneActive;
+            event_.deviceValues.clientId = cmd.client_id;
+            event_.deviceValues.deviceId = cmd.device_id;
+            event_.iData = static_cast<int32_t>(cmd.active_type);
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::CallRequest:
+        {
+            Proto::CALL_REQUEST::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received call request (subscriber_id: {0:d}, type: {1:d})", cmd.id, static_cast<int32_t>(cmd.type));
+            
+            subscriberId = cmd.id;
+
+            Event event_;
+            event_.type = Event::Type::CallRequest;
+            event_.callValues.name = cmd.name;
+            event_.callValues.subscriberId = cmd.id;
+            event_.callValues.subscriberConnectionId = cmd.connection_id;
+            event_.callValues.requestType = cmd.type;
+            event_.callValues.timeLimit = cmd.time_limit;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::CallResponse:
+        {
+            Proto::CALL_RESPONSE::Command cmd;
+            cmd.Parse(message);
+            
+            sysLog->info("Controller :: Received call response (subscriber_id: {0:d}, type: {1:d})", cmd.id, static_cast<int32_t>(cmd.type));
 
+            switch (cmd.type)
+            {
+                case Proto::CALL_RESPONSE::Type::AutoCall:
+                    eventHandler(Event(Event::Type::AutoCallDenied));
+                break;
+                case Proto::CALL_RESPONSE::Type::NotConnected:
+                    eventHandler(Event(Event::Type::ResponderNotConnected));
+                break;
+                case Proto::CALL_RESPONSE::Type::Accept: case Proto::CALL_RESPONSE::Type::Refuse:
+                case Proto::CALL_RESPONSE::Type::Busy: case Proto::CALL_RESPONSE::Type::Timeout:
+                {
+                    /// Writing call history
+                    Proto::CallResult callResult = Proto::CallResult::Undefined;
+                    std::string eventType;
                     switch (cmd.type)
                     {
-                        case Proto::CALL_RESPONSE::Type::AutoCall:
-                            eventHandler(Event(Event::Type::AutoCallDenied));
+                        case Proto::CALL_RESPONSE::Type::Accept:
+                            eventType = "call_start";
+                            callResult = Proto::CallResult::Answered;
+                            subscriberId = cmd.id;
                         break;
-                        case Proto::CALL_RESPONSE::Type::NotConnected:
-                            eventHandler(Event(Event::Type::ResponderNotConnected));
+                        case Proto::CALL_RESPONSE::Type::Refuse:
+                            eventType = "subscriber_reject_call";
+                            callResult = Proto::CallResult::Rejected;
                         break;
-                        case Proto::CALL_RESPONSE::Type::Accept: case Proto::CALL_RESPONSE::Type::Refuse:
-                        case Proto::CALL_RESPONSE::Type::Busy: case Proto::CALL_RESPONSE::Type::Timeout:
-                        {
-                            /// Writing call history
-                            Proto::CallResult callResult = Proto::CallResult::Undefined;
-                            std::string eventType;
-                            switch (cmd.type)
-                            {
-                                case Proto::CALL_RESPONSE::Type::Accept:
-                                    eventType = "call_start";
-                                    callResult = Proto::CallResult::Answered;
-                                    subscriberId = cmd.id;
-                                break;
-                                case Proto::CALL_RESPONSE::Type::Refuse:
-                                    eventType = "subscriber_reject_call";
-                                    callResult = Proto::CallResult::Rejected;
-                                break;
-                                case Proto::CALL_RESPONSE::Type::Busy:
-                                    eventType = "subscriber_busy";
-                                    callResult = Proto::CallResult::Busy;
-                                break;
-                                case Proto::CALL_RESPONSE::Type::Timeout:
-                                    eventType = "subscriber_answer_timeout";
-                                    callResult = Proto::CallResult::Missed;
-                                break;
-                            }
-
-                            auto msg = Proto::Message(Storage::GUID(),
-                                time(0),
-                                Proto::MessageType::Call,
-                                cmd.id, "",
-                                cmd.id, "",
-                                cmd.id, "",
-                                "", "",
-                                Proto::MessageStatus::Created,
-                                "{\"type\":\"system_notice\",\"event\":\"" + eventType + "\"}",
-                                0, callResult,
-                                "", "", "");
-
-                            storage.AddMessage(msg);
-
-                            auto absentContacts = storage.GetAbsentContacts({ msg });
-                            if (!absentContacts.empty())
-                            {
-                                AddContact(absentContacts[0]);
-                            }
-
-                            Event event_;
-                            event_.type = Event::Type::CallResponse;
-                            event_.callValues.subscriberId = cmd.id;
-                            event_.callValues.subscriberConnectionId = cmd.connection_id;
-                            event_.callValues.name = cmd.name;
-                            event_.callValues.responseType = cmd.type;
-                            event_.callValues.timeLimit = cmd.time_limit;
-                            eventHandler(event_);
-                        }
+                        case Proto::CALL_RESPONSE::Type::Busy:
+                            eventType = "subscriber_busy";
+                            callResult = Proto::CallResult::Busy;
+                        break;
+                        case Proto::CALL_RESPONSE::Type::Timeout:
+                            eventType = "subscriber_answer_timeout";
+                            callResult = Proto::CallResult::Missed;
                         break;
-                        default: break;
                     }
-                }
-                break;
-                case Proto::CommandType::ConferenceUpdateResponse:
-                {
-                    Proto::CONFERENCE_UPDATE_RESPONSE::Command cmd;
-                    cmd.Parse(message);
 
-                    if (conferenceUpdateHandler) conferenceUpdateHandler(cmd);
-                }
-                break;
-                case Proto::CommandType::CreateTempConference:
-                {
-                    Proto::CREATE_TEMP_CONFERENCE::Command cmd;
-                    cmd.Parse(message);
+                    auto msg = Proto::Message(Storage::GUID(),
+                        time(0),
+                        Proto::MessageType::Call,
+                        cmd.id, "",
+                        cmd.id, "",
+                        cmd.id, "",
+                        "", "",
+                        Proto::MessageStatus::Created,
+                        "{\"type\":\"system_notice\",\"event\":\"" + eventType + "\"}",
+                        0, callResult,
+                        "", "", "");
+
+                    Post(Lane::Contacts, [this, msg]() {
+                        storage.AddMessage(msg);
+
+                        auto absentContacts = storage.GetAbsentContacts({ msg });
+                        if (!absentContacts.empty())
+                        {
+                            AddContact(absentContacts[0]);
+                        }
+                    });
 
                     Event event_;
-                    event_.type = Event::Type::ConferenceCreated;
-                    event_.conference.tag = cmd.tag;
-                    eventHandler(event_);
-                }
-                break;
-                case Proto::CommandType::SendConnectToConference:
-                {
-                    Proto::SEND_CONNECT_TO_CONFERENCE::Command cmd;
-                    cmd.Parse(message);
-                    
-                    sysLog->info("Controller :: Received send connect to conference (tag: {0})", cmd.tag);
-                    
-                    Event event_;
-                    event_.type = Event::Type::StartConnectToConference;
-                    event_.conference.tag = cmd.tag;
-                    event_.conference.grants = cmd.flags;
+                    event_.type = Event::Type::CallResponse;
+                    event_.callValues.subscriberId = cmd.id;
+                    event_.callValues.subscriberConnectionId = cmd.connection_id;
+                    event_.callValues.name = cmd.name;
+                    event_.callValues.responseType = cmd.type;
+                    event_.callValues.timeLimit = cmd.time_limit;
                     eventHandler(event_);
                 }
                 break;
-                case Proto::CommandType::ConnectToConferenceResponse:
-                {
-                    Proto::CONNECT_TO_CONFERENCE_RESPONSE::Command cmd;
-                    cmd.Parse(message);
+                default: break;
+            }
+        }
+        break;
+        case Proto::CommandType::ConferenceUpdateResponse:
+        {
+            Proto::CONFERENCE_UPDATE_RESPONSE::Command cmd;
+            cmd.Parse(message);
 
-                    sysLog->info("Controller :: Received connect to conference response (result: {0:d})", static_cast<int32_t>(cmd.result));
+            if (conferenceUpdateHandler) conferenceUpdateHandler(cmd);
+        }
+        break;
+        case Proto::CommandType::CreateTempConference:
+        {
+            Proto::CREATE_TEMP_CONFERENCE::Command cmd;
+            cmd.Parse(message);
 
-                    switch (cmd.result)
-                    {
-                        case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::OK:
-                            ChangeState(State::Conferencing);
+            Event event_;
+            event_.type = Event::Type::ConferenceCreated;
+            event_.conference.tag = cmd.tag;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::SendConnectToConference:
+        {
+            Proto::SEND_CONNECT_TO_CONFERENCE::Command cmd;
+            cmd.Parse(message);
+            
+            sysLog->info("Controller :: Received send connect to conference (tag: {0})", cmd.tag);
+            
+            Event event_;
+            event_.type = Event::Type::StartConnectToConference;
+            event_.conference.tag = cmd.tag;
+            event_.conference.grants = cmd.flags;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::ConnectToConferenceResponse:
+        {
+            Proto::CONNECT_TO_CONFERENCE_RESPONSE::Command cmd;
+            cmd.Parse(message);
 
-                            currentConference.id = cmd.id;
-                            currentConference.tag = cmd.tag;
-                            currentConference.founder_id = cmd.founder_id;
-                            currentConference.name = cmd.name;
-                            currentConference.grants = cmd.grants;
-                            currentConference.temp = cmd.temp;
+            sysLog->info("Controller :: Received connect to conference response (result: {0:d})", static_cast<int32_t>(cmd.result));
 
-                            sysLog->info("Controller :: Successfully connected to conference (tag: {0})", currentConference.tag);
-                            
-                            callStart = time(0);
+            switch (cmd.result)
+            {
+                case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::OK:
+                    ChangeState(State::Conferencing);
 
-                            eventHandler(Event(Event::Type::ConferenceConnected));
+                    currentConference.id = cmd.id;
+                    currentConference.tag = cmd.tag;
+                    currentConference.founder_id = cmd.founder_id;
+                    currentConference.name = cmd.name;
+                    currentConference.grants = cmd.grants;
+                    currentConference.temp = cmd.temp;
 
-                            if (!currentConference.temp)
-                            {
-                                storage.AddMessage(Proto::Message(Storage::GUID(),
-                                    time(0),
-                                    Proto::MessageType::Call,
-                                    0, "",
-                                    0, "",
-                                    0, "",
-                                    currentConference.tag, currentConference.name,
-                                    Proto::MessageStatus::Created,
-                                    "{\"type\":\"system_notice\",\"event\":\"call_start\"}",
-                                    0, Proto::CallResult::Answered,
-                                    "", "", ""));
-                            }
-                        break;
-                        case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::NotAllowed:
-                            ChangeState(State::Ready);
-                            currentConference.Clear();
-                            eventHandler(Event(Event::Type::ConferenceNotAllowed));
-                        break;
-                        case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::NotExists:
-                            ChangeState(State::Ready);
-                            currentConference.Clear();
-                            eventHandler(Event(Event::Type::ConferenceNotExists));
-                        break;
-                        case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::LicenseFull:
-                            ChangeState(State::Ready);
-                            currentConference.Clear();
-                            eventHandler(Event(Event::Type::ConferenceLicenseFull));
-                        break;
-                        default: break;
-                    }
-                }
-                break;
-                case Proto::CommandType::DisconnectFromConference:
-                {
-                    sysLog->info("Controller :: Received disconnect from conference");
+                    sysLog->info("Controller :: Successfully connected to conference (tag: {0})", currentConference.tag);
+                    
+                    callStart = time(0);
 
-                    if (GetState() == State::Conferencing)
-                    {
-                        eventHandler(Event(Event::Type::DoDisconnectFromConference));
-                    }
-                }
-                break;
-                case Proto::CommandType::ContactList:
-                {
-                    Proto::CONTACT_LIST::Command cmd;
-                    cmd.Parse(message);
+                    eventHandler(Event(Event::Type::ConferenceConnected));
 
-                    switch (contactListReceving)
+                    if (!currentConference.temp)
                     {
-                        case ContactListReceiving::Update:
-                            storage.UpdateContacts(cmd.sort_type, cmd.show_numbers, cmd.members);
-
-                            for (auto &member : cmd.members)
-                            {
-                                if (member.id == clientId)
-                                {
-                                    clientName = member.name;
-                                    login = member.login;
-                                    break;
-                                }
-                            }
-                        break;
-                        case ContactListReceiving::Search:
-                            if (contactListHandler) contactListHandler(cmd.members);
-                        break;
-                        default: break;
+                        Post(Lane::Contacts, [this, msg = Proto::Message(Storage::GUID(),
+                            time(0),
+                            Proto::MessageType::Call,
+                            0, "",
+                            0, "",
+                            0, "",
+                            currentConference.tag, currentConference.name,
+                            Proto::MessageStatus::Created,
+                            "{\"type\":\"system_notice\",\"event\":\"call_start\"}",
+                            0, Proto::CallResult::Answered,
+                            "", "", "")]() { storage.AddMessage(msg); });
                     }
-
-                    contactListReceving = ContactListReceiving::Update;
-                }
                 break;
-                case Proto::CommandType::ChangeContactState:
-                {
-                    Proto::CHANGE_CONTACT_STATE::Command cmd;
-                    cmd.Parse(message);
-
-                    storage.ChangeContactState(cmd.id, cmd.state);
-                }
+                case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::NotAllowed:
+                    ChangeState(State::Ready);
+                    currentConference.Clear();
+                    eventHandler(Event(Event::Type::ConferenceNotAllowed));
                 break;
-                case Proto::CommandType::GroupList:
-                {
-                    Proto::GROUP_LIST::Command cmd;
-                    cmd.Parse(message);
-
-                    storage.ClearGroups();
-                    storage.UpdateGroups(cmd.groups);
-                }
+                case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::NotExists:
+                    ChangeState(State::Ready);
+                    currentConference.Clear();
+                    eventHandler(Event(Event::Type::ConferenceNotExists));
                 break;
-                case Proto::CommandType::ConferencesList:
-                {
-                    Proto::CONFERENCES_LIST::Command cmd;
-                    cmd.Parse(message);
+                case Proto::CONNECT_TO_CONFERENCE_RESPONSE::Result::LicenseFull:
+                    ChangeState(State::Ready);
+                    currentConference.Clear();
+                    eventHandler(Event(Event::Type::ConferenceLicenseFull));
+                break;
+                default: break;
+            }
+        }
+        break;
+        case Proto::CommandType::DisconnectFromConference:
+        {
+            sysLog->info("Controller :: Received disconnect from conference");
 
-                    storage.UpdateConferences(cmd.conferences);
+            if (GetState() == State::Conferencing)
+            {
+                eventHandler(Event(Event::Type::DoDisconnectFromConference));
+            }
+        }
+        break;
+        case Proto::CommandType::ContactList:
+        {
+            Proto::CONTACT_LIST::Command cmd;
+            cmd.Parse(message);
 
-                    for (auto &c : cmd.conferences)
-                    {
-                        if (c.tag == currentConference.tag)
+            switch (contactListReceving)
+            {
+                case ContactListReceiving::Update:
+                    storage.UpdateContacts(cmd.sort_type, cmd.show_numbers, cmd.members);
+
+                    /// clientId is set by the connect response, so it's read in the session lane only
+                    Post(Lane::Session, [this, members = std::move(cmd.members)]() {
+                        for (auto &member : members)
                         {
-                            currentConference = c;
-                            break;
+                            if (member.id == clientId)
+                            {
+                                clientName = member.name;
+                                login = member.login;
+                                break;
+                            }
                         }
-                    }
-                }
+                    });
                 break;
-                case Proto::CommandType::ChangeMemberState:
-                {
-                    Proto::CHANGE_MEMBER_STATE::Command cmd;
-                    cmd.Parse(message);
+                case ContactListReceiving::Search:
+                    if (contactListHandler) contactListHandler(cmd.members);
+                break;
+                default: break;
+            }
 
-                    std::lock_guard<std::recursive_mutex> lock(memberList.GetItemsMutex());
+            contactListReceving = ContactListReceiving::Update;
+        }
+        break;
+        case Proto::CommandType::ChangeContactState:
+        {
+            Proto::CHANGE_CONTACT_STATE::Command cmd;
+            cmd.Parse(message);
 
-                    for (auto &member : cmd.members)
-                    {
-                        sysLog->info("Controller :: Received changed member state (member_id: {0}, state: {1:d})", member.id, static_cast<int>(member.state));
-                        if (member.state == Proto::MemberState::Conferencing)
-                        {
-                            if (!memberList.ExistsMember(member.id))
-                            {									
-                                Event event_;
-                                event_.type = Event::Type::MemberAdded;
-                                event_.iData = member.id;
-                                event_.data = member.name;
-                                event_.deviceValues.type = Proto::DeviceType::Camera;
-                                event_.deviceValues.disabled = !member.has_camera;
-                                eventHandler(event_);
-                            }
-                            memberList.UpdateItem(member);
-                        }
-                        else
-                        {
-                            memberList.DeleteItem(member.id);
+            storage.ChangeContactState(cmd.id, cmd.state);
+        }
+        break;
+        case Proto::CommandType::GroupList:
+        {
+            Proto::GROUP_LIST::Command cmd;
+            cmd.Parse(message);
 
-                            Event event_;
-                            event_.type = Event::Type::MemberRemoved;
-                            event_.iData = member.id;
-                            eventHandler(event_);
-                        }
-                    }
+            storage.ClearGroups();
+            storage.UpdateGroups(cmd.groups);
+        }
+        break;
+        case Proto::CommandType::ConferencesList:
+        {
+            Proto::CONFERENCES_LIST::Command cmd;
+            cmd.Parse(message);
 
-                    eventHandler(Event(Event::Type::UpdateMembers));
-                }
-                break;
-                case Proto::CommandType::ScheduleConnect:
-                {
-                    Proto::SCHEDULE_CONNECT::Command cmd;
-                    cmd.Parse(message);
+            storage.UpdateConferences(cmd.conferences);
 
-                    Event event_;
-                    event_.type = Event::Type::ScheduleConnect;
-                    event_.conference.tag = cmd.tag;
-                    event_.conference.name = cmd.name;
-                    event_.conference.duration = cmd.time_limit;
-                    eventHandler(event_);
-                }
-                break;
-                case Proto::CommandType::MemberAction:
+            /// The current conference belongs to the session lane
+            Post(Lane::Session, [this, conferences = std::move(cmd.conferences)]() {
+                for (auto &c : conferences)
                 {
-                    Proto::MEMBER_ACTION::Command cmd;
-                    cmd.Parse(message);
-
-                    if (cmd.result == Proto::MEMBER_ACTION::Result::NotAllowed)
-                    {
-                        return eventHandler(Event(Event::Type::DisallowedActionInThisConference));
-                    }
-                    else if (cmd.result == Proto::MEMBER_ACTION::Result::Accepted)
-                    {
-                        Event event_;
-                        event_.type = Event::Type::AcceptedAction;
-                        event_.iData = cmd.actor_id;
-                        event_.data = cmd.actor_name;
-                        return eventHandler(event_);
-                    }
-                    else if (cmd.result == Proto::MEMBER_ACTION::Result::Rejected)
+                    if (c.tag == currentConference.tag)
                     {
-                        Event event_;
-                        event_.type = Event::Type::RejectedAction;
-                        event_.iData = cmd.actor_id;
-                        event_.data = cmd.actor_name;
-                        return eventHandler(event_);
-                    }
-                    else if (cmd.result == Proto::MEMBER_ACTION::Result::Busy)
-                    {
-                        Event event_;
-                        event_.type = Event::Type::BusyAction;
-                        event_.iData = cmd.actor_id;
-                        event_.data = cmd.actor_name;
-                        return eventHandler(event_);
-                    }
-                    
-                    Event event_;
-                    switch (cmd.action)
-                    {
-                        case Proto::MEMBER_ACTION::Action::TurnCamera:
-                            event_.type = Event::Type::ActionTurnCamera;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::TurnMicrophone:
-                            event_.type = Event::Type::ActionTurnMicrophone;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::TurnDemonstration:
-                            event_.type = Event::Type::ActionTurnDemonstration;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::EnableRemoteControl:
-                            event_.type = Event::Type::ActionEnableRemoteControl;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::DisableRemoteControl:
-                            event_.type = Event::Type::ActionDisableRemoteControl;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::TurnSpeaker:
-                            event_.type = Event::Type::ActionTurnSpeaker;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::MuteMicrophone:
-                            event_.type = Event::Type::ActionMuteMicrophone;
-                        break;
-                        case Proto::MEMBER_ACTION::Action::DisconnectFromConference:
-                            event_.type = Event::Type::ActionDisconnectFromConference;
+                        currentConference = c;
                         break;
                     }
+                }
+            });
+        }
+        break;
+        case Proto::CommandType::ChangeMemberState:
+        {
+            Proto::CHANGE_MEMBER_STATE::Command cmd;
+            cmd.Parse(message);
 
-                    event_.iData = cmd.actor_id;
-                    event_.data = cmd.actor_name;
+            std::lock_guard<std::recursive_mutex> lock(memberList.GetItemsMutex());
 
-                    eventHandler(event_);
+            for (auto &member : cmd.members)
+            {
+                sysLog->info("Controller :: Received changed member state (member_id: {0}, state: {1:d})", member.id, static_cast<int>(member.state));
+                if (member.state == Proto::MemberState::Conferencing)
+                {
+                    if (!memberList.ExistsMember(member.id))
+                    {									
+                        Event event_;
+                        event_.type = Event::Type::MemberAdded;
+                        event_.iData = member.id;
+                        event_.data = member.name;
+                        event_.deviceValues.type = Proto::DeviceType::Camera;
+                        event_.deviceValues.disabled = !member.has_camera;
+                        eventHandler(event_);
+                    }
+                    memberList.UpdateItem(member);
                 }
-                break;
-                case Proto::CommandType::WantSpeak:
+                else
                 {
-                    Proto::WANT_SPEAK::Command cmd;
-                    cmd.Parse(message);
+                    memberList.DeleteItem(member.id);
 
                     Event event_;
-                    event_.type = Event::Type::WantSpeak;
-                    event_.iData = cmd.user_id;
-                    event_.data = cmd.user_name;
-                    if (cmd.is_speak) SetBit(event_.conference.grants, static_cast<int32_t>(Proto::MemberGrants::Speaker)); else ClearBit(event_.conference.grants, static_cast<int32_t>(Proto::MemberGrants::Speaker));
+                    event_.type = Event::Type::MemberRemoved;
+                    event_.iData = member.id;
                     eventHandler(event_);
                 }
-                break;
-                case Proto::CommandType::DeliveryMessages:
-                {
-                    Proto::DELIVERY_MESSAGES::Command cmd;
-                    cmd.Parse(message);
+            }
 
-                    storage.UpdateMessages(cmd.messages);
+            eventHandler(Event(Event::Type::UpdateMembers));
+        }
+        break;
+        case Proto::CommandType::ScheduleConnect:
+        {
+            Proto::SCHEDULE_CONNECT::Command cmd;
+            cmd.Parse(message);
+
+            Event event_;
+            event_.type = Event::Type::ScheduleConnect;
+            event_.conference.tag = cmd.tag;
+            event_.conference.name = cmd.name;
+            event_.conference.duration = cmd.time_limit;
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::MemberAction:
+        {
+            Proto::MEMBER_ACTION::Command cmd;
+            cmd.Parse(message);
 
-                    auto absentContacts = storage.GetAbsentContacts(cmd.messages);
-                    for (auto &c : absentContacts)
-                    {
-                        AddContact(c);
-                    }
-                }
+            if (cmd.result == Proto::MEMBER_ACTION::Result::NotAllowed)
+            {
+                return eventHandler(Event(Event::Type::DisallowedActionInThisConference));
+            }
+            else if (cmd.result == Proto::MEMBER_ACTION::Result::Accepted)
+            {
+                Event event_;
+                event_.type = Event::Type::AcceptedAction;
+                event_.iData = cmd.actor_id;
+                event_.data = cmd.actor_name;
+                return eventHandler(event_);
+            }
+            else if (cmd.result == Proto::MEMBER_ACTION::Result::Rejected)
+            {
+                Event event_;
+                event_.type = Event::Type::RejectedAction;
+                event_.iData = cmd.actor_id;
+                event_.data = cmd.actor_name;
+                return eventHandler(event_);
+            }
+            else if (cmd.result == Proto::MEMBER_ACTION::Result::Busy)
+            {
+                Event event_;
+                event_.type = Event::Type::BusyAction;
+                event_.iData = cmd.actor_id;
+                event_.data = cmd.actor_name;
+                return eventHandler(event_);
+            }
+            
+            Event event_;
+            switch (cmd.action)
+            {
+                case Proto::MEMBER_ACTION::Action::TurnCamera:
+                    event_.type = Event::Type::ActionTurnCamera;
                 break;
-                case Proto::CommandType::MediaAddressesList:
-                {
-                    Proto::MEDIA_ADDRESSES_LIST::Command cmd;
-                    cmd.Parse(message);
-
-                    for (const auto &a : cmd.addresses)
-                    {
-                        std::string proto, host, port;
-                        Transport::ParseURI(a, proto, host, port);
-
-                        if (host == "0.0.0.0" || host == "::/")
-                        {
-                            host = GetDefaultAddress(serverAddress);
-                        }
-
-                        if (proto == "rtp")
-                        {
-                            Event event_;
-                            event_.type = Event::Type::UpdateRTPAddress;
-                            event_.iData = atoi(port.c_str());
-                            event_.data = host;
-                            eventHandler(event_);
-                        }
-                    }
-
-                    eventHandler(Event(Event::Type::ReadyToMakeMediaTest));
-                }
+                case Proto::MEMBER_ACTION::Action::TurnMicrophone:
+                    event_.type = Event::Type::ActionTurnMicrophone;
                 break;
-                case Proto::CommandType::Disconnect:
-                {
-                    sysLog->info("Controller :: Received disconnect from server");
-
-                    std::thread([this]() { Logout(); }).detach();
-                }
+                case Proto::MEMBER_ACTION::Action::TurnDemonstration:
+                    event_.type = Event::Type::ActionTurnDemonstration;
                 break;
-                case Proto::CommandType::ChangeServer:
-                {
-                    Proto::CHANGE_SERVER::Command cmd;
-                    cmd.Parse(message);
+                case Proto::MEMBER_ACTION::Action::EnableRemoteControl:
+                    event_.type = Event::Type::ActionEnableRemoteControl;
+                break;
+                case Proto::MEMBER_ACTION::Action::DisableRemoteControl:
+                    event_.type = Event::Type::ActionDisableRemoteControl;
+                break;
+                case Proto::MEMBER_ACTION::Action::TurnSpeaker:
+                    event_.type = Event::Type::ActionTurnSpeaker;
+                break;
+                case Proto::MEMBER_ACTION::Action::MuteMicrophone:
+                    event_.type = Event::Type::ActionMuteMicrophone;
+                break;
+                case Proto::MEMBER_ACTION::Action::DisconnectFromConference:
+                    event_.type = Event::Type::ActionDisconnectFromConference;
+                break;
+            }
 
-                    sysLog->info("Controller :: Received change server to url: {0}", cmd.url);
+            event_.iData = cmd.actor_id;
+            event_.data = cmd.actor_name;
 
-                    std::string proto, host, port;
-                    Transport::ParseURI(cmd.url, proto, host, port);
-                    if (!proto.empty())
-                    {
-                        serverAddress = host + ":" + port;
-                        secureConnection = proto == "https";
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::WantSpeak:
+        {
+            Proto::WANT_SPEAK::Command cmd;
+            cmd.Parse(message);
+
+            Event event_;
+            event_.type = Event::Type::WantSpeak;
+            event_.iData = cmd.user_id;
+            event_.data = cmd.user_name;
+            if (cmd.is_speak) SetBit(event_.conference.grants, static_cast<int32_t>(Proto::MemberGrants::Speaker)); else ClearBit(event_.conference.grants, static_cast<int32_t>(Proto::MemberGrants::Speaker));
+            eventHandler(event_);
+        }
+        break;
+        case Proto::CommandType::DeliveryMessages:
+        {
+            Proto::DELIVERY_MESSAGES::Command cmd;
+            cmd.Parse(message);
 
-                        Event event_;
-                        event_.type = Event::Type::ServerChanged;
-                        event_.data = serverAddress;
-                        event_.iData = secureConnection ? 1 : 0;
-                        eventHandler(event_);
-                    }
-                    else
-                    {
-                        ChangeState(State::ServerError);
-                        errLog->critical("Controller :: Server sent incorrect redirect URL\n");
-                    }
+            storage.UpdateMessages(cmd.messages);
 
-                    std::thread([this]() { Logout(); }).detach();
-                }
-                break;
-                case Proto::CommandType::Undefined:
-                break;
-                case Proto::CommandType::Ping:
-                    SendCommand(Proto::PING::Command().Serialize());
-                    eventHandler(Event(Event::Type::Ping));
-                break;
-                default: break;
+            auto absentContacts = storage.GetAbsentContacts(cmd.messages);
+            for (auto &c : absentContacts)
+            {
+                AddContact(c);
             }
         }
         break;
-        case Transport::WSMethod::Close:
-            sysLog->info("Controller :: WebSocket closed (message: \"{0}\", reason: {1})", message, toString(disconnectReason));
-            switch (disconnectReason)
+        case Proto::CommandType::MediaAddressesList:
+        {
+            Proto::MEDIA_ADDRESSES_LIST::Command cmd;
+            cmd.Parse(message);
+
+            for (const auto &a : cmd.addresses)
             {
-                case DisconnectReason::NetworkError: case DisconnectReason::Redirected:
-                    eventHandler(Event(Event::Type::Disconnected));
-                break;
-                case DisconnectReason::AuthNeeded:
+                std::string proto, host, port;
+                Transport::ParseURI(a, proto, host, port);
+
+                if (host == "0.0.0.0" || host == "::/")
                 {
-                    Event event_;
-                    event_.type = Event::Type::AuthNeeded;
-                    event_.iData = 2;
-                    eventHandler(event_);
+                    host = GetDefaultAddress(serverAddress);
                 }
-                break;
-                case DisconnectReason::InvalidCredentionals:
+
+                if (proto == "rtp")
                 {
                     Event event_;
-                    event_.type = Event::Type::AuthNeeded;
-                    event_.iData = 1;
+                    event_.type = Event::Type::UpdateRTPAddress;
+                    event_.iData = atoi(port.c_str());
+                    event_.data = host;
                     eventHandler(event_);
                 }
-                break;
-                case DisconnectReason::UpdateRequired:
-                    eventHandler(Event(Event::Type::UpdateRequired));
-                break;
-                case DisconnectReason::ServerOutdated:
-                    eventHandler(Event(Event::Type::ServerOutdated));
-                break;
-                case DisconnectReason::ServerFull:
-                    eventHandler(Event(Event::Type::ServerFull));
-                break;
-                case DisconnectReason::InternalServerError:
-                    eventHandler(Event(Event::Type::ServerInternalError));
-                break;
-                default:
-                break;
             }
-            disconnectReason = DisconnectReason::NetworkError;
+
+            eventHandler(Event(Event::Type::ReadyToMakeMediaTest));
+        }
         break;
-        case Transport::WSMethod::Error:
-            errLog->critical("Controller :: WebSocket error (message: \"{0}\")", message);
+        case Proto::CommandType::Disconnect:
+        {
+            sysLog->info("Controller :: Received disconnect from server");
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            eventHandler(Event(Event::Type::NetworkError));
+            std::thread([this]() { Logout(); }).detach();
+        }
         break;
+        case Proto::CommandType::ChangeServer:
+        {
+            Proto::CHANGE_SERVER::Command cmd;
+            cmd.Parse(message);
+
+            sysLog->info("Controller :: Received change server to url: {0}", cmd.url);
+
+            std::string proto, host, port;
+            Transport::ParseURI(cmd.url, proto, host, port);
+            if (!proto.empty())
+            {
+                serverAddress = host + ":" + port;
+                secureConnection = proto == "https";
+
+                Event event_;
+                event_.type = Event::Type::ServerChanged;
+                event_.data = serverAddress;
+                event_.iData = secureConnection ? 1 : 0;
+                eventHandler(event_);
+            }
+            else
+            {
+                ChangeState(State::ServerError);
+                errLog->critical("Controller :: Server sent incorrect redirect URL\n");
+            }
+
+            std::thread([this]() { Logout(); }).detach();
+        }
+        break;
+        case Proto::CommandType::Undefined:
+        break;
+        case Proto::CommandType::Ping: /// Is answered by the WebSocket thread
+            eventHandler(Event(Event::Type::Ping));
+        break;
+        default: break;
     }
 }
 
+Controller::Lane Controller::GetLane(Proto::CommandType commandType)
+{
+    switch (commandType)
+    {
+        case Proto::CommandType::ContactList: case Proto::CommandType::ChangeContactState:
+        case Proto::CommandType::DeliveryMessages: /// Adds the absent contacts, so follows the contact list
+            return Lane::Contacts;
+        case Proto::CommandType::ConferencesList:
+            return Lane::Conferences;
+        case Proto::CommandType::GroupList:
+            return Lane::Groups;
+        default:
+            return Lane::Session;
+    }
+}
+
+void Controller::Post(Lane lane, std::function<void()> task, std::chrono::milliseconds delay)
+{
+    auto index = static_cast<uint32_t>(lane);
+    if (index != 0 && workersCount > 1)
+    {
+        index = 1 + (index - 1) % (workersCount - 1);
+    }
+    else
+    {
+        index = 0;
+    }
+
+    workQueue.Post(index, std::move(task), delay);
+}
+
 void Controller::Logon()
 {
     if (login.empty() || password.empty())
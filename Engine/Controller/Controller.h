@@ -12,9 +12,12 @@
 
 #include "IController.h"
 #include "IMemberList.h"
+#include "WorkQueue.h"
 
 #include <Transport/WS/WebSocket.h>
 
+#include <Proto/CommandType.h>
+
 #include <Common/TimeMeter.h>
 
 #include <spdlog/spdlog.h>
@@ -124,6 +127,21 @@ private:
     Proto::Conference currentConference;
     int64_t subscriberId;
 
+    /// The ordering units of the work queue, the big lists don't hold the session commands.
+    /// The lanes aren't ordered between each other, so the messages go with the contacts they add,
+    /// and the session state (clientId, currentConference) is read and written in the session lane only
+    enum class Lane : uint32_t
+    {
+        Session = 0,
+
+        Contacts,
+        Conferences,
+        Groups
+    };
+
+    WorkQueue workQueue; /// Before the WebSocket, its thread posts to the queue until the end
+    uint32_t workersCount;
+
     std::string baseURL;
     Transport::WebSocket webSocket;
 
@@ -173,6 +191,10 @@ private:
     std::shared_ptr<spdlog::logger> sysLog, errLog;
 
     void OnWebSocket(Transport::WSMethod method, std::string_view message);
+    void OnCommand(Proto::CommandType commandType, std::string_view message);
+
+    static Lane GetLane(Proto::CommandType commandType);
+    void Post(Lane lane, std::function<void()> task, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
 
     void Logon();
     void Logout();
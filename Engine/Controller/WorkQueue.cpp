@@ -0,0 +1,165 @@
+/**
+ * WorkQueue.cpp - Contains the controller's work queue impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Controller/WorkQueue.h>
+
+#include <algorithm>
+
+namespace Controller
+{
+
+WorkQueue::Worker::Worker()
+    : mutex(),
+    cv(),
+    tasks(),
+    runned(false),
+    thread()
+{
+}
+
+WorkQueue::WorkQueue()
+    : workers(),
+    statsMutex(),
+    stats{},
+    totalWait(0),
+    sysLog(spdlog::get("System"))
+{
+}
+
+WorkQueue::~WorkQueue()
+{
+    Stop();
+}
+
+void WorkQueue::Start(uint32_t workersCount)
+{
+    if (!workers.empty())
+    {
+        return;
+    }
+
+    workersCount = std::max<uint32_t>(workersCount, 1);
+
+    for (uint32_t i = 0; i != workersCount; ++i)
+    {
+        workers.emplace_back(std::make_unique<Worker>());
+    }
+
+    for (auto &w : workers)
+    {
+        w->runned = true;
+        w->thread = std::thread([this, &worker = *w]() { Run(worker); });
+    }
+}
+
+void WorkQueue::Stop()
+{
+    for (auto &w : workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->runned = false;
+        }
+        w->cv.notify_one();
+    }
+
+    for (auto &w : workers)
+    {
+        if (w->thread.joinable()) w->thread.join();
+    }
+
+    workers.clear();
+}
+
+void WorkQueue::Post(uint32_t lane, std::function<void()> task, std::chrono::milliseconds delay)
+{
+    if (workers.empty())
+    {
+        return;
+    }
+
+    auto &worker = *workers[lane % workers.size()];
+
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.runned)
+        {
+            return;
+        }
+
+        worker.tasks.push_back(Task{ std::chrono::steady_clock::now() + delay, std::move(task) });
+
+        /// Counted before the worker can take the task, so the depth never goes below zero
+        std::lock_guard<std::mutex> statsLock(statsMutex);
+        ++stats.depth;
+        if (stats.depth > stats.maxDepth) stats.maxDepth = stats.depth;
+    }
+    worker.cv.notify_one();
+}
+
+WorkQueueStats WorkQueue::GetStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    auto out = stats;
+    out.avgWait = stats.executed != 0 ? totalWait / stats.executed : 0;
+    return out;
+}
+
+void WorkQueue::Run(Worker &worker)
+{
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    while (true)
+    {
+        if (worker.tasks.empty())
+        {
+            if (!worker.runned)
+            {
+                break;
+            }
+            worker.cv.wait(lock);
+            continue;
+        }
+
+        /// The delayed task holds the lane, the order is kept
+        if (worker.runned && worker.tasks.front().due > std::chrono::steady_clock::now())
+        {
+            worker.cv.wait_until(lock, worker.tasks.front().due);
+            continue;
+        }
+
+        auto task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        auto depth = worker.tasks.size();
+
+        lock.unlock();
+
+        Account(task, depth);
+        task.function();
+
+        lock.lock();
+    }
+}
+
+void WorkQueue::Account(const Task &task, size_t depth)
+{
+    auto wait = static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - task.due).count(), 0));
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        --stats.depth;
+        ++stats.executed;
+        totalWait += wait;
+        if (wait > stats.maxWait) stats.maxWait = wait;
+    }
+
+    if (wait > WAIT_WARNING && sysLog)
+    {
+        sysLog->warn("Controller :: Task waited in the queue {0} us, {1} tasks behind it", wait, depth);
+    }
+}
+
+}
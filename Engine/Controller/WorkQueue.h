@@ -0,0 +1,83 @@
+/**
+ * WorkQueue.h - Contains the controller's work queue
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+namespace Controller
+{
+
+struct WorkQueueStats
+{
+    size_t depth, maxDepth; /// The tasks waiting in all the workers
+    uint64_t executed;
+    uint64_t avgWait, maxWait; /// microseconds from the posting (or the due time of the delayed task) to the start
+};
+
+/// Runs the tasks posted by the WebSocket thread on the worker threads.
+/// The tasks of one lane are executed by the same worker in the posting order,
+/// so the lane is the ordering unit (the session, the contacts, the messages, etc.)
+class WorkQueue
+{
+public:
+    WorkQueue();
+    ~WorkQueue();
+
+    void Start(uint32_t workersCount);
+
+    /// Executes the rest of tasks (the delayed ones without waiting) and joins the workers
+    void Stop();
+
+    /// The task waits for all the previous tasks of the lane, delay postpones it and the next ones of the lane
+    void Post(uint32_t lane, std::function<void()> task, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+    WorkQueueStats GetStats();
+
+private:
+    static const uint64_t WAIT_WARNING = 100000; /// microseconds
+
+    struct Task
+    {
+        std::chrono::steady_clock::time_point due;
+        std::function<void()> function;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Task> tasks;
+        bool runned;
+        std::thread thread;
+
+        Worker();
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex statsMutex;
+    WorkQueueStats stats;
+    uint64_t totalWait;
+
+    std::shared_ptr<spdlog::logger> sysLog;
+
+    void Run(Worker &worker);
+    void Account(const Task &task, size_t depth);
+};
+
+}
@@ -0,0 +1,69 @@
+/**
+ * Cipher.cpp - Contains the media ciphers impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <openssl/evp.h>
+
+#include <Crypto/Cipher.h>
+
+namespace Crypto
+{
+
+static const std::string_view AES128GCM_PREFIX = "aes128gcm:";
+static const std::string_view AES256GCM_PREFIX = "aes256gcm:";
+
+static std::string DeriveKey(std::string_view material, size_t size)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE] = { 0 };
+	unsigned int digestSize = 0;
+	EVP_Digest(material.data(), material.size(), digest, &digestSize, EVP_sha256(), NULL);
+
+	return std::string(reinterpret_cast<const char*>(digest), size);
+}
+
+CipherKey ParseSecureKey(std::string_view secureKey)
+{
+	if (secureKey.substr(0, AES128GCM_PREFIX.size()) == AES128GCM_PREFIX)
+	{
+		return { Cipher::AES128GCM, DeriveKey(secureKey.substr(AES128GCM_PREFIX.size()), 16) };
+	}
+	if (secureKey.substr(0, AES256GCM_PREFIX.size()) == AES256GCM_PREFIX)
+	{
+		return { Cipher::AES256GCM, DeriveKey(secureKey.substr(AES256GCM_PREFIX.size()), 32) };
+	}
+
+	std::string key(secureKey);
+	key.resize(32, '\0');
+	return { Cipher::AES256ECB, key };
+}
+
+const EVP_CIPHER *GetEVPCipher(Cipher cipher)
+{
+	switch (cipher)
+	{
+		case Cipher::AES128GCM: return EVP_aes_128_gcm();
+		case Cipher::AES256GCM: return EVP_aes_256_gcm();
+		default: return EVP_aes_256_ecb();
+	}
+}
+
+void MakeNonce(const Transport::RTPPacket::RTPHeader &header, uint8_t (&nonce)[GCM_NONCE_SIZE])
+{
+	nonce[0] = static_cast<uint8_t>(header.ssrc >> 24);
+	nonce[1] = static_cast<uint8_t>(header.ssrc >> 16);
+	nonce[2] = static_cast<uint8_t>(header.ssrc >> 8);
+	nonce[3] = static_cast<uint8_t>(header.ssrc);
+	nonce[4] = static_cast<uint8_t>(header.ts >> 24);
+	nonce[5] = static_cast<uint8_t>(header.ts >> 16);
+	nonce[6] = static_cast<uint8_t>(header.ts >> 8);
+	nonce[7] = static_cast<uint8_t>(header.ts);
+	nonce[8] = static_cast<uint8_t>(header.seq >> 8);
+	nonce[9] = static_cast<uint8_t>(header.seq);
+	nonce[10] = 0;
+	nonce[11] = 0;
+}
+
+}
@@ -0,0 +1,46 @@
+/**
+ * Cipher.h - Contains the media ciphers definitions
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <Transport/RTP/RTPPacket.h>
+
+typedef struct evp_cipher_st EVP_CIPHER;
+
+namespace Crypto
+{
+
+enum class Cipher
+{
+	AES256ECB = 0, /// Legacy, the key without prefix
+	AES128GCM,
+	AES256GCM
+};
+
+static const size_t GCM_NONCE_SIZE = 12;
+static const size_t GCM_TAG_SIZE = 16;
+
+struct CipherKey
+{
+	Cipher cipher;
+	std::string key; /// Raw key of the cipher's length
+};
+
+/// The secure key has the optional cipher prefix "aes128gcm:" or "aes256gcm:".
+/// Both sides get the same key string from the server, so the prefix is how the session negotiates the cipher,
+/// the GCM keys are derived by SHA-256 of the key string
+CipherKey ParseSecureKey(std::string_view secureKey);
+
+const EVP_CIPHER *GetEVPCipher(Cipher cipher);
+
+/// Unique per packet of the stream: ssrc, timestamp and sequence number, so the receiver restores it from the RTP header
+void MakeNonce(const Transport::RTPPacket::RTPHeader &header, uint8_t (&nonce)[GCM_NONCE_SIZE]);
+
+}
@@ -1,5 +1,5 @@
 /**
- * Encryptor.cpp - Contains encryptor impl
+ * Decryptor.cpp - Contains decryptor impl
  *
  * Author: Anton (ud) Golovkov, udattsk@gmail.com
  * Copyright (C), Infinity Video Soft LLC, 2016
@@ -10,24 +10,24 @@
 #include <openssl/err.h>
 
 #include <iostream>
+#include <algorithm>
 
 #include <Common/Common.h>
+#include <Common/Trace.h>
 #include <Crypto/Decryptor.h>
 #include <Transport/RTP/RTPPacket.h>
 
 namespace Crypto
 {
 
-static const uint32_t DECRYPTOR_BUFFER_SIZE = 1024 * 1024;
-
 Decryptor::Decryptor()
 	: runned(false),
 	receiver(nullptr),
-	key(),
+	cipher(Cipher::AES256ECB),
 	ctx(EVP_CIPHER_CTX_new(), ::EVP_CIPHER_CTX_free),
-	buffer(new uint8_t[DECRYPTOR_BUFFER_SIZE])
+	buffer(),
+	authFailures(0)
 {
-	EVP_add_cipher(EVP_aes_256_ecb());
 }
 
 Decryptor::~Decryptor()
@@ -42,12 +42,17 @@ void Decryptor::SetReceiver(Transport::ISocket *receiver_)
 
 void Decryptor::Start(std::string_view secureKey)
 {
-	if (!runned)
+	auto cipherKey = ParseSecureKey(secureKey);
+	cipher = cipherKey.cipher;
+
+	if (EVP_DecryptInit_ex(ctx.get(), GetEVPCipher(cipher), NULL, NULL, NULL) != 1 ||
+		(cipher != Cipher::AES256ECB && EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, GCM_NONCE_SIZE, NULL) != 1) ||
+		EVP_DecryptInit_ex(ctx.get(), NULL, NULL, reinterpret_cast<const unsigned char*>(cipherKey.key.data()), NULL) != 1)
 	{
-		runned = true;
+		HandleErrors();
 	}
 
-	key = secureKey;
+	runned = true;
 }
 
 void Decryptor::Stop()
@@ -60,6 +65,11 @@ bool Decryptor::Started() const
     return runned;
 }
 
+uint64_t Decryptor::GetAuthFailures() const
+{
+	return authFailures;
+}
+
 void Decryptor::Send(const Transport::IPacket &packet_, const Transport::Address *)
 {
 	if (!runned)
@@ -69,28 +79,65 @@ void Decryptor::Send(const Transport::IPacket &packet_, const Transport::Address
 
 	const Transport::RTPPacket &inputPacket = *static_cast<const Transport::RTPPacket*>(&packet_);
 
-	if (EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_ecb(), NULL, reinterpret_cast<const unsigned char*>(key.c_str()), NULL) != 1)
+	Common::Trace::Span span(Common::Trace::Stage::Decrypt, Common::Trace::GetKind(inputPacket.rtpHeader.pt), inputPacket.rtpHeader.ssrc, inputPacket.rtpHeader.ts);
+
+	const bool gcm = cipher != Cipher::AES256ECB;
+
+	uint32_t payloadSize = inputPacket.payloadSize;
+	uint8_t nonce[GCM_NONCE_SIZE], tag[GCM_TAG_SIZE];
+	if (gcm)
+	{
+		if (payloadSize < GCM_TAG_SIZE)
+		{
+			++authFailures;
+			return;
+		}
+		payloadSize -= GCM_TAG_SIZE;
+
+		MakeNonce(inputPacket.rtpHeader, nonce);
+		std::copy(inputPacket.payload + payloadSize, inputPacket.payload + payloadSize + GCM_TAG_SIZE, tag);
+	}
+
+	if (EVP_DecryptInit_ex(ctx.get(), NULL, NULL, NULL, gcm ? nonce : NULL) != 1)
 	{
 		return HandleErrors();
 	}
 
+	const size_t outputSize = payloadSize + AES_BLOCK_SIZE;
+	if (buffer.size() < outputSize)
+	{
+		buffer.resize(outputSize);
+	}
+
 	int decryptedSize = 0;
-	if (EVP_DecryptUpdate(ctx.get(), static_cast<unsigned char*>(buffer.get()), &decryptedSize, inputPacket.payload, inputPacket.payloadSize) != 1)
+	if (EVP_DecryptUpdate(ctx.get(), buffer.data(), &decryptedSize, inputPacket.payload, payloadSize) != 1)
+	{
+		return HandleErrors();
+	}
+
+	if (gcm && EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, tag) != 1)
 	{
 		return HandleErrors();
 	}
 
 	int finalSize = 0;
-	if (EVP_DecryptFinal_ex(ctx.get(), buffer.get() + decryptedSize, &finalSize) != 1)
+	if (EVP_DecryptFinal_ex(ctx.get(), buffer.data() + decryptedSize, &finalSize) != 1)
 	{
+		if (gcm)
+		{
+			++authFailures; /// Forged or damaged packet, never goes to the decoder
+			return;
+		}
 		HandleErrors();
 	}
 	decryptedSize += finalSize;
 
 	Transport::RTPPacket outputPacket;
 	outputPacket.rtpHeader = inputPacket.rtpHeader;
-	outputPacket.payload = buffer.get();
+	outputPacket.payload = buffer.data();
 	outputPacket.payloadSize = decryptedSize;
+
+	span.End();
 	
 	receiver->Send(outputPacket);
 }
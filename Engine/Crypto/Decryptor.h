@@ -8,10 +8,12 @@
 #pragma once
 
 #include <Crypto/IDecryptor.h>
+#include <Crypto/Cipher.h>
 #include <Transport/ISocket.h>
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
 typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
 void EVP_CIPHER_CTX_free(EVP_CIPHER_CTX *);
@@ -28,11 +30,15 @@ public:
 	void SetReceiver(Transport::ISocket *receiver);
 
 	/// Derived from IEncryptor
+	/// The cipher is selected by the prefix of the key, see ParseSecureKey()
 	virtual void Start(std::string_view secureKey);
 	virtual void Stop();
 
     virtual bool Started() const;
 
+	/// Count of the packets were dropped by the failed authentication of the GCM
+	uint64_t GetAuthFailures() const;
+
 	/// Derived from Transport::ISocket (input method)
 	virtual void Send(const Transport::IPacket &packet, const Transport::Address *address = nullptr) final;
 
@@ -41,11 +47,14 @@ private:
 
 	Transport::ISocket *receiver;
 
-	std::string key;
+	Cipher cipher;
 
+	/// Keeps the expanded key between the packets
 	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx;
 
-	std::unique_ptr<uint8_t[]> buffer;
+	std::vector<uint8_t> buffer; /// Grows up to the max packet size
+
+	std::atomic<uint64_t> authFailures;
 
 	void HandleErrors();
 };
@@ -12,22 +12,20 @@
 #include <iostream>
 
 #include <Common/Common.h>
+#include <Common/Trace.h>
 #include <Crypto/Encryptor.h>
 #include <Transport/RTP/RTPPacket.h>
 
 namespace Crypto
 {
 
-static const uint32_t ENCRYPTOR_BUFFER_SIZE = 1024 * 1024;
-
 Encryptor::Encryptor()
 	: runned(false),
 	receiver(nullptr),
-	key(),
+	cipher(Cipher::AES256ECB),
 	ctx(EVP_CIPHER_CTX_new(), ::EVP_CIPHER_CTX_free),
-	buffer(new uint8_t[ENCRYPTOR_BUFFER_SIZE])
+	buffer()
 {
-	EVP_add_cipher(EVP_aes_256_ecb());
 }
 
 Encryptor::~Encryptor()
@@ -42,12 +40,19 @@ void Encryptor::SetReceiver(Transport::ISocket *receiver_)
 
 void Encryptor::Start(std::string_view secureKey)
 {
-	if (!runned)
+	auto cipherKey = ParseSecureKey(secureKey);
+	cipher = cipherKey.cipher;
+
+	/// The key schedule is expanded once, the packets only reset the context with own nonce.
+	/// If this fails, the packets are dropped rather than sent in clear
+	if (EVP_EncryptInit_ex(ctx.get(), GetEVPCipher(cipher), NULL, NULL, NULL) != 1 ||
+		(cipher != Cipher::AES256ECB && EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, GCM_NONCE_SIZE, NULL) != 1) ||
+		EVP_EncryptInit_ex(ctx.get(), NULL, NULL, reinterpret_cast<const unsigned char*>(cipherKey.key.data()), NULL) != 1)
 	{
-		runned = true;
+		HandleErrors();
 	}
 
-	key = secureKey;
+	runned = true;
 }
 
 void Encryptor::Stop()
@@ -77,30 +82,58 @@ void Encryptor::Send(const Transport::IPacket &packet_, const Transport::Address
 	}
 	
 	const Transport::RTPPacket &inputPacket = *static_cast<const Transport::RTPPacket*>(&packet_);
-	
-	if (EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ecb(), NULL, reinterpret_cast<const unsigned char*>(key.c_str()), NULL) != 1)
+
+	Common::Trace::Span span(Common::Trace::Stage::Encrypt, Common::Trace::GetKind(inputPacket.rtpHeader.pt), inputPacket.rtpHeader.ssrc, inputPacket.rtpHeader.ts);
+
+	const bool gcm = cipher != Cipher::AES256ECB;
+
+	uint8_t nonce[GCM_NONCE_SIZE];
+	if (gcm)
+	{
+		MakeNonce(inputPacket.rtpHeader, nonce);
+	}
+
+	if (EVP_EncryptInit_ex(ctx.get(), NULL, NULL, NULL, gcm ? nonce : NULL) != 1)
 	{
 		return HandleErrors();
 	}
+
+	/// GCM output is the payload size plus the tag, ECB pads up to the block
+	const size_t outputSize = inputPacket.payloadSize + (gcm ? GCM_TAG_SIZE : AES_BLOCK_SIZE);
+	if (buffer.size() < outputSize)
+	{
+		buffer.resize(outputSize);
+	}
 	
 	int encryptedSize = 0;
-	if (EVP_EncryptUpdate(ctx.get(), static_cast<unsigned char*>(buffer.get()), &encryptedSize, inputPacket.payload, inputPacket.payloadSize) != 1)
+	if (EVP_EncryptUpdate(ctx.get(), buffer.data(), &encryptedSize, inputPacket.payload, inputPacket.payloadSize) != 1)
 	{
 		return HandleErrors();
 	}
 
 	int finalSize = 0;
-	if (EVP_EncryptFinal_ex(ctx.get(), buffer.get() + encryptedSize, &finalSize) != 1)
+	if (EVP_EncryptFinal_ex(ctx.get(), buffer.data() + encryptedSize, &finalSize) != 1)
 	{
 		return HandleErrors();
 	}
 	encryptedSize += finalSize;
+
+	if (gcm)
+	{
+		if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, buffer.data() + encryptedSize) != 1)
+		{
+			return HandleErrors();
+		}
+		encryptedSize += GCM_TAG_SIZE;
+	}
 	
 	Transport::RTPPacket outputPacket;
 	outputPacket.rtpHeader = inputPacket.rtpHeader;
-	outputPacket.payload = buffer.get();
+	outputPacket.payload = buffer.data();
 	outputPacket.payloadSize = encryptedSize;
 
+	span.End();
+
 	receiver->Send(outputPacket);
 }
 
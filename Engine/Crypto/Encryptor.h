@@ -8,10 +8,12 @@
 #pragma once
 
 #include <Crypto/IEncryptor.h>
+#include <Crypto/Cipher.h>
 #include <Transport/ISocket.h>
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
 typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
 void EVP_CIPHER_CTX_free(EVP_CIPHER_CTX *);
@@ -28,6 +30,7 @@ public:
 	void SetReceiver(Transport::ISocket *receiver);
 
 	/// Derived from IEncryptor
+	/// The cipher is selected by the prefix of the key, see ParseSecureKey()
 	virtual void Start(std::string_view secureKey);
 	virtual void Stop();
 
@@ -41,11 +44,12 @@ private:
 
 	Transport::ISocket *receiver;
 
-	std::string key;
+	Cipher cipher;
 
+	/// Keeps the expanded key between the packets
 	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx;
 
-	std::unique_ptr<uint8_t[]> buffer;
+	std::vector<uint8_t> buffer; /// Grows up to the max packet size
 
 	void HandleErrors();		
 };
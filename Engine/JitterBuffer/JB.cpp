@@ -11,6 +11,8 @@
 #include <Common/Common.h>
 #include <Common/ShortSleep.h>
 
+#include <Audio/AudioLevel.h>
+
 namespace JB
 {
 
@@ -33,19 +35,24 @@ JB::JB(Common::TimeMeter &timeMeter_)
 
     mutex(),
     buffer(),
-    statMeter(100),
+    rxIntervals(std::chrono::milliseconds(4000)),
 
 	frameDuration(40),
 
     buffering(true),
     reserveCount(4), // 160 ms delay
 
-    prevRxTS(0), rxInterval(frameDuration),
+    prevRxTS(0), rxInterval(frameDuration), rxIntervalTail(frameDuration),
     stateRxTS(40.0), covarianceRxTS(0.1),
     checkTime(0),
 
     prevSeq(0),
 
+    voiceActivity(true),
+
+    receivedPackets(), lostPackets(), underruns(), droppedPackets(),
+    depth(), rxIntervalGauge(), rxIntervalTailGauge(),
+
     sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
 {
 }
@@ -71,13 +78,27 @@ void JB::Start(Mode mode_, std::string_view name_)
 
         prevSeq = 0;
 
+        voiceActivity = true;
+
         prevRxTS = static_cast<uint32_t>(timeMeter.Measure() / 1000);
         rxInterval = frameDuration;
+        rxIntervalTail = frameDuration;
+        rxIntervals.Clear();
         stateRxTS = frameDuration;
         covarianceRxTS = 0.1;
 
         checkTime = 0;
 
+        Common::Metrics::Labels labels{ { "kind", mode == Mode::Sound ? "audio" : "video" }, { "device", name } };
+        auto &registry = Common::Metrics::Registry::Instance();
+        receivedPackets = registry.GetCounter("jb_received_packets_total", "Packets put to the jitter buffer", labels);
+        lostPackets = registry.GetCounter("jb_lost_packets_total", "Gaps in the sequence numbers", labels);
+        underruns = registry.GetCounter("jb_underruns_total", "Frames requested from the empty buffer", labels);
+        droppedPackets = registry.GetCounter("jb_dropped_packets_total", "Packets dropped to reduce the delay", labels);
+        depth = registry.GetGauge("jb_depth_packets", "Packets in the buffer", labels);
+        rxIntervalGauge = registry.GetGauge("jb_rx_interval_ms", "Smoothed interarrival time", labels);
+        rxIntervalTailGauge = registry.GetGauge("jb_rx_interval_p95_ms", "95th percentile of the interarrival time", labels);
+
 		runned = true;
         buffering = true;
 
@@ -124,19 +145,37 @@ void JB::Send(const Transport::IPacket &packet_, const Transport::Address *)
             mode == Mode::Sound ? Transport::RTPPayloadType::ptOpus : Transport::RTPPayloadType::ptVP8);
 
         std::lock_guard<std::mutex> lock(mutex);
-        buffer.push_back(rtpPacket);
+        buffer.push_back(Item{ rtpPacket, Common::Trace::Enabled() ? Common::Trace::Now() : 0 });
+
+        receivedPackets->Add();
+        depth->Set(buffer.size());
+
+        if (mode == Mode::Sound)
+        {
+            uint8_t level = 0;
+            bool va = true;
+            voiceActivity = !Audio::GetAudioLevel(packet.rtpHeader, level, va) || va; /// Legacy senders have no level and no DTX
+        }
 
-        if (packet.rtpHeader.seq - 1 == prevSeq) /// Don't calc jitter on loses
+        const auto gap = static_cast<int16_t>(packet.rtpHeader.seq - prevSeq); /// Not positive on the reordered and duplicated packets
+        if (gap == 1) /// Don't calc jitter on loses
         {
             CalcJitter(packet.rtpHeader);
         }
         else
         {
+            if (prevSeq != 0 && gap > 1)
+            {
+                lostPackets->Add(gap - 1);
+            }
             sysLog->trace("{0}_JB[{1}] :: Packet loss (prev_seq: {2}, current_seq: {3})", to_string(mode), name, prevSeq, packet.rtpHeader.seq);
             prevRxTS = static_cast<uint32_t>(timeMeter.Measure() / 1000);
         }
 
-        prevSeq = packet.rtpHeader.seq;
+        if (prevSeq == 0 || gap > 0) /// The late packet was counted as lost already, so the newest one stays the previous
+        {
+            prevSeq = packet.rtpHeader.seq;
+        }
 	}
 }
 
@@ -166,12 +205,19 @@ void JB::GetFrame(Transport::OwnedRTPPacket& output)
     {
         auto bufferSize = buffer.size();
 
-        while (buffer.size() > reserveCount && rxInterval < (buffer.size() * frameDuration)) /// Prevent big delay
+        /// The delay is kept for the late packets, not for the average ones, so the bursts don't lead to the underruns
+        auto snapshot = rxIntervals.GetSnapshot(Common::WindowedHistogram::Now());
+        rxIntervalTail = std::max(rxInterval, static_cast<uint32_t>(snapshot.GetPercentile(95)));
+        rxIntervalTailGauge->Set(rxIntervalTail);
+
+        while (buffer.size() > reserveCount && rxIntervalTail < (buffer.size() * frameDuration)) /// Prevent big delay
         {
             buffer.pop_front();
         }
 
-        sysLog->trace("{0}_JB[{1}] :: Check (rxInterval: {2}, buffer size: {3}, removed: {4})", to_string(mode), name, rxInterval, buffer.size(), bufferSize - buffer.size());
+        droppedPackets->Add(bufferSize - buffer.size());
+
+        sysLog->trace("{0}_JB[{1}] :: Check (rxInterval: {2}, p95: {3}, max: {4}, buffer size: {5}, removed: {6})", to_string(mode), name, rxInterval, rxIntervalTail, snapshot.max, buffer.size(), bufferSize - buffer.size());
 
         checkTime = 0;
     }
@@ -182,8 +228,16 @@ void JB::GetFrame(Transport::OwnedRTPPacket& output)
         if (mode == Mode::Video ||
             rxInterval < (buffer.size() + 1) * frameDuration)
         {
-            output = std::move(*buffer.front());
+            auto arrival = buffer.front().arrival;
+            output = std::move(*buffer.front().packet);
             buffer.pop_front();
+
+            if (arrival != 0)
+            {
+                Common::Trace::Record(Common::Trace::Stage::JBWait, mode == Mode::Sound ? Common::Trace::Kind::Audio : Common::Trace::Kind::Video,
+                    output.header.ssrc, output.header.ts, arrival, Common::Trace::Now());
+            }
+            depth->Set(buffer.size());
         }
         else
         {
@@ -191,9 +245,14 @@ void JB::GetFrame(Transport::OwnedRTPPacket& output)
             sysLog->trace("{0}_JB[{1}] :: Buffering (rxInterval: {2}, buffer size: {3})", to_string(mode), name, rxInterval, buffer.size());
         }
     }
+    else if (mode == Mode::Sound && !voiceActivity)
+    {
+        /// DTX gap: the sender doesn't transmit the silence, so don't rebuffer and play the next packet as soon as it comes
+    }
     else
     {
         buffering = true;
+        underruns->Add();
         sysLog->warn("{0}_JB[{1}] :: Empty (rxInterval: {2})", to_string(mode), name, rxInterval);
     }  
 }
@@ -203,7 +262,7 @@ void JB::ReadFrame(Transport::OwnedRTPPacket &out)
     std::lock_guard<std::mutex> lock(mutex);
     if (!buffer.empty())
     {
-        out = *buffer.front();
+        out = *buffer.front().packet;
     }
 }
 
@@ -216,9 +275,11 @@ void JB::CalcJitter(const Transport::RTPPacket::RTPHeader &header)
 
     auto actualrxInterval = KalmanCorrectRxTS(interarrivalTime);
     
-    statMeter.PushVal(actualrxInterval);
+    auto now = Common::WindowedHistogram::Now();
+    rxIntervals.Record(actualrxInterval, now);
 
-    rxInterval = static_cast<uint32_t>(statMeter.GetAvg());
+    rxInterval = static_cast<uint32_t>(rxIntervals.GetAvg(now));
+    rxIntervalGauge->Set(rxInterval);
 }
 
 uint32_t JB::KalmanCorrectRxTS(uint32_t data)
@@ -11,7 +11,9 @@
 #include <Transport/RTP/OwnedRTPPacket.h>
 
 #include <Common/TimeMeter.h>
-#include <Common/StatMeter.h>
+#include <Common/Histogram.h>
+#include <Common/Metrics.h>
+#include <Common/Trace.h>
 
 #include <atomic>
 #include <mutex>
@@ -58,20 +60,30 @@ private:
     std::atomic_bool runned;
 
     std::mutex mutex;
-    std::deque<std::shared_ptr<Transport::OwnedRTPPacket>> buffer;
+    struct Item
+    {
+        std::shared_ptr<Transport::OwnedRTPPacket> packet;
+        uint64_t arrival; /// Trace time, 0 if the tracing is disabled
+    };
+    std::deque<Item> buffer;
 
-    Common::StatMeter statMeter;
+    Common::WindowedHistogram rxIntervals; /// The interarrival times of the last 4 seconds
 
 	uint32_t frameDuration;
 
     bool buffering;
     uint32_t reserveCount;
 
-    uint32_t prevRxTS, rxInterval;
+    uint32_t prevRxTS, rxInterval, rxIntervalTail; /// Tail is the 95th percentile of the interarrival times
     double stateRxTS, covarianceRxTS;
     uint32_t checkTime;
 
     uint16_t prevSeq;
+
+    bool voiceActivity; /// From the audio level of the last packet, false means the sender can be in DTX
+
+    std::shared_ptr<Common::Metrics::Counter> receivedPackets, lostPackets, underruns, droppedPackets;
+    std::shared_ptr<Common::Metrics::Gauge> depth, rxIntervalGauge, rxIntervalTailGauge;
  
     std::shared_ptr<spdlog::logger> sysLog, errLog;
 
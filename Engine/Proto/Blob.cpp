@@ -7,8 +7,7 @@
 
 #include <Proto/Blob.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -67,16 +66,24 @@ bool Blob::Parse(const nlohmann::json::object_t &obj)
 
 std::string Blob::Serialize()
 {
-	return "{" + quot(ID) + ":" + std::to_string(id) +
-		(owner_id != -1 ? "," + quot(OWNER_ID) + ":" + std::to_string(owner_id) : "") +
-		(!guid.empty() ? "," + quot(GUID) + ":" + quot(Common::JSON::Screen(guid)) : "") +
-		(type != BlobType::Undefined ? "," + quot(TYPE) + ":" + std::to_string(static_cast<uint32_t>(type)) : "") +
-		(status != BlobStatus::Undefined ? "," + quot(STATUS) + ":" + std::to_string(static_cast<uint32_t>(status)) : "") +
-		(action != BlobAction::Undefined ? "," + quot(ACTION) + ":" + std::to_string(static_cast<uint32_t>(action)) : "") +
-		(!data.empty() ? "," + quot(DATA) + ":" + quot(Common::JSON::Screen(data)) : "") +
-		(!name.empty() ? "," + quot(NAME) + ":" + quot(Common::JSON::Screen(name)) : "") +
-		(!description.empty() ? "," + quot(DESCRIPTION) + ":" + quot(Common::JSON::Screen(description)) : "") +
-		(deleted ? "," + quot(DELETED) + ":1" : "") + "}";
+	JSON::Writer writer;
+	Serialize(writer);
+	return writer.Result();
+}
+
+void Blob::Serialize(JSON::Writer &writer)
+{
+	writer.Raw('{').Key(ID).Number(id);
+	if (owner_id != -1) writer.Raw(',').Key(OWNER_ID).Number(owner_id);
+	if (!guid.empty()) writer.Raw(',').Key(GUID).String(guid);
+	if (type != BlobType::Undefined) writer.Raw(',').Key(TYPE).Number(static_cast<uint32_t>(type));
+	if (status != BlobStatus::Undefined) writer.Raw(',').Key(STATUS).Number(static_cast<uint32_t>(status));
+	if (action != BlobAction::Undefined) writer.Raw(',').Key(ACTION).Number(static_cast<uint32_t>(action));
+	if (!data.empty()) writer.Raw(',').Key(DATA).String(data);
+	if (!name.empty()) writer.Raw(',').Key(NAME).String(name);
+	if (!description.empty()) writer.Raw(',').Key(DESCRIPTION).String(description);
+	if (deleted) writer.Raw(',').Key(DELETED).Raw('1');
+	writer.Raw('}');
 }
 
 }
@@ -10,6 +10,8 @@
 #include <string>
 #include <cstdint>
 
+#include <Proto/JSONWriter.h>
+
 #include <nlohmann/json.hpp>
 
 namespace Proto
@@ -81,6 +83,7 @@ namespace Proto
 
 		bool Parse(const nlohmann::json::object_t &pt);
 		std::string Serialize();
+		void Serialize(JSON::Writer &writer); /// Appends to the writer of the outer command
 
 		inline bool operator==(int64_t id_) const
 		{
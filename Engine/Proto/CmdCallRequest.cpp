@@ -7,8 +7,7 @@
 
 #include <Proto/CmdCallRequest.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -68,11 +67,14 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," +
-		quot(ID) + ":" + std::to_string(id) + "," +
-		quot(CONNECTION_ID) + ":" + std::to_string(connection_id) + "," +
-		quot(TYPE) + ":" + std::to_string(static_cast<int32_t>(type)) + "," +
-		quot(TIME_LIMIT) + ":" + std::to_string(time_limit) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(NAME_).String(name).Raw(',')
+		.Key(ID).Number(id).Raw(',')
+		.Key(CONNECTION_ID).Number(connection_id).Raw(',')
+		.Key(TYPE).Number(static_cast<int32_t>(type)).Raw(',')
+		.Key(TIME_LIMIT).Number(time_limit).Raw("}}");
+	return writer.Result();
 }
 
 std::string str(Type t)
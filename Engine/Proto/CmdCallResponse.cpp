@@ -7,7 +7,7 @@
 
 #include <Proto/CmdCallResponse.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -66,11 +66,14 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ID) + ":" + std::to_string(id) + "," +
-		quot(CONNECTION_ID) + ":" + std::to_string(connection_id) + "," +
-		quot(NAME_) + ":" + quot(name) + "," +
-		quot(TYPE) + ":" + std::to_string(static_cast<int32_t>(type)) + "," +
-		quot(TIME_LIMIT) + ":" + std::to_string(time_limit) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ID).Number(id).Raw(',')
+		.Key(CONNECTION_ID).Number(connection_id).Raw(',')
+		.Key(NAME_).Quoted(name).Raw(',')
+		.Key(TYPE).Number(static_cast<int32_t>(type)).Raw(',')
+		.Key(TIME_LIMIT).Number(time_limit).Raw("}}");
+	return writer.Result();
 }
 
 }
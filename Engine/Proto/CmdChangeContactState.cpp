@@ -7,7 +7,7 @@
 
 #include <Proto/CmdChangeContactState.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -57,8 +57,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ID) + ":" + std::to_string(id) + "," +
-		quot(STATE) + ":" + std::to_string(static_cast<int32_t>(state)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ID).Number(id).Raw(',')
+		.Key(STATE).Number(static_cast<int32_t>(state)).Raw("}}");
+	return writer.Result();
 }
 
 }
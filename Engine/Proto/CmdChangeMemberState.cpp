@@ -7,7 +7,7 @@
 
 #include <Proto/CmdChangeMemberState.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -64,17 +64,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
 	for (auto &m : members)
 	{
-		out += m.Serialize() + ",";
-	}
-	if (!members.empty())
-	{
-		out.pop_back(); // drop last ","
+		m.Serialize(writer);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdChangeServer.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,8 +54,10 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(URL) + ":" + quot(Common::JSON::Screen(url)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(URL).String(url).Raw("}}");
+	return writer.Result();
 }
 
 }
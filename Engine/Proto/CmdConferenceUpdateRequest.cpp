@@ -7,7 +7,7 @@
 
 #include <Proto/CmdConferenceUpdateRequest.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -57,9 +57,13 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ACTION) + ":" + std::to_string(static_cast<int32_t>(action)) + "," +
-		quot(CONFERENCE) + ":" + conference.Serialize() +
-		"}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ACTION).Number(static_cast<int32_t>(action)).Raw(',')
+		.Key(CONFERENCE);
+	conference.Serialize(writer);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,9 @@
 
 #include <Proto/CmdConferenceUpdateResponse.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
+
+#include <Proto/JSONReader.h>
 
 #include <nlohmann/json.hpp>
 
@@ -41,18 +42,37 @@ Command::~Command()
 {
 }
 
-bool Command::Parse(std::string_view message)
+class CommandReader : public JSON::Reader
 {
-	try
+public:
+	CommandReader(Command &command_)
+		: command(command_),
+		hasResult(false)
+	{
+	}
+
+	void Set(std::string_view key, JSON::Value &value) override
+	{
+		if (key == ID) command.id = value.As<int64_t>();
+		else if (key == RESULT) { command.result = static_cast<Result>(value.As<uint32_t>()); hasResult = true; }
+	}
+
+	bool HasResult() const
 	{
-		auto j = nlohmann::json::parse(message);
-		auto obj = j.get<nlohmann::json::object_t>().at(NAME);
+		return hasResult;
+	}
 
-		if (obj.count(ID) != 0) id = obj.at(ID).get<int64_t>();
+private:
+	Command &command;
+	bool hasResult;
+};
 
-		result = static_cast<Result>(obj.at(RESULT).get<uint32_t>());
-		
-		return true;
+bool Command::Parse(std::string_view message)
+{
+	try
+	{
+		CommandReader reader(*this);
+		return JSON::Parse(message, NAME, reader) && reader.HasResult();
 	}
 	catch (nlohmann::json::parse_error& ex)
 	{
@@ -63,9 +83,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-        (id != -1 ? quot(ID) + ":" + std::to_string(id) + "," : "") +
-        quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{');
+	if (id != -1) writer.Key(ID).Number(id).Raw(',');
+	writer.Key(RESULT).Number(static_cast<int32_t>(result)).Raw("}}");
+	return writer.Result();
 }
 
 }
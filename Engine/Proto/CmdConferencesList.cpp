@@ -7,7 +7,7 @@
 
 #include <Proto/CmdConferencesList.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -34,19 +34,9 @@ bool Command::Parse(std::string_view message)
 {
 	try
 	{
-		auto j = nlohmann::json::parse(message);
-		auto confs = j.get<nlohmann::json::object_t>().at(NAME);
-
-		for (auto &c : confs)
-		{
-			Conference conference;
-			if (conference.Parse(c))
-			{
-				conferences.emplace_back(conference);
-			}
-		}
-		
-		return true;
+		JSON::ListReader<Conference, ConferenceReader> reader;
+		reader.Reset(&conferences);
+		return JSON::Parse(message, NAME, reader);
 	}
 	catch (nlohmann::json::parse_error& ex)
 	{
@@ -57,18 +47,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
 	for (auto &c : conferences)
 	{
-		out += c.Serialize() + ",";
+		c.Serialize(writer);
+		writer.Raw(',');
 	}
-	if (!conferences.empty())
-	{
-		out.pop_back(); // drop last ","
-	}
-
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
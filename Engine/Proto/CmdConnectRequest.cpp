@@ -7,8 +7,7 @@
 
 #include <Proto/CmdConnectRequest.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -68,13 +67,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" +
-		quot(TYPE) + ":" + std::to_string(static_cast<int32_t>(type)) +
-		(client_version != 0 ? "," + quot(CLIENT_VERSION) + ":" + std::to_string(client_version) : "") +
-		(!system.empty() ? "," + quot(SYSTEM) + ":" + quot(Common::JSON::Screen(system)) : "") +
-		(!login.empty() ? "," + quot(LOGIN) + ":" + quot(Common::JSON::Screen(login)) : "") +
-		(!password.empty() ? "," + quot(PASSWORD) + ":" + quot(Common::JSON::Screen(password)) : "") +
-		(!access_token.empty() ? "," + quot(ACCESS_TOKEN) + ":" + quot(Common::JSON::Screen(access_token)) : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(TYPE).Number(static_cast<int32_t>(type));
+	if (client_version != 0) writer.Raw(',').Key(CLIENT_VERSION).Number(client_version);
+	if (!system.empty()) writer.Raw(',').Key(SYSTEM).String(system);
+	if (!login.empty()) writer.Raw(',').Key(LOGIN).String(login);
+	if (!password.empty()) writer.Raw(',').Key(PASSWORD).String(password);
+	if (!access_token.empty()) writer.Raw(',').Key(ACCESS_TOKEN).String(access_token);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdConnectResponse.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -85,33 +84,22 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	/*return "{" + quot(NAME) + ":{" +
-		quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) + 
-		(server_version != 0 ? "," + quot(SERVER_VERSION) + ":" + std::to_string(server_version) : "") +
-		(id != 0 ? "," + quot(ID) + ":" + std::to_string(id) : "") +
-		(connection_id != 0 ? "," + quot(CONNECTION_ID) + ":" + std::to_string(connection_id) : "") +
-		(!access_token.empty() ? "," + quot(ACCESS_TOKEN) + ":" + quot(Common::JSON::Screen(access_token)) : "") +
-		(!name.empty() ? "," + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) : "") +
-		(!redirect_url.empty() ? "," + quot(REDIRECT_URL) + ":" + quot(Common::JSON::Screen(redirect_url)) : "") +
-		(!secure_key.empty() ? "," + quot(SECURE_KEY) + ":" + quot(Common::JSON::Screen(secure_key)) : "") +
-		(!server_name.empty() ? "," + quot(SERVER_NAME) + ":" + quot(Common::JSON::Screen(server_name)) : "") +
-		(options != 0 ? "," + quot(OPTIONS) + ":" + std::to_string(options) : "") +
-		(grants != 0 ? "," + quot(GRANTS) + ":" + std::to_string(grants) : "") + "}}";*/
-
-	/// This need to make old clients work
-	return "{" + quot(NAME) + ":{" +
-		quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) + "," +
-		quot(SERVER_VERSION) + ":" + std::to_string(server_version) + "," +
-		quot(ID) + ":" + std::to_string(id) + "," +
-		quot(CONNECTION_ID) + ":" + std::to_string(connection_id) + "," +
-		(!access_token.empty() ? quot(ACCESS_TOKEN) + ":" + quot(Common::JSON::Screen(access_token)) + "," : "") +
-		quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," +
-		(!redirect_url.empty() ? quot(REDIRECT_URL) + ":" + quot(Common::JSON::Screen(redirect_url)) + "," : "") +
-		(!secure_key.empty() ? quot(SECURE_KEY) + ":" + quot(Common::JSON::Screen(secure_key)) + "," : "") +
-		(!server_name.empty() ? quot(SERVER_NAME) + ":" + quot(Common::JSON::Screen(server_name)) + "," : "") +
-		quot(OPTIONS) + ":" + std::to_string(options) + "," +
-		quot(GRANTS) + ":" + std::to_string(grants) + "," +
-		quot(MAX_OUTPUT_BITRATE) + ":" + std::to_string(max_output_bitrate) + "}}";
+	/// Every field is always sent, this need to make old clients work
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(RESULT).Number(static_cast<int32_t>(result)).Raw(',')
+		.Key(SERVER_VERSION).Number(server_version).Raw(',')
+		.Key(ID).Number(id).Raw(',')
+		.Key(CONNECTION_ID).Number(connection_id).Raw(',');
+	if (!access_token.empty()) writer.Key(ACCESS_TOKEN).String(access_token).Raw(',');
+	writer.Key(NAME_).String(name).Raw(',');
+	if (!redirect_url.empty()) writer.Key(REDIRECT_URL).String(redirect_url).Raw(',');
+	if (!secure_key.empty()) writer.Key(SECURE_KEY).String(secure_key).Raw(',');
+	if (!server_name.empty()) writer.Key(SERVER_NAME).String(server_name).Raw(',');
+	writer.Key(OPTIONS).Number(options).Raw(',')
+		.Key(GRANTS).Number(grants).Raw(',')
+		.Key(MAX_OUTPUT_BITRATE).Number(max_output_bitrate).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdConnectToConferenceRequest.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -69,12 +68,15 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) +
-		(connect_members ? "," + quot(CONNECT_MEMBERS) + ":1" : "") +
-		(has_camera ? "," + quot(HAS_CAMERA) + ":1" : "") +
-		(has_microphone ? "," + quot(HAS_MICROPHONE) + ":1" : "") +
-        (has_demonstration ? "," + quot(HAS_DEMONSTRATION) + ":1" : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(TAG).String(tag);
+	if (connect_members) writer.Raw(',').Key(CONNECT_MEMBERS).Raw('1');
+	if (has_camera) writer.Raw(',').Key(HAS_CAMERA).Raw('1');
+	if (has_microphone) writer.Raw(',').Key(HAS_MICROPHONE).Raw('1');
+	if (has_demonstration) writer.Raw(',').Key(HAS_DEMONSTRATION).Raw('1');
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
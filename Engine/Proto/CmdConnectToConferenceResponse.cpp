@@ -7,8 +7,7 @@
 
 #include <Proto/CmdConnectToConferenceResponse.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -78,14 +77,17 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) + 
-		(grants != 0 ? "," + quot(GRANTS) + ":" + std::to_string(grants) : "") +
-		(id != 0 ? "," + quot(ID) + ":" + std::to_string(id) : "") +
-		(founder_id != 0 ? "," + quot(FOUNDER_ID) + ":" + std::to_string(founder_id) : "") +
-		(!tag.empty() ? "," + quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) : "") +
-		(!name.empty() ? "," + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) : "") + 
-		(temp ? "," + quot(TEMP) + ":1" : "") +	"}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(RESULT).Number(static_cast<int32_t>(result));
+	if (grants != 0) writer.Raw(',').Key(GRANTS).Number(grants);
+	if (id != 0) writer.Raw(',').Key(ID).Number(id);
+	if (founder_id != 0) writer.Raw(',').Key(FOUNDER_ID).Number(founder_id);
+	if (!tag.empty()) writer.Raw(',').Key(TAG).String(tag);
+	if (!name.empty()) writer.Raw(',').Key(NAME_).String(name);
+	if (temp) writer.Raw(',').Key(TEMP).Raw('1');
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
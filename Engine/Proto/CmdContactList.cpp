@@ -7,8 +7,7 @@
 
 #include <Proto/CmdContactList.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -42,27 +41,43 @@ Command::~Command()
 {
 }
 
-bool Command::Parse(std::string_view message)
+/// Reads the members straight into the command, without the DOM of the whole list
+class CommandReader : public JSON::Reader
 {
-	try
+public:
+	CommandReader(Command &command_)
+		: command(command_),
+		members()
 	{
-		auto j = nlohmann::json::parse(message);
-		auto obj = j.get<nlohmann::json::object_t>().at(NAME);
+	}
 
-		if (obj.count(SORT_TYPE) != 0) sort_type = static_cast<SortType>(obj.at(SORT_TYPE).get<int32_t>());
-		if (obj.count(SHOW_NUMBERS) != 0) show_numbers = obj.at(SHOW_NUMBERS).get<int32_t>();
+	void Set(std::string_view key, JSON::Value &value) override
+	{
+		if (key == SORT_TYPE) command.sort_type = static_cast<SortType>(value.As<int32_t>());
+		else if (key == SHOW_NUMBERS) command.show_numbers = value.As<int32_t>();
+	}
 
-		auto users = obj.at(MEMBERS);
-		for (auto &u : users)
+	JSON::Reader *Nested(std::string_view key) override
+	{
+		if (key == MEMBERS)
 		{
-			Member member;
-			if (member.Parse(u))
-			{
-				members.emplace_back(member);
-			}
+			members.Reset(&command.members);
+			return &members;
 		}
-				
-		return true;
+		return nullptr;
+	}
+
+private:
+	Command &command;
+	JSON::ListReader<Member, MemberReader> members;
+};
+
+bool Command::Parse(std::string_view message)
+{
+	try
+	{
+		CommandReader reader(*this);
+		return JSON::Parse(message, NAME, reader);
 	}
 	catch (nlohmann::json::parse_error& ex)
 	{
@@ -73,21 +88,21 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":{";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{');
 
-    out += (sort_type != SortType::Undefined ? quot(SORT_TYPE) + ":" + std::to_string(static_cast<int32_t>(sort_type)) + "," : "") +
-        (show_numbers ? quot(SHOW_NUMBERS) + ":1," : "");
+	if (sort_type != SortType::Undefined) writer.Key(SORT_TYPE).Number(static_cast<int32_t>(sort_type)).Raw(',');
+	if (show_numbers) writer.Key(SHOW_NUMBERS).Raw("1,");
 
-    out += quot(MEMBERS) + ":[";
+	writer.Key(MEMBERS).Raw('[');
 	for (auto &m : members)
 	{
-		out += m.Serialize() + ",";
-	}
-	if (!members.empty())
-	{
-		out.pop_back(); // drop last ","
+		m.Serialize(writer);
+		writer.Raw(',');
 	}
-	return out + "]}}";
+	writer.DropComma();
+	writer.Raw("]}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdContactsUpdate.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -59,9 +58,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(ACTION) + ":" + std::to_string(static_cast<uint32_t>(action)) + "," +
-        quot(CLIENT_ID) + ":" + std::to_string(client_id) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ACTION).Number(static_cast<uint32_t>(action)).Raw(',')
+		.Key(CLIENT_ID).Number(client_id).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdDeliveryBlobs.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -59,17 +58,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
-	for (auto& b : blobs)
-	{
-		out += b.Serialize() + ",";
-	}
-	if (!blobs.empty())
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
+	for (auto &b : blobs)
 	{
-		out.pop_back(); // drop last ","
+		b.Serialize(writer);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdDeliveryMessages.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -43,18 +42,9 @@ bool Command::Parse(std::string_view message)
 {
 	try
 	{
-		auto j = nlohmann::json::parse(message);
-		auto deliveries = j.get<nlohmann::json::object_t>().at(NAME);
-		for (auto &d : deliveries)
-		{
-			Message message;
-			if (message.Parse(d))
-			{
-				messages.emplace_back(message);
-			}
-		}
-
-		return true;
+		JSON::ListReader<Message, MessageReader> reader;
+		reader.Reset(&messages);
+		return JSON::Parse(message, NAME, reader);
 	}
 	catch (nlohmann::json::parse_error& ex)
 	{
@@ -65,17 +55,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
 	for (auto &m : messages)
 	{
-		out += m.Serialize() + ",";
-	}
-	if (!messages.empty())
-	{
-		out.pop_back(); // drop last ","
+		m.Serialize(writer);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdDeviceConnect.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -94,20 +93,23 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(CONNECT_TYPE) + ":" + std::to_string(static_cast<int32_t>(connect_type)) + "," +
-		quot(DEVICE_TYPE) + ":" + std::to_string(static_cast<int32_t>(device_type)) + "," +
-		quot(DEVICE_ID) + ":" + std::to_string(device_id) + "," +
-		quot(CLIENT_ID) + ":" + std::to_string(client_id) + "," +
-		quot(METADATA) + ":" + quot(Common::JSON::Screen(metadata)) + "," +
-		quot(RECEIVER_SSRC) + ":" + std::to_string(receiver_ssrc) + "," +
-		quot(AUTHOR_SSRC) + ":" + std::to_string(author_ssrc) + "," +
-		quot(ADDRESS) + ":" + quot(Common::JSON::Screen(address)) + "," +
-		quot(PORT) + ":" + std::to_string(port) + "," +
-		quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," +
-		quot(RESOLUTION) + ":" + std::to_string(resolution) + "," +
-		quot(COLOR_SPACE) + ":" + std::to_string(static_cast<int32_t>(color_space)) + "," +
-		quot(MY) + ":" + (my ? "1" : "0") + "," +
-		quot(SECURE_KEY) + ":" + quot(Common::JSON::Screen(secure_key)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(CONNECT_TYPE).Number(static_cast<int32_t>(connect_type)).Raw(',')
+		.Key(DEVICE_TYPE).Number(static_cast<int32_t>(device_type)).Raw(',')
+		.Key(DEVICE_ID).Number(device_id).Raw(',')
+		.Key(CLIENT_ID).Number(client_id).Raw(',')
+		.Key(METADATA).String(metadata).Raw(',')
+		.Key(RECEIVER_SSRC).Number(receiver_ssrc).Raw(',')
+		.Key(AUTHOR_SSRC).Number(author_ssrc).Raw(',')
+		.Key(ADDRESS).String(address).Raw(',')
+		.Key(PORT).Number(port).Raw(',')
+		.Key(NAME_).String(name).Raw(',')
+		.Key(RESOLUTION).Number(resolution).Raw(',')
+		.Key(COLOR_SPACE).Number(static_cast<int32_t>(color_space)).Raw(',')
+		.Key(MY).Raw(my ? '1' : '0').Raw(',')
+		.Key(SECURE_KEY).String(secure_key).Raw("}}");
+	return writer.Result();
 }
 
 }
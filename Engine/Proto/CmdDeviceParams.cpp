@@ -7,8 +7,7 @@
 
 #include <Proto/CmdDeviceParams.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -83,14 +82,17 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ID) + ":" + std::to_string(id) + "," +
-		quot(SSRC) + ":" + std::to_string(ssrc) + "," +
-		quot(DEVICE_TYPE) + ":" + std::to_string(static_cast<int32_t>(device_type)) + "," +
-		quot(ORD) + ":" + std::to_string(ord) + "," +
-		quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," +
-		quot(METADATA) + ":" + quot(Common::JSON::Screen(metadata)) + "," +
-		quot(RESOLUTION) + ":" + std::to_string(resolution) + "," +
-		quot(COLOR_SPACE) + ":" + std::to_string(static_cast<int32_t>(color_space)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ID).Number(id).Raw(',')
+		.Key(SSRC).Number(ssrc).Raw(',')
+		.Key(DEVICE_TYPE).Number(static_cast<int32_t>(device_type)).Raw(',')
+		.Key(ORD).Number(ord).Raw(',')
+		.Key(NAME_).String(name).Raw(',')
+		.Key(METADATA).String(metadata).Raw(',')
+		.Key(RESOLUTION).Number(resolution).Raw(',')
+		.Key(COLOR_SPACE).Number(static_cast<int32_t>(color_space)).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdGroupList.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -37,18 +36,9 @@ bool Command::Parse(std::string_view message)
 {
 	try
 	{
-		auto j = nlohmann::json::parse(message);
-		auto groups_ = j.get<nlohmann::json::object_t>().at(NAME);
-		for (auto &g : groups_)
-		{
-			Group group;
-			if (group.Parse(g))
-			{
-				groups.emplace_back(group);
-			}
-		}
-				
-		return true;
+		JSON::ListReader<Group, GroupReader> reader;
+		reader.Reset(&groups);
+		return JSON::Parse(message, NAME, reader);
 	}
 	catch (nlohmann::json::parse_error& ex)
 	{
@@ -59,17 +49,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
 	for (auto &g : groups)
 	{
-		out += g.Serialize() + ",";
-	}
-	if (!groups.empty())
-	{
-		out.pop_back(); // drop last ","
+		g.Serialize(writer);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
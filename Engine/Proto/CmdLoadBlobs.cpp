@@ -7,8 +7,7 @@
 
 #include <Proto/CmdLoadBlobs.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,17 +54,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
-	for (auto& g : guids)
-	{
-		out += quot(g) + ",";
-	}
-	if (!guids.empty())
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
+	for (auto &g : guids)
 	{
-		out.pop_back(); // drop last ","
+		writer.Quoted(g);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
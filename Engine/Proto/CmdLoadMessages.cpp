@@ -7,8 +7,7 @@
 
 #include <Proto/CmdLoadMessages.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,7 +54,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + (from != 0 ? quot(FROM) + ":" + std::to_string(from) : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{');
+	if (from != 0) writer.Key(FROM).Number(from);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
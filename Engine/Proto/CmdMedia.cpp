@@ -7,8 +7,7 @@
 
 #include <Proto/CmdMedia.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -65,11 +64,14 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-    return "{" + quot(NAME) + ":{" +
-        quot(DATA) + ":" + quot(data) +
-        (ssrc != 0 ? "," + quot(SSRC) + ":" + std::to_string(ssrc) : "") +
-        (!addr.empty() ? "," + quot(ADDR) + ":" + quot(addr) : "") +
-        (media_type != MediaType::Undefined ? "," + quot(MEDIA_TYPE) + ":" + std::to_string(static_cast<int>(media_type)) : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(DATA).Quoted(data);
+	if (ssrc != 0) writer.Raw(',').Key(SSRC).Number(ssrc);
+	if (!addr.empty()) writer.Raw(',').Key(ADDR).Quoted(addr);
+	if (media_type != MediaType::Undefined) writer.Raw(',').Key(MEDIA_TYPE).Number(static_cast<int>(media_type));
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
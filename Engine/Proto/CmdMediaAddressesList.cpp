@@ -7,7 +7,7 @@
 
 #include <Proto/CmdMediaAddressesList.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,17 +55,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":[";
-
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('[');
 	for (auto &a : addresses)
 	{
-		out += "\"" + a + "\",";
-	}
-	if (!addresses.empty())
-	{
-		out.pop_back(); // drop last ","
+		writer.Quoted(a);
+		writer.Raw(',');
 	}
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
+	return writer.Result();
 }
 
 }
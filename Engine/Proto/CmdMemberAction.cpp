@@ -7,8 +7,7 @@
 
 #include <Proto/CmdMemberAction.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -86,26 +85,24 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	std::string out = "{" + quot(NAME) + ":{" + quot(IDS) + ":[";
-	
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{').Key(IDS).Raw('[');
 	for (auto &i : ids)
 	{
-		out += std::to_string(i) + ",";
+		writer.Number(i).Raw(',');
 	}
-	if (!ids.empty())
-	{
-		out.pop_back(); // drop last ","
-	}
-	out += "],";
-	
-    out += (action != Action::Undefined ? quot(ACTION) + ":" + std::to_string(static_cast<int32_t>(action)) + "," : "") +
-        (result != Result::Undefined ? quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) + "," : "") +
-        (actor_id != 0 ? quot(ACTOR_ID) + ":" + std::to_string(actor_id) + "," : "") +
-        (!actor_name.empty() ? quot(ACTOR_NAME) + ":" + quot(Common::JSON::Screen(actor_name)) + "," : "") +
-        (grants != 0 ? quot(GRANTS) + ":" + std::to_string(grants) + "," : "");
-
-	out.pop_back(); // drop last ","
-	return out + "}}";
+	writer.DropComma();
+	writer.Raw("],");
+
+	if (action != Action::Undefined) writer.Key(ACTION).Number(static_cast<int32_t>(action)).Raw(',');
+	if (result != Result::Undefined) writer.Key(RESULT).Number(static_cast<int32_t>(result)).Raw(',');
+	if (actor_id != 0) writer.Key(ACTOR_ID).Number(actor_id).Raw(',');
+	if (!actor_name.empty()) writer.Key(ACTOR_NAME).String(actor_name).Raw(',');
+	if (grants != 0) writer.Key(GRANTS).Number(grants).Raw(',');
+
+	writer.DropComma();
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,7 +7,7 @@
 
 #include <Proto/CmdMicrophoneActive.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -60,9 +60,12 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ACTIVE_TYPE) + ":" + std::to_string(static_cast<int32_t>(active_type)) + "," +
-		quot(DEVICE_ID) + ":" + std::to_string(device_id) + "," +
-		quot(CLIENT_ID) + ":" + std::to_string(client_id) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ACTIVE_TYPE).Number(static_cast<int32_t>(active_type)).Raw(',')
+		.Key(DEVICE_ID).Number(device_id).Raw(',')
+		.Key(CLIENT_ID).Number(client_id).Raw("}}");
+	return writer.Result();
 }
 
 }
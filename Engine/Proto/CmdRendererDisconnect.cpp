@@ -7,7 +7,7 @@
 
 #include <Proto/CmdRendererDisconnect.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -57,8 +57,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(DEVICE_ID) + ":" + std::to_string(device_id) + "," +
-		quot(SSRC) + ":" + std::to_string(ssrc) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(DEVICE_ID).Number(device_id).Raw(',')
+		.Key(SSRC).Number(ssrc).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,7 +7,7 @@
 
 #include <Proto/CmdResolutionChange.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -57,7 +57,11 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(ID) + ":" + std::to_string(id) + "," + quot(RESOLUTION) + ":" + std::to_string(resolution) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ID).Number(id).Raw(',')
+		.Key(RESOLUTION).Number(resolution).Raw("}}");
+	return writer.Result();
 }
 
 }
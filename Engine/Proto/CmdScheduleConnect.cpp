@@ -7,8 +7,7 @@
 
 #include <Proto/CmdScheduleConnect.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -61,9 +60,12 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) + "," +
-		quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," +
-		quot(TIME_LIMIT) + ":" + std::to_string(time_limit) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(TAG).String(tag).Raw(',')
+		.Key(NAME_).String(name).Raw(',')
+		.Key(TIME_LIMIT).Number(time_limit).Raw("}}");
+	return writer.Result();
 }
 
 }
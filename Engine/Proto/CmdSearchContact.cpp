@@ -7,8 +7,7 @@
 
 #include <Proto/CmdSearchContact.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,7 +54,10 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(QUERY) + ":" + quot(Common::JSON::Screen(query)) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(QUERY).String(query).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdSendConnectToConference.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -65,11 +64,14 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) + "," +
-		quot(CONNECTER_ID) + ":" + std::to_string(connecter_id) + "," + 
-		quot(CONNECTER_CONNECTION_ID) + ":" + std::to_string(connecter_connection_id) +
-        (flags != 0 ? "," + quot(FLAGS) + ":" + std::to_string(flags) : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(TAG).String(tag).Raw(',')
+		.Key(CONNECTER_ID).Number(connecter_id).Raw(',')
+		.Key(CONNECTER_CONNECTION_ID).Number(connecter_connection_id);
+	if (flags != 0) writer.Raw(',').Key(FLAGS).Number(flags);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
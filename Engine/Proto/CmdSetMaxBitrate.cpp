@@ -7,8 +7,7 @@
 
 #include <Proto/CmdSetMaxBitrate.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -55,7 +54,10 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(BITRATE) + ":" + std::to_string(bitrate) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(BITRATE).Number(bitrate).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,7 +7,7 @@
 
 #include <Proto/CmdTurnSpeaker.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -43,7 +43,9 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + "}";
+	JSON::Writer writer;
+	writer.Raw('{').Quoted(NAME).Raw('}');
+	return writer.Result();
 }
 
 }
@@ -7,7 +7,7 @@
 
 #include <Proto/CmdUpdateGrants.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -54,7 +54,10 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(GRANTS) + ":" + std::to_string(grants) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(GRANTS).Number(grants).Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdUserUpdateRequest.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -26,7 +25,6 @@ static const std::string AVATAR = "avatar";
 static const std::string LOGIN = "login";
 static const std::string PASSWORD = "password";
 
-
 Command::Command()
 	: action(Action::Undefined), id(0), name(), login(), password()
 {
@@ -76,14 +74,16 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(ACTION) + ":" + std::to_string(static_cast<int32_t>(action)) + 
-		(id != 0 ? "," + quot(ID) + ":" + std::to_string(id) : "") +
-		(!name.empty() ? "," + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) : "") +
-		(!avatar.empty() ? "," + quot(AVATAR) + ":" + quot(Common::JSON::Screen(avatar)) : "") +
-		(!login.empty() ? "," + quot(LOGIN) + ":" + quot(Common::JSON::Screen(login)) : "") +
-		(!password.empty() ? "," + quot(PASSWORD) + ":" + quot(Common::JSON::Screen(password)) : "") 
-		+ "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ACTION).Number(static_cast<int32_t>(action));
+	if (id != 0) writer.Raw(',').Key(ID).Number(id);
+	if (!name.empty()) writer.Raw(',').Key(NAME_).String(name);
+	if (!avatar.empty()) writer.Raw(',').Key(AVATAR).String(avatar);
+	if (!login.empty()) writer.Raw(',').Key(LOGIN).String(login);
+	if (!password.empty()) writer.Raw(',').Key(PASSWORD).String(password);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/CmdUserUpdateResponse.h>
 
-#include <Common/JSONSymbolsScreener.h>
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -62,11 +61,14 @@ bool Command::Parse(std::string_view msg)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + 
-		quot(ACTION) + ":" + std::to_string(static_cast<int32_t>(action)) + "," +
-		quot(RESULT) + ":" + std::to_string(static_cast<int32_t>(result)) +
-		(user_id != -1 ? "," + quot(USER_ID) + ":" + std::to_string(user_id) : "") +
-		(!message.empty() ? "," + quot(MESSAGE) + ":" + quot(Common::JSON::Screen(message)) : "") + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(ACTION).Number(static_cast<int32_t>(action)).Raw(',')
+		.Key(RESULT).Number(static_cast<int32_t>(result));
+	if (user_id != -1) writer.Raw(',').Key(USER_ID).Number(user_id);
+	if (!message.empty()) writer.Raw(',').Key(MESSAGE).String(message);
+	writer.Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,7 +7,7 @@
 
 #include <Proto/CmdWantSpeak.h>
 
-#include <Common/Quoter.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -60,9 +60,12 @@ bool Command::Parse(std::string_view message)
 
 std::string Command::Serialize()
 {
-	return "{" + quot(NAME) + ":{" + quot(USER_ID) + ":" + std::to_string(user_id) + "," +
-		quot(USER_NAME) + ":" + quot(user_name) + "," +
-		quot(IS_SPEAK) + ":" + std::to_string(is_speak ? 1 : 0) + "}}";
+	JSON::Writer writer;
+	writer.Raw('{').Key(NAME).Raw('{')
+		.Key(USER_ID).Number(user_id).Raw(',')
+		.Key(USER_NAME).Quoted(user_name).Raw(',')
+		.Key(IS_SPEAK).Raw(is_speak ? '1' : '0').Raw("}}");
+	return writer.Result();
 }
 
 }
@@ -7,249 +7,169 @@
 
 #include <Proto/CommandType.h>
 
-#include <boost/algorithm/string.hpp>
-#include <algorithm>
-#include <vector>
-
-#include <Common/Quoter.h>
-
-#include <Proto/CmdUserUpdateRequest.h>
-#include <Proto/CmdUserUpdateResponse.h>
-#include <Proto/CmdConnectRequest.h>
-#include <Proto/CmdConnectResponse.h>
-#include <Proto/CmdDisconnect.h>
-#include <Proto/CmdChangeServer.h>
-#include <Proto/CmdPing.h>
-#include <Proto/CmdSetMaxBitrate.h>
-#include <Proto/CmdUpdateGrants.h>
-#include <Proto/CmdContactList.h>
-#include <Proto/CmdSearchContact.h>
-#include <Proto/CmdContactsUpdate.h>
-#include <Proto/CmdGroupList.h>
-#include <Proto/CmdConferencesList.h>
-#include <Proto/CmdDeviceParams.h>
-#include <Proto/CmdDeviceConnect.h>
-#include <Proto/CmdDeviceDisconnect.h>
-#include <Proto/CmdRendererConnect.h>
-#include <Proto/CmdRendererDisconnect.h>
-#include <Proto/CmdResolutionChange.h>
-#include <Proto/CmdMicrophoneActive.h>
-#include <Proto/CmdCallRequest.h>
-#include <Proto/CmdCallResponse.h>
-#include <Proto/CmdConferenceUpdateRequest.h>
-#include <Proto/CmdConferenceUpdateResponse.h>
-#include <Proto/CmdCreateTempConference.h>
-#include <Proto/CmdSendConnectToConference.h>
-#include <Proto/CmdConnectToConferenceRequest.h>
-#include <Proto/CmdConnectToConferenceResponse.h>
-#include <Proto/CmdDisconnectFromConference.h>
-#include <Proto/CmdChangeContactState.h>
-#include <Proto/CmdChangeMemberState.h>
-#include <Proto/CmdTurnSpeaker.h>
-#include <Proto/CmdMemberAction.h>
-#include <Proto/CmdWantSpeak.h>
-#include <Proto/CmdScheduleConnect.h>
-#include <Proto/CmdDeliveryMessages.h>
-#include <Proto/CmdLoadMessages.h>
-#include <Proto/CmdDeliveryBlobs.h>
-#include <Proto/CmdLoadBlobs.h>
-#include <Proto/CmdRequestMediaAddresses.h>
-#include <Proto/CmdMediaAddressesList.h>
-#include <Proto/CmdMedia.h>
+#include <array>
+#include <cstdint>
 
 namespace Proto
 {
 
-CommandType GetCommandType(std::string_view message)
+struct CommandName
 {
-	auto firstQuotePos = message.find_first_of('"');
-	if (firstQuotePos == std::string::npos)
-	{
-		return CommandType::Undefined;
-	}
-	auto secondQuotePos = message.find_first_of('"', firstQuotePos + 1);
-	if (secondQuotePos == std::string::npos)
-	{
-		return CommandType::Undefined;
-	}
+	std::string_view name;
+	CommandType type;
+};
 
-	std::string command = std::string(message.substr(firstQuotePos, secondQuotePos));
-	std::transform(command.begin(), command.end(), command.begin(), ::tolower);
+/// Has to follow the NAME constants of the commands
+static constexpr CommandName COMMANDS[] =
+{
+	{ "user_update_request", CommandType::UserUpdateRequest },
+	{ "user_update_response", CommandType::UserUpdateResponse },
+	{ "connect_request", CommandType::ConnectRequest },
+	{ "connect_response", CommandType::ConnectResponse },
+	{ "disconnect", CommandType::Disconnect },
+	{ "change_server", CommandType::ChangeServer },
+	{ "ping", CommandType::Ping },
+	{ "set_max_bitrate", CommandType::SetMaxBitrate },
+	{ "update_grants", CommandType::UpdateGrants },
+	{ "contact_list", CommandType::ContactList },
+	{ "search_contact", CommandType::SearchContact },
+	{ "contacts_update", CommandType::ContactsUpdate },
+	{ "group_list", CommandType::GroupList },
+	{ "conferences_list", CommandType::ConferencesList },
+	{ "device_params", CommandType::DeviceParams },
+	{ "device_connect", CommandType::DeviceConnect },
+	{ "device_disconnect", CommandType::DeviceDisconnect },
+	{ "renderer_connect", CommandType::RendererConnect },
+	{ "renderer_disconnect", CommandType::RendererDisconnect },
+	{ "resolution_change", CommandType::ResolutionChange },
+	{ "microphone_active", CommandType::MicrophoneActive },
+	{ "call_request", CommandType::CallRequest },
+	{ "call_response", CommandType::CallResponse },
+	{ "conference_update_request", CommandType::ConferenceUpdateRequest },
+	{ "conference_update_response", CommandType::ConferenceUpdateResponse },
+	{ "create_temp_conference", CommandType::CreateTempConference },
+	{ "send_connect_to_conference", CommandType::SendConnectToConference },
+	{ "connect_to_conference_request", CommandType::ConnectToConferenceRequest },
+	{ "connect_to_conference_response", CommandType::ConnectToConferenceResponse },
+	{ "disconnect_from_conference", CommandType::DisconnectFromConference },
+	{ "change_contact_state", CommandType::ChangeContactState },
+	{ "change_member_state", CommandType::ChangeMemberState },
+	{ "turn_speaker", CommandType::TurnSpeaker },
+	{ "member_action", CommandType::MemberAction },
+	{ "want_speak", CommandType::WantSpeak },
+	{ "schedule_connect", CommandType::ScheduleConnect },
+	{ "delivery_messages", CommandType::DeliveryMessages },
+	{ "load_messages", CommandType::LoadMessages },
+	{ "delivery_blobs", CommandType::DeliveryBlobs },
+	{ "load_blobs", CommandType::LoadBlobs },
+	{ "request_media_addresses", CommandType::RequestMediaAddresses },
+	{ "media_addresses_list", CommandType::MediaAddressesList },
+	{ "media", CommandType::Media },
+};
 
-	if (command == quot(Proto::USER_UPDATE_REQUEST::NAME))
-	{
-		return CommandType::UserUpdateRequest;
-	}
-	else if (command == quot(Proto::USER_UPDATE_RESPONSE::NAME))
-	{
-		return CommandType::UserUpdateResponse;
-	}
-	else if (command == quot(Proto::CONNECT_REQUEST::NAME))
-	{
-		return CommandType::ConnectRequest;
-	}
-	else if (command == quot(Proto::CONNECT_RESPONSE::NAME))
-	{
-		return CommandType::ConnectResponse;
-	}
-	else if (command == quot(Proto::DISCONNECT::NAME))
-	{
-		return CommandType::Disconnect;
-	}
-	else if (command == quot(Proto::CHANGE_SERVER::NAME))
-	{
-		return CommandType::ChangeServer;
-	}
-	else if (command == quot(Proto::PING::NAME))
-	{
-		return CommandType::Ping;
-	}
-	else if (command == quot(Proto::SET_MAX_BITRATE::NAME))
-	{
-		return CommandType::SetMaxBitrate;
-	}
-	else if (command == quot(Proto::UPDATE_GRANTS::NAME))
-	{
-		return CommandType::UpdateGrants;
-	}
-	else if (command == quot(Proto::CONTACT_LIST::NAME))
-	{
-		return CommandType::ContactList;
-	}
-	else if (command == quot(Proto::SEARCH_CONTACT::NAME))
-	{
-		return CommandType::SearchContact;
-	}
-	else if (command == quot(Proto::CONTACTS_UPDATE::NAME))
-	{
-		return CommandType::ContactsUpdate;
-	}
-	else if (command == quot(Proto::GROUP_LIST::NAME))
-	{
-		return CommandType::GroupList;
-	}
-	else if (command == quot(Proto::CONFERENCES_LIST::NAME))
-	{
-		return CommandType::ConferencesList;
-	}
-	else if (command == quot(Proto::DEVICE_PARAMS::NAME))
-	{
-		return CommandType::DeviceParams;
-	}
-	else if (command == quot(Proto::DEVICE_CONNECT::NAME))
-	{
-		return CommandType::DeviceConnect;
-	}
-	else if (command == quot(Proto::DEVICE_DISCONNECT::NAME))
-	{
-		return CommandType::DeviceDisconnect;
-	}
-	else if (command == quot(Proto::RENDERER_CONNECT::NAME))
-	{
-		return CommandType::RendererConnect;
-	}
-	else if (command == quot(Proto::RENDERER_DISCONNECT::NAME))
-	{
-		return CommandType::RendererDisconnect;
-	}
-	else if (command == quot(Proto::RESOLUTION_CHANGE::NAME))
-	{
-		return CommandType::ResolutionChange;
-	}
-	else if (command == quot(Proto::MICROPHONE_ACTIVE::NAME))
-	{
-		return CommandType::MicrophoneActive;
-	}
-	else if (command == quot(Proto::CALL_REQUEST::NAME))
-	{
-		return CommandType::CallRequest;
-	}
-	else if (command == quot(Proto::CALL_RESPONSE::NAME))
-	{
-		return CommandType::CallResponse;
-	}
-	else if (command == quot(Proto::CONFERENCE_UPDATE_REQUEST::NAME))
-	{
-		return CommandType::ConferenceUpdateRequest;
-	}
-	else if (command == quot(Proto::CONFERENCE_UPDATE_RESPONSE::NAME))
-	{
-		return CommandType::ConferenceUpdateResponse;
-	}
-	else if (command == quot(Proto::CREATE_TEMP_CONFERENCE::NAME))
-	{
-		return CommandType::CreateTempConference;
-	}
-	else if (command == quot(Proto::SEND_CONNECT_TO_CONFERENCE::NAME))
-	{
-		return CommandType::SendConnectToConference;
-	}
-	else if (command == quot(Proto::CONNECT_TO_CONFERENCE_REQUEST::NAME))
-	{
-		return CommandType::ConnectToConferenceRequest;
-	}
-	else if (command == quot(Proto::CONNECT_TO_CONFERENCE_RESPONSE::NAME))
-	{
-		return CommandType::ConnectToConferenceResponse;
-	}
-	else if (command == quot(Proto::DISCONNECT_FROM_CONFERENCE::NAME))
-	{
-		return CommandType::DisconnectFromConference;
-	}
-	else if (command == quot(Proto::CHANGE_CONTACT_STATE::NAME))
-	{
-		return CommandType::ChangeContactState;
-	}
-	else if (command == quot(Proto::CHANGE_MEMBER_STATE::NAME))
+static constexpr size_t COMMANDS_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static constexpr size_t TABLE_SIZE = 256; /// Power of two, big enough to find the seed quickly
+static constexpr uint8_t EMPTY_SLOT = 0xFF;
+
+static_assert(COMMANDS_COUNT < EMPTY_SLOT, "Too many commands for the table");
+
+static constexpr char Lower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/// FNV-1a of the lower case name
+static constexpr uint32_t Hash(std::string_view name, uint32_t seed)
+{
+	uint32_t hash = 2166136261u ^ seed;
+	for (auto c : name)
 	{
-		return CommandType::ChangeMemberState;
+		hash = (hash ^ static_cast<uint8_t>(Lower(c))) * 16777619u;
 	}
-	else if (command == quot(Proto::TURN_SPEAKER::NAME))
-	{
-		return CommandType::TurnSpeaker;
+	return hash & (TABLE_SIZE - 1);
+}
+
+/// The first seed which gives no collisions for the names
+static constexpr uint32_t FindSeed()
+{
+	for (uint32_t seed = 0; seed != 100000; ++seed)
+	{
+		bool used[TABLE_SIZE] = {};
+		bool collision = false;
+		for (size_t i = 0; i != COMMANDS_COUNT && !collision; ++i)
+		{
+			auto slot = Hash(COMMANDS[i].name, seed);
+			collision = used[slot];
+			used[slot] = true;
+		}
+		if (!collision)
+		{
+			return seed;
+		}
 	}
-	else if (command == quot(Proto::MEMBER_ACTION::NAME))
+	return UINT32_MAX;
+}
+
+static constexpr uint32_t SEED = FindSeed();
+
+static_assert(SEED != UINT32_MAX, "No perfect hash seed for the command names");
+
+/// Slot to the index in the COMMANDS
+static constexpr std::array<uint8_t, TABLE_SIZE> MakeTable()
+{
+	std::array<uint8_t, TABLE_SIZE> table{};
+	for (auto &slot : table)
 	{
-		return CommandType::MemberAction;
+		slot = EMPTY_SLOT;
 	}
-	else if (command == quot(Proto::WANT_SPEAK::NAME))
+	for (size_t i = 0; i != COMMANDS_COUNT; ++i)
 	{
-		return CommandType::WantSpeak;
+		table[Hash(COMMANDS[i].name, SEED)] = static_cast<uint8_t>(i);
 	}
-	else if (command == quot(Proto::SCHEDULE_CONNECT::NAME))
+	return table;
+}
+
+static constexpr auto TABLE = MakeTable();
+
+static bool EqualsIgnoreCase(std::string_view key, std::string_view name)
+{
+	if (key.size() != name.size())
 	{
-		return CommandType::ScheduleConnect;
+		return false;
 	}
-	else if (command == quot(Proto::DELIVERY_MESSAGES::NAME))
+	for (size_t i = 0; i != key.size(); ++i)
 	{
-		return CommandType::DeliveryMessages;
+		if (Lower(key[i]) != name[i])
+		{
+			return false;
+		}
 	}
-	else if (command == quot(Proto::LOAD_MESSAGES::NAME))
+	return true;
+}
+
+CommandType GetCommandType(std::string_view message)
+{
+	auto firstQuotePos = message.find_first_of('"');
+	if (firstQuotePos == std::string::npos)
 	{
-		return CommandType::LoadMessages;
+		return CommandType::Undefined;
 	}
-	else if (command == quot(Proto::DELIVERY_BLOBS::NAME))
-	{
-		return CommandType::DeliveryBlobs;
-		}
-	else if (command == quot(Proto::LOAD_BLOBS::NAME))
-	{
-		return CommandType::LoadBlobs;
-		}
-	else if (command == quot(Proto::REQUEST_MEDIA_ADDRESSES::NAME))
+	auto secondQuotePos = message.find_first_of('"', firstQuotePos + 1);
+	if (secondQuotePos == std::string::npos)
 	{
-		return CommandType::RequestMediaAddresses;
+		return CommandType::Undefined;
 	}
-	else if (command == quot(Proto::MEDIA_ADDRESSES_LIST::NAME))
+
+	auto key = message.substr(firstQuotePos + 1, secondQuotePos - firstQuotePos - 1);
+
+	auto index = TABLE[Hash(key, SEED)];
+	if (index == EMPTY_SLOT || !EqualsIgnoreCase(key, COMMANDS[index].name))
 	{
-		return CommandType::MediaAddressesList;
+		return CommandType::Undefined;
 	}
-	else if (command == quot(Proto::MEDIA::NAME))
-	{
-		return CommandType::Media;
-		}
 
-	return CommandType::Undefined;
+	return COMMANDS[index].type;
 }
 
 }
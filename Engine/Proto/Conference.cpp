@@ -7,8 +7,7 @@
 
 #include <Proto/Conference.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -123,32 +122,80 @@ bool Conference::Parse(const nlohmann::json::object_t& obj)
 	return false;
 }
 
-std::string Conference::Serialize()
+ConferenceReader::ConferenceReader()
+	: conference(nullptr),
+	hasId(false),
+	members()
 {
-	std::string out = "{" + quot(ID) + ":" + std::to_string(id) + "," +
-		(!tag.empty() ? quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) + "," : "") +
-		(!name.empty() ? quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) + "," : "") +
-		(!descr.empty() ? quot(DESCR) + ":" + quot(Common::JSON::Screen(descr)) + "," : "") +
-		(!founder.empty() ? quot(FOUNDER) + ":" + quot(Common::JSON::Screen(founder)) + "," : "") +
-		(founder_id != 0 ? quot(FOUNDER_ID) + ":" + std::to_string(founder_id) + "," : "") +
-		(type != ConferenceType::Undefined ? quot(TYPE) + ":" + std::to_string(static_cast<int32_t>(type)) + "," : "") +
-		(grants != 0 ? quot(GRANTS) + ":" + std::to_string(grants) + "," : "") +
-		(duration != 0 ? quot(DURATION) + ":" + std::to_string(duration) + "," : "") +
-		(connect_members ? quot(CONNECT_MEMBERS) + ":1," : "") +
-		(temp ? quot(TEMP) + ":1," : "") +
-		(deleted ? quot(DELETED) + ":1," : "") +
-		quot(MEMBERS) + ":[";
+}
 
-	for (auto &m : members)
+void ConferenceReader::Reset(Conference *conference_)
+{
+	conference = conference_;
+	hasId = false;
+}
+
+void ConferenceReader::Set(std::string_view key, JSON::Value &value)
+{
+	if (key == ID) { conference->id = value.As<int64_t>(); hasId = true; }
+	else if (key == TAG) value.Take(conference->tag);
+	else if (key == NAME_) value.Take(conference->name);
+	else if (key == DESCR) value.Take(conference->descr);
+	else if (key == FOUNDER) value.Take(conference->founder);
+	else if (key == FOUNDER_ID) conference->founder_id = value.As<uint64_t>();
+	else if (key == TYPE) conference->type = static_cast<ConferenceType>(value.As<uint32_t>());
+	else if (key == GRANTS) conference->grants = value.As<uint32_t>();
+	else if (key == DURATION) conference->duration = value.As<uint32_t>();
+	else if (key == CONNECT_MEMBERS) conference->connect_members = value.As<uint32_t>();
+	else if (key == TEMP) conference->temp = value.As<uint32_t>();
+	else if (key == DELETED) conference->deleted = value.As<uint32_t>();
+}
+
+JSON::Reader *ConferenceReader::Nested(std::string_view key)
+{
+	if (key == MEMBERS)
 	{
-		out += m.Serialize() + ",";
+		members.Reset(&conference->members);
+		return &members;
 	}
-	if (!members.empty())
+	return nullptr;
+}
+
+bool ConferenceReader::End()
+{
+	return hasId;
+}
+
+std::string Conference::Serialize()
+{
+	JSON::Writer writer;
+	Serialize(writer);
+	return writer.Result();
+}
+
+void Conference::Serialize(JSON::Writer &writer)
+{
+	writer.Raw('{').Key(ID).Number(id).Raw(',');
+	if (!tag.empty()) writer.Key(TAG).String(tag).Raw(',');
+	if (!name.empty()) writer.Key(NAME_).String(name).Raw(',');
+	if (!descr.empty()) writer.Key(DESCR).String(descr).Raw(',');
+	if (!founder.empty()) writer.Key(FOUNDER).String(founder).Raw(',');
+	if (founder_id != 0) writer.Key(FOUNDER_ID).Number(founder_id).Raw(',');
+	if (type != ConferenceType::Undefined) writer.Key(TYPE).Number(static_cast<int32_t>(type)).Raw(',');
+	if (grants != 0) writer.Key(GRANTS).Number(grants).Raw(',');
+	if (duration != 0) writer.Key(DURATION).Number(duration).Raw(',');
+	if (connect_members) writer.Key(CONNECT_MEMBERS).Raw("1,");
+	if (temp) writer.Key(TEMP).Raw("1,");
+	if (deleted) writer.Key(DELETED).Raw("1,");
+
+	writer.Key(MEMBERS).Raw('[');
+	for (auto &m : members)
 	{
-		out.pop_back(); // drop last ","
+		m.Serialize(writer);
+		writer.Raw(',');
 	}
-
-	return out + "]}";
+	writer.DropComma();
+	writer.Raw("]}");
 }
 
 void Conference::Clear()
@@ -67,6 +67,7 @@ namespace Proto
 
 		bool Parse(const nlohmann::json::object_t& obj);
 		std::string Serialize();
+		void Serialize(JSON::Writer &writer); /// Appends to the writer of the outer command
 
 		void Clear();
 
@@ -80,4 +81,22 @@ namespace Proto
 			return tag == tag_;
 		}
 	};
+
+	/// Fills the conference during the streaming parsing
+	class ConferenceReader : public JSON::Reader
+	{
+	public:
+		ConferenceReader();
+
+		void Reset(Conference *conference);
+
+		void Set(std::string_view key, JSON::Value &value) override;
+		JSON::Reader *Nested(std::string_view key) override;
+		bool End() override;
+
+	private:
+		Conference *conference;
+		bool hasId;
+		JSON::ListReader<Member, MemberReader> members;
+	};
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/Group.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -69,17 +68,55 @@ bool Group::Parse(const nlohmann::json::object_t &obj)
 	return false;
 }
 
+GroupReader::GroupReader()
+	: group(nullptr),
+	hasId(false)
+{
+}
+
+void GroupReader::Reset(Group *group_)
+{
+	group = group_;
+	hasId = false;
+}
+
+void GroupReader::Set(std::string_view key, JSON::Value &value)
+{
+	if (key == ID) { group->id = value.As<int64_t>(); hasId = true; }
+	else if (key == PARENT_ID) group->parent_id = value.As<int64_t>();
+	else if (key == TAG) value.Take(group->tag);
+	else if (key == NAME_) value.Take(group->name);
+	else if (key == OWNER_ID) group->owner_id = value.As<int64_t>();
+	else if (key == PASSWORD) value.Take(group->password);
+	else if (key == GRANTS) group->grants = value.As<uint32_t>();
+	else if (key == LEVEL) group->level = value.As<int32_t>();
+	else if (key == DELETED) group->deleted = value.As<uint8_t>();
+}
+
+bool GroupReader::End()
+{
+	return hasId;
+}
+
 std::string Group::Serialize()
 {
-	return "{" + quot(ID) + ":" + std::to_string(id) +
-		(parent_id != -1 ? "," + quot(PARENT_ID) + ":" + std::to_string(parent_id) : "") +
-		(!tag.empty() ? "," + quot(TAG) + ":" + quot(Common::JSON::Screen(tag)) : "") +
-		(!name.empty() ? "," + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) : "") +
-		(owner_id != -1 ? "," + quot(OWNER_ID) + ":" + std::to_string(owner_id) : "") +
-		(!password.empty() ? "," + quot(PASSWORD) + ":" + quot(Common::JSON::Screen(password)) : "") +
-		(grants != 0 ? "," + quot(GRANTS) + ":" + std::to_string(grants) : "") +
-		(level != -1 ? "," + quot(LEVEL) + ":" + std::to_string(level) : "") +
-		(deleted ? "," + quot(DELETED) + ":1" : "") + "}";
+	JSON::Writer writer;
+	Serialize(writer);
+	return writer.Result();
+}
+
+void Group::Serialize(JSON::Writer &writer)
+{
+	writer.Raw('{').Key(ID).Number(id);
+	if (parent_id != -1) writer.Raw(',').Key(PARENT_ID).Number(parent_id);
+	if (!tag.empty()) writer.Raw(',').Key(TAG).String(tag);
+	if (!name.empty()) writer.Raw(',').Key(NAME_).String(name);
+	if (owner_id != -1) writer.Raw(',').Key(OWNER_ID).Number(owner_id);
+	if (!password.empty()) writer.Raw(',').Key(PASSWORD).String(password);
+	if (grants != 0) writer.Raw(',').Key(GRANTS).Number(grants);
+	if (level != -1) writer.Raw(',').Key(LEVEL).Number(level);
+	if (deleted) writer.Raw(',').Key(DELETED).Raw('1');
+	writer.Raw('}');
 }
 
 }
@@ -10,6 +10,9 @@
 #include <string>
 #include <cstdint>
 
+#include <Proto/JSONReader.h>
+#include <Proto/JSONWriter.h>
+
 #include <nlohmann/json.hpp>
 
 namespace Proto
@@ -49,10 +52,27 @@ namespace Proto
 
 		bool Parse(const nlohmann::json::object_t &pt);
 		std::string Serialize();
+		void Serialize(JSON::Writer &writer); /// Appends to the writer of the outer command
 
 		inline bool operator==(int64_t id_) const
 		{
 			return id == id_;
 		}
 	};
+
+	/// Fills the group during the streaming parsing
+	class GroupReader : public JSON::Reader
+	{
+	public:
+		GroupReader();
+
+		void Reset(Group *group);
+
+		void Set(std::string_view key, JSON::Value &value) override;
+		bool End() override;
+
+	private:
+		Group *group;
+		bool hasId;
+	};
 }
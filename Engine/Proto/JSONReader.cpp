@@ -0,0 +1,252 @@
+/**
+ * JSONReader.cpp - Contains the streaming JSON reader impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Proto/JSONReader.h>
+
+#include <nlohmann/json.hpp>
+
+namespace Proto
+{
+namespace JSON
+{
+
+Value::Value()
+	: type(Type::Null),
+	boolean(false),
+	integer(0),
+	unsigned_(0),
+	float_(0),
+	string()
+{
+}
+
+void Value::Take(std::string &out)
+{
+	if (type == Type::String)
+	{
+		out = std::move(string);
+	}
+}
+
+/// Gives the member of the root object with the name to the command's reader
+class RootReader : public Reader
+{
+public:
+	RootReader(std::string_view name_, Reader &reader_)
+		: name(name_),
+		reader(reader_),
+		found(false)
+	{
+	}
+
+	Reader *Nested(std::string_view key) override
+	{
+		if (key == name)
+		{
+			found = true;
+			return &reader;
+		}
+		return nullptr;
+	}
+
+	bool Found() const
+	{
+		return found;
+	}
+
+private:
+	std::string_view name;
+	Reader &reader;
+	bool found;
+};
+
+class SAXHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+	SAXHandler(Reader &root_)
+		: root(root_),
+		stack(),
+		depth(0),
+		skip(0),
+		value()
+	{
+	}
+
+	bool null() override
+	{
+		value.type = Value::Type::Null;
+		return Scalar();
+	}
+
+	bool boolean(bool val) override
+	{
+		value.type = Value::Type::Boolean;
+		value.boolean = val;
+		return Scalar();
+	}
+
+	bool number_integer(number_integer_t val) override
+	{
+		value.type = Value::Type::Integer;
+		value.integer = val;
+		return Scalar();
+	}
+
+	bool number_unsigned(number_unsigned_t val) override
+	{
+		value.type = Value::Type::Unsigned;
+		value.unsigned_ = val;
+		return Scalar();
+	}
+
+	bool number_float(number_float_t val, const string_t&) override
+	{
+		value.type = Value::Type::Float;
+		value.float_ = val;
+		return Scalar();
+	}
+
+	bool string(string_t &val) override
+	{
+		value.type = Value::Type::String;
+		value.string = std::move(val); /// The lexer clears its token buffer before the next token
+		return Scalar();
+	}
+
+	bool binary(binary_t&) override
+	{
+		return true;
+	}
+
+	bool start_object(std::size_t) override
+	{
+		return Open(false);
+	}
+
+	bool key(string_t &val) override
+	{
+		if (skip == 0)
+		{
+			Top().key = val;
+		}
+		return true;
+	}
+
+	bool end_object() override
+	{
+		return Close();
+	}
+
+	bool start_array(std::size_t) override
+	{
+		return Open(true);
+	}
+
+	bool end_array() override
+	{
+		return Close();
+	}
+
+	bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception &ex) override
+	{
+		if (auto parseError = dynamic_cast<const nlohmann::json::parse_error*>(&ex))
+		{
+			throw *parseError;
+		}
+		return false;
+	}
+
+private:
+	struct Frame
+	{
+		Reader *reader;
+		bool array;
+		std::string key; /// Current key of the object
+	};
+
+	Reader &root;
+	std::vector<Frame> stack; /// Frames above the depth are kept to reuse the keys memory
+	size_t depth;
+	size_t skip; /// Depth inside of the subtree nobody reads
+	Value value;
+
+	Frame &Top()
+	{
+		return stack[depth - 1];
+	}
+
+	std::string_view Key()
+	{
+		return Top().array ? std::string_view() : std::string_view(Top().key);
+	}
+
+	bool Scalar()
+	{
+		if (skip == 0 && depth != 0)
+		{
+			Top().reader->Set(Key(), value);
+		}
+		return true;
+	}
+
+	bool Open(bool array)
+	{
+		if (skip != 0)
+		{
+			++skip;
+			return true;
+		}
+
+		auto reader = depth == 0 ? (array ? nullptr : &root) : Top().reader->Nested(Key());
+		if (!reader)
+		{
+			skip = 1;
+			return true;
+		}
+
+		if (depth == stack.size())
+		{
+			stack.emplace_back();
+		}
+		++depth;
+		Top().reader = reader;
+		Top().array = array;
+		Top().key.clear();
+
+		return true;
+	}
+
+	bool Close()
+	{
+		if (skip != 0)
+		{
+			--skip;
+			return true;
+		}
+
+		auto valid = Top().reader->End();
+		--depth;
+		if (!valid && depth != 0)
+		{
+			Top().reader->Drop();
+		}
+		return true;
+	}
+};
+
+bool Parse(std::string_view message, std::string_view name, Reader &reader)
+{
+	RootReader root(name, reader);
+	SAXHandler handler(root);
+
+	nlohmann::json::sax_parse(message.begin(), message.end(), &handler);
+
+	return root.Found();
+}
+
+}
+}
@@ -0,0 +1,116 @@
+/**
+ * JSONReader.h - Contains the streaming JSON reader of the protocol commands
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace Proto
+{
+namespace JSON
+{
+	/// Scalar value of the JSON, the string can be moved out
+	struct Value
+	{
+		enum class Type
+		{
+			Null,
+			Boolean,
+			Integer,
+			Unsigned,
+			Float,
+			String
+		};
+
+		Type type;
+
+		bool boolean;
+		int64_t integer;
+		uint64_t unsigned_;
+		double float_;
+		std::string string;
+
+		Value();
+
+		/// Numbers and booleans are converted like nlohmann::json::get<T>(), other types give T()
+		template<typename T>
+		T As() const
+		{
+			switch (type)
+			{
+				case Type::Boolean: return static_cast<T>(boolean);
+				case Type::Integer: return static_cast<T>(integer);
+				case Type::Unsigned: return static_cast<T>(unsigned_);
+				case Type::Float: return static_cast<T>(float_);
+				default: return T();
+			}
+		}
+
+		/// Moves the string to out, other types leave it as is
+		void Take(std::string &out);
+	};
+
+	/// Receives the content of one object or array during the parsing
+	class Reader
+	{
+	public:
+		virtual ~Reader() {}
+
+		/// Scalar member of the object, the key is empty for the items of the array
+		virtual void Set(std::string_view, Value &) {}
+
+		/// Reader of the nested object or array, nullptr skips it
+		virtual Reader *Nested(std::string_view) { return nullptr; }
+
+		/// The object or array is ended, false drops it from the parent
+		virtual bool End() { return true; }
+
+		/// The last nested object or array was not valid
+		virtual void Drop() {}
+	};
+
+	/// Fills the vector by the objects of the array, ItemReader has to have Reset(T*)
+	template<class T, class ItemReader>
+	class ListReader : public Reader
+	{
+	public:
+		ListReader()
+			: items(nullptr),
+			item()
+		{
+		}
+
+		void Reset(std::vector<T> *items_)
+		{
+			items = items_;
+		}
+
+		Reader *Nested(std::string_view) override
+		{
+			items->emplace_back();
+			item.Reset(&items->back());
+			return &item;
+		}
+
+		void Drop() override
+		{
+			items->pop_back();
+		}
+
+	private:
+		std::vector<T> *items;
+		ItemReader item;
+	};
+
+	/// Parses the message in one pass without the DOM, the content of the root member with the name goes to the reader.
+	/// Throws nlohmann::json::parse_error as nlohmann::json::parse() does, returns false if there is no such member
+	bool Parse(std::string_view message, std::string_view name, Reader &reader);
+}
+}
@@ -0,0 +1,106 @@
+/**
+ * JSONWriter.cpp - Contains the JSON writer impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Proto/JSONWriter.h>
+
+#include <Common/JSONSymbolsScreener.h>
+
+namespace Proto
+{
+namespace JSON
+{
+
+static const size_t MAX_KEPT_BUFFER = 4 * 1024 * 1024; /// Don't hold the memory of a rare huge list
+
+struct ThreadBuffer
+{
+	std::string buffer;
+	bool busy = false;
+};
+
+static thread_local ThreadBuffer threadBuffer;
+
+Writer::Writer()
+	: out(nullptr),
+	own(),
+	pooled(!threadBuffer.busy)
+{
+	if (pooled)
+	{
+		threadBuffer.busy = true;
+		out = &threadBuffer.buffer;
+		out->clear();
+	}
+	else
+	{
+		out = &own;
+	}
+}
+
+Writer::~Writer()
+{
+	if (pooled)
+	{
+		if (out->capacity() > MAX_KEPT_BUFFER)
+		{
+			std::string().swap(*out);
+		}
+		threadBuffer.busy = false;
+	}
+}
+
+Writer &Writer::Raw(std::string_view text)
+{
+	out->append(text);
+	return *this;
+}
+
+Writer &Writer::Raw(char c)
+{
+	out->push_back(c);
+	return *this;
+}
+
+Writer &Writer::Key(std::string_view key)
+{
+	out->push_back('"');
+	out->append(key);
+	out->append("\":", 2);
+	return *this;
+}
+
+Writer &Writer::String(std::string_view value)
+{
+	out->push_back('"');
+	Common::JSON::Screen(value, *out);
+	out->push_back('"');
+	return *this;
+}
+
+Writer &Writer::Quoted(std::string_view value)
+{
+	out->push_back('"');
+	out->append(value);
+	out->push_back('"');
+	return *this;
+}
+
+void Writer::DropComma()
+{
+	if (!out->empty() && out->back() == ',')
+	{
+		out->pop_back();
+	}
+}
+
+std::string Writer::Result() const
+{
+	return *out;
+}
+
+}
+}
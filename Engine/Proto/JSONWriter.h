@@ -0,0 +1,67 @@
+/**
+ * JSONWriter.h - Contains the JSON writer of the protocol commands
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+
+namespace Proto
+{
+namespace JSON
+{
+	/// Appends the JSON to the thread's reusable buffer, so the serialization
+	/// allocates only the result. The caller writes the punctuation itself
+	class Writer
+	{
+	public:
+		Writer();
+		~Writer();
+
+		/// Punctuation or the ready JSON
+		Writer &Raw(std::string_view text);
+		Writer &Raw(char c);
+
+		/// "key":
+		Writer &Key(std::string_view key);
+
+		/// Quoted and screened string
+		Writer &String(std::string_view value);
+
+		/// Quoted string without the screening, for the values the protocol always sent as is
+		Writer &Quoted(std::string_view value);
+
+		/// Integer in the same text as std::to_string() gives
+		template<typename T>
+		Writer &Number(T value)
+		{
+			static_assert(std::is_integral<T>::value, "Only the integers are written");
+
+			char buffer[24];
+			auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			out->append(buffer, result.ptr - buffer);
+			return *this;
+		}
+
+		/// Drops the trailing ',' if it is
+		void DropComma();
+
+		/// Copy of the written JSON
+		std::string Result() const;
+
+		Writer(const Writer&) = delete;
+		Writer &operator=(const Writer&) = delete;
+
+	private:
+		std::string *out;
+		std::string own; /// Used if the thread's buffer is busy by the outer writer
+		bool pooled;
+	};
+}
+}
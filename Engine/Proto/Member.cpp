@@ -7,8 +7,7 @@
 
 #include <Proto/Member.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -118,36 +117,89 @@ bool Member::Parse(const nlohmann::json::object_t &obj)
 	return false;
 }
 
+MemberReader::MemberReader()
+	: member(nullptr),
+	hasId(false),
+	groups()
+{
+}
+
+void MemberReader::Reset(Member *member_)
+{
+	member = member_;
+	hasId = false;
+}
+
+void MemberReader::Set(std::string_view key, JSON::Value &value)
+{
+	if (key == ID) { member->id = value.As<int64_t>(); hasId = true; }
+	else if (key == STATE) member->state = static_cast<MemberState>(value.As<uint32_t>());
+	else if (key == LOGIN) value.Take(member->login);
+	else if (key == NAME_) value.Take(member->name);
+	else if (key == NUMBER) value.Take(member->number);
+	else if (key == ICON) value.Take(member->icon);
+	else if (key == AVATAR) value.Take(member->avatar);
+	else if (key == MAX_INPUT_BITRATE) member->max_input_bitrate = value.As<uint32_t>();
+	else if (key == ORDER) member->order = value.As<uint32_t>();
+	else if (key == HAS_CAMERA) member->has_camera = value.As<uint8_t>();
+	else if (key == HAS_MICROPHONE) member->has_microphone = value.As<uint8_t>();
+	else if (key == HAS_DEMONSTRATION) member->has_demonstration = value.As<uint8_t>();
+	else if (key == GRANTS) member->grants = value.As<uint32_t>();
+	else if (key == DELETED) member->deleted = value.As<uint8_t>();
+}
+
+JSON::Reader *MemberReader::Nested(std::string_view key)
+{
+	if (key == GROUPS)
+	{
+		groups.Reset(&member->groups);
+		return &groups;
+	}
+	return nullptr;
+}
+
+bool MemberReader::End()
+{
+	return hasId;
+}
+
 std::string Member::Serialize()
 {
-	std::string out = "{" + quot(ID) + ":" + std::to_string(id) +
-		(state != MemberState::Undefined ? "," + quot(STATE) + ":" + std::to_string(static_cast<int32_t>(state)) : "") +
-		(!login.empty() ? "," + quot(LOGIN) + ":" + quot(Common::JSON::Screen(login)) : "") +
-		(!name.empty() ? "," + quot(NAME_) + ":" + quot(Common::JSON::Screen(name)) : "") +
-		(!number.empty() ? "," + quot(NUMBER) + ":" + quot(Common::JSON::Screen(number)) : "");
+	JSON::Writer writer;
+	Serialize(writer);
+	return writer.Result();
+}
+
+void Member::Serialize(JSON::Writer &writer)
+{
+	writer.Raw('{').Key(ID).Number(id);
+	if (state != MemberState::Undefined) writer.Raw(',').Key(STATE).Number(static_cast<int32_t>(state));
+	if (!login.empty()) writer.Raw(',').Key(LOGIN).String(login);
+	if (!name.empty()) writer.Raw(',').Key(NAME_).String(name);
+	if (!number.empty()) writer.Raw(',').Key(NUMBER).String(number);
 
 	if (!groups.empty())
 	{
-		out += "," + quot(GROUPS) + ":[";
+		writer.Raw(',').Key(GROUPS).Raw('[');
 		for (auto &g : groups)
 		{
-			out += g.Serialize() + ",";
+			g.Serialize(writer);
+			writer.Raw(',');
 		}
-		out.pop_back(); // drop last ","
-		out += "]";
+		writer.DropComma();
+		writer.Raw(']');
 	}
 
-	out += (!icon.empty() ? "," + quot(ICON) + ":" + quot(Common::JSON::Screen(icon)) : "") +
-		(!avatar.empty() ? "," + quot(AVATAR) + ":" + quot(Common::JSON::Screen(avatar)) : "") +
-		(max_input_bitrate != 0 ? "," + quot(MAX_INPUT_BITRATE) + ":" + std::to_string(max_input_bitrate) : "") +
-		(order != 0 ? "," + quot(ORDER) + ":" + std::to_string(order) : "") +
-		(has_camera ? "," + quot(HAS_CAMERA) + ":1" : "") +
-		(has_microphone ? "," + quot(HAS_MICROPHONE) + ":1" : "") +
-        (has_demonstration ? "," + quot(HAS_DEMONSTRATION) + ":1" : "") +
-		(grants != 0 ? "," + quot(GRANTS) + ":" + std::to_string(grants) : "") +
-		(deleted ? "," + quot(DELETED) + ":1" : "") + "}";
-
-	return out;
+	if (!icon.empty()) writer.Raw(',').Key(ICON).String(icon);
+	if (!avatar.empty()) writer.Raw(',').Key(AVATAR).String(avatar);
+	if (max_input_bitrate != 0) writer.Raw(',').Key(MAX_INPUT_BITRATE).Number(max_input_bitrate);
+	if (order != 0) writer.Raw(',').Key(ORDER).Number(order);
+	if (has_camera) writer.Raw(',').Key(HAS_CAMERA).Raw('1');
+	if (has_microphone) writer.Raw(',').Key(HAS_MICROPHONE).Raw('1');
+	if (has_demonstration) writer.Raw(',').Key(HAS_DEMONSTRATION).Raw('1');
+	if (grants != 0) writer.Raw(',').Key(GRANTS).Number(grants);
+	if (deleted) writer.Raw(',').Key(DELETED).Raw('1');
+	writer.Raw('}');
 }
 
 }
@@ -11,6 +11,8 @@
 #include <cstdint>
 
 #include <Proto/Group.h>
+#include <Proto/JSONReader.h>
+#include <Proto/JSONWriter.h>
 
 #include <nlohmann/json.hpp>
 
@@ -76,10 +78,29 @@ namespace Proto
 
 		bool Parse(const nlohmann::json::object_t &obj);
 		std::string Serialize();
+		void Serialize(JSON::Writer &writer); /// Appends to the writer of the outer command
 
 		inline bool operator==(int64_t id_)
 		{
 			return id == id_;
 		}
 	};
+
+	/// Fills the member during the streaming parsing
+	class MemberReader : public JSON::Reader
+	{
+	public:
+		MemberReader();
+
+		void Reset(Member *member);
+
+		void Set(std::string_view key, JSON::Value &value) override;
+		JSON::Reader *Nested(std::string_view key) override;
+		bool End() override;
+
+	private:
+		Member *member;
+		bool hasId;
+		JSON::ListReader<Group, GroupReader> groups;
+	};
 }
@@ -7,8 +7,7 @@
 
 #include <Proto/Message.h>
 
-#include <Common/Quoter.h>
-#include <Common/JSONSymbolsScreener.h>
+#include <Proto/JSONWriter.h>
 
 #include <spdlog/spdlog.h>
 
@@ -83,28 +82,74 @@ bool Message::Parse(const nlohmann::json::object_t& obj)
 	return false;
 }
 
+MessageReader::MessageReader()
+	: message(nullptr),
+	hasGuid(false)
+{
+}
+
+void MessageReader::Reset(Message *message_)
+{
+	message = message_;
+	hasGuid = false;
+}
+
+void MessageReader::Set(std::string_view key, JSON::Value &value)
+{
+	if (key == GUID) { hasGuid = value.type == JSON::Value::Type::String; value.Take(message->guid); }
+	else if (key == DT) message->dt = value.As<uint64_t>();
+	else if (key == TYPE) message->type = static_cast<MessageType>(value.As<uint32_t>());
+	else if (key == AUTHOR_ID) message->author_id = value.As<int64_t>();
+	else if (key == AUTHOR_NAME) value.Take(message->author_name);
+	else if (key == SENDER_ID) message->sender_id = value.As<int64_t>();
+	else if (key == SENDER_NAME) value.Take(message->sender_name);
+	else if (key == SUBSCRIBER_ID) message->subscriber_id = value.As<int64_t>();
+	else if (key == SUBSCRIBER_NAME) value.Take(message->subscriber_name);
+	else if (key == CONFERENCE_TAG) value.Take(message->conference_tag);
+	else if (key == CONFERENCE_NAME) value.Take(message->conference_name);
+	else if (key == STATUS) message->status = static_cast<MessageStatus>(value.As<uint32_t>());
+	else if (key == TEXT) value.Take(message->text);
+	else if (key == CALL_RESULT) message->call_result = static_cast<CallResult>(value.As<uint32_t>());
+	else if (key == CALL_DURATION) message->call_duration = value.As<int32_t>();
+	else if (key == PREVIEW) value.Take(message->preview);
+	else if (key == DATA) value.Take(message->data);
+	else if (key == URL) value.Take(message->url);
+}
+
+bool MessageReader::End()
+{
+	return hasGuid;
+}
+
 std::string Message::Serialize()
 {
-	std::string out = "{" + quot(GUID) + ":" + quot(guid) + "," +
-		(dt != 0 ? quot(DT) + ":" + std::to_string(dt) + "," : "") +
-		(type != MessageType::Undefined ? quot(TYPE) + ":" + std::to_string(static_cast<int32_t>(type)) + "," : "") +
-		(author_id != 0 ? quot(AUTHOR_ID) + ":" + std::to_string(author_id) + "," : "") +
-		(!author_name.empty() ? quot(AUTHOR_NAME) + ":" + quot(Common::JSON::Screen(author_name)) + "," : "") +
-		(sender_id != 0 ? quot(SENDER_ID) + ":" + std::to_string(sender_id) + "," : "") +
-		(!sender_name.empty() ? quot(SENDER_NAME) + ":" + quot(Common::JSON::Screen(sender_name)) + "," : "") +
-		(subscriber_id != 0 ? quot(SUBSCRIBER_ID) + ":" + std::to_string(subscriber_id) + "," : "") +
-		(!subscriber_name.empty() ? quot(SUBSCRIBER_NAME) + ":" + quot(Common::JSON::Screen(subscriber_name)) + "," : "") +
-		(!conference_tag.empty() ? quot(CONFERENCE_TAG) + ":" + quot(Common::JSON::Screen(conference_tag)) + "," : "") +
-		(!conference_name.empty() ? quot(CONFERENCE_NAME) + ":" + quot(Common::JSON::Screen(conference_name)) + "," : "") +
-		(status != MessageStatus::Undefined ? quot(STATUS) + ":" + std::to_string(static_cast<int32_t>(status)) + "," : "") +
-		(!text.empty() ? quot(TEXT) + ":" + quot(Common::JSON::Screen(text)) + "," : "") +
-		(call_result != CallResult::Undefined ? quot(CALL_RESULT) + ":" + std::to_string(static_cast<int32_t>(call_result)) + "," : "") +
-		(call_duration != 0 ? quot(CALL_DURATION) + ":" + std::to_string(call_duration) + "," : "") +
-		(!preview.empty() ? quot(PREVIEW) + ":" + quot(Common::JSON::Screen(preview)) + "," : "") +
-		(!data.empty() ? quot(DATA) + ":" + quot(Common::JSON::Screen(data)) + "," : "") +
-		(!url.empty() ? quot(URL) + ":" + quot(Common::JSON::Screen(url)) + "," : "");
-	out.pop_back(); // drop last ","
-	return out + "}";
+	JSON::Writer writer;
+	Serialize(writer);
+	return writer.Result();
+}
+
+void Message::Serialize(JSON::Writer &writer)
+{
+	writer.Raw('{').Key(GUID).Quoted(guid).Raw(',');
+	if (dt != 0) writer.Key(DT).Number(dt).Raw(',');
+	if (type != MessageType::Undefined) writer.Key(TYPE).Number(static_cast<int32_t>(type)).Raw(',');
+	if (author_id != 0) writer.Key(AUTHOR_ID).Number(author_id).Raw(',');
+	if (!author_name.empty()) writer.Key(AUTHOR_NAME).String(author_name).Raw(',');
+	if (sender_id != 0) writer.Key(SENDER_ID).Number(sender_id).Raw(',');
+	if (!sender_name.empty()) writer.Key(SENDER_NAME).String(sender_name).Raw(',');
+	if (subscriber_id != 0) writer.Key(SUBSCRIBER_ID).Number(subscriber_id).Raw(',');
+	if (!subscriber_name.empty()) writer.Key(SUBSCRIBER_NAME).String(subscriber_name).Raw(',');
+	if (!conference_tag.empty()) writer.Key(CONFERENCE_TAG).String(conference_tag).Raw(',');
+	if (!conference_name.empty()) writer.Key(CONFERENCE_NAME).String(conference_name).Raw(',');
+	if (status != MessageStatus::Undefined) writer.Key(STATUS).Number(static_cast<int32_t>(status)).Raw(',');
+	if (!text.empty()) writer.Key(TEXT).String(text).Raw(',');
+	if (call_result != CallResult::Undefined) writer.Key(CALL_RESULT).Number(static_cast<int32_t>(call_result)).Raw(',');
+	if (call_duration != 0) writer.Key(CALL_DURATION).Number(call_duration).Raw(',');
+	if (!preview.empty()) writer.Key(PREVIEW).String(preview).Raw(',');
+	if (!data.empty()) writer.Key(DATA).String(data).Raw(',');
+	if (!url.empty()) writer.Key(URL).String(url).Raw(',');
+	writer.DropComma();
+	writer.Raw('}');
 }
 
 void Message::Clear()
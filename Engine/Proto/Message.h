@@ -10,6 +10,9 @@
 #include <string>
 #include <cstdint>
 
+#include <Proto/JSONReader.h>
+#include <Proto/JSONWriter.h>
+
 #include <nlohmann/json.hpp>
 
 namespace Proto
@@ -95,6 +98,7 @@ namespace Proto
 
 		bool Parse(const nlohmann::json::object_t& obj);
 		std::string Serialize();
+		void Serialize(JSON::Writer &writer); /// Appends to the writer of the outer command
 
         void Clear();
 
@@ -103,4 +107,20 @@ namespace Proto
 			return guid == guid_;
 		}
 	};
+
+	/// Fills the message during the streaming parsing
+	class MessageReader : public JSON::Reader
+	{
+	public:
+		MessageReader();
+
+		void Reset(Message *message);
+
+		void Set(std::string_view key, JSON::Value &value) override;
+		bool End() override;
+
+	private:
+		Message *message;
+		bool hasGuid;
+	};
 }
@@ -0,0 +1,143 @@
+/**
+ * BufferedWriter.cpp - Contains the write-behind file writer impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Record/BufferedWriter.h>
+
+#include <cstring>
+
+namespace Recorder
+{
+
+BufferedWriter::BufferedWriter(size_t bufferSize_, bool seekable_)
+	: file(nullptr),
+	buffer(),
+	bufferSize(bufferSize_),
+	seekable(seekable_),
+	filePosition(0)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+	Close();
+}
+
+bool BufferedWriter::Open(std::string_view fileName)
+{
+	Close();
+
+#ifndef _WIN32
+	file = fopen(fileName.data(), "wb");
+#else
+	fopen_s(&file, fileName.data(), "wb");
+#endif
+	if (!file)
+	{
+		return false;
+	}
+
+	/// The buffer is ours, the stdio's one would only add a copy
+	setvbuf(file, nullptr, _IONBF, 0);
+
+	buffer.clear();
+	buffer.reserve(bufferSize);
+	filePosition = 0;
+
+	return true;
+}
+
+void BufferedWriter::Close()
+{
+	if (file)
+	{
+		Flush();
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+bool BufferedWriter::Flush()
+{
+	if (!file || buffer.empty())
+	{
+		return true;
+	}
+
+	const auto written = fwrite(buffer.data(), 1, buffer.size(), file);
+	filePosition += written;
+
+	const auto ok = written == buffer.size();
+	buffer.clear();
+
+	return ok;
+}
+
+mkvmuxer::int32 BufferedWriter::Write(const void* buf, mkvmuxer::uint32 len)
+{
+	if (!file || !buf)
+	{
+		return -1;
+	}
+
+	if (buffer.size() + len > bufferSize)
+	{
+		if (!Flush())
+		{
+			return -1;
+		}
+
+		if (len >= bufferSize) /// Too big to be buffered
+		{
+			const auto written = fwrite(buf, 1, len, file);
+			filePosition += written;
+			return written == len ? 0 : -1;
+		}
+	}
+
+	const auto *data = static_cast<const uint8_t*>(buf);
+	buffer.insert(buffer.end(), data, data + len);
+
+	return 0;
+}
+
+mkvmuxer::int64 BufferedWriter::Position() const
+{
+	return filePosition + static_cast<int64_t>(buffer.size());
+}
+
+mkvmuxer::int32 BufferedWriter::Position(mkvmuxer::int64 position)
+{
+	if (!file || !seekable || !Flush())
+	{
+		return -1;
+	}
+
+#ifdef _WIN32
+	const auto result = _fseeki64(file, position, SEEK_SET);
+#else
+	const auto result = fseeko(file, static_cast<off_t>(position), SEEK_SET);
+#endif
+	if (result != 0)
+	{
+		return -1;
+	}
+
+	filePosition = position;
+
+	return 0;
+}
+
+bool BufferedWriter::Seekable() const
+{
+	return seekable;
+}
+
+void BufferedWriter::ElementStartNotify(mkvmuxer::uint64, mkvmuxer::int64)
+{
+}
+
+}
@@ -0,0 +1,52 @@
+/**
+ * BufferedWriter.h - Contains the write-behind file writer for the muxer
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <mkvmuxer/mkvmuxer.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <string_view>
+
+namespace Recorder
+{
+
+/// Collects the muxer's small writes in the memory and puts them to the file by the big blocks,
+/// so the muxer makes one system call per a few megabytes instead of one per element
+class BufferedWriter : public mkvmuxer::IMkvWriter
+{
+public:
+	/// Not seekable writer makes the muxer write only forward, with the unknown sizes of the elements
+	BufferedWriter(size_t bufferSize = 4 * 1024 * 1024, bool seekable = true);
+	~BufferedWriter();
+
+	bool Open(std::string_view fileName);
+	void Close();
+
+	/// Put the buffer to the file
+	bool Flush();
+
+	/// Impl of mkvmuxer::IMkvWriter
+	virtual mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len) final;
+	virtual mkvmuxer::int64 Position() const final;
+	virtual mkvmuxer::int32 Position(mkvmuxer::int64 position) final;
+	virtual bool Seekable() const final;
+	virtual void ElementStartNotify(mkvmuxer::uint64 element_id, mkvmuxer::int64 position) final;
+
+private:
+	FILE *file;
+
+	std::vector<uint8_t> buffer;
+	size_t bufferSize;
+	bool seekable;
+
+	int64_t filePosition; /// Position of the buffer's begin in the file
+};
+
+}
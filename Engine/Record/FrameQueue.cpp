@@ -0,0 +1,139 @@
+/**
+ * FrameQueue.cpp - Contains the muxer's frame queue impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Record/FrameQueue.h>
+
+#include <algorithm>
+
+namespace Recorder
+{
+
+FrameQueue::FrameQueue()
+	: mutex(),
+	notEmpty(), notFull(),
+	frames(),
+	pool(),
+	capacity(256),
+	policy(OverflowPolicy::Drop),
+	stopped(true),
+	stats{ 0 },
+	depthGauge(Common::Metrics::Registry::Instance().GetGauge("recorder_queue_depth_frames", "Frames waiting for the muxer")),
+	pushedFrames(Common::Metrics::Registry::Instance().GetCounter("recorder_queue_frames_total", "Frames put to the muxing queue")),
+	droppedFrames(Common::Metrics::Registry::Instance().GetCounter("recorder_queue_dropped_frames_total", "Frames dropped by the full or stopped muxing queue"))
+{
+}
+
+void FrameQueue::Start(size_t capacity_, OverflowPolicy policy_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	capacity = std::max<size_t>(capacity_, 1);
+	policy = policy_;
+	stopped = false;
+
+	while (!frames.empty())
+	{
+		pool.emplace_back(std::move(frames.front().data));
+		frames.pop_front();
+	}
+
+	stats = { 0 };
+}
+
+void FrameQueue::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	notEmpty.notify_all();
+	notFull.notify_all();
+}
+
+bool FrameQueue::Push(uint64_t track, uint64_t ts, bool key, const uint8_t *data, uint32_t size, uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> buffer;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (policy == OverflowPolicy::Block)
+		{
+			notFull.wait(lock, [this]() { return stopped || frames.size() < capacity; });
+		}
+
+		if (stopped || frames.size() >= capacity)
+		{
+			++stats.dropped;
+			droppedFrames->Add();
+			return false;
+		}
+
+		if (!pool.empty())
+		{
+			buffer = std::move(pool.back());
+			pool.pop_back();
+		}
+	}
+
+	/// Copying is made out of the lock
+	buffer.assign(data, data + size);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (stopped)
+		{
+			++stats.dropped;
+			droppedFrames->Add();
+			return false;
+		}
+
+		frames.emplace_back(Frame{ track, ts, key, width, height, std::move(buffer) });
+
+		++stats.pushed;
+		stats.depth = frames.size();
+		stats.maxDepth = std::max(stats.maxDepth, stats.depth);
+
+		pushedFrames->Add();
+		depthGauge->Set(stats.depth);
+	}
+	notEmpty.notify_one();
+
+	return true;
+}
+
+bool FrameQueue::Pop(Frame &frame)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		notEmpty.wait(lock, [this]() { return stopped || !frames.empty(); });
+
+		if (frames.empty())
+		{
+			return false;
+		}
+
+		std::swap(frame, frames.front());
+		pool.emplace_back(std::move(frames.front().data));
+		frames.pop_front();
+
+		stats.depth = frames.size();
+		depthGauge->Set(stats.depth);
+	}
+	notFull.notify_one();
+
+	return true;
+}
+
+FrameQueueStats FrameQueue::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+}
@@ -0,0 +1,80 @@
+/**
+ * FrameQueue.h - Contains the bounded queue of the compressed frames going to the muxer
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <Common/Metrics.h>
+
+namespace Recorder
+{
+
+struct Frame
+{
+	uint64_t track;
+	uint64_t ts; /// ns
+	bool key;
+	uint32_t width, height; /// Of the video key frames, 0 - no change
+	std::vector<uint8_t> data;
+};
+
+enum class OverflowPolicy
+{
+	Drop,  /// Drop the incoming frame, the video waits for the next key frame
+	Block  /// Wait until the writer takes a frame
+};
+
+struct FrameQueueStats
+{
+	size_t depth, maxDepth;
+	uint64_t pushed, dropped;
+};
+
+/// Many producers (network threads, sound writer), one consumer (muxing thread).
+/// The lock only guards moving of the frames, the buffers are reused, so no allocations in the steady state
+class FrameQueue
+{
+public:
+	FrameQueue();
+
+	void Start(size_t capacity, OverflowPolicy policy);
+
+	/// Wake up the consumer, it takes the rest of frames and gets false from Pop()
+	void Stop();
+
+	/// Return false if the frame was dropped
+	bool Push(uint64_t track, uint64_t ts, bool key, const uint8_t *data, uint32_t size, uint32_t width = 0, uint32_t height = 0);
+
+	/// The previous content of the frame goes to the pool
+	bool Pop(Frame &frame);
+
+	FrameQueueStats GetStats();
+
+private:
+	std::mutex mutex;
+	std::condition_variable notEmpty, notFull;
+
+	std::deque<Frame> frames;
+	std::vector<std::vector<uint8_t>> pool;
+
+	size_t capacity;
+	OverflowPolicy policy;
+	bool stopped;
+
+	FrameQueueStats stats;
+
+	std::shared_ptr<Common::Metrics::Gauge> depthGauge;
+	std::shared_ptr<Common::Metrics::Counter> pushedFrames, droppedFrames;
+};
+
+}
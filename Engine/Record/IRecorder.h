@@ -18,17 +18,24 @@ class IPacketLossCallback;
 
 namespace Recorder
 {
+	enum class Mode
+	{
+		Mixed,     /// One video track of the speaker and the mixed sound
+		MP3,       /// Only the mixed sound
+		MultiTrack /// File per participant's stream as it came from the wire, composed offline
+	};
+
 	class IRecorder
 	{
 	public:
-		virtual void Start(std::string_view fileName, bool mp3Mode) = 0;
+		virtual void Start(std::string_view fileName, Mode mode) = 0;
 		virtual void Stop() = 0;
 
 		virtual void AddVideo(ssrc_t ssrc, int64_t clientId, int32_t priority, Video::Resolution resolution, Video::IPacketLossCallback *packetLossCallback) = 0;
 		virtual void ChangeVideoResolution(ssrc_t ssrc, Video::Resolution resolution) = 0;
 		virtual void DeleteVideo(ssrc_t ssrc) = 0;
 
-		virtual void AddAudio(ssrc_t ssrc, int64_t clientId) = 0;
+		virtual void AddAudio(ssrc_t ssrc, int64_t clientId, int32_t sampleFreq) = 0;
 		virtual void DeleteAudio(ssrc_t ssrc) = 0;
 
         virtual void SpeakerChanged(int64_t clientId) = 0;
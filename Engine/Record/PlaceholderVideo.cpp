@@ -0,0 +1,121 @@
+/**
+ * PlaceholderVideo.cpp - Contains the pre-encoded placeholder video impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Record/PlaceholderVideo.h>
+
+#include <Common/Common.h>
+
+#include <vpx/vpx_encoder.h>
+#include <vpx/vp8cx.h>
+
+#include <cstring>
+
+namespace Recorder
+{
+
+PlaceholderVideo::PlaceholderVideo()
+	: mutex(),
+	cache()
+{
+}
+
+PlaceholderVideo::~PlaceholderVideo()
+{
+}
+
+const PlaceholderVideo::Frames &PlaceholderVideo::Get(Video::Resolution resolution)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = cache.find(resolution);
+	if (it == cache.end())
+	{
+		it = cache.emplace(resolution, Encode(resolution)).first;
+	}
+
+	return it->second;
+}
+
+PlaceholderVideo::Frames PlaceholderVideo::Encode(Video::Resolution resolution)
+{
+	Frames frames;
+
+	auto rv = Video::GetValues(resolution);
+
+	vpx_codec_enc_cfg_t cfg;
+	if (vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &cfg, 0) != VPX_CODEC_OK)
+	{
+		return frames;
+	}
+
+	cfg.g_w = rv.width;
+	cfg.g_h = rv.height;
+	cfg.g_threads = 1;
+	cfg.g_timebase.den = 25;
+	cfg.g_timebase.num = 1;
+	cfg.g_lag_in_frames = 0;
+	cfg.rc_end_usage = VPX_Q;
+	cfg.kf_mode = VPX_KF_DISABLED;
+
+	vpx_codec_ctx_t codec;
+	if (vpx_codec_enc_init(&codec, vpx_codec_vp8_cx(), &cfg, 0) != VPX_CODEC_OK)
+	{
+		DBGTRACE("PlaceholderVideo Failed to initialize encoder: %s\n", vpx_codec_error(&codec));
+		return frames;
+	}
+
+	vpx_image_t img;
+	if (!vpx_img_alloc(&img, VPX_IMG_FMT_I420, cfg.g_w, cfg.g_h, 1))
+	{
+		vpx_codec_destroy(&codec);
+		return frames;
+	}
+
+	/// Grey frame
+	for (int plane = 0; plane != 3; ++plane)
+	{
+		const auto width = plane == 0 ? img.d_w : (img.d_w + 1) / 2;
+		const auto height = plane == 0 ? img.d_h : (img.d_h + 1) / 2;
+		for (uint32_t y = 0; y != height; ++y)
+		{
+			memset(img.planes[plane] + y * img.stride[plane], 128, width);
+		}
+	}
+
+	auto encode = [&](vpx_enc_frame_flags_t flags, vpx_codec_pts_t pts, std::vector<uint8_t> &out)
+	{
+		if (vpx_codec_encode(&codec, &img, pts, 1, flags, VPX_DL_GOOD_QUALITY) != VPX_CODEC_OK)
+		{
+			return;
+		}
+
+		vpx_codec_iter_t iter = nullptr;
+		const vpx_codec_cx_pkt_t *pkt = nullptr;
+		while ((pkt = vpx_codec_get_cx_data(&codec, &iter)) != nullptr)
+		{
+			if (pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+			{
+				const auto *data = static_cast<const uint8_t*>(pkt->data.frame.buf);
+				out.insert(out.end(), data, data + pkt->data.frame.sz);
+			}
+		}
+	};
+
+	encode(VPX_EFLAG_FORCE_KF, 0, frames.keyFrame);
+
+	/// Predicted from the key frame only and leaves the decoder's state as it was
+	encode(VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF |
+		VP8_EFLAG_NO_UPD_LAST | VP8_EFLAG_NO_UPD_GF | VP8_EFLAG_NO_UPD_ARF |
+		VP8_EFLAG_NO_UPD_ENTROPY, 1, frames.skipFrame);
+
+	vpx_img_free(&img);
+	vpx_codec_destroy(&codec);
+
+	return frames;
+}
+
+}
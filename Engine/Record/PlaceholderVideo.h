@@ -0,0 +1,44 @@
+/**
+ * PlaceholderVideo.h - Contains the cache of the pre-encoded placeholder video
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <Video/Resolution.h>
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace Recorder
+{
+
+/// Grey VP8 video for the time nobody's video is recorded.
+/// The key frame and the "skip" frame are encoded once per resolution and then only muxed,
+/// the skip frame doesn't update the references, so it can be repeated endlessly without any drift
+class PlaceholderVideo
+{
+public:
+	struct Frames
+	{
+		std::vector<uint8_t> keyFrame, skipFrame;
+	};
+
+	PlaceholderVideo();
+	~PlaceholderVideo();
+
+	/// Encode the frames at the first call for the resolution, empty frames on the encoder's error
+	const Frames &Get(Video::Resolution resolution);
+
+private:
+	std::mutex mutex;
+	std::map<Video::Resolution, Frames> cache;
+
+	static Frames Encode(Video::Resolution resolution);
+};
+
+}
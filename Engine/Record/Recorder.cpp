@@ -28,11 +28,19 @@ namespace Recorder
 
 Recorder::Recorder()
 	: runned(false),
-	mp3Mode(false),
+	mode(Mode::Mixed),
+	fileName(),
 	timeMeter(),
 	writerMutex(),
 	writer(),
 	muxerSegment(),
+	frameQueue(),
+	muxer(),
+	segmentMinutes(0), segmentMegabytes(0),
+	segmentIndex(0),
+	segmentStart(0), lastFlush(0),
+	rollRequestTs(0), lastKeyFrameRequest(0),
+	keyFrameRequested(false),
 	vidTrack(0), audTrack(0),
 	ts(0),
 	videosRWLock(), videos(),
@@ -42,13 +50,15 @@ Recorder::Recorder()
 	audioEncoder(), audioMixer(),
 	audiosRWLock(),
 	jBufs(),
-	fakeVideoSource(new uint8_t[static_cast<size_t>(1280 * 720 * 1.5)]),
-	fakeVideoEncoder(),
+	resamplers(),
+	placeholderVideo(),
+	placeholderFrames(0),
+	muxedBytes(Common::Metrics::Registry::Instance().GetCounter("recorder_muxed_bytes_total", "Bytes of the frames given to the muxer")),
+	muxErrors(Common::Metrics::Registry::Instance().GetCounter("recorder_mux_errors_total", "Frames failed to write")),
+	segments(Common::Metrics::Registry::Instance().GetCounter("recorder_segments_total", "Files opened by the recorder")),
+	soundOverruns(Common::Metrics::Registry::Instance().GetCounter("recorder_sound_overruns_total", "Sound frames mixed and encoded longer than the frame duration")),
 	sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
 {
-	fakeVideoEncoder.SetReceiver(this);
-	fakeVideoEncoder.SetResolution(fakeVideoChannel.resolution);
-	memset(fakeVideoSource.get(), 128, static_cast<size_t>(1280 * 720 * 1.5));
 }
 
 Recorder::~Recorder()
@@ -56,7 +66,7 @@ Recorder::~Recorder()
 	Stop();
 }
 
-void Recorder::Start(std::string_view name, bool mp3Mode_)
+void Recorder::Start(std::string_view name, Mode mode_)
 {
 	if (!runned)
 	{
@@ -64,9 +74,27 @@ void Recorder::Start(std::string_view name, bool mp3Mode_)
 
 		timeMeter.Reset();
 
-		mp3Mode = mp3Mode_;
+		mode = mode_;
+		fileName = name;
 
-		if (mp3Mode)
+		audioMixer.SetMaxActiveInputs(wui::config::get_int("Record", "MaxSpeakers", 3));
+
+		if (mode == Mode::MultiTrack)
+		{
+			keyedVideos.clear();
+			wireAudios.clear();
+			speakersTimeline.clear();
+
+			frameQueue.Start(wui::config::get_int("Record", "QueueSize", 256),
+				wui::config::get_string("Record", "QueueOverflow", "drop") == "block" ? OverflowPolicy::Block : OverflowPolicy::Drop);
+			muxer = std::thread(std::bind(&Recorder::Mux, this));
+
+			runned = true;
+
+			return sysLog->info("Recorder started in multi-track mode, writing files: {0}_*", name);
+		}
+
+		if (mode == Mode::MP3)
 		{
 			mp3Writer.Start(name);
 			audioMixer.Start();
@@ -77,99 +105,197 @@ void Recorder::Start(std::string_view name, bool mp3Mode_)
 			return sysLog->info("Recorder start in mp3 only mode, writing file: {0}", name);
 		}
 
-		audioMixer.Start();
-
 		ts = 0;
 		hasKeyFrame = false;
 
-		bool ok = false;
+		segmentMinutes = wui::config::get_int("Record", "SegmentMinutes", 0);
+		segmentMegabytes = wui::config::get_int("Record", "SegmentMB", 0);
+		segmentIndex = 0;
+		segmentStart = 0;
+		rollRequestTs = lastKeyFrameRequest = 0;
+		keyFrameRequested = false;
 
-		if (writer == nullptr)
+		if (!OpenSegment(IsSegmented() ? SegmentName(segmentIndex) : fileName, 0))
 		{
-			writer = std::unique_ptr<mkvmuxer::MkvWriter>(new mkvmuxer::MkvWriter());
-			ok = writer->Open(name.data());
-			if (!ok)
-			{
-				return errLog->error("Recorder start error opening file {0}", name);
-			}
+			return;
 		}
 
-		if (muxerSegment)
-		{
-			muxerSegment.reset(nullptr);
-		}
-		muxerSegment = std::unique_ptr<mkvmuxer::Segment>(new mkvmuxer::Segment());
+		// Start the audio encoder and mixer
+		audioEncoder.Start(Audio::CodecType::Opus);
+		audioMixer.Start();
 
-		ok = muxerSegment->Init(writer.get());
-		if (!ok)
-		{
-			return errLog->error("Recorder start error muxerSegment->Init", name);
-		}
+		// Start the muxer, from now only it touches the segment
+		frameQueue.Start(wui::config::get_int("Record", "QueueSize", 256),
+			wui::config::get_string("Record", "QueueOverflow", "drop") == "block" ? OverflowPolicy::Block : OverflowPolicy::Drop);
+		muxer = std::thread(std::bind(&Recorder::Mux, this));
 
+		runned = true;
+		soundWriter = std::thread(std::bind(&Recorder::WriteSound, this));
+
+		sysLog->info("Recorder started in normal mode, writing file: {0}{1}", name, IsSegmented() ? " (segmented)" : "");
+	}
+}
+
+bool Recorder::IsSegmented() const
+{
+	return segmentMinutes > 0 || segmentMegabytes > 0;
+}
+
+std::string Recorder::SegmentName(uint32_t index) const
+{
+	auto number = std::to_string(index);
+	number.insert(0, number.size() < 4 ? 4 - number.size() : 0, '0');
+
+	const auto dot = fileName.find_last_of('.');
+	return fileName.substr(0, dot) + "_" + number + (dot != std::string::npos ? fileName.substr(dot) : ".mkv");
+}
+
+bool Recorder::OpenSegment(const std::string &name, uint64_t startTs)
+{
+	const auto segmented = IsSegmented();
+
+	/// The segmented file is written only forward, so it is playable at any moment
+	writer = std::unique_ptr<BufferedWriter>(new BufferedWriter(wui::config::get_int("Record", "WriteBufferSize", 4 * 1024 * 1024), !segmented));
+	if (!writer->Open(name))
+	{
+		writer.reset(nullptr);
+		errLog->error("Recorder error opening file {0}", name);
+		return false;
+	}
+
+	muxerSegment = std::unique_ptr<mkvmuxer::Segment>(new mkvmuxer::Segment());
+
+	if (!muxerSegment->Init(writer.get()))
+	{
+		errLog->error("Recorder error muxerSegment->Init({0})", name);
+		return false;
+	}
+
+	if (segmented)
+	{
+		/// No cues to keep in the memory till the end, the clusters are closed often
+		muxerSegment->set_mode(mkvmuxer::Segment::kLive);
+		muxerSegment->OutputCues(false);
+		muxerSegment->set_max_cluster_duration(LIVE_CLUSTER_DURATION);
+	}
+	else
+	{
 		muxerSegment->set_mode(mkvmuxer::Segment::kFile);
 		muxerSegment->OutputCues(true);
 
 		mkvmuxer::Cues* const cues = muxerSegment->GetCues();
 		cues->set_output_block_number(true);
+	}
 
-		// Set SegmentInfo element attributes
-		auto *info = muxerSegment->GetSegmentInfo();
-		info->set_timecode_scale(1000000);
-		info->set_writing_app(SYSTEM_NAME " Client");
+	// Set SegmentInfo element attributes
+	auto *info = muxerSegment->GetSegmentInfo();
+	info->set_timecode_scale(1000000);
+	info->set_writing_app(SYSTEM_NAME " Client");
 
-		// Creating video channel
-		auto rv = Video::GetValues(currentVideoChannel.resolution);
-		vidTrack = muxerSegment->AddVideoTrack(rv.width, rv.height, 0);
-		if (!vidTrack)
-		{
-			return errLog->error("Recorder start error muxerSegment->AddVideoTrack :: (name: {0})", name);
-		}
+	// Creating video channel
+	auto rv = Video::GetValues(currentVideoChannel.resolution);
+	vidTrack = muxerSegment->AddVideoTrack(rv.width, rv.height, 0);
+	if (!vidTrack)
+	{
+		errLog->error("Recorder error muxerSegment->AddVideoTrack :: (name: {0})", name);
+		return false;
+	}
 
-		mkvmuxer::VideoTrack* const video =
-			static_cast<mkvmuxer::VideoTrack*>(
-				muxerSegment->GetTrackByNumber(vidTrack));
+	mkvmuxer::VideoTrack* const video =
+		static_cast<mkvmuxer::VideoTrack*>(
+			muxerSegment->GetTrackByNumber(vidTrack));
 
-		if (!video)
-		{
-			return errLog->error("Recorder start error muxerSegment->GetTrackByNumber(vidTrack: {0}, name: {1})", vidTrack, name);
-		}
-		
-		video->set_frame_rate(25); /// 40 ms - 25 frames per second
+	if (!video)
+	{
+		errLog->error("Recorder error muxerSegment->GetTrackByNumber(vidTrack: {0}, name: {1})", vidTrack, name);
+		return false;
+	}
 
-		muxerSegment->CuesTrack(vidTrack);
+	video->set_frame_rate(25); /// 40 ms - 25 frames per second
 
-		// Creating audio channel
-		audTrack = muxerSegment->AddAudioTrack(48000, 1, 0);
-		if (!audTrack)
-		{
-			return errLog->error("Recorder start error muxerSegment->AddAudioTrack", name);
-		}
+	// Creating audio channel
+	audTrack = muxerSegment->AddAudioTrack(48000, 1, 0);
+	if (!audTrack)
+	{
+		errLog->error("Recorder error muxerSegment->AddAudioTrack({0})", name);
+		return false;
+	}
 
-		mkvmuxer::AudioTrack* const audio =
-			static_cast<mkvmuxer::AudioTrack*>(
-				muxerSegment->GetTrackByNumber(audTrack));
+	mkvmuxer::AudioTrack* const audio =
+		static_cast<mkvmuxer::AudioTrack*>(
+			muxerSegment->GetTrackByNumber(audTrack));
 
-		if (!audio)
-		{
-			return errLog->error("Recorder start error muxerSegment->GetTrackByNumber(audTrack)", name);
-		}
+	if (!audio)
+	{
+		errLog->error("Recorder error muxerSegment->GetTrackByNumber(audTrack, {0})", name);
+		return false;
+	}
 
-		audio->set_codec_id(mkvmuxer::Tracks::kOpusCodecId);
+	audio->set_codec_id(mkvmuxer::Tracks::kOpusCodecId);
 
+	if (!segmented)
+	{
+		muxerSegment->CuesTrack(vidTrack);
 		muxerSegment->CuesTrack(audTrack);
+	}
+	else
+	{
+		AppendIndex(name, startTs);
+	}
 
-		// Start the audio encoder and mixer
-		audioEncoder.Start(Audio::CodecType::Opus);
-		audioMixer.Start();
+	segmentStart = startTs;
+	lastFlush = startTs;
+	segments->Add();
+
+	return true;
+}
+
+void Recorder::CloseSegment(uint64_t endTs)
+{
+	if (!muxerSegment)
+	{
+		return;
+	}
 
-		// Start the fake video encoder
-		fakeVideoEncoder.Start(Video::CodecType::VP8);
+	muxerSegment->set_duration(std::round((endTs - segmentStart) / 1000000));
 
-		runned = true;
-		soundWriter = std::thread(std::bind(&Recorder::WriteSound, this));
+	muxerSegment->Finalize();
+	muxerSegment.reset(nullptr);
+
+	writer.reset(nullptr);
+}
 
-		sysLog->info("Recorder started in normal mode, writing file: {0}", name);
+void Recorder::AppendIndex(const std::string &name, uint64_t startTs)
+{
+	/// One line per segment: the file's name and its start in ms from the recording's start
+	const auto dot = fileName.find_last_of('.');
+	const auto indexName = fileName.substr(0, dot) + ".index";
+
+	FILE *index = nullptr;
+#ifndef _WIN32
+	index = fopen(indexName.c_str(), "ab");
+#else
+	fopen_s(&index, indexName.c_str(), "ab");
+#endif
+	if (!index)
+	{
+		return errLog->error("Recorder error opening the index file {0}", indexName);
 	}
+
+	const auto slash = name.find_last_of("/\\");
+	fprintf(index, "%s\t%llu\n", name.substr(slash != std::string::npos ? slash + 1 : 0).c_str(), static_cast<unsigned long long>(startTs / 1000000));
+	fclose(index);
+}
+
+bool Recorder::NeedNewSegment(uint64_t frameTs)
+{
+	if (!IsSegmented())
+	{
+		return false;
+	}
+
+	return (segmentMinutes > 0 && frameTs - segmentStart >= static_cast<uint64_t>(segmentMinutes) * 60 * 1000000000ULL) ||
+		(segmentMegabytes > 0 && writer && writer->Position() >= static_cast<int64_t>(segmentMegabytes) * 1024 * 1024);
 }
 
 void Recorder::Stop()
@@ -179,34 +305,58 @@ void Recorder::Stop()
 		runned = false;
 		if (soundWriter.joinable()) soundWriter.join();
 
-		if (mp3Mode)
+		if (mode == Mode::MP3)
 		{
 			mp3Writer.Stop();
 			return sysLog->info("Recorder ended (mp3 mode)");
 		}
+
+		if (mode == Mode::MultiTrack)
+		{
+			frameQueue.Stop();
+			if (muxer.joinable()) muxer.join();
+
+			streamFiles.clear();
+
+			{
+				mt::scoped_rw_lock lock(&audiosRWLock, true);
+				localEncoders.clear();
+			}
+
+			std::lock_guard<std::recursive_mutex> lock(writerMutex);
+			WriteChapters();
+
+			auto stats = frameQueue.GetStats();
+			return sysLog->info("Recorder ended (multi-track mode), muxing queue max depth: {0}, frames: {1}, dropped: {2}", stats.maxDepth, stats.pushed, stats.dropped);
+		}
 		
 		audioEncoder.Stop();
 
-		std::lock_guard<std::recursive_mutex> lock(writerMutex);
-
-		muxerSegment->set_duration(std::round(ts / 1000000));
+		/// The muxer writes the rest of the queue and exits
+		frameQueue.Stop();
+		if (muxer.joinable()) muxer.join();
 
-		muxerSegment->Finalize();
-		muxerSegment.reset(nullptr);
+		std::lock_guard<std::recursive_mutex> lock(writerMutex);
 
-		writer.reset(nullptr);
+		CloseSegment(ts);
 
-		sysLog->info("Recorder ended (normal mode)");
+		auto stats = frameQueue.GetStats();
+		sysLog->info("Recorder ended (normal mode), muxing queue max depth: {0}, frames: {1}, dropped: {2}", stats.maxDepth, stats.pushed, stats.dropped);
 	}
 }
 
 void Recorder::AddVideo(ssrc_t ssrc, int64_t clientId, int32_t priority, Video::Resolution resolution, Video::IPacketLossCallback *packetLossCallback)
 {
-	if (mp3Mode)
+	if (mode == Mode::MP3)
 	{
 		return;
 	}
 
+	{
+		std::lock_guard<std::mutex> lock(streamsMutex);
+		streamInfos[ssrc] = StreamInfo{ clientId, true };
+	}
+
 	mt::scoped_rw_lock lock(&videosRWLock, true);
 
 	if (videos.find(ssrc) == videos.end())
@@ -231,7 +381,7 @@ void Recorder::AddVideo(ssrc_t ssrc, int64_t clientId, int32_t priority, Video::
 
 void Recorder::ChangeVideoResolution(ssrc_t ssrc, Video::Resolution resolution)
 {
-	if (mp3Mode)
+	if (mode == Mode::MP3)
 	{
 		return;
 	}
@@ -253,11 +403,26 @@ void Recorder::ChangeVideoResolution(ssrc_t ssrc, Video::Resolution resolution)
 
 void Recorder::DeleteVideo(ssrc_t ssrc)
 {
-	if (mp3Mode)
+	if (mode == Mode::MP3)
 	{
 		return;
 	}
 
+	if (mode == Mode::MultiTrack)
+	{
+		{
+			mt::scoped_rw_lock lock(&videosRWLock, true);
+			videos.erase(ssrc);
+		}
+
+		std::lock_guard<std::recursive_mutex> lock(writerMutex);
+		if (keyedVideos.erase(ssrc) != 0 && runned)
+		{
+			frameQueue.Push(ssrc, MultiTrackTime(), false, nullptr, 0); /// Close the stream's file
+		}
+		return;
+	}
+
 	int64_t clientId = 0;
 
 	{
@@ -280,8 +445,13 @@ void Recorder::DeleteVideo(ssrc_t ssrc)
 	SpeakerChanged(clientId);
 }
 
-void Recorder::AddAudio(ssrc_t ssrc, int64_t clientId)
+void Recorder::AddAudio(ssrc_t ssrc, int64_t clientId, int32_t sampleFreq)
 {
+	{
+		std::lock_guard<std::mutex> lock(streamsMutex);
+		streamInfos[ssrc] = StreamInfo{ clientId, false };
+	}
+
 	mt::scoped_rw_lock lock(&audiosRWLock, true);
 
 	auto jb = jBufs.find(ssrc);
@@ -292,6 +462,13 @@ void Recorder::AddAudio(ssrc_t ssrc, int64_t clientId)
 
 		jBufs.insert(std::pair<ssrc_t, std::shared_ptr<JB::JB>>(ssrc, jb));
 
+		if (sampleFreq != 48000)
+		{
+			auto resampler = std::make_shared<Audio::Resampler>();
+			resampler->SetSampleFreq(sampleFreq, 48000);
+			resamplers.insert(std::pair<ssrc_t, std::shared_ptr<Audio::Resampler>>(ssrc, resampler));
+		}
+
 		audioMixer.AddInput(ssrc, clientId, std::bind(&JB::JB::GetFrame, jb, std::placeholders::_1));
 	}
 }
@@ -305,6 +482,16 @@ void Recorder::DeleteAudio(ssrc_t ssrc)
 	{
 		audioMixer.DeleteInput(ssrc);
 		jBufs.erase(jb);
+		resamplers.erase(ssrc);
+		localEncoders.erase(ssrc);
+	}
+
+	if (mode == Mode::MultiTrack && runned)
+	{
+		frameQueue.Push(ssrc, MultiTrackTime(), false, nullptr, 0); /// Close the stream's file
+
+		std::lock_guard<std::recursive_mutex> lock(writerMutex);
+		wireAudios.erase(ssrc);
 	}
 }
 
@@ -343,6 +530,11 @@ void Recorder::Send(const Transport::IPacket &packet_, const Transport::Address
 		return;
 	}
 
+	if (mode == Mode::MultiTrack)
+	{
+		return SendMultiTrack(packet);
+	}
+
 	switch (static_cast<Transport::RTPPayloadType>(packet.rtpHeader.pt))
 	{
 		case Transport::RTPPayloadType::ptPCM: // Receiving audio from clients
@@ -352,13 +544,23 @@ void Recorder::Send(const Transport::IPacket &packet_, const Transport::Address
 			auto jb = jBufs.find(packet.rtpHeader.ssrc);
 			if (jb != jBufs.end())
 			{
-				jb->second->Send(packet_);
+				auto resampler = resamplers.find(packet.rtpHeader.ssrc);
+				if (resampler != resamplers.end())
+				{
+					Transport::RTPPacket resampled;
+					resampler->second->Resample(packet, resampled);
+					jb->second->Send(resampled);
+				}
+				else
+				{
+					jb->second->Send(packet_);
+				}
 			}
 		}
 		break;
 		case Transport::RTPPayloadType::ptVP8: // Receive the video
 		{
-			if (mp3Mode)
+			if (mode == Mode::MP3)
 			{
 				return;
 			}
@@ -372,6 +574,11 @@ void Recorder::Send(const Transport::IPacket &packet_, const Transport::Address
 			}
 
 			auto isKey = IsKeyFrame(packet.payload);
+			if (keyFrameRequested.exchange(false) && !isKey)
+			{
+				currentVideoChannel.packetLossCallback->ForceKeyFrame(packet.rtpHeader.seq);
+			}
+
 			if (!hasKeyFrame && !isKey)
 			{
 				currentVideoChannel.packetLossCallback->ForceKeyFrame(packet.rtpHeader.seq);
@@ -380,16 +587,13 @@ void Recorder::Send(const Transport::IPacket &packet_, const Transport::Address
 			}
 
 			hasKeyFrame = true;
-			
-			bool ok = muxerSegment->AddFrame(packet.payload,
-				packet.payloadSize,
-				vidTrack,
-				ts,
-				isKey);
-			
-			if (!ok)
+
+			auto rv = Video::GetValues(currentVideoChannel.resolution);
+			if (!frameQueue.Push(vidTrack, ts, isKey, packet.payload, packet.payloadSize, isKey ? rv.width : 0, isKey ? rv.height : 0))
 			{
-				return errLog->error("Recorder::Send error in video muxerSegment->AddFrame({0})", vidTrack);
+				/// The chain of the frames is broken, wait for the next key frame
+				hasKeyFrame = false;
+				return sysLog->trace("Recorder::Send video frame was dropped by the full muxing queue");
 			}
 		}
 		break;
@@ -400,11 +604,22 @@ void Recorder::Send(const Transport::IPacket &packet_, const Transport::Address
 
 void Recorder::SpeakerChanged(int64_t clientId)
 {
-	if (mp3Mode)
+	if (mode == Mode::MP3)
 	{
 		return;
 	}
 
+	if (mode == Mode::MultiTrack)
+	{
+		/// All the streams are recorded, only note who speaks for the offline composition
+		std::lock_guard<std::recursive_mutex> lock(writerMutex);
+		if (runned && (speakersTimeline.empty() || speakersTimeline.back().second != clientId))
+		{
+			speakersTimeline.emplace_back(MultiTrackTime() / 1000000, clientId);
+		}
+		return;
+	}
+
 	VideoChannel channel = { 0 };
 	{
         mt::scoped_rw_lock lock(&videosRWLock, false);
@@ -427,24 +642,9 @@ void Recorder::SpeakerChanged(int64_t clientId)
 		sysLog->debug("Recorder::SpeakerChanged to fake channel :: (clientId: {0})", clientId);
 	}
 
+	/// The track's size will be changed by the muxer on the first key frame of the new channel
 	std::lock_guard<std::recursive_mutex> lock(writerMutex);
 
-	if (runned)
-	{
-		mkvmuxer::VideoTrack* const video =
-			static_cast<mkvmuxer::VideoTrack*>(
-				muxerSegment->GetTrackByNumber(vidTrack));
-
-		if (!video)
-		{
-			return errLog->error("Recorder::SpeakerChanged error in muxerSegment->GetTrackByNumber({0})", vidTrack);
-		}
-
-		auto rv = Video::GetValues(channel.resolution);
-		video->set_width(rv.width);
-		video->set_height(rv.height);
-	}
-
 	currentVideoChannel = channel;
 	hasKeyFrame = false;
 
@@ -453,16 +653,29 @@ void Recorder::SpeakerChanged(int64_t clientId)
 
 void Recorder::ForceKeyFrame(uint32_t)
 {
-	fakeVideoEncoder.ForceKeyFrame(0);
+	std::lock_guard<std::recursive_mutex> lock(writerMutex);
+	hasKeyFrame = false;
 }
 
-void Recorder::GenerateFakeVideo()
+void Recorder::WritePlaceholderVideo()
 {
-	Transport::RTPPacket packet;
-	packet.payload = fakeVideoSource.get();
-	packet.payloadSize = static_cast<uint32_t>(1280 * 720 * 1.5);
+	const auto &frames = placeholderVideo.Get(currentVideoChannel.resolution);
 
-	fakeVideoEncoder.Send(packet);
+	const auto key = !hasKeyFrame || ++placeholderFrames >= PLACEHOLDER_KEY_INTERVAL || keyFrameRequested.exchange(false);
+	const auto &frame = key ? frames.keyFrame : frames.skipFrame;
+	if (frame.empty())
+	{
+		return;
+	}
+
+	auto rv = Video::GetValues(currentVideoChannel.resolution);
+	const auto pushed = frameQueue.Push(vidTrack, ts, key, frame.data(), static_cast<uint32_t>(frame.size()), key ? rv.width : 0, key ? rv.height : 0);
+
+	if (key)
+	{
+		hasKeyFrame = pushed;
+		placeholderFrames = 0;
+	}
 }
 
 void Recorder::WriteSound()
@@ -474,13 +687,13 @@ void Recorder::WriteSound()
 		Transport::OwnedRTPPacket packet(480 * 2 * 4);
 		audioMixer.GetSound(packet);
 
-		if (!mp3Mode)
+		if (mode != Mode::MP3)
 		{
 			std::lock_guard<std::recursive_mutex> lock(writerMutex);
 
 			if (currentVideoChannel.ssrc == fakeVideoChannel.ssrc)
 			{
-				GenerateFakeVideo();
+				WritePlaceholderVideo();
 			}
 
 			Transport::RTPPacket in, out;
@@ -491,18 +704,9 @@ void Recorder::WriteSound()
 
 			audioEncoder.Encode(in, out);
 
-			bool ok = muxerSegment->AddFrame(out.payload,
-				out.payloadSize,
-				audTrack,
-				ts,
-				false);
+			frameQueue.Push(audTrack, ts, false, out.payload, out.payloadSize);
 
 			ts += FRAME_DURATION * 1000;
-
-			if (!ok)
-			{
-				return errLog->error("Recorder::Send audio error in muxerSegment->AddFrame({0})", audTrack);
-			}
 		}
 		else
 		{
@@ -520,7 +724,286 @@ void Recorder::WriteSound()
 		{
 			Common::ShortSleep(FRAME_DURATION - workDuration);
 		}
+		else
+		{
+			soundOverruns->Add();
+		}
+	}
+}
+
+void Recorder::Mux()
+{
+	Frame frame;
+	while (frameQueue.Pop(frame))
+	{
+		if (mode == Mode::MultiTrack)
+		{
+			MuxStream(frame);
+			continue;
+		}
+
+		if (frame.data.empty())
+		{
+			continue;
+		}
+
+		if (NeedNewSegment(frame.ts))
+		{
+			if (rollRequestTs == 0)
+			{
+				rollRequestTs = frame.ts;
+			}
+
+			/// Each segment starts from the key frame, so it's playable alone,
+			/// the video can be gone at all, so don't wait forever
+			if ((frame.track == vidTrack && frame.key) || frame.ts - rollRequestTs >= SEGMENT_KEY_FRAME_WAIT)
+			{
+				CloseSegment(frame.ts);
+				if (!OpenSegment(SegmentName(++segmentIndex), frame.ts))
+				{
+					return;
+				}
+				rollRequestTs = 0;
+				keyFrameRequested = false;
+			}
+			else if (frame.ts - lastKeyFrameRequest >= LIVE_FLUSH_INTERVAL)
+			{
+				keyFrameRequested = true;
+				lastKeyFrameRequest = frame.ts;
+			}
+		}
+
+		if (frame.width != 0 && frame.height != 0)
+		{
+			auto *video = static_cast<mkvmuxer::VideoTrack*>(muxerSegment->GetTrackByNumber(frame.track));
+			if (video && (video->width() != frame.width || video->height() != frame.height))
+			{
+				video->set_width(frame.width);
+				video->set_height(frame.height);
+			}
+		}
+
+		muxedBytes->Add(frame.data.size());
+		if (!muxerSegment->AddFrame(frame.data.data(), frame.data.size(), frame.track, frame.ts - segmentStart, frame.key))
+		{
+			muxErrors->Add();
+			errLog->error("Recorder::Mux error in muxerSegment->AddFrame({0})", frame.track);
+		}
+
+		/// Limit the loss on the crash
+		if (IsSegmented() && frame.ts - lastFlush >= LIVE_FLUSH_INTERVAL)
+		{
+			writer->Flush();
+			lastFlush = frame.ts;
+		}
+	}
+}
+
+uint64_t Recorder::MultiTrackTime()
+{
+	return timeMeter.Measure() * 1000;
+}
+
+void Recorder::SendMultiTrack(const Transport::RTPPacket &packet)
+{
+	const auto ssrc = packet.rtpHeader.ssrc;
+
+	switch (static_cast<Transport::RTPPayloadType>(packet.rtpHeader.pt))
+	{
+		case Transport::RTPPayloadType::ptVP8:
+		{
+			const auto isKey = IsKeyFrame(packet.payload);
+
+			Video::IPacketLossCallback *packetLossCallback = nullptr;
+			Video::ResolutionValues rv;
+			{
+				mt::scoped_rw_lock lock(&videosRWLock, false);
+				auto it = videos.find(ssrc);
+				if (it == videos.end())
+				{
+					return;
+				}
+				packetLossCallback = it->second.packetLossCallback;
+				if (isKey)
+				{
+					rv = Video::GetValues(it->second.resolution);
+				}
+			}
+
+			std::lock_guard<std::recursive_mutex> lock(writerMutex);
+
+			if (keyedVideos.count(ssrc) == 0)
+			{
+				/// The stream's file starts from the key frame, it's requested once per participant, not per speaker change
+				if (!isKey)
+				{
+					if (packetLossCallback)
+					{
+						packetLossCallback->ForceKeyFrame(packet.rtpHeader.seq);
+					}
+					return;
+				}
+				keyedVideos.insert(ssrc);
+			}
+
+			if (!frameQueue.Push(ssrc, MultiTrackTime(), isKey, packet.payload, packet.payloadSize, rv.width, rv.height))
+			{
+				keyedVideos.erase(ssrc); /// Wait for the next key frame
+			}
+		}
+		break;
+		case Transport::RTPPayloadType::ptOpus: // The remote sound as it came from the wire
+		{
+			{
+				std::lock_guard<std::recursive_mutex> lock(writerMutex);
+				wireAudios.insert(ssrc);
+			}
+			frameQueue.Push(ssrc, MultiTrackTime(), false, packet.payload, packet.payloadSize);
+		}
+		break;
+		case Transport::RTPPayloadType::ptPCM: // The own sound has no wire, so it is encoded here
+		{
+			std::shared_ptr<Audio::Encoder> encoder;
+			{
+				std::lock_guard<std::recursive_mutex> lock(writerMutex);
+				if (wireAudios.count(ssrc) != 0)
+				{
+					return;
+				}
+			}
+
+			mt::scoped_rw_lock lock(&audiosRWLock, false);
+
+			if (jBufs.find(ssrc) == jBufs.end())
+			{
+				return;
+			}
+
+			{
+				std::lock_guard<std::recursive_mutex> lock(writerMutex);
+				auto it = localEncoders.find(ssrc);
+				if (it == localEncoders.end())
+				{
+					encoder = std::make_shared<Audio::Encoder>();
+					encoder->Start(Audio::CodecType::Opus);
+					localEncoders.insert(std::pair<ssrc_t, std::shared_ptr<Audio::Encoder>>(ssrc, encoder));
+				}
+				else
+				{
+					encoder = it->second;
+				}
+			}
+
+			Transport::RTPPacket in = packet, out;
+
+			auto resampler = resamplers.find(ssrc);
+			if (resampler != resamplers.end())
+			{
+				resampler->second->Resample(packet, in);
+			}
+
+			encoder->Encode(in, out);
+			if (out.payloadSize != 0)
+			{
+				frameQueue.Push(ssrc, MultiTrackTime(), false, out.payload, out.payloadSize);
+			}
+		}
+		break;
+		default:
+		break;
 	}
 }
 
+void Recorder::MuxStream(Frame &frame)
+{
+	const auto ssrc = static_cast<ssrc_t>(frame.track);
+
+	auto it = streamFiles.find(ssrc);
+
+	if (frame.data.empty()) /// End of the stream
+	{
+		if (it != streamFiles.end())
+		{
+			streamFiles.erase(it);
+		}
+		return;
+	}
+
+	if (it == streamFiles.end())
+	{
+		StreamInfo info = { 0 };
+		{
+			std::lock_guard<std::mutex> lock(streamsMutex);
+			auto i = streamInfos.find(ssrc);
+			if (i == streamInfos.end())
+			{
+				return;
+			}
+			info = i->second;
+		}
+
+		auto base = fileName.substr(0, fileName.find_last_of('.'));
+		auto name = base + "_" + std::to_string(info.clientId) + "_" + std::to_string(ssrc) + "_" + std::to_string(frame.ts / 1000000) + ".mkv";
+
+		StreamFile::Tags tags = {
+			{ "CLIENT_ID", std::to_string(info.clientId) },
+			{ "SSRC", std::to_string(ssrc) },
+			{ "START_OFFSET_MS", std::to_string(frame.ts / 1000000) }
+		};
+
+		auto file = std::unique_ptr<StreamFile>(new StreamFile());
+		if (!file->Open(name, info.video, frame, tags))
+		{
+			return errLog->error("Recorder::MuxStream error opening file {0}", name);
+		}
+		it = streamFiles.emplace(ssrc, std::move(file)).first;
+		segments->Add();
+
+		sysLog->info("Recorder::MuxStream :: new stream file: {0}", name);
+	}
+
+	muxedBytes->Add(frame.data.size());
+	if (!it->second->Write(frame))
+	{
+		muxErrors->Add();
+		errLog->error("Recorder::MuxStream error in AddFrame(ssrc: {0})", ssrc);
+	}
+}
+
+void Recorder::WriteChapters()
+{
+	/// FFMETADATA, ready for the ffmpeg's offline composition
+	auto name = fileName.substr(0, fileName.find_last_of('.')) + "_chapters.txt";
+
+	FILE *file = nullptr;
+#ifndef _WIN32
+	file = fopen(name.c_str(), "wb");
+#else
+	fopen_s(&file, name.c_str(), "wb");
+#endif
+	if (!file)
+	{
+		return errLog->error("Recorder::WriteChapters error opening file {0}", name);
+	}
+
+	fputs(";FFMETADATA1\n", file);
+
+	const auto end = MultiTrackTime() / 1000000;
+	for (size_t i = 0; i != speakersTimeline.size(); ++i)
+	{
+		const auto start = speakersTimeline[i].first;
+		const auto stop = i + 1 != speakersTimeline.size() ? speakersTimeline[i + 1].first : end;
+
+		fprintf(file, "[CHAPTER]\nTIMEBASE=1/1000\nSTART=%llu\nEND=%llu\ntitle=speaker %lld\n",
+			static_cast<unsigned long long>(start), static_cast<unsigned long long>(stop), static_cast<long long>(speakersTimeline[i].second));
+	}
+
+	fclose(file);
+}
+
+FrameQueueStats Recorder::GetQueueStats()
+{
+	return frameQueue.GetStats();
+}
+
 }
@@ -10,6 +10,9 @@
 #include <Record/IRecorder.h>
 
 #include <map>
+#include <set>
+#include <vector>
+#include <string>
 #include <mutex>
 #include <memory>
 #include <thread>
@@ -21,6 +24,7 @@
 
 #include <Audio/AudioMixer.h>
 #include <Audio/AudioEncoder.h>
+#include <Audio/Resampler.h>
 
 #include <Video/VideoEncoder.h>
 
@@ -29,10 +33,13 @@
 #include <JitterBuffer/JB.h>
 
 #include <Record/MP3Writer.h>
+#include <Record/BufferedWriter.h>
+#include <Record/FrameQueue.h>
+#include <Record/PlaceholderVideo.h>
+#include <Record/StreamFile.h>
 
 // libwebm muxer includes
 #include <mkvmuxer/mkvmuxer.h>
-#include <mkvmuxer/mkvwriter.h>
 #include <mkvmuxer/mkvmuxerutil.h>
 
 #include <spdlog/spdlog.h>
@@ -43,14 +50,14 @@ namespace Recorder
 	{
 	public:
 		/// Derived from IRecorder
-		virtual void Start(std::string_view fileName, bool mp3Mode) final;
+		virtual void Start(std::string_view fileName, Mode mode) final;
 		virtual void Stop() final;
 
 		virtual void AddVideo(ssrc_t ssrc, int64_t clientId, int32_t priority, Video::Resolution resolution, Video::IPacketLossCallback *packetLossCallback);
 		virtual void ChangeVideoResolution(ssrc_t ssrc, Video::Resolution resolution);
 		virtual void DeleteVideo(ssrc_t ssrc);
 
-		virtual void AddAudio(ssrc_t ssrc, int64_t clientId);
+		virtual void AddAudio(ssrc_t ssrc, int64_t clientId, int32_t sampleFreq);
 		virtual void DeleteAudio(ssrc_t ssrc);
 
         virtual void SpeakerChanged(int64_t clientId);
@@ -61,23 +68,42 @@ namespace Recorder
 		/// Derived from Video::IPacketLossCallback
 		virtual void ForceKeyFrame(uint32_t);
 
+		/// Muxing queue's depth and drops, the writer's position
+		FrameQueueStats GetQueueStats();
+
 		Recorder();
 		~Recorder();
 
 	private:
 		static constexpr int32_t FRAME_DURATION = 40000;
+		static constexpr uint32_t PLACEHOLDER_KEY_INTERVAL = 250; /// 10 s, to keep the file seekable
+		static constexpr uint64_t LIVE_CLUSTER_DURATION = 2000000000; /// ns, the segmented mode's cluster
+		static constexpr uint64_t LIVE_FLUSH_INTERVAL = 1000000000; /// ns, the segmented mode's write behind
+		static constexpr uint64_t SEGMENT_KEY_FRAME_WAIT = 10000000000; /// ns, start the next segment without the key frame after
 
 		std::atomic_bool runned;
 
-		bool mp3Mode;
+		Mode mode;
+		std::string fileName;
 
 		Common::TimeMeter timeMeter;
 
 		std::recursive_mutex writerMutex;
-				
-		std::unique_ptr<mkvmuxer::MkvWriter> writer;
+
+		/// The writer and the segment are used only by the muxer thread after the start
+		std::unique_ptr<BufferedWriter> writer;
 		std::unique_ptr<mkvmuxer::Segment> muxerSegment;
 
+		FrameQueue frameQueue;
+		std::thread muxer;
+
+		/// Segmented mode, the rolling files of SegmentMinutes or SegmentMB, each one starts from the key frame
+		int32_t segmentMinutes, segmentMegabytes;
+		uint32_t segmentIndex;
+		uint64_t segmentStart, lastFlush; /// ns
+		uint64_t rollRequestTs, lastKeyFrameRequest; /// ns
+		std::atomic_bool keyFrameRequested; /// The muxer waits the key frame to start the next segment
+
 		uint64_t vidTrack, audTrack;
 		uint64_t ts;
 
@@ -105,17 +131,50 @@ namespace Recorder
 
 		mt::rw_lock audiosRWLock;
 		std::map<ssrc_t, std::shared_ptr<JB::JB>> jBufs;
+		std::map<ssrc_t, std::shared_ptr<Audio::Resampler>> resamplers; /// For the inputs not in 48 kHz
 
-		std::unique_ptr<uint8_t[]> fakeVideoSource;
-		std::unique_ptr<uint8_t[]> buffer0, buffer1, buffer2;
-		Video::Encoder fakeVideoEncoder;
+		PlaceholderVideo placeholderVideo;
+		uint32_t placeholderFrames;
 
 		std::thread soundWriter;
 
+		/// Multi-track mode
+		struct StreamInfo
+		{
+			int64_t clientId;
+			bool video;
+		};
+		std::mutex streamsMutex;
+		std::map<ssrc_t, StreamInfo> streamInfos;
+
+		std::set<ssrc_t> keyedVideos; /// Guarded by the writerMutex
+		std::set<ssrc_t> wireAudios; /// Guarded by the writerMutex, the sound is taken from the wire in Opus
+		std::map<ssrc_t, std::shared_ptr<Audio::Encoder>> localEncoders; /// Guarded by the audiosRWLock, for the own PCM sound
+
+		std::vector<std::pair<uint64_t, int64_t>> speakersTimeline; /// Guarded by the writerMutex, ms from the start and the speaker's client id
+
+		std::map<ssrc_t, std::unique_ptr<StreamFile>> streamFiles; /// Muxer thread only
+
+		std::shared_ptr<Common::Metrics::Counter> muxedBytes, muxErrors, segments, soundOverruns;
+
 		std::shared_ptr<spdlog::logger> sysLog, errLog;
 
-		void GenerateFakeVideo();
+		void WritePlaceholderVideo();
 
 		void WriteSound();
+		void Mux();
+
+		bool IsSegmented() const;
+		std::string SegmentName(uint32_t index) const;
+		bool OpenSegment(const std::string &name, uint64_t startTs);
+		void CloseSegment(uint64_t endTs);
+		void AppendIndex(const std::string &name, uint64_t startTs);
+		bool NeedNewSegment(uint64_t frameTs);
+
+		void SendMultiTrack(const Transport::RTPPacket &packet);
+		void MuxStream(Frame &frame);
+		void WriteChapters();
+
+		uint64_t MultiTrackTime();
 	};
 }
@@ -0,0 +1,117 @@
+/**
+ * StreamFile.cpp - Contains the single stream Matroska file impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Record/StreamFile.h>
+
+#include <Version.h>
+
+#include <algorithm>
+
+namespace Recorder
+{
+
+StreamFile::StreamFile()
+	: writer(256 * 1024),
+	segment(),
+	track(0),
+	startTs(0), lastTs(0)
+{
+}
+
+StreamFile::~StreamFile()
+{
+	Close();
+}
+
+bool StreamFile::Open(std::string_view fileName, bool video, const Frame &firstFrame, const Tags &tags)
+{
+	if (!writer.Open(fileName))
+	{
+		return false;
+	}
+
+	segment = std::unique_ptr<mkvmuxer::Segment>(new mkvmuxer::Segment());
+	if (!segment->Init(&writer))
+	{
+		return false;
+	}
+
+	segment->set_mode(mkvmuxer::Segment::kFile);
+	segment->OutputCues(true);
+
+	auto *info = segment->GetSegmentInfo();
+	info->set_timecode_scale(1000000);
+	info->set_writing_app(SYSTEM_NAME " Client");
+
+	if (video)
+	{
+		track = segment->AddVideoTrack(firstFrame.width, firstFrame.height, 0);
+		auto *videoTrack = static_cast<mkvmuxer::VideoTrack*>(segment->GetTrackByNumber(track));
+		if (!videoTrack)
+		{
+			return false;
+		}
+		videoTrack->set_frame_rate(25);
+	}
+	else
+	{
+		track = segment->AddAudioTrack(48000, 1, 0);
+		auto *audioTrack = static_cast<mkvmuxer::AudioTrack*>(segment->GetTrackByNumber(track));
+		if (!audioTrack)
+		{
+			return false;
+		}
+		audioTrack->set_codec_id(mkvmuxer::Tracks::kOpusCodecId);
+	}
+
+	segment->CuesTrack(track);
+
+	auto *tag = segment->AddTag();
+	for (auto &t : tags)
+	{
+		tag->add_simple_tag(t.first.c_str(), t.second.c_str());
+	}
+
+	startTs = lastTs = firstFrame.ts;
+
+	return true;
+}
+
+bool StreamFile::Write(const Frame &frame)
+{
+	if (!segment)
+	{
+		return false;
+	}
+
+	/// The wire's frames can be late, the muxer wants the monotonic time
+	lastTs = std::max(lastTs, frame.ts);
+
+	if (frame.width != 0 && frame.height != 0)
+	{
+		auto *video = static_cast<mkvmuxer::VideoTrack*>(segment->GetTrackByNumber(track));
+		if (video && (video->width() != frame.width || video->height() != frame.height))
+		{
+			video->set_width(frame.width);
+			video->set_height(frame.height);
+		}
+	}
+
+	return segment->AddFrame(frame.data.data(), frame.data.size(), track, lastTs - startTs, frame.key);
+}
+
+void StreamFile::Close()
+{
+	if (segment)
+	{
+		segment->Finalize();
+		segment.reset(nullptr);
+	}
+	writer.Close();
+}
+
+}
@@ -0,0 +1,46 @@
+/**
+ * StreamFile.h - Contains the single stream Matroska file of the multi-track recording
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <Record/BufferedWriter.h>
+#include <Record/FrameQueue.h>
+
+#include <mkvmuxer/mkvmuxer.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace Recorder
+{
+
+/// Keeps one participant's stream as it came from the wire (VP8 or Opus), without any re-encoding.
+/// The time in the file starts from the first frame, the offset in the recording goes to the tags
+class StreamFile
+{
+public:
+	typedef std::vector<std::pair<std::string, std::string>> Tags;
+
+	StreamFile();
+	~StreamFile();
+
+	bool Open(std::string_view fileName, bool video, const Frame &firstFrame, const Tags &tags);
+	bool Write(const Frame &frame);
+	void Close();
+
+private:
+	BufferedWriter writer;
+	std::unique_ptr<mkvmuxer::Segment> segment;
+
+	uint64_t track;
+	uint64_t startTs, lastTs;
+};
+
+}
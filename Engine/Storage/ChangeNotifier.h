@@ -0,0 +1,274 @@
+/**
+ * ChangeNotifier.h - Contains the incremental notifications of the lists changes
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+namespace Storage
+{
+
+std::string GUID();
+
+/// Immutable copy of the list at the version, shared by all the readers of this version
+template <typename Item>
+struct Snapshot
+{
+	uint64_t version = 0;
+	std::shared_ptr<const std::vector<Item>> items;
+};
+
+/// Changes of the list since the previous notification.
+/// The items are the new values of the inserted and then of the updated, in the order of the ids
+template <typename Item, typename Id = int64_t>
+struct ChangeSet
+{
+	uint64_t version = 0; /// Of the list after the changes
+	bool reset = false; /// The list was reloaded, the view has to be rebuilt from the snapshot
+	std::vector<Id> inserted, updated, removed;
+	std::vector<Item> items;
+};
+
+/// Collects the changes of the list made under the list's lock and delivers them to the receivers.
+/// With zero interval the changes are delivered by Commit(), otherwise the changes of the interval
+/// are merged by the ids and delivered by Flush() from the notifier thread of the Storage
+template <typename Item, typename Id = int64_t>
+class ChangeNotifier
+{
+public:
+	typedef ChangeSet<Item, Id> Changes;
+	typedef std::function<void(const Changes &changes)> Receiver;
+
+	ChangeNotifier()
+		: mutex(),
+		receivers(),
+		pending(),
+		reset(false),
+		changed(false),
+		coalesce(false),
+		version(0),
+		snapshot()
+	{
+	}
+
+	std::string Subscribe(Receiver receiver)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto id = GUID();
+		receivers[id] = receiver;
+
+		return id;
+	}
+
+	void Unsubscribe(std::string_view subscriberId)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		receivers.erase(std::string(subscriberId));
+	}
+
+	void SetCoalesce(bool yes)
+	{
+		coalesce = yes;
+	}
+
+	void Insert(const Id &id, const Item &item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = pending.find(id);
+		if (it != pending.end())
+		{
+			/// Removed and inserted again in the same notification is the update for the receiver
+			it->second.kind = it->second.kind == Kind::Removed ? Kind::Updated : it->second.kind;
+			it->second.item = item;
+		}
+		else
+		{
+			pending.emplace(id, Change{ Kind::Inserted, item });
+		}
+		changed = true;
+	}
+
+	void Update(const Id &id, const Item &item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = pending.find(id);
+		if (it != pending.end())
+		{
+			it->second.item = item; /// Inserted stays inserted
+		}
+		else
+		{
+			pending.emplace(id, Change{ Kind::Updated, item });
+		}
+		changed = true;
+	}
+
+	void Remove(const Id &id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = pending.find(id);
+		if (it != pending.end() && it->second.kind == Kind::Inserted)
+		{
+			pending.erase(it); /// The receiver has never seen it
+		}
+		else
+		{
+			pending[id] = Change{ Kind::Removed, Item() };
+		}
+		changed = true;
+	}
+
+	/// The whole list was replaced, the collected changes don't matter
+	void Reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		pending.clear();
+		reset = true;
+		changed = true;
+	}
+
+	/// Ends the change of the list, the version is increased if something was changed.
+	/// Return true if the changes are waiting for the Flush()
+	bool Commit()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!changed)
+			{
+				return false;
+			}
+			changed = false;
+			++version;
+		}
+
+		if (coalesce)
+		{
+			return true;
+		}
+
+		Flush();
+		return false;
+	}
+
+	/// Deliver the collected changes, if there are.
+	/// Return true if the list is in the middle of the change, the changes wait for the next flush
+	bool Flush()
+	{
+		Changes changes;
+		std::vector<Receiver> receivers_;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (changed)
+			{
+				return true;
+			}
+			if (pending.empty() && !reset)
+			{
+				return false;
+			}
+
+			changes.version = version;
+			changes.reset = reset;
+			for (auto &p : pending)
+			{
+				switch (p.second.kind)
+				{
+					case Kind::Inserted:
+						changes.inserted.emplace_back(p.first);
+					break;
+					case Kind::Updated:
+						changes.updated.emplace_back(p.first);
+					break;
+					case Kind::Removed:
+						changes.removed.emplace_back(p.first);
+					break;
+				}
+			}
+			for (auto &p : pending)
+			{
+				if (p.second.kind == Kind::Inserted) changes.items.emplace_back(std::move(p.second.item));
+			}
+			for (auto &p : pending)
+			{
+				if (p.second.kind == Kind::Updated) changes.items.emplace_back(std::move(p.second.item));
+			}
+
+			pending.clear();
+			reset = false;
+
+			for (auto &r : receivers)
+			{
+				receivers_.emplace_back(r.second);
+			}
+		}
+
+		for (auto &receiver : receivers_)
+		{
+			receiver(changes);
+		}
+
+		return false;
+	}
+
+	uint64_t GetVersion() const
+	{
+		return version;
+	}
+
+	/// The caller holds the lock of the list, the copy is made once per version
+	Snapshot<Item> MakeSnapshot(const std::vector<Item> &items)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!snapshot.items || snapshot.version != version)
+		{
+			snapshot.version = version;
+			snapshot.items = std::make_shared<const std::vector<Item>>(items);
+		}
+
+		return snapshot;
+	}
+
+private:
+	enum class Kind
+	{
+		Inserted,
+		Updated,
+		Removed
+	};
+
+	struct Change
+	{
+		Kind kind;
+		Item item;
+	};
+
+	std::mutex mutex;
+	std::map<std::string, Receiver> receivers;
+
+	std::map<Id, Change> pending;
+	bool reset, changed;
+
+	std::atomic<bool> coalesce;
+	std::atomic<uint64_t> version;
+
+	Snapshot<Item> snapshot;
+};
+
+}
@@ -0,0 +1,118 @@
+/**
+ * Connection.cpp - Contains the long-lived database connection impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Storage/Connection.h>
+
+namespace Storage
+{
+
+Statement::Statement(db::query *query_, bool *busy_, std::unique_ptr<db::query> &&owned_)
+	: query(query_),
+	busy(busy_),
+	owned(std::move(owned_))
+{
+}
+
+Statement::Statement(Statement &&other) noexcept
+	: query(other.query),
+	busy(other.busy),
+	owned(std::move(other.owned))
+{
+	other.query = nullptr;
+	other.busy = nullptr;
+}
+
+Statement::~Statement()
+{
+	if (query)
+	{
+		query->reset(); /// Don't keep the read transaction open until the next use
+	}
+	if (busy)
+	{
+		*busy = false;
+	}
+}
+
+Connection::Connection(std::string_view path, size_t cacheSize_)
+	: conn(db::dbms::SQLite, path),
+	cacheSize(cacheSize_),
+	entries(),
+	index()
+{
+	/// WAL lets the readers of other threads work while the writer commits,
+	/// and the busy timeout makes the writers wait for each other instead of failing
+	db::query pragma_query(conn);
+	pragma_query.prepare("PRAGMA journal_mode=WAL");
+	pragma_query.step();
+	pragma_query.prepare("PRAGMA synchronous=NORMAL");
+	pragma_query.step();
+	pragma_query.prepare("PRAGMA busy_timeout=5000");
+	pragma_query.step();
+}
+
+Connection::~Connection()
+{
+	index.clear();
+	entries.clear(); /// Statements have to be finalized before the connection is closed
+}
+
+db::connection &Connection::Get()
+{
+	return conn;
+}
+
+Statement Connection::Prepare(std::string_view sql)
+{
+	auto it = index.find(sql);
+	if (it != index.end())
+	{
+		auto entry = it->second;
+		if (!entry->busy)
+		{
+			entries.splice(entries.begin(), entries, entry);
+			entry->busy = true;
+			return Statement(entry->query.get(), &entry->busy, nullptr);
+		}
+
+		/// Recursive use of the same statement, give a temporary one
+		auto owned = std::make_unique<db::query>(conn);
+		owned->prepare(sql);
+		auto query = owned.get();
+		return Statement(query, nullptr, std::move(owned));
+	}
+
+	auto query = std::make_unique<db::query>(conn);
+	if (query->prepare(sql) != db::result::OK)
+	{
+		auto failed = query.get();
+		return Statement(failed, nullptr, std::move(query));
+	}
+
+	entries.push_front(Entry{ std::string(sql), std::move(query), true });
+	index[entries.front().sql] = entries.begin();
+
+	Evict();
+
+	return Statement(entries.front().query.get(), &entries.front().busy, nullptr);
+}
+
+void Connection::Evict()
+{
+	auto it = entries.end();
+	while (entries.size() > cacheSize && it != entries.begin())
+	{
+		--it;
+		if (!it->busy)
+		{
+			index.erase(it->sql);
+			it = entries.erase(it);
+		}
+	}
+}
+
+}
@@ -0,0 +1,80 @@
+/**
+ * Connection.h - Contains the long-lived database connection with the prepared statements cache
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+
+#include <db/connection.h>
+#include <db/query.h>
+
+namespace Storage
+{
+
+class Connection;
+
+/// Prepared statement taken from the cache, ready to bind.
+/// Resets the statement and gives it back to the cache on destruction
+class Statement
+{
+public:
+	Statement(Statement &&other) noexcept;
+	~Statement();
+
+	db::query *operator->() { return query; }
+	db::query &operator*() { return *query; }
+
+	Statement(const Statement&) = delete;
+	Statement &operator=(const Statement&) = delete;
+	Statement &operator=(Statement&&) = delete;
+
+private:
+	friend Connection;
+
+	Statement(db::query *query, bool *busy, std::unique_ptr<db::query> &&owned);
+
+	db::query *query;
+	bool *busy;
+	std::unique_ptr<db::query> owned; /// Not cached statement, the same SQL is already in use up the stack
+};
+
+/// SQLite connection opened once in the WAL mode.
+/// Works only in the thread was created it (SQLITE_THREADSAFE=2), so the Storage keeps one per thread
+class Connection
+{
+public:
+	Connection(std::string_view path, size_t cacheSize);
+	~Connection();
+
+	db::connection &Get();
+
+	/// Return the cached statement, the least recently used one is finalized if the cache is full
+	Statement Prepare(std::string_view sql);
+
+private:
+	struct Entry
+	{
+		std::string sql;
+		std::unique_ptr<db::query> query;
+		bool busy;
+	};
+
+	typedef std::list<Entry> Entries;
+
+	db::connection conn;
+
+	size_t cacheSize;
+	Entries entries; /// The most recently used in front
+	std::unordered_map<std::string_view, Entries::iterator> index; /// Keys point to Entry::sql
+
+	void Evict();
+};
+
+}
@@ -0,0 +1,92 @@
+/**
+ * HistoryWindow.cpp - Contains the window over the pages of the messages history impl
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#include <Storage/HistoryWindow.h>
+
+namespace Storage
+{
+
+HistoryWindow::HistoryWindow(Storage &storage_, int64_t subscriber_, std::string_view conference_, uint32_t pageSize_, size_t maxPages_)
+	: storage(storage_),
+	subscriber(subscriber_),
+	conference(conference_),
+	pageSize(pageSize_),
+	maxPages(maxPages_ > 1 ? maxPages_ : 2),
+	pages(),
+	hasOlder(false),
+	hasNewer(false)
+{
+}
+
+void HistoryWindow::Reset()
+{
+	pages.clear();
+
+	auto page = storage.LoadHistoryPage(subscriber, conference, HistoryCursor(), HistoryDirection::Older, pageSize);
+	hasOlder = page->more;
+	hasNewer = false;
+
+	if (!page->messages.empty())
+	{
+		pages.emplace_back(page);
+	}
+}
+
+bool HistoryWindow::ScrollOlder()
+{
+	if (pages.empty() || !hasOlder)
+	{
+		return false;
+	}
+
+	auto page = storage.LoadHistoryPage(subscriber, conference, pages.back()->oldest, HistoryDirection::Older, pageSize);
+	hasOlder = page->more;
+	if (page->messages.empty())
+	{
+		return false;
+	}
+
+	pages.emplace_back(page);
+	if (pages.size() > maxPages)
+	{
+		pages.pop_front();
+		hasNewer = true;
+	}
+
+	return true;
+}
+
+bool HistoryWindow::ScrollNewer()
+{
+	if (pages.empty() || !hasNewer)
+	{
+		return false;
+	}
+
+	auto page = storage.LoadHistoryPage(subscriber, conference, pages.front()->newest, HistoryDirection::Newer, pageSize);
+	hasNewer = page->more;
+	if (page->messages.empty())
+	{
+		return false;
+	}
+
+	pages.emplace_front(page);
+	if (pages.size() > maxPages)
+	{
+		pages.pop_back();
+		hasOlder = true;
+	}
+
+	return true;
+}
+
+const std::deque<MessagesPagePtr> &HistoryWindow::GetPages() const
+{
+	return pages;
+}
+
+}
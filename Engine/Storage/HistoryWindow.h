@@ -0,0 +1,48 @@
+/**
+ * HistoryWindow.h - Contains the window over the pages of the messages history
+ *
+ * Author: Anton (ud) Golovkov, udattsk@gmail.com
+ * Copyright (C), Infinity Video Soft LLC, 2024
+ */
+
+#pragma once
+
+#include <deque>
+
+#include <Storage/Storage.h>
+
+namespace Storage
+{
+
+/// Keeps only maxPages pages of the history around the visible part of the chat.
+/// Scrolling loads the neighbor page and drops the page from the opposite edge,
+/// the pages are immutable so the view reads them without the storage's lock
+class HistoryWindow
+{
+public:
+	HistoryWindow(Storage &storage, int64_t subscriber, std::string_view conference, uint32_t pageSize, size_t maxPages);
+
+	/// Load the newest page, drop all others
+	void Reset();
+
+	/// Return false if there are no messages in the direction
+	bool ScrollOlder();
+	bool ScrollNewer();
+
+	/// From the newest to the oldest page
+	const std::deque<MessagesPagePtr> &GetPages() const;
+
+private:
+	Storage &storage;
+
+	int64_t subscriber;
+	std::string conference;
+
+	uint32_t pageSize;
+	size_t maxPages;
+
+	std::deque<MessagesPagePtr> pages;
+	bool hasOlder, hasNewer;
+};
+
+}
@@ -6,21 +6,26 @@
  */
 
 #include <ctime>
+#include <chrono>
 #include <algorithm>
+#include <variant>
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
 #include <Storage/Storage.h>
+#include <Storage/Connection.h>
 
 #include <Proto/ConferenceGrants.h>
 #include <Common/BitHelpers.h>
+#include <Common/TimeMeter.h>
 
-#include <db/connection.h>
 #include <db/transaction.h>
 #include <db/query.h>
 
+#include <spdlog/spdlog.h>
+
 namespace Storage
 {
 
@@ -29,15 +34,104 @@ std::string GUID()
 	return boost::uuids::to_string(boost::uuids::random_generator()());
 }
 
+/// The unreaded counters are kept by the triggers on messages,
+/// so the conditions are the SQL expressions over the row (new / old)
+std::string MyClientIdSQL()
+{
+	return "(select cast(value as integer) from settings where key = 'my_client_id')";
+}
+
+std::string UnreadedContactCondition(std::string_view row)
+{
+	const std::string r(row);
+	return "(" + r + ".conference_tag is null and " + r + ".subscriber_id is not null and " +
+		r + ".status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and ((" +
+		r + ".type = " + std::to_string(static_cast<int32_t>(Proto::MessageType::TextMessage)) + " and " + r + ".author_id <> " + MyClientIdSQL() + ") or " +
+		r + ".type = " + std::to_string(static_cast<int32_t>(Proto::MessageType::ServiceMessage)) + "))";
+}
+
+std::string UnreadedConferenceCondition(std::string_view row)
+{
+	const std::string r(row);
+	return "(" + r + ".subscriber_id is null and " + r + ".conference_tag is not null and " +
+		r + ".status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and (" +
+		r + ".author_id is null or " + r + ".author_id <> " + MyClientIdSQL() + "))";
+}
+
+std::string IncrementUnreadedSQL(std::string_view table, std::string_view key, std::string_view condition)
+{
+	return "insert into " + std::string(table) + " (" + std::string(key) + ", count) select new." + std::string(key) + ", 1 where " + std::string(condition) +
+		" on conflict(" + std::string(key) + ") do update set count = count + 1;";
+}
+
+std::string DecrementUnreadedSQL(std::string_view table, std::string_view key, std::string_view condition)
+{
+	return "update " + std::string(table) + " set count = count - 1 where " + std::string(key) + " = old." + std::string(key) + " and " + std::string(condition) + ";";
+}
+
+/// Creates the counters tables and the triggers, called by the migration
+void CreateUnreadedCounters(db::connection &conn)
+{
+	const std::string contactNew = UnreadedContactCondition("new"), contactOld = UnreadedContactCondition("old");
+	const std::string conferenceNew = UnreadedConferenceCondition("new"), conferenceOld = UnreadedConferenceCondition("old");
+
+	const std::string statements[] = {
+		"CREATE TABLE `unreaded_contacts` (`subscriber_id` INTEGER NOT NULL PRIMARY KEY, `count` INTEGER NOT NULL)",
+		"CREATE TABLE `unreaded_conferences` (`conference_tag` TEXT NOT NULL PRIMARY KEY, `count` INTEGER NOT NULL)",
+
+		"CREATE TRIGGER `messages_unreaded_insert` AFTER INSERT ON `messages` BEGIN " +
+			IncrementUnreadedSQL("unreaded_contacts", "subscriber_id", contactNew) +
+			IncrementUnreadedSQL("unreaded_conferences", "conference_tag", conferenceNew) + " END",
+
+		"CREATE TRIGGER `messages_unreaded_delete` AFTER DELETE ON `messages` BEGIN " +
+			DecrementUnreadedSQL("unreaded_contacts", "subscriber_id", contactOld) +
+			DecrementUnreadedSQL("unreaded_conferences", "conference_tag", conferenceOld) + " END",
+
+		"CREATE TRIGGER `messages_unreaded_update` AFTER UPDATE OF `status`, `type`, `author_id`, `subscriber_id`, `conference_tag` ON `messages` BEGIN " +
+			DecrementUnreadedSQL("unreaded_contacts", "subscriber_id", contactOld) +
+			DecrementUnreadedSQL("unreaded_conferences", "conference_tag", conferenceOld) +
+			IncrementUnreadedSQL("unreaded_contacts", "subscriber_id", contactNew) +
+			IncrementUnreadedSQL("unreaded_conferences", "conference_tag", conferenceNew) + " END",
+
+		/// Cover the remaining filters of the messages
+		"CREATE INDEX `messages_subscriber_id_dt_index` ON `messages` ( `subscriber_id`, `dt` DESC )",
+		"CREATE INDEX `messages_conference_tag_dt_index` ON `messages` ( `conference_tag`, `dt` DESC )",
+		"CREATE INDEX `messages_sender_id_type_status_index` ON `messages` ( `sender_id`, `type`, `status` )",
+		"CREATE INDEX `messages_type_status_dt_index` ON `messages` ( `type`, `status`, `dt` )",
+		"CREATE INDEX `client_groups_client_id_index` ON `client_groups` ( `client_id`, `group_id` )"
+	};
+
+	for (auto &sql : statements)
+	{
+		db::query query(conn);
+		query.prepare(sql);
+		query.step();
+	}
+}
+
+/// Recalculate the counters by the full scan, when the own client id is changed or the check has failed
+void RebuildUnreadedCounters(Connection &conn)
+{
+	conn.Prepare("delete from unreaded_contacts")->step();
+	conn.Prepare("delete from unreaded_conferences")->step();
+	conn.Prepare("insert into unreaded_contacts (subscriber_id, count) select subscriber_id, count(id) from messages where " +
+		UnreadedContactCondition("messages") + " group by subscriber_id")->step();
+	conn.Prepare("insert into unreaded_conferences (conference_tag, count) select conference_tag, count(id) from messages where " +
+		UnreadedConferenceCondition("messages") + " group by conference_tag")->step();
+}
+
 Storage::Storage()
 	: dbPath(),
+	connectionsMutex(), connections(),
 	myClientId(0),
-	messagesStart(0), messagesEnd(0), messageSubscriber(0), messagesLimit(0),
+	messagesStart(0), messagesEnd(), messageSubscriber(0), messagesLimit(0),
 	messagesConference(),
 	messagesMutex(), messages(), messagesReceivers(),
 	contactsMutex(), contacts(), contactsReceivers(),
 	groupsMutex(), groups(), groupsReceivers(),
 	conferencesMutex(), conferences(), conferencesReceivers(),
+	messagesChanges(), contactsChanges(), groupsChanges(), conferencesChanges(),
+	notifier(), notifierMutex(), notifierCV(), notifyInterval(0), notifierRunned(false), notifierWaked(false),
     contactSortType(Proto::CONTACT_LIST::SortType::Undefined),
     showNumbers(-1)
 {
@@ -45,30 +139,144 @@ Storage::Storage()
 
 Storage::~Storage()
 {
+	StopNotifier();
+	StopSearchIndexer();
+}
+
+Connection &Storage::GetConnection()
+{
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+
+	auto &connection = connections[std::this_thread::get_id()];
+	if (!connection)
+	{
+		connection = std::make_unique<Connection>(dbPath, STATEMENTS_CACHE_SIZE);
+	}
+
+	return *connection;
+}
+
+void Storage::ReleaseConnection()
+{
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	connections.erase(std::this_thread::get_id());
 }
 
 void Storage::Connect(std::string_view dbPath_)
 {
+	StopSearchIndexer();
+
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		connections.clear();
+	}
+
 	dbPath = dbPath_;
 	UpdateDB();
+	CheckUnreadedCounters();
 	LoadContacts();
 	LoadGroups();
 	LoadConferences();
+	StartSearchIndexer();
+
+	contactsChanges.Reset();
+	groupsChanges.Reset();
+	conferencesChanges.Reset();
+
+	bool waiting = contactsChanges.Commit();
+	waiting = groupsChanges.Commit() || waiting;
+	waiting = conferencesChanges.Commit() || waiting;
+	if (waiting) WakeNotifier();
+}
+
+void Storage::SetNotifyInterval(std::chrono::milliseconds interval)
+{
+	StopNotifier();
+
+	notifyInterval = interval;
+
+	auto coalesce = interval.count() > 0;
+	messagesChanges.SetCoalesce(coalesce);
+	contactsChanges.SetCoalesce(coalesce);
+	groupsChanges.SetCoalesce(coalesce);
+	conferencesChanges.SetCoalesce(coalesce);
+
+	if (coalesce)
+	{
+		notifierRunned = true;
+		notifier = std::thread(&Storage::RunNotifier, this);
+	}
+}
+
+void Storage::StopNotifier()
+{
+	{
+		std::lock_guard<std::mutex> lock(notifierMutex);
+		notifierRunned = false;
+	}
+	notifierCV.notify_one();
+
+	if (notifier.joinable()) notifier.join();
+
+	/// Deliver the rest
+	messagesChanges.Flush();
+	contactsChanges.Flush();
+	groupsChanges.Flush();
+	conferencesChanges.Flush();
+}
+
+void Storage::WakeNotifier()
+{
+	{
+		std::lock_guard<std::mutex> lock(notifierMutex);
+		notifierWaked = true;
+	}
+	notifierCV.notify_one();
+}
+
+void Storage::RunNotifier()
+{
+	std::unique_lock<std::mutex> lock(notifierMutex);
+	while (notifierRunned)
+	{
+		notifierCV.wait(lock, [this]() { return !notifierRunned || notifierWaked; });
+
+		/// The changes made during the interval go to the same notification
+		notifierCV.wait_for(lock, notifyInterval, [this]() { return !notifierRunned; });
+		notifierWaked = false;
+
+		lock.unlock();
+
+		bool again = messagesChanges.Flush();
+		again = contactsChanges.Flush() || again;
+		again = groupsChanges.Flush() || again;
+		again = conferencesChanges.Flush() || again;
+
+		lock.lock();
+
+		if (again) notifierWaked = true;
+	}
 }
 
 void Storage::SetMyClientId(int64_t id)
 {
+	auto changed = GetMyClientId() != id;
+
 	myClientId = id;
 
-    db::connection conn(db::dbms::SQLite, dbPath);
+    auto &conn = GetConnection();
 
-    db::transaction writeTr(conn);
+    db::transaction writeTr(conn.Get());
     writeTr.start();
 
-    db::query upd_sort_query(conn);
-    upd_sort_query.prepare("update settings set value = ? where key='my_client_id'");
-    upd_sort_query.set(0, id);
-    upd_sort_query.step();
+    auto upd_sort_query = conn.Prepare("update settings set value = ? where key='my_client_id'");
+    upd_sort_query->set(0, id);
+    upd_sort_query->step();
+
+    if (changed)
+    {
+        RebuildUnreadedCounters(conn); /// The own messages are not counted
+    }
 
     writeTr.commit();
 }
@@ -77,33 +285,35 @@ void Storage::SetMyClientId(int64_t id)
 
 void Storage::AddMessage(const Proto::Message &message)
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 
-	db::query message_query(conn);
-	message_query.prepare("insert into messages (guid, dt, type, author_id, sender_id, subscriber_id, conference_tag, text_value, call_duration, call_result, data_preview, data_url, status) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-	message_query.set(0, message.guid);
-	message_query.set(1, static_cast<int64_t>(message.dt));
-	message_query.set(2, static_cast<int32_t>(message.type));
-	message_query.set(3, message.author_id);
-	message_query.set(4, message.sender_id);
-	message_query.set(5, message.subscriber_id);
-	message_query.set(6, message.conference_tag);
-	message_query.set(7, message.text);
-	message_query.set(8, message.call_duration);
-	message_query.set(9, static_cast<int32_t>(message.call_result));
-	message_query.set(10, message.preview);
-	message_query.set(11, message.url);
-	message_query.set(12, static_cast<int32_t>(message.status));
-	message_query.step();
-	message_query.reset();
+	auto message_query = conn.Prepare("insert into messages (guid, dt, type, author_id, sender_id, subscriber_id, conference_tag, text_value, call_duration, call_result, data_preview, data_url, status) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+	message_query->set(0, message.guid);
+	message_query->set(1, static_cast<int64_t>(message.dt));
+	message_query->set(2, static_cast<int32_t>(message.type));
+	message_query->set(3, message.author_id);
+	message_query->set(4, message.sender_id);
+	message_query->set(5, message.subscriber_id);
+	message_query->set(6, message.conference_tag);
+	message_query->set(7, message.text);
+	message_query->set(8, message.call_duration);
+	message_query->set(9, static_cast<int32_t>(message.call_result));
+	message_query->set(10, message.preview);
+	message_query->set(11, message.url);
+	message_query->set(12, static_cast<int32_t>(message.status));
+	message_query->step();
+	message_query->reset();
 	
 	if (messageSubscriber == message.subscriber_id || (!messagesConference.empty() && messagesConference == message.conference_tag))
 	{
 		std::lock_guard<std::recursive_mutex> lock(messagesMutex);
 		messages.insert(messages.begin(), message);
+
+		messagesChanges.Insert(message.guid, message);
+		if (messagesChanges.Commit()) WakeNotifier();
 	}
 	
 	writeTr.commit();
@@ -114,122 +324,168 @@ void Storage::AddMessage(const Proto::Message &message)
     }
 }
 
+/// Values bound to the "?" placeholders in the order of adding, monostate is null
+typedef std::vector<std::variant<std::monostate, int64_t, double, std::string>> SQLParams;
+
 template <typename T>
-inline void AddSQLValue(std::string_view fieldName, T value, std::string &fields, std::string &values, bool exists, bool allowNull = true)
+inline void AddSQLParam(SQLParams &params, T value, bool allowNull = true)
 {
-	std::string value_ = std::to_string(value);
 	if (value == 0 && allowNull)
 	{
-		value_ = "null";
+		params.emplace_back(std::monostate());
 	}
+	else
+	{
+		params.emplace_back(static_cast<int64_t>(value));
+	}
+}
 
-	if (!exists)
+inline void AddSQLParam(SQLParams &params, const std::string &value)
+{
+	if (value.empty())
 	{
-		fields += std::string(fieldName) + ",";
-		values += value_ + ",";
+		params.emplace_back(std::monostate());
 	}
 	else
 	{
-		values += std::string(fieldName) + "=" + value_ + ",";
+		params.emplace_back(value);
 	}
 }
 
-inline void AddSQLValue(std::string_view fieldName, const std::string& value, std::string& fields, std::string& values, bool exists)
+inline void BindSQLParam(db::query &query, size_t position, const SQLParams::value_type &param)
 {
-	std::string value_ = "'" + value + "'";
-	if (value.empty())
+	if (std::holds_alternative<int64_t>(param))
 	{
-		value_ = "null";
+		query.set(position, std::get<int64_t>(param));
 	}
-
-	if (!exists)
+	else if (std::holds_alternative<double>(param))
+	{
+		query.set(position, std::get<double>(param));
+	}
+	else if (std::holds_alternative<std::string>(param))
 	{
-		fields += std::string(fieldName) + ",";
-		values += value_ + ",";
+		query.set(position, std::string_view(std::get<std::string>(param)));
 	}
 	else
 	{
-		values += std::string(fieldName) + "=" + value_ + ",";
+		query.set_null(position);
 	}
 }
 
-template <typename T>
-inline void AddOnlyDataSQLValue(std::string_view fieldName, T value, std::string &fields, std::string &values, bool exists)
+void BindSQLParams(db::query &query, const SQLParams &params)
 {
-	if (value != 0)
+	for (size_t i = 0; i != params.size(); ++i)
 	{
-		if (!exists)
-		{
-			fields += std::string(fieldName) + ",";
-			values += std::to_string(value) + ",";
-		}
-		else
-		{
-			values += std::string(fieldName) + "=" + std::to_string(value) + ",";
-		}
+		BindSQLParam(query, i, params[i]);
 	}
 }
 
-inline void AddOnlyDataSQLValue(std::string_view fieldName, const std::string &value, std::string &fields, std::string &values, bool exists)
+/// Old SQLite builds limit a statement by 999 parameters
+static const size_t MAX_SQL_PARAMS = 999;
+
+/// Run "<head> values (?, ...), (?, ...) <tail>" with the multi-row batches,
+/// params contains the rows one by one, the columns of each row, return the count of rows
+size_t ExecuteBatches(Connection &conn, std::string_view head, std::string_view tail, size_t columns, const SQLParams &params)
 {
-	if (!value.empty())
+	const size_t rows = params.size() / columns;
+	const size_t batchRows = MAX_SQL_PARAMS / columns;
+
+	std::string row = "(";
+	for (size_t i = 0; i != columns; ++i)
+	{
+		row += "?,";
+	}
+	row.back() = ')';
+
+	for (size_t first = 0; first < rows; first += batchRows)
 	{
-		if (!exists)
+		const auto count = std::min(batchRows, rows - first);
+
+		std::string sql(head);
+		sql += " values ";
+		for (size_t i = 0; i != count; ++i)
 		{
-			fields += std::string(fieldName) + ",";
-			values += "'" + value + "',";
+			sql += row + ",";
 		}
-		else
+		sql.pop_back(); // drop last ","
+		sql += " ";
+		sql += tail;
+
+		/// The full batches have the same text, so only the last one is prepared again
+		auto query = conn.Prepare(sql);
+		for (size_t i = 0; i != count * columns; ++i)
 		{
-			values += std::string(fieldName) + "='" + value + "',";
+			BindSQLParam(*query, i, params[first * columns + i]);
 		}
+		query->step();
+	}
+
+	return rows;
+}
+
+/// The set of synchronized ids and the links (client - group, conference - member) in the temp tables,
+/// lets to update and delete the links with a few statements instead of the row by row queries
+void FillSyncTables(Connection &conn, const SQLParams &ids, const SQLParams &links)
+{
+	conn.Prepare("create temp table if not exists sync_ids (id INTEGER NOT NULL PRIMARY KEY, deleted INTEGER)")->step();
+	conn.Prepare("create temp table if not exists sync_links (owner_id INTEGER NOT NULL, item_id INTEGER NOT NULL, grants INTEGER)")->step();
+	conn.Prepare("delete from temp.sync_ids")->step();
+	conn.Prepare("delete from temp.sync_links")->step();
+
+	ExecuteBatches(conn, "insert or replace into temp.sync_ids (id, deleted)", "", 2, ids);
+	ExecuteBatches(conn, "insert into temp.sync_links (owner_id, item_id, grants)", "", 3, links);
+}
+
+void ReportSync(std::string_view name, size_t rows, size_t deleted, Common::TimeMeter &timeMeter)
+{
+	auto sysLog = spdlog::get("System");
+	if (sysLog)
+	{
+		sysLog->info("Storage :: {0} synchronized {1} rows ({2} deleted) in {3} ms", name, rows, deleted, timeMeter.Measure() / 1000);
 	}
 }
 
 void Storage::UpdateMessages(const Messages &inputMessages)
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	Common::TimeMeter timeMeter;
 
-	db::transaction writeTr(conn);
+	auto &conn = GetConnection();
+
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
-	
-	db::query exists_query(conn);
-	exists_query.prepare("select id from messages where guid = ?");
 
-	db::query message_query(conn);
-	
+	/// Zero and empty fields are bound as null and don't overwrite the stored values
+	SQLParams params;
+	for (auto &message : inputMessages)
+	{
+		AddSQLParam(params, message.guid);
+		AddSQLParam(params, message.dt);
+		AddSQLParam(params, static_cast<int32_t>(message.type));
+		AddSQLParam(params, message.author_id);
+		AddSQLParam(params, message.sender_id);
+		AddSQLParam(params, message.subscriber_id);
+		AddSQLParam(params, message.conference_tag);
+		AddSQLParam(params, message.text);
+		AddSQLParam(params, message.call_duration);
+		AddSQLParam(params, static_cast<int32_t>(message.call_result));
+		AddSQLParam(params, message.preview);
+		AddSQLParam(params, message.url);
+		AddSQLParam(params, static_cast<int32_t>(message.status));
+	}
+
+	auto rows = ExecuteBatches(conn,
+		"insert into messages (guid, dt, type, author_id, sender_id, subscriber_id, conference_tag, text_value, call_duration, call_result, data_preview, data_url, status)",
+		"on conflict(guid) do update set dt = coalesce(excluded.dt, dt), type = coalesce(excluded.type, type), author_id = coalesce(excluded.author_id, author_id), "
+		"sender_id = coalesce(excluded.sender_id, sender_id), subscriber_id = coalesce(excluded.subscriber_id, subscriber_id), conference_tag = coalesce(excluded.conference_tag, conference_tag), "
+		"text_value = coalesce(excluded.text_value, text_value), call_duration = coalesce(excluded.call_duration, call_duration), call_result = coalesce(excluded.call_result, call_result), "
+		"data_preview = coalesce(excluded.data_preview, data_preview), data_url = coalesce(excluded.data_url, data_url), status = coalesce(excluded.status, status)",
+		13, params);
+
     bool updatedMessages = false;
 
 	std::lock_guard<std::recursive_mutex> lock(messagesMutex);
 	for (auto &message : inputMessages)
 	{
-		exists_query.set(0, message.guid);
-		bool exists = exists_query.step();
-		exists_query.reset();
-
-		std::string sqlFields, sqlValues;
-
-		AddOnlyDataSQLValue("guid", message.guid, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("dt", message.dt, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("type", static_cast<int32_t>(message.type), sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("author_id", message.author_id, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("sender_id", message.sender_id, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("subscriber_id", message.subscriber_id, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("conference_tag", message.conference_tag, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("text_value", message.text, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("call_duration", message.call_duration, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("call_result", static_cast<int32_t>(message.call_result), sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("data_preview", message.preview, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("data_url", message.url, sqlFields, sqlValues, exists);
-		AddOnlyDataSQLValue("status", static_cast<int32_t>(message.status), sqlFields, sqlValues, exists);
-
-		if (!sqlFields.empty()) sqlFields.pop_back(); // drop last ","
-		if (!sqlValues.empty()) sqlValues.pop_back(); // drop last ","
-
-		message_query.prepare(!exists ? "insert into messages (" + sqlFields + ") values (" + sqlValues + ")" : "update messages set " + sqlValues + " where guid='" + message.guid + "'");
-		message_query.step();
-		message_query.reset();
-
 		if (messageSubscriber == message.subscriber_id ||
 			(!messagesConference.empty() && messagesConference == message.conference_tag) ||
 			message.status == Proto::MessageStatus::Readed)
@@ -249,10 +505,14 @@ void Storage::UpdateMessages(const Messages &inputMessages)
 				if (!message.preview.empty())                            storedMessage->preview = message.preview;
 				if (!message.url.empty())                                storedMessage->url = message.url;
 				if (message.status != Proto::MessageStatus::Undefined)   storedMessage->status = message.status;
+
+				messagesChanges.Update(message.guid, *storedMessage);
 			}
 			else
 			{
 				messages.emplace_back(message);
+
+				messagesChanges.Insert(message.guid, message);
 			}
 
 			updatedMessages = true;
@@ -267,11 +527,18 @@ void Storage::UpdateMessages(const Messages &inputMessages)
 			return a.dt > b.dt;
 		});
 
-		messagesEnd = (messages.end() - 1)->dt;
+		if ((messages.end() - 1)->dt < messagesEnd.dt)
+		{
+			messagesEnd = HistoryCursor{ (messages.end() - 1)->dt, 0 };
+		}
 	}
+
+	if (messagesChanges.Commit()) WakeNotifier();
 	
 	writeTr.commit();
 
+	ReportSync("UpdateMessages", rows, 0, timeMeter);
+
 	UpdateUnreadedContacts();
 	UpdateUnreadedConferences();
 
@@ -327,96 +594,127 @@ std::vector<int64_t> Storage::GetAbsentContacts(const Messages &messages_)
     return out;
 }
 
-void Storage::UpdateUnreadedContacts()
+bool Storage::CheckUnreadedCounters()
 {
-	if (GetMyClientId() == 0)
+	auto &conn = GetConnection();
+
+	/// Both directions of the difference between the stored and the calculated counters
+	auto check_query = conn.Prepare("select count(*) from ("
+		"select subscriber_id, count from unreaded_contacts where count <> 0 except "
+		"select subscriber_id, count(id) from messages where " + UnreadedContactCondition("messages") + " group by subscriber_id) "
+		"union all select count(*) from ("
+		"select subscriber_id, count(id) from messages where " + UnreadedContactCondition("messages") + " group by subscriber_id except "
+		"select subscriber_id, count from unreaded_contacts) "
+		"union all select count(*) from ("
+		"select conference_tag, count from unreaded_conferences where count <> 0 except "
+		"select conference_tag, count(id) from messages where " + UnreadedConferenceCondition("messages") + " group by conference_tag) "
+		"union all select count(*) from ("
+		"select conference_tag, count(id) from messages where " + UnreadedConferenceCondition("messages") + " group by conference_tag except "
+		"select conference_tag, count from unreaded_conferences)");
+
+	int64_t mismatches = 0;
+	while (check_query->step())
+	{
+		mismatches += check_query->get_int64(0);
+	}
+
+	if (mismatches == 0)
+	{
+		return true;
+	}
+
+	auto errLog = spdlog::get("Error");
+	if (errLog)
 	{
-		return;
+		errLog->error("Storage :: Unreaded counters are inconsistent ({0} mismatches), rebuilding", mismatches);
 	}
 
+	db::transaction writeTr(conn.Get());
+	writeTr.start();
+	RebuildUnreadedCounters(conn);
+	writeTr.commit();
+
+	return false;
+}
+
+void Storage::UpdateUnreadedContacts()
+{
 	std::lock_guard<std::recursive_mutex> lock(contactsMutex);
-	for (auto &c : contacts)
+
+	std::map<int64_t, uint32_t> counts;
+
+	auto &conn = GetConnection();
+	auto count_query = conn.Prepare("select subscriber_id, count from unreaded_contacts where count > 0");
+	while (count_query->step())
 	{
-		c.unreaded_count = 0;
+		counts[count_query->get_int64(0)] = static_cast<uint32_t>(count_query->get_int32(1));
 	}
 
-	db::connection conn(db::dbms::SQLite, dbPath);
-	db::query count_query(conn);
-	count_query.prepare("select subscriber_id, count(id) from messages where status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and ((type = " + std::to_string(static_cast<int32_t>(Proto::MessageType::TextMessage)) + " and author_id <> ?) or type = " + std::to_string(static_cast<int32_t>(Proto::MessageType::ServiceMessage)) + ") and conference_tag is null group by subscriber_id");
-	count_query.set(0, GetMyClientId());
-	while (count_query.step())
+	/// Only the contacts with the changed counter are notified
+	for (auto &c : contacts)
 	{
-		auto it = std::find(contacts.begin(), contacts.end(), count_query.get_int64(0));
-		if (it != contacts.end())
+		auto it = counts.find(c.id);
+		auto count = it != counts.end() ? it->second : 0u;
+		if (c.unreaded_count != count)
 		{
-			it->unreaded_count = count_query.get_int32(1);
+			c.unreaded_count = count;
+			contactsChanges.Update(c.id, c);
 		}
 	}
 
     SortContacts();
+
+	if (contactsChanges.Commit()) WakeNotifier();
 }
 
 void Storage::UpdateUnreadedConferences()
 {
-	if (GetMyClientId() == 0)
-	{
-		return;
-	}
-
 	std::lock_guard<std::recursive_mutex> lock_(conferencesMutex);
-	for (auto &c : conferences)
+
+	std::map<std::string, uint32_t> counts;
+
+	auto &conn = GetConnection();
+	auto count_query = conn.Prepare("select conference_tag, count from unreaded_conferences where count > 0");
+	while (count_query->step())
 	{
-		c.unreaded_count = 0;
+		counts[count_query->get_string(0)] = static_cast<uint32_t>(count_query->get_int32(1));
 	}
 
-	db::connection conn(db::dbms::SQLite, dbPath);
-	db::query count_query(conn);
-	count_query.prepare("select conference_tag, count(id) from messages where status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and subscriber_id is null and (author_id is null or author_id <> ?) group by conference_tag");
-	count_query.set(0, GetMyClientId());
-	while (count_query.step())
+	for (auto &c : conferences)
 	{
-		auto it = std::find(conferences.begin(), conferences.end(), count_query.get_string(0));
-		if (it != conferences.end())
+		auto it = counts.find(c.tag);
+		auto count = it != counts.end() ? it->second : 0u;
+		if (c.unreaded_count != count)
 		{
-			it->unreaded_count = count_query.get_int32(1);
+			c.unreaded_count = count;
+			conferencesChanges.Update(c.id, c);
 		}
 	}
 
     SortConferences();
+
+	if (conferencesChanges.Commit()) WakeNotifier();
 }
 
-int32_t Storage::CalcUnreadedContact(db::connection &conn, int64_t clientId)
+int32_t Storage::CalcUnreadedContact(Connection &conn, int64_t clientId)
 {
-    db::query count_query(conn);
-    count_query.prepare("select subscriber_id, count(id) from messages where status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and author_id <> ? and conference_tag is null group by subscriber_id");
-    count_query.set(0, GetMyClientId());
-    while (count_query.step())
+    auto count_query = conn.Prepare("select count from unreaded_contacts where subscriber_id = ?");
+    count_query->set(0, clientId);
+    if (count_query->step())
     {
-        if (count_query.get_int64(0) == clientId)
-        {
-            return count_query.get_int32(1);
-        }
+        return count_query->get_int32(0);
     }
 
     return 0;
 }
 
-int32_t Storage::CalcUnreadedConference(db::connection &conn, std::string_view tag)
+int32_t Storage::CalcUnreadedConference(Connection &conn, std::string_view tag)
 {
-    if (GetMyClientId() == 0)
+    auto count_query = conn.Prepare("select count from unreaded_conferences where conference_tag = ?");
+    count_query->set(0, tag);
+    if (count_query->step())
     {
-        return 0;
-    }
-
-    db::query count_query(conn);
-    count_query.prepare("select conference_tag, count(id) from messages where status < " + std::to_string(static_cast<int32_t>(Proto::MessageStatus::Readed)) + " and subscriber_id is null and (author_id is null or author_id <> ?) group by conference_tag");
-    count_query.set(0, GetMyClientId());
-    while (count_query.step())
-    {
-        if (count_query.get_string(0) == tag)
-        {
-            return count_query.get_int32(1);
-        }
+        return count_query->get_int32(0);
     }
 
     return 0;
@@ -424,15 +722,18 @@ int32_t Storage::CalcUnreadedConference(db::connection &conn, std::string_view t
 
 size_t Storage::LoadMessages(int64_t start, int64_t subscriber, std::string_view conference, uint32_t limit)
 {
+	std::lock_guard<std::recursive_mutex> lock(messagesMutex);
+
 	messages.clear();
+	messagesChanges.Reset();
 
 	messagesStart = start;
-	messagesEnd = 0;
+	messagesEnd = HistoryCursor();
 	messageSubscriber = subscriber;
 	messagesConference = conference;
 	messagesLimit = limit;
 
-	return LoadMessages(start);
+	return LoadMessages(HistoryCursor{ start, 0 });
 }
 
 size_t Storage::LoadNextMessages(int32_t count)
@@ -442,174 +743,336 @@ size_t Storage::LoadNextMessages(int32_t count)
 	return LoadMessages(messagesEnd);
 }
 
-size_t Storage::LoadMessages(int64_t start)
+size_t Storage::LoadMessages(const HistoryCursor &from)
 {
     std::lock_guard<std::recursive_mutex> lock(messagesMutex);
 
-	db::connection conn(db::dbms::SQLite, dbPath);
-
-	std::string predicat;
+	auto page = LoadHistoryPage(messageSubscriber, messagesConference, from, HistoryDirection::Older, messagesLimit);
 
-	if (start != 0)
+	messages.insert(messages.end(), page->messages.begin(), page->messages.end());
+	if (!page->messages.empty())
 	{
-		predicat = " where dt < " + std::to_string(start);
+		messagesEnd = page->oldest;
 	}
 
-	if (messageSubscriber != 0)
+	for (auto &message : page->messages)
 	{
-		if (predicat.empty()) predicat += " where"; else predicat += " and";
+		messagesChanges.Insert(message.guid, message);
+	}
+	if (messagesChanges.Commit()) WakeNotifier();
+
+	return page->messages.size();
+}
+
+/// Columns of the history queries, the names are resolved by the joins instead of the query per message
+static const char *HISTORY_COLUMNS = "m.id, m.guid, m.dt, m.type, m.author_id, a.name, m.sender_id, s.name, m.subscriber_id, r.name, m.conference_tag, c.name, "
+	"m.status, m.text_value, m.call_duration, m.call_result, m.data_preview, m.data_url";
+static const char *HISTORY_JOINS = "left join users a on a.id = m.author_id left join users s on s.id = m.sender_id left join users r on r.id = m.subscriber_id "
+	"left join conferences c on c.tag = m.conference_tag";
+
+Proto::Message ReadHistoryMessage(db::query &query)
+{
+	return Proto::Message(query.get_string(1),
+		query.get_int64(2),
+		static_cast<Proto::MessageType>(query.get_int32(3)),
+		query.get_int64(4), query.get_string(5),
+		query.get_int64(6), query.get_string(7),
+		query.get_int64(8), query.get_string(9),
+		query.get_string(10), query.get_string(11),
+		static_cast<Proto::MessageStatus>(query.get_int32(12)),
+		query.get_string(13),
+		query.get_int32(14), static_cast<Proto::CallResult>(query.get_int32(15)),
+		query.get_string(16), query.get_string(17),
+		"");
+}
+
+MessagesPagePtr Storage::LoadHistoryPage(int64_t subscriber, std::string_view conference, const HistoryCursor &from, HistoryDirection direction, uint32_t limit)
+{
+	auto page = std::make_shared<MessagesPage>();
 
-		predicat += " subscriber_id = " + std::to_string(messageSubscriber);
+	std::string sql = std::string("select ") + HISTORY_COLUMNS + " from messages m " + HISTORY_JOINS;
+	SQLParams params;
 
+	std::string predicat;
+	if (subscriber != 0)
+	{
+		predicat = " where m.subscriber_id = ?";
+		params.emplace_back(subscriber);
+	}
+	else if (!conference.empty())
+	{
+		predicat = " where m.conference_tag = ?";
+		params.emplace_back(std::string(conference));
 	}
-	else if (!messagesConference.empty())
+
+	const bool older = direction == HistoryDirection::Older;
+
+	if (from.dt != 0)
 	{
 		if (predicat.empty()) predicat += " where"; else predicat += " and";
 
-		predicat += " conference_tag = '" + messagesConference + "'";
+		predicat += older ? " (m.dt, m.id) < (?, ?)" : " (m.dt, m.id) > (?, ?)";
+		params.emplace_back(from.dt);
+		params.emplace_back(from.id);
 	}
-	
-	predicat += " order by dt desc";
 
-	if (messagesLimit != 0)
+	sql += predicat;
+	sql += older ? " order by m.dt desc, m.id desc" : " order by m.dt, m.id";
+
+	if (limit != 0)
 	{
-		predicat += " limit 0," + std::to_string(messagesLimit);
+		sql += " limit ?";
+		params.emplace_back(static_cast<int64_t>(limit) + 1); /// One more to know there are the next messages
 	}
 
-	db::query user_name_query(conn);
-	user_name_query.prepare("select name from users where id = ?");
+	auto &conn = GetConnection();
 
-	db::query conferences_query(conn);
-	conferences_query.prepare("select name from conferences where tag = ?");
+	auto messages_query = conn.Prepare(sql);
+	BindSQLParams(*messages_query, params);
 
-	size_t count = 0;
-
-	db::query messages_query(conn);
-	messages_query.prepare("select guid, dt, type, author_id, sender_id, subscriber_id, conference_tag, text_value, call_duration, call_result, data_preview, data_url, status from messages" + predicat);
-	while (messages_query.step())
+	std::vector<HistoryCursor> cursors;
+	while (messages_query->step())
 	{
-		std::string authorName, senderName, subscriberName;
-		user_name_query.set(0, messages_query.get_int64(3));
-		if (user_name_query.step())
-		{
-			authorName = user_name_query.get_string(0);
-		}
-		user_name_query.reset();
-		user_name_query.set(0, messages_query.get_int64(4));
-		if (user_name_query.step())
+		if (limit != 0 && page->messages.size() == limit)
 		{
-			senderName = user_name_query.get_string(0);
-		}
-		user_name_query.reset();
-		user_name_query.set(0, messages_query.get_int64(5));
-		if (user_name_query.step())
-		{
-			subscriberName = user_name_query.get_string(0);
-		}
-		user_name_query.reset();
-
-		std::string conferenceName;
-		conferences_query.set(0, messages_query.get_string(6));
-		if (conferences_query.step())
-		{
-			conferenceName = conferences_query.get_string(0);
+			page->more = true;
+			break;
 		}
-		conferences_query.reset();
 
-		messages.emplace_back(Proto::Message(messages_query.get_string(0),
-			messages_query.get_int32(1),
-			static_cast<Proto::MessageType>(messages_query.get_int32(2)),
-			messages_query.get_int64(3),	authorName,
-			messages_query.get_int64(4),	senderName,
-			messages_query.get_int64(5),	subscriberName,
-			messages_query.get_string(6), conferenceName,
-			static_cast<Proto::MessageStatus>(messages_query.get_int32(12)),
-			messages_query.get_string(7),
-			messages_query.get_int32(8), static_cast<Proto::CallResult>(messages_query.get_int32(9)),
-			messages_query.get_string(10), messages_query.get_string(11),
-			"" ));
+		page->messages.emplace_back(ReadHistoryMessage(*messages_query));
+		cursors.push_back(HistoryCursor{ messages_query->get_int64(2), messages_query->get_int64(0) });
+	}
 
-		messagesEnd = messages_query.get_int32(1);
+	if (!older)
+	{
+		std::reverse(page->messages.begin(), page->messages.end());
+		std::reverse(cursors.begin(), cursors.end());
+	}
 
-		++count;
+	if (!cursors.empty())
+	{
+		page->newest = cursors.front();
+		page->oldest = cursors.back();
+	}
+	else
+	{
+		page->newest = page->oldest = from;
 	}
 
-	return count;
+	return page;
 }
 
 Messages Storage::GetUndeliveredMessages()
 {
 	Messages outMessages;
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
+
+	auto messages_query = conn.Prepare(std::string("select ") + HISTORY_COLUMNS + " from messages m " + HISTORY_JOINS + " where m.sender_id = ? and m.type = 1 and m.status < 2");
+	messages_query->set(0, GetMyClientId());
+	while (messages_query->step())
+	{
+		outMessages.emplace_back(ReadHistoryMessage(*messages_query));
+	}
 
-	db::query user_name_query(conn);
-	user_name_query.prepare("select name from users where id = ?");
+	return outMessages;
+}
 
-	db::query conferences_query(conn);
-	conferences_query.prepare("select name from conferences where tag = ?");
+/// Each word of the user's input becomes a quoted FTS5 string, so the operators and the quotes of the input are not the syntax
+std::string MakeMatchExpression(std::string_view input)
+{
+	std::string out, word;
 
-	db::query messages_query(conn);
-	messages_query.prepare("select guid, dt, type, author_id, sender_id, subscriber_id, conference_tag, text_value, call_duration, call_result, data_preview, data_url, status from messages where sender_id = ? and type = 1 and status < 2");
-	messages_query.set(0, GetMyClientId());
-	while (messages_query.step())
+	auto addWord = [&out, &word]()
 	{
-		std::string authorName, senderName, subscriberName;
-		user_name_query.set(0, messages_query.get_int32(3));
-		if (user_name_query.step())
+		if (!word.empty())
 		{
-			authorName = user_name_query.get_string(0);
+			out += "\"" + word + "\" ";
+			word.clear();
 		}
-		user_name_query.reset();
-		user_name_query.set(0, messages_query.get_int32(4));
-		if (user_name_query.step())
+	};
+
+	for (auto c : input)
+	{
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
 		{
-			senderName = user_name_query.get_string(0);
+			addWord();
 		}
-		user_name_query.reset();
-		user_name_query.set(0, messages_query.get_int32(5));
-		if (user_name_query.step())
+		else if (c == '"')
 		{
-			subscriberName = user_name_query.get_string(0);
+			word += "\"\"";
 		}
-		user_name_query.reset();
+		else
+		{
+			word += c;
+		}
+	}
+	addWord();
+
+	if (!out.empty())
+	{
+		out.back() = '*'; /// The last word is being typed
+	}
 
-		std::string conferenceName;
-		conferences_query.set(0, messages_query.get_string(6));
-		if (conferences_query.step())
+	return out;
+}
+
+SearchPage Storage::SearchMessages(std::string_view input, const SearchScope &scope, uint32_t limit, const SearchCursor &cursor)
+{
+	SearchPage page;
+	page.next = cursor;
+
+	auto match = MakeMatchExpression(input);
+	if (match.empty())
+	{
+		return page;
+	}
+
+	std::string sql = std::string("select ") + HISTORY_COLUMNS + ", snippet(messages_fts, 0, '<b>', '</b>', '...', 16), messages_fts.rank "
+		"from messages_fts join messages m on m.id = messages_fts.rowid " + HISTORY_JOINS + " where messages_fts match ?";
+	SQLParams params;
+	params.emplace_back(match);
+
+	if (scope.subscriber != 0)
+	{
+		sql += " and m.subscriber_id = ?";
+		params.emplace_back(scope.subscriber);
+	}
+	else if (!scope.conference.empty())
+	{
+		sql += " and m.conference_tag = ?";
+		params.emplace_back(scope.conference);
+	}
+
+	if (cursor.id != 0)
+	{
+		sql += " and (messages_fts.rank, m.id) > (?, ?)";
+		params.emplace_back(cursor.rank);
+		params.emplace_back(cursor.id);
+	}
+
+	sql += " order by messages_fts.rank, m.id";
+
+	if (limit != 0)
+	{
+		sql += " limit ?";
+		params.emplace_back(static_cast<int64_t>(limit) + 1);
+	}
+
+	auto &conn = GetConnection();
+
+	auto search_query = conn.Prepare(sql);
+	BindSQLParams(*search_query, params);
+	while (search_query->step())
+	{
+		if (limit != 0 && page.results.size() == limit)
 		{
-			conferenceName = conferences_query.get_string(0);
+			page.more = true;
+			break;
 		}
-		conferences_query.reset();
-
-		outMessages.emplace_back(Proto::Message(messages_query.get_string(0),
-			messages_query.get_int32(1),
-			static_cast<Proto::MessageType>(messages_query.get_int32(2)),
-			messages_query.get_int32(3), authorName,
-			messages_query.get_int32(4), senderName,
-			messages_query.get_int32(5), subscriberName,
-			messages_query.get_string(6), conferenceName,
-			static_cast<Proto::MessageStatus>(messages_query.get_int32(12)),
-			messages_query.get_string(7),
-			messages_query.get_int32(8), static_cast<Proto::CallResult>(messages_query.get_int32(9)),
-			messages_query.get_string(10), messages_query.get_string(11),
-			""));
+
+		auto rank = search_query->get_double(19);
+		page.results.emplace_back(SearchResult{ ReadHistoryMessage(*search_query), search_query->get_string(18), rank });
+		page.next = SearchCursor{ rank, search_query->get_int64(0) };
 	}
 
-	return outMessages;
+	return page;
+}
+
+static const int64_t SEARCH_INDEX_CHUNK = 2000;
+
+void Storage::StartSearchIndexer()
+{
+	searchIndexerRunned = true;
+	searchIndexer = std::thread(&Storage::IndexOldMessages, this);
+}
+
+void Storage::StopSearchIndexer()
+{
+	searchIndexerRunned = false;
+	if (searchIndexer.joinable()) searchIndexer.join();
+}
+
+void Storage::IndexOldMessages()
+{
+	{
+		auto &conn = GetConnection();
+
+		/// The messages are indexed from the newest, the progress is stored, so the restart continues the work
+		while (searchIndexerRunned)
+		{
+			int64_t upper = 0;
+			{
+				auto progress_query = conn.Prepare("select cast(value as integer) from settings where key = 'search_index_id'");
+				if (!progress_query->step())
+				{
+					break;
+				}
+				upper = progress_query->get_int64(0);
+			}
+
+			int64_t lower = 0;
+			{
+				auto chunk_query = conn.Prepare("select min(id) from (select id from messages where id < ? order by id desc limit ?)");
+				chunk_query->set(0, upper);
+				chunk_query->set(1, SEARCH_INDEX_CHUNK);
+				if (chunk_query->step() && !chunk_query->get_null(0))
+				{
+					lower = chunk_query->get_int64(0);
+				}
+			}
+
+			db::transaction writeTr(conn.Get());
+			writeTr.start();
+
+			if (lower != 0)
+			{
+				/// The triggers could already index the rows were changed after the migration
+				auto index_query = conn.Prepare("insert into messages_fts (rowid, text_value) select id, text_value from messages m "
+					"where id >= ? and id < ? and text_value is not null and not exists (select 1 from messages_fts where rowid = m.id)");
+				index_query->set(0, lower);
+				index_query->set(1, upper);
+				index_query->step();
+
+				auto progress_query = conn.Prepare("update settings set value = ? where key = 'search_index_id'");
+				progress_query->set(0, lower);
+				progress_query->step();
+			}
+			else
+			{
+				conn.Prepare("delete from settings where key = 'search_index_id'")->step();
+			}
+
+			writeTr.commit();
+
+			if (lower == 0)
+			{
+				auto sysLog = spdlog::get("System");
+				if (sysLog)
+				{
+					sysLog->info("Storage :: Search index of the old messages is completed");
+				}
+				break;
+			}
+
+			/// Let the other threads to write between the chunks
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	ReleaseConnection();
 }
 
 uint64_t Storage::GetLastMessageDT()
 {
 	uint64_t out = 0;
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::query query(conn);
-	query.prepare("select max(dt) from messages where type = 1 and status > 1");
-	if (query.step())
+	auto query = conn.Prepare("select max(dt) from messages where type = 1 and status > 1");
+	if (query->step())
 	{
-		out = query.get_int64(0);
+		out = query->get_int64(0);
 	}
     return out;
 }
@@ -646,6 +1109,22 @@ void Storage::UnsubscribeMessagesReceiver(std::string_view subscriberId)
     }
 }
 
+std::string Storage::SubscribeMessagesChanges(std::function<void(const MessagesChanges &changes)> receiver)
+{
+	return messagesChanges.Subscribe(receiver);
+}
+
+void Storage::UnsubscribeMessagesChanges(std::string_view subscriberId)
+{
+	messagesChanges.Unsubscribe(subscriberId);
+}
+
+Snapshot<Proto::Message> Storage::GetMessagesSnapshot()
+{
+	std::lock_guard<std::recursive_mutex> lock(messagesMutex);
+	return messagesChanges.MakeSnapshot(messages);
+}
+
 /// Contacts
 
 void Storage::UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNumbers_, const Contacts &contacts_)
@@ -653,96 +1132,77 @@ void Storage::UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNu
     contactSortType = sortType;
     showNumbers = showNumbers_ ? 1 : 0;
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	Common::TimeMeter timeMeter;
 
-	db::query exists_query(conn);
-	exists_query.prepare("select id from users where id = ?");
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 	
-    db::query upd_sort_query(conn);
-    upd_sort_query.prepare("update settings set value = ? where key = ?");
+    auto upd_sort_query = conn.Prepare("update settings set value = ? where key = ?");
     
-    upd_sort_query.set(0, sortType == Proto::CONTACT_LIST::SortType::Name ? "0" : "1");
-    upd_sort_query.set(1, "users_sort_type");
-    upd_sort_query.step();
-    upd_sort_query.reset();
-
-    upd_sort_query.set(0, showNumbers_ ? "1" : "0");
-    upd_sort_query.set(1, "show_number_on_contact_list");
-    upd_sort_query.step();
-    upd_sort_query.reset();
-
-	std::lock_guard<std::recursive_mutex> lock(contactsMutex);
+    upd_sort_query->set(0, sortType == Proto::CONTACT_LIST::SortType::Name ? "0" : "1");
+    upd_sort_query->set(1, "users_sort_type");
+    upd_sort_query->step();
+    upd_sort_query->reset();
+
+    upd_sort_query->set(0, showNumbers_ ? "1" : "0");
+    upd_sort_query->set(1, "show_number_on_contact_list");
+    upd_sort_query->step();
+    upd_sort_query->reset();
+
+	SQLParams ids, links, params;
+	size_t deleted = 0;
 	for (auto &contact : contacts_)
 	{
-		bool exists = false;
-		exists_query.set(0, contact.id);
-		if (exists_query.step())
+		AddSQLParam(ids, contact.id);
+		AddSQLParam(ids, contact.deleted);
+
+		for (auto &g : contact.groups)
 		{
-			exists = true;
+			AddSQLParam(links, contact.id);
+			AddSQLParam(links, g.id);
+			AddSQLParam(links, 0);
 		}
-		exists_query.reset();
-
-		std::string sqlFields, sqlValues;
 
-		if (!contact.deleted)
+		if (contact.deleted)
 		{
-			AddSQLValue("id", contact.id, sqlFields, sqlValues, exists);
-			AddSQLValue("login", contact.login, sqlFields, sqlValues, exists);
-			AddSQLValue("name", contact.name, sqlFields, sqlValues, exists);
-			AddSQLValue("number", contact.number, sqlFields, sqlValues, exists);
-			AddSQLValue("state", static_cast<int32_t>(contact.state), sqlFields, sqlValues, exists);
+			++deleted;
+			continue;
 		}
-		AddSQLValue("deleted", contact.deleted, sqlFields, sqlValues, exists);
 
-		if (!sqlFields.empty()) sqlFields.pop_back(); // drop last ","
-		if (!sqlValues.empty()) sqlValues.pop_back(); // drop last ","
+		AddSQLParam(params, contact.id);
+		AddSQLParam(params, contact.login);
+		AddSQLParam(params, contact.name);
+		AddSQLParam(params, contact.number);
+		AddSQLParam(params, static_cast<int32_t>(contact.state));
+	}
 
-		db::query contact_query(conn);
-		contact_query.prepare(!exists ? "insert into users (" + sqlFields + ") values (" + sqlValues + ")" : "update users set " + sqlValues + " where id='" + std::to_string(contact.id) + "'");
-		contact_query.step();
-		contact_query.reset();
+	FillSyncTables(conn, ids, links);
 
-		std::string groupIds = "in ( ";
-		for (auto &g : contact.groups)
-		{
-			groupIds += std::to_string(g.id) + ",";
-		}
-		groupIds.pop_back();
-		groupIds += ")";
+	conn.Prepare("update users set deleted = 1 where id in (select id from temp.sync_ids where deleted is not null)")->step();
 
-		db::query contact_groups_clear_query(conn);
-		contact_groups_clear_query.prepare("delete from client_groups where client_id = ? and group_id not " + groupIds);
-		contact_groups_clear_query.set(0, contact.id);
-		contact_groups_clear_query.step();
+	ExecuteBatches(conn,
+		"insert into users (id, login, name, number, state)",
+		"on conflict(id) do update set login = excluded.login, name = excluded.name, number = excluded.number, state = excluded.state, deleted = null",
+		5, params);
 
-		db::query exists_group_query(conn);
-		exists_group_query.prepare("select id from client_groups where client_id = ? and group_id = ?");
-
-		db::query contact_groups_query(conn);
-		contact_groups_query.prepare("insert into client_groups (client_id, group_id) values (?, ?)");
-		for (auto &g : contact.groups)
-		{
-			exists_group_query.set(0, contact.id);
-			exists_group_query.set(1, g.id);
-			if (!exists_group_query.step())
-			{
-				contact_groups_query.set(0, contact.id);
-				contact_groups_query.set(1, g.id);
-				contact_groups_query.step();
-				contact_groups_query.reset();
-			}
-			exists_group_query.reset();				
-		}
+	/// The groups of the synchronized contacts become exactly the received ones
+	conn.Prepare("delete from client_groups where client_id in (select id from temp.sync_ids) and "
+		"not exists (select 1 from temp.sync_links l where l.owner_id = client_groups.client_id and l.item_id = client_groups.group_id)")->step();
+	conn.Prepare("insert into client_groups (client_id, group_id) select distinct owner_id, item_id from temp.sync_links l where "
+		"not exists (select 1 from client_groups c where c.client_id = l.owner_id and c.group_id = l.item_id)")->step();
 
+	std::lock_guard<std::recursive_mutex> lock(contactsMutex);
+	for (auto &contact : contacts_)
+	{
         auto it = std::find(contacts.begin(), contacts.end(), contact.id);
 		if (it != contacts.end())
 		{
 			if (contact.deleted)
 			{
 				contacts.erase(it);
+				contactsChanges.Remove(contact.id);
 			}
 			else
 			{
@@ -751,6 +1211,7 @@ void Storage::UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNu
                 *it = contact;
 
                 it->unreaded_count = unreaded;
+				contactsChanges.Update(contact.id, *it);
 			}
 		}
 		else
@@ -758,13 +1219,16 @@ void Storage::UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNu
 			if (!contact.deleted)
 			{
                 contacts.emplace_back(contact);
+				contactsChanges.Insert(contact.id, contact);
 			}
 		}
 	}
 
 	writeTr.commit();
 
-    UpdateUnreadedContacts();
+	ReportSync("UpdateContacts", contacts_.size(), deleted, timeMeter);
+
+    UpdateUnreadedContacts(); /// Commits the changes too
     SortContacts();
 
     for (auto receiver : contactsReceivers)
@@ -775,20 +1239,18 @@ void Storage::UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNu
 
 void Storage::DeleteContact(int64_t clientId)
 {
-    db::connection conn(db::dbms::SQLite, dbPath);
+    auto &conn = GetConnection();
 
-    db::transaction writeTr(conn);
+    db::transaction writeTr(conn.Get());
     writeTr.start();
 
-    db::query contact_query(conn);
-    contact_query.prepare("update users set deleted = 1 where id = ?");
-    contact_query.set(0, clientId);
-    contact_query.step();
+    auto contact_query = conn.Prepare("update users set deleted = 1 where id = ?");
+    contact_query->set(0, clientId);
+    contact_query->step();
 
-    db::query groups_query(conn);
-    groups_query.prepare("delete from client_groups where client_id = ?");
-    groups_query.set(0, clientId);
-    groups_query.step();
+    auto groups_query = conn.Prepare("delete from client_groups where client_id = ?");
+    groups_query->set(0, clientId);
+    groups_query->step();
 
     writeTr.commit();
 
@@ -798,6 +1260,9 @@ void Storage::DeleteContact(int64_t clientId)
         if (it != contacts.end())
         {
             contacts.erase(it);
+
+            contactsChanges.Remove(clientId);
+            if (contactsChanges.Commit()) WakeNotifier();
         }
     }
 
@@ -809,32 +1274,34 @@ void Storage::DeleteContact(int64_t clientId)
 
 void Storage::ClearContacts()
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 
-	db::query del_query(conn);
-	del_query.prepare("delete from users");
-	del_query.step();
+	auto del_query = conn.Prepare("delete from users");
+	del_query->step();
 
 	writeTr.commit();
 
+	std::lock_guard<std::recursive_mutex> lock(contactsMutex);
 	contacts.clear();
+
+	contactsChanges.Reset();
+	if (contactsChanges.Commit()) WakeNotifier();
 }
 
 void Storage::ChangeContactState(int64_t clientId, Proto::MemberState state)
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 
-	db::query contact_query(conn);
-	contact_query.prepare("update users set state = ? where id = ?");
-	contact_query.set(0, static_cast<int32_t>(state));
-	contact_query.set(1, static_cast<int32_t>(clientId));
-	contact_query.step();
+	auto contact_query = conn.Prepare("update users set state = ? where id = ?");
+	contact_query->set(0, static_cast<int32_t>(state));
+	contact_query->set(1, static_cast<int32_t>(clientId));
+	contact_query->step();
 
 	writeTr.commit();
 
@@ -845,6 +1312,9 @@ void Storage::ChangeContactState(int64_t clientId, Proto::MemberState state)
 	{
 		it->state = state;
 		changedContact = *it;
+
+		contactsChanges.Update(clientId, *it);
+		if (contactsChanges.Commit()) WakeNotifier();
 	}
 
 	if (changedContact.id != 0)
@@ -863,13 +1333,12 @@ Proto::CONTACT_LIST::SortType Storage::GetContactSortType()
         return contactSortType;
     }
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::query get_sort_query(conn);
-	get_sort_query.prepare("select value from settings where key='users_sort_type'");
-	if (get_sort_query.step())
+	auto get_sort_query = conn.Prepare("select value from settings where key='users_sort_type'");
+	if (get_sort_query->step())
 	{
-        contactSortType = get_sort_query.get_string(0) != "0" ? Proto::CONTACT_LIST::SortType::Number : Proto::CONTACT_LIST::SortType::Name;
+        contactSortType = get_sort_query->get_string(0) != "0" ? Proto::CONTACT_LIST::SortType::Number : Proto::CONTACT_LIST::SortType::Name;
 	}
 
 	return contactSortType;
@@ -882,13 +1351,12 @@ int64_t Storage::GetMyClientId()
         return myClientId;
     }
     
-    db::connection conn(db::dbms::SQLite, dbPath);
+    auto &conn = GetConnection();
 
-    db::query get_my_client_id_query(conn);
-    get_my_client_id_query.prepare("select value from settings where key='my_client_id'");
-    if (get_my_client_id_query.step())
+    auto get_my_client_id_query = conn.Prepare("select value from settings where key='my_client_id'");
+    if (get_my_client_id_query->step())
     {
-        return get_my_client_id_query.get_int64(0);
+        return get_my_client_id_query->get_int64(0);
     }
     return 0;
 }
@@ -929,34 +1397,32 @@ void Storage::LoadContacts()
 
 	contacts.clear();
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
     std::vector<int64_t> availGroups;
-    db::query avail_groups_query(conn);
-    avail_groups_query.prepare("select id from groups");
-    while (avail_groups_query.step())
     {
-        availGroups.emplace_back(avail_groups_query.get_int64(0));
+        auto avail_groups_query = conn.Prepare("select id from groups");
+        while (avail_groups_query->step())
+        {
+            availGroups.emplace_back(avail_groups_query->get_int64(0));
+        }
     }
-    avail_groups_query.close();
 
-	db::query contact_groups_query(conn);
-	contact_groups_query.prepare("select group_id from client_groups where client_id = ?");
+	auto contact_groups_query = conn.Prepare("select group_id from client_groups where client_id = ?");
 
-	db::query contacts_query(conn);
-	contacts_query.prepare("select id, state, login, name, number from users where deleted is null order by " + std::string(GetContactSortType() == Proto::CONTACT_LIST::SortType::Name ? "name" : "cast(number as integer)"));
-	while (contacts_query.step())
+	auto contacts_query = conn.Prepare("select id, state, login, name, number from users where deleted is null order by " + std::string(GetContactSortType() == Proto::CONTACT_LIST::SortType::Name ? "name" : "cast(number as integer)"));
+	while (contacts_query->step())
 	{
         bool contactAvail = false;
 
-        auto contactId = contacts_query.get_int64(0);
+        auto contactId = contacts_query->get_int64(0);
 
 		std::vector<Proto::Group> groups_;
 
-		contact_groups_query.set(0, contactId);
-		while (contact_groups_query.step())
+		contact_groups_query->set(0, contactId);
+		while (contact_groups_query->step())
 		{
-            auto groupId = contact_groups_query.get_int64(0);
+            auto groupId = contact_groups_query->get_int64(0);
 			groups_.emplace_back(Proto::Group(groupId));
 
             if (!contactAvail)
@@ -964,19 +1430,19 @@ void Storage::LoadContacts()
                 contactAvail = std::find(availGroups.begin(), availGroups.end(), groupId) != availGroups.end();
             }
 		}
-		contact_groups_query.reset();
+		contact_groups_query->reset();
 
         if (contactAvail)
         {
             auto member = Proto::Member(
                 contactId,
-                static_cast<Proto::MemberState>(contacts_query.get_int32(1)),
-                contacts_query.get_string(2),
-                contacts_query.get_string(3),
-                contacts_query.get_string(4),
+                static_cast<Proto::MemberState>(contacts_query->get_int32(1)),
+                contacts_query->get_string(2),
+                contacts_query->get_string(3),
+                contacts_query->get_string(4),
                 groups_);
 
-            member.unreaded_count = CalcUnreadedContact(conn, contacts_query.get_int64(0));
+            member.unreaded_count = CalcUnreadedContact(conn, contacts_query->get_int64(0));
 
             contacts.emplace_back(member);
         }
@@ -1002,13 +1468,12 @@ bool Storage::GetShowNumbers()
         return showNumbers != 0;
     }
 
-    db::connection conn(db::dbms::SQLite, dbPath);
+    auto &conn = GetConnection();
 
-    db::query get_query(conn);
-    get_query.prepare("select value from settings where key='show_number_on_contact_list'");
-    if (get_query.step())
+    auto get_query = conn.Prepare("select value from settings where key='show_number_on_contact_list'");
+    if (get_query->step())
     {
-        showNumbers = get_query.get_string(0) == "0" ? 0 : 1;
+        showNumbers = get_query->get_string(0) == "0" ? 0 : 1;
     }
 
     return showNumbers != 0;
@@ -1036,38 +1501,52 @@ void Storage::UnsubscribeContactsReceiver(std::string_view subscriberId)
     }
 }
 
+std::string Storage::SubscribeContactsChanges(std::function<void(const ContactsChanges &changes)> receiver)
+{
+	return contactsChanges.Subscribe(receiver);
+}
+
+void Storage::UnsubscribeContactsChanges(std::string_view subscriberId)
+{
+	contactsChanges.Unsubscribe(subscriberId);
+}
+
+Snapshot<Proto::Member> Storage::GetContactsSnapshot()
+{
+	std::lock_guard<std::recursive_mutex> lock(contactsMutex);
+	return contactsChanges.MakeSnapshot(contacts);
+}
+
 /// Groups
 
-void GetChildGroups(db::connection &conn, int64_t parentID, int32_t level, std::vector<Proto::Group> &out)
+void GetChildGroups(Connection &conn, int64_t parentID, int32_t level, std::vector<Proto::Group> &out)
 {
-	db::query rolled_query(conn);
-	rolled_query.prepare("select id from group_rolled where id = ?");
+	auto rolled_query = conn.Prepare("select id from group_rolled where id = ?");
 
-	db::query groups_query(conn);
-	groups_query.prepare("select id, parent_id, tag, name, owner_id, password, grants from groups where deleted is null and parent_id = ? order by name");
-	groups_query.set(0, parentID);
+	auto groups_query = conn.Prepare("select id, parent_id, tag, name, owner_id, password, grants from groups where deleted is null and parent_id = ? order by name");
+	groups_query->set(0, parentID);
 
 	++level;
 
-	while (groups_query.step())
+	while (groups_query->step())
 	{
 		Proto::Group group(
-			groups_query.get_int64(0),
-			groups_query.get_int64(1),
-			groups_query.get_string(2),
-			groups_query.get_string(3),
-			groups_query.get_int64(4),
-			groups_query.get_string(5),
-			groups_query.get_int32(6),
+			groups_query->get_int64(0),
+			groups_query->get_int64(1),
+			groups_query->get_string(2),
+			groups_query->get_string(3),
+			groups_query->get_int64(4),
+			groups_query->get_string(5),
+			groups_query->get_int32(6),
 			level
 		);
 
-		rolled_query.set(0, group.id);
-		if (rolled_query.step())
+		rolled_query->set(0, group.id);
+		if (rolled_query->step())
 		{
 			group.rolled = true;
 		}
-		rolled_query.reset();
+		rolled_query->reset();
 
 		out.emplace_back(group);
 
@@ -1075,7 +1554,7 @@ void GetChildGroups(db::connection &conn, int64_t parentID, int32_t level, std::
 	}
 }
 
-std::string GetChildGroupsSQL(db::connection &conn, int64_t group_id)
+std::string GetChildGroupsSQL(Connection &conn, int64_t group_id)
 {
 	std::string groupsSQL = " in(" + std::to_string(group_id) + ",";
 
@@ -1094,46 +1573,74 @@ std::string GetChildGroupsSQL(db::connection &conn, int64_t group_id)
 
 void Storage::UpdateGroups(const Groups &groups_)
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	Common::TimeMeter timeMeter;
 
-	db::query exists_query(conn);
-	exists_query.prepare("select id from groups where id = ?");
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 
-	std::lock_guard<std::recursive_mutex> lock(groupsMutex);
+	SQLParams ids, params;
+	size_t deleted = 0;
 	for (auto &group : groups_)
 	{
-		exists_query.set(0, group.id);
-		bool exists = exists_query.step();
-		exists_query.reset();
-
-		std::string sqlFields, sqlValues;
-
-        if (!group.deleted)
+		if (group.deleted)
 		{
-			AddSQLValue("id", group.id, sqlFields, sqlValues, exists);
-			AddSQLValue("parent_id", group.parent_id, sqlFields, sqlValues, exists, false);
-			AddSQLValue("tag", group.tag, sqlFields, sqlValues, exists);
-			AddSQLValue("name", group.name, sqlFields, sqlValues, exists);
-			AddSQLValue("owner_id", group.owner_id, sqlFields, sqlValues, exists);
-			AddSQLValue("password", group.password, sqlFields, sqlValues, exists);
-			AddSQLValue("grants", group.grants, sqlFields, sqlValues, exists);
+			AddSQLParam(ids, group.id);
+			AddSQLParam(ids, group.deleted);
+			++deleted;
+			continue;
 		}
-		AddSQLValue("deleted", group.deleted, sqlFields, sqlValues, exists);
-			
-		if (!sqlFields.empty()) sqlFields.pop_back(); // drop last ","
-		if (!sqlValues.empty()) sqlValues.pop_back(); // drop last ","
 
-		db::query group_query(conn);
-		group_query.prepare(!exists ? "insert into groups (" + sqlFields + ") values (" + sqlValues + ")" : "update groups set " + sqlValues + " where id='" + std::to_string(group.id) + "'");
-		group_query.step();
-		group_query.reset();
+		AddSQLParam(params, group.id);
+		AddSQLParam(params, group.parent_id, false);
+		AddSQLParam(params, group.tag);
+		AddSQLParam(params, group.name);
+		AddSQLParam(params, group.owner_id);
+		AddSQLParam(params, group.password);
+		AddSQLParam(params, group.grants);
 	}
 
+	FillSyncTables(conn, ids, {});
+
+	conn.Prepare("update groups set deleted = 1 where id in (select id from temp.sync_ids)")->step();
+
+	ExecuteBatches(conn,
+		"insert into groups (id, parent_id, tag, name, owner_id, password, grants)",
+		"on conflict(id) do update set parent_id = excluded.parent_id, tag = excluded.tag, name = excluded.name, owner_id = excluded.owner_id, "
+		"password = excluded.password, grants = excluded.grants, deleted = null",
+		7, params);
+
     writeTr.commit();
+
+	ReportSync("UpdateGroups", groups_.size(), deleted, timeMeter);
+
+	std::lock_guard<std::recursive_mutex> lock(groupsMutex);
+
+	std::vector<int64_t> stored;
+	for (auto &g : groups)
+	{
+		stored.emplace_back(g.id);
+	}
+	std::sort(stored.begin(), stored.end());
+
     LoadGroups();
+
+	/// The levels and the rolled flags come from the reloaded tree
+	for (auto &group : groups_)
+	{
+		auto wasStored = std::binary_search(stored.begin(), stored.end(), group.id);
+		auto it = std::find_if(groups.begin(), groups.end(), [&group](const Proto::Group &g) { return g.id == group.id; });
+		if (it != groups.end())
+		{
+			if (wasStored) groupsChanges.Update(group.id, *it); else groupsChanges.Insert(group.id, *it);
+		}
+		else if (wasStored)
+		{
+			groupsChanges.Remove(group.id);
+		}
+	}
+	if (groupsChanges.Commit()) WakeNotifier();
 	
     for (auto receiver : groupsReceivers)
     {
@@ -1143,18 +1650,21 @@ void Storage::UpdateGroups(const Groups &groups_)
 
 void Storage::ClearGroups()
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::transaction writeTr(conn);
+	db::transaction writeTr(conn.Get());
 	writeTr.start();
 
-	db::query del_query(conn);
-	del_query.prepare("delete from groups");
-	del_query.step();
+	auto del_query = conn.Prepare("delete from groups");
+	del_query->step();
 
 	writeTr.commit();
 
+	std::lock_guard<std::recursive_mutex> lock(groupsMutex);
 	groups.clear();
+
+	groupsChanges.Reset();
+	if (groupsChanges.Commit()) WakeNotifier();
 }
 
 void Storage::LoadGroups()
@@ -1163,7 +1673,7 @@ void Storage::LoadGroups()
 
 	groups.clear();
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
 	GetChildGroups(conn, 0, -1, groups);
 }
@@ -1209,14 +1719,13 @@ void Storage::ChangeGroupRolled(int64_t groupId)
 		{
 			group.rolled = !group.rolled;
 
-			db::connection conn(db::dbms::SQLite, dbPath);
-			db::transaction writeTr(conn);
+			auto &conn = GetConnection();
+			db::transaction writeTr(conn.Get());
 			writeTr.start();
 
-			db::query rolled_query(conn);
-			rolled_query.prepare(group.rolled ? "insert into group_rolled (id) values (?)" : "delete from group_rolled where id = ?");
-			rolled_query.set(0, group.id);
-			rolled_query.step();
+			auto rolled_query = conn.Prepare(group.rolled ? "insert into group_rolled (id) values (?)" : "delete from group_rolled where id = ?");
+			rolled_query->set(0, group.id);
+			rolled_query->step();
 			
 			writeTr.commit();
 
@@ -1247,46 +1756,86 @@ void Storage::UnsubscribeGroupsReceiver(std::string_view subscriberId)
     }
 }
 
+std::string Storage::SubscribeGroupsChanges(std::function<void(const GroupsChanges &changes)> receiver)
+{
+	return groupsChanges.Subscribe(receiver);
+}
+
+void Storage::UnsubscribeGroupsChanges(std::string_view subscriberId)
+{
+	groupsChanges.Unsubscribe(subscriberId);
+}
+
+Snapshot<Proto::Group> Storage::GetGroupsSnapshot()
+{
+	std::lock_guard<std::recursive_mutex> lock(groupsMutex);
+	return groupsChanges.MakeSnapshot(groups);
+}
+
 /// Conferences
 void Storage::UpdateConferences(const Conferences &conferences_)
 {
-	db::connection conn(db::dbms::SQLite, dbPath);
+	Common::TimeMeter timeMeter;
 
-	db::query exists_query(conn);
-	exists_query.prepare("select id from conferences where id = ?");
+	auto &conn = GetConnection();
 
-	db::query clear_members_query(conn);
-	clear_members_query.prepare("delete from conference_members where conference_id = ?");
+	db::transaction writeTr(conn.Get());
+	writeTr.start();
 
-	db::query insert_members_query(conn);
-	insert_members_query.prepare("insert into conference_members (conference_id, user_id, grants) values (?, ?, ?)");
+	SQLParams ids, links, params;
+	size_t deleted = 0;
+	for (auto &conference : conferences_)
+	{
+		AddSQLParam(ids, conference.id);
+		AddSQLParam(ids, conference.deleted);
 
-	db::transaction writeTr(conn);
-	writeTr.start();
+		for (auto &m : conference.members)
+		{
+			AddSQLParam(links, conference.id);
+			AddSQLParam(links, m.id);
+			AddSQLParam(links, static_cast<int32_t>(m.grants), false);
+		}
+
+		if (conference.deleted)
+		{
+			++deleted;
+			continue;
+		}
+
+		AddSQLParam(params, conference.id);
+		AddSQLParam(params, conference.tag);
+		AddSQLParam(params, conference.name);
+		AddSQLParam(params, conference.descr);
+		AddSQLParam(params, conference.founder_id);
+		AddSQLParam(params, static_cast<int32_t>(conference.type));
+		AddSQLParam(params, conference.grants);
+		AddSQLParam(params, conference.duration);
+		AddSQLParam(params, conference.connect_members);
+	}
+
+	FillSyncTables(conn, ids, links);
+
+	conn.Prepare("update conferences set deleted = 1 where id in (select id from temp.sync_ids where deleted is not null)")->step();
+
+	ExecuteBatches(conn,
+		"insert into conferences (id, tag, name, descr, founder_id, type, grants, duration, connect_members)",
+		"on conflict(id) do update set tag = excluded.tag, name = excluded.name, descr = excluded.descr, founder_id = excluded.founder_id, type = excluded.type, "
+		"grants = excluded.grants, duration = excluded.duration, connect_members = excluded.connect_members, deleted = null",
+		9, params);
+
+	/// The members of the synchronized conferences become exactly the received ones
+	conn.Prepare("delete from conference_members where conference_id in (select id from temp.sync_ids) and "
+		"not exists (select 1 from temp.sync_links l where l.owner_id = conference_members.conference_id and l.item_id = conference_members.user_id)")->step();
+	conn.Prepare("insert into conference_members (conference_id, user_id, grants) select owner_id, item_id, grants from temp.sync_links where true "
+		"on conflict(conference_id, user_id) do update set grants = excluded.grants")->step();
 
     std::vector<std::string> newConferences;
 
 	std::lock_guard<std::recursive_mutex> lock(conferencesMutex);
 	for (auto &conference : conferences_)
 	{
-		exists_query.set(0, conference.id);
-		bool exists = exists_query.step();
-		exists_query.reset();
-
-        std::string sqlFields, sqlValues;
-
         if (!conference.deleted)
 		{
-			AddSQLValue("id", conference.id, sqlFields, sqlValues, exists);
-			AddSQLValue("tag", conference.tag, sqlFields, sqlValues, exists);
-			AddSQLValue("name", conference.name, sqlFields, sqlValues, exists);
-			AddSQLValue("descr", conference.descr, sqlFields, sqlValues, exists);
-			AddSQLValue("founder_id", conference.founder_id, sqlFields, sqlValues, exists);
-			AddSQLValue("type", static_cast<int32_t>(conference.type), sqlFields, sqlValues, exists);
-			AddSQLValue("grants", conference.grants, sqlFields, sqlValues, exists);
-			AddSQLValue("duration", conference.duration, sqlFields, sqlValues, exists);
-			AddSQLValue("connect_members", conference.connect_members, sqlFields, sqlValues, exists);
-
             auto c = std::find(conferences.begin(), conferences.end(), conference.tag);
             if (c != conferences.end())
             {
@@ -1297,6 +1846,8 @@ void Storage::UpdateConferences(const Conferences &conferences_)
                 
                 c->rolled = rolled;
                 c->unreaded_count = unreaded;
+
+                conferencesChanges.Update(c->id, *c);
             }
             else
             {
@@ -1307,12 +1858,14 @@ void Storage::UpdateConferences(const Conferences &conferences_)
 					if (c != conferences.end())
 					{
 						conferences.erase(c);
+						conferencesChanges.Remove(conference.id);
 					}
 				}
 				else
 				{
 					conferences.emplace_back(conference);
 					newConferences.emplace_back(conference.tag);
+					conferencesChanges.Insert(conference.id, conference);
 				}
             }
 		}
@@ -1322,34 +1875,17 @@ void Storage::UpdateConferences(const Conferences &conferences_)
             if (c != conferences.end())
             {
                 conferences.erase(c);
+                conferencesChanges.Remove(conference.id);
             }
         }
-		AddSQLValue("deleted", conference.deleted, sqlFields, sqlValues, exists);
-
-		if (!sqlFields.empty()) sqlFields.pop_back(); // drop last ","
-		if (!sqlValues.empty()) sqlValues.pop_back(); // drop last ","
-
-		db::query conference_query(conn);
-		conference_query.prepare(!exists ? "insert into conferences (" + sqlFields + ") values (" + sqlValues + ")" : "update conferences set " + sqlValues + " where id='" + std::to_string(conference.id) + "'");
-		conference_query.step();
-		conference_query.reset();
-
-		clear_members_query.set(0, static_cast<int32_t>(conference.id));
-		clear_members_query.step();
-		clear_members_query.reset();
-
-		for (auto &m : conference.members)
-		{
-			insert_members_query.set(0, static_cast<int32_t>(conference.id));
-			insert_members_query.set(1, m.id);
-			insert_members_query.set(2, static_cast<int32_t>(m.grants));
-			insert_members_query.step();
-			insert_members_query.reset();
-		}
 	}
 
 	writeTr.commit();
 
+	if (conferencesChanges.Commit()) WakeNotifier();
+
+	ReportSync("UpdateConferences", conferences_.size(), deleted, timeMeter);
+
     for (auto receiver : conferencesReceivers)
     {
         receiver.second(conferences_);
@@ -1384,28 +1920,23 @@ void Storage::LoadConferences()
 
 	conferences.clear();
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::query members_query(conn);
-	members_query.prepare("select user_id, grants from conference_members where conference_id = ?");
+	auto members_query = conn.Prepare("select user_id, grants from conference_members where conference_id = ?");
 
-	db::query user_query(conn);
-	user_query.prepare("select state, login, name, number from users where id = ?");
+	auto user_query = conn.Prepare("select state, login, name, number from users where id = ?");
 
-	db::query contact_groups_query(conn);
-	contact_groups_query.prepare("select group_id from client_groups where client_id = ?");
+	auto contact_groups_query = conn.Prepare("select group_id from client_groups where client_id = ?");
 
-	db::query rolled_query(conn);
-	rolled_query.prepare("select id from conference_rolled where id = ?");
+	auto rolled_query = conn.Prepare("select id from conference_rolled where id = ?");
 
-	db::query conferences_query(conn);
-	conferences_query.prepare("select id, tag, name, descr, founder_id, type, grants, duration, connect_members from conferences where deleted is null order by name");
-	while (conferences_query.step())
+	auto conferences_query = conn.Prepare("select id, tag, name, descr, founder_id, type, grants, duration, connect_members from conferences where deleted is null order by name");
+	while (conferences_query->step())
 	{
-		auto conf_id = conferences_query.get_int32(0);
-		auto conf_tag = conferences_query.get_string(1);
-		auto founder_id = conferences_query.get_int64(4);
-		auto conf_grants = conferences_query.get_int32(6);
+		auto conf_id = conferences_query->get_int32(0);
+		auto conf_tag = conferences_query->get_string(1);
+		auto founder_id = conferences_query->get_int64(4);
+		auto conf_grants = conferences_query->get_int32(6);
 		
 		if (BitIsSet(conf_grants, static_cast<int32_t>(Proto::ConferenceGrants::Deactivated)) &&
 			founder_id != GetMyClientId())
@@ -1415,52 +1946,52 @@ void Storage::LoadConferences()
 
 		std::vector<Proto::Member> members;
 
-		members_query.set(0, conf_id);
-		while (members_query.step())
+		members_query->set(0, conf_id);
+		while (members_query->step())
 		{
-			auto userId = members_query.get_int64(0);
-			auto grants = members_query.get_int32(1);
+			auto userId = members_query->get_int64(0);
+			auto grants = members_query->get_int32(1);
 			Proto::MemberState state = Proto::MemberState::Undefined;
 			std::string login, name, number;
 
-			user_query.set(0, userId);
-			if (user_query.step())
+			user_query->set(0, userId);
+			if (user_query->step())
 			{
-				state = static_cast<Proto::MemberState>(user_query.get_int32(0));
-				login = user_query.get_string(1);
-				name = user_query.get_string(2);
-				number = user_query.get_string(3);
+				state = static_cast<Proto::MemberState>(user_query->get_int32(0));
+				login = user_query->get_string(1);
+				name = user_query->get_string(2);
+				number = user_query->get_string(3);
 			}
-			user_query.reset();
+			user_query->reset();
 
 			std::vector<Proto::Group> groups_;
 
-			contact_groups_query.set(0, userId);
-			while (contact_groups_query.step())
+			contact_groups_query->set(0, userId);
+			while (contact_groups_query->step())
 			{
-				groups_.emplace_back(Proto::Group(contact_groups_query.get_int64(0)));
+				groups_.emplace_back(Proto::Group(contact_groups_query->get_int64(0)));
 			}
-			contact_groups_query.reset();
+			contact_groups_query->reset();
 
 			members.emplace_back(Proto::Member(userId, state, login, name, number, groups_, grants));
 		}
-		members_query.reset();
+		members_query->reset();
 
-		rolled_query.set(0, conf_id);
-		bool rolled = rolled_query.step();
-		rolled_query.reset();
+		rolled_query->set(0, conf_id);
+		bool rolled = rolled_query->step();
+		rolled_query->reset();
 
 		auto conference = Proto::Conference(
 			conf_id,
 			conf_tag,
-			conferences_query.get_string(2),
-			conferences_query.get_string(3), "", 
+			conferences_query->get_string(2),
+			conferences_query->get_string(3), "", 
 			founder_id,
-			static_cast<Proto::ConferenceType>(conferences_query.get_int32(5)),
+			static_cast<Proto::ConferenceType>(conferences_query->get_int32(5)),
 			conf_grants,
-			conferences_query.get_int32(7),
+			conferences_query->get_int32(7),
 			members,
-			conferences_query.get_int32(8) != 0,
+			conferences_query->get_int32(8) != 0,
 			false,
 			false,
 			rolled);
@@ -1521,14 +2052,13 @@ void Storage::ChangeConferenceRolled(int64_t conferenceId)
 		{
 			conference.rolled = !conference.rolled;
 
-			db::connection conn(db::dbms::SQLite, dbPath);
-			db::transaction writeTr(conn);
+			auto &conn = GetConnection();
+			db::transaction writeTr(conn.Get());
 			writeTr.start();
 
-			db::query rolled_query(conn);
-			rolled_query.prepare(conference.rolled ? "insert into conference_rolled (id) values (?)" : "delete from conference_rolled where id = ?");
-			rolled_query.set(0, conferenceId);
-			rolled_query.step();
+			auto rolled_query = conn.Prepare(conference.rolled ? "insert into conference_rolled (id) values (?)" : "delete from conference_rolled where id = ?");
+			rolled_query->set(0, conferenceId);
+			rolled_query->step();
 
 			writeTr.commit();
 
@@ -1559,13 +2089,29 @@ void Storage::UnsubscribeConferencesReceiver(std::string_view subscriberId)
     }
 }
 
+std::string Storage::SubscribeConferencesChanges(std::function<void(const ConferencesChanges &changes)> receiver)
+{
+	return conferencesChanges.Subscribe(receiver);
+}
+
+void Storage::UnsubscribeConferencesChanges(std::string_view subscriberId)
+{
+	conferencesChanges.Unsubscribe(subscriberId);
+}
+
+Snapshot<Proto::Conference> Storage::GetConferencesSnapshot()
+{
+	std::lock_guard<std::recursive_mutex> lock(conferencesMutex);
+	return conferencesChanges.MakeSnapshot(conferences);
+}
+
 void Storage::UpdateDB()
 {
 	std::string currentDBVersion = "";
 
-	db::connection conn(db::dbms::SQLite, dbPath);
+	auto &conn = GetConnection();
 
-	db::query get_ver_query(conn);
+	db::query get_ver_query(conn.Get());
 	get_ver_query.prepare("select db_version from db_version");
 	if (get_ver_query.step())
 	{
@@ -1577,74 +2123,74 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "2.0.230304";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query users_query(conn);
+		db::query users_query(conn.Get());
 		users_query.prepare("CREATE TABLE `users` (`id` INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, `login` TEXT, `name` TEXT, `number` TEXT, `email` TEXT, `bio` TEXT, `icon` TEXT, `avatar` TEXT, `state` INTEGER, `deleted` INTEGER)");
 		users_query.step();
 
-		db::query groups_query(conn);
+		db::query groups_query(conn.Get());
 		groups_query.prepare("CREATE TABLE \"groups\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, \"parent_id\" INTEGER NOT NULL, \"tag\" TEXT NOT NULL, \"name\" TEXT NOT NULL, \"password\" TEXT, \"grants\" INTEGER, \"owner_id\" integer, \"deleted\" INTEGER)");
 		groups_query.step();
 
-		db::query client_groups_query(conn);
+		db::query client_groups_query(conn.Get());
 		client_groups_query.prepare("CREATE TABLE \"client_groups\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, \"client_id\" INTEGER NOT NULL, \"group_id\" INTEGER NOT NULL, \"deleted\" INTEGER);");
 		client_groups_query.step();
 
-		db::query group_rolled_query(conn);
+		db::query group_rolled_query(conn.Get());
 		group_rolled_query.prepare("CREATE TABLE \"group_rolled\" (\"id\" INTEGER NOT NULL PRIMARY KEY);");
 		group_rolled_query.step();
 
-		db::query conference_rolled_query(conn);
+		db::query conference_rolled_query(conn.Get());
 		conference_rolled_query.prepare("CREATE TABLE \"conference_rolled\" (\"id\" INTEGER NOT NULL PRIMARY KEY);");
 		conference_rolled_query.step();
 
-		db::query conferences_query(conn);
+		db::query conferences_query(conn.Get());
 		conferences_query.prepare("CREATE TABLE `conferences` (`id` INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, `tag` TEXT NOT NULL, `name` TEXT NOT NULL, `descr` TEXT, `founder_id` INTEGER, `type` INTEGER, `grants` INTEGER, `duration` INTEGER, `connect_members` INTEGER, `deleted` INTEGER);");
 		conferences_query.step();
 
-		db::query conference_members_query(conn);
+		db::query conference_members_query(conn.Get());
 		conference_members_query.prepare("CREATE TABLE `conference_members` (`conference_id` INTEGER NOT NULL, `user_id` INTEGER NOT NULL, `grants` INTEGER, PRIMARY KEY(`conference_id`, `user_id`));");
 		conference_members_query.step();
 
-		db::query messages_query(conn);
+		db::query messages_query(conn.Get());
 		messages_query.prepare("CREATE TABLE \"messages\" ( `id` INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, `guid`	TEXT NOT NULL UNIQUE, `dt` INTEGER, `type` INTEGER, `author_id` INTEGER, `sender_id` INTEGER, `subscriber_id` INTEGER, `conference_tag` TEXT, `text_value` TEXT, `call_duration` INTEGER, `call_result` INTEGER, `data_preview` TEXT, `data_url` TEXT, `data_local_path` TEXT, status INTEGER )");
 		messages_query.step();
 
-		db::query messages_guid_index_query(conn);
+		db::query messages_guid_index_query(conn.Get());
 		messages_guid_index_query.prepare("CREATE INDEX `messages_guid_index` ON `messages` ( `guid` )");
 		messages_guid_index_query.step();
 
-		db::query messages_author_id_index_query(conn);
+		db::query messages_author_id_index_query(conn.Get());
 		messages_author_id_index_query.prepare("CREATE INDEX `messages_author_id_index` ON `messages` ( `author_id` )");
 		messages_author_id_index_query.step();
 
-		db::query messages_sender_id_index_query(conn);
+		db::query messages_sender_id_index_query(conn.Get());
 		messages_sender_id_index_query.prepare("CREATE INDEX `messages_sender_id_index` ON `messages` ( `sender_id` )");
 		messages_sender_id_index_query.step();
 
-		db::query messages_subscriber_id_index_query(conn);
+		db::query messages_subscriber_id_index_query(conn.Get());
 		messages_subscriber_id_index_query.prepare("CREATE INDEX `messages_subscriber_id_index` ON `messages` ( `subscriber_id` )");
 		messages_subscriber_id_index_query.step();
 
-		db::query messages_conference_tag_index_query(conn);
+		db::query messages_conference_tag_index_query(conn.Get());
 		messages_conference_tag_index_query.prepare("CREATE INDEX `messages_conference_tag_index` ON `messages` ( `conference_tag` )");
 		messages_conference_tag_index_query.step();
 
-		db::query messages_dt_index_query(conn);
+		db::query messages_dt_index_query(conn.Get());
 		messages_dt_index_query.prepare("CREATE INDEX `messages_dt_index` ON `messages` ( `dt` DESC )");
 		messages_dt_index_query.step();
 
-		db::query conferences_tag_index_query(conn);
+		db::query conferences_tag_index_query(conn.Get());
 		conferences_tag_index_query.prepare("CREATE UNIQUE INDEX `conferences_tag_index` ON `conferences` ( `tag` )");
 		conferences_tag_index_query.step();
 
-		db::query create_settings_query(conn);
+		db::query create_settings_query(conn.Get());
 		create_settings_query.prepare("CREATE TABLE \"settings\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT UNIQUE, \"key\" TEXT, \"value\" TEXT);");
 		create_settings_query.step();
 
-		db::query insert_settings_query(conn);
+		db::query insert_settings_query(conn.Get());
 		insert_settings_query.prepare("insert into settings (key, value) values ('users_sort_type', '0')");
 		insert_settings_query.step();
         insert_settings_query.prepare("insert into settings (key, value) values ('show_number_on_contact_list', '0')");
@@ -1652,11 +2198,11 @@ void Storage::UpdateDB()
         insert_settings_query.prepare("insert into settings (key, value) values ('my_client_id', '0')");
         insert_settings_query.step();
 
-		db::query db_version_query(conn);
+		db::query db_version_query(conn.Get());
 		db_version_query.prepare("CREATE TABLE `db_version` ( `db_version` TEXT )");
 		db_version_query.step();
 		
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("insert into db_version (db_version) values ('" + currentDBVersion + "')");
 		upd_db_version_query.step();
 
@@ -1666,18 +2212,18 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.4.191016";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query create_settings_query(conn);
+		db::query create_settings_query(conn.Get());
 		create_settings_query.prepare("CREATE TABLE \"settings\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT UNIQUE, \"key\" TEXT, \"value\" TEXT);");
 		create_settings_query.step();
 
-		db::query insert_settings_query(conn);
+		db::query insert_settings_query(conn.Get());
 		insert_settings_query.prepare("insert into settings (key, value) values ('users_sort_type', '0')");
 		insert_settings_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1687,14 +2233,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.4.200506";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query alter_users_query(conn);
+		db::query alter_users_query(conn.Get());
 		alter_users_query.prepare("alter table `users` add `login` text;");
 		alter_users_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1704,18 +2250,18 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.4.210325";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query alter_users_query(conn);
+		db::query alter_users_query(conn.Get());
 		alter_users_query.prepare("alter table users add group_id integer not null default 1;");
 		alter_users_query.step();
 
-		db::query groups_query(conn);
+		db::query groups_query(conn.Get());
 		groups_query.prepare("CREATE TABLE \"groups\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, \"parent_id\" INTEGER NOT NULL, \"tag\" TEXT NOT NULL, \"name\" TEXT NOT NULL, \"password\" TEXT, \"grants\" INTEGER, \"deleted\"	INTEGER)");
 		groups_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1725,14 +2271,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.5.210426";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query client_groups_query(conn);
+		db::query client_groups_query(conn.Get());
 		client_groups_query.prepare("CREATE TABLE \"client_groups\" (\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, \"client_id\" INTEGER NOT NULL, \"group_id\" INTEGER NOT NULL, \"deleted\" INTEGER);");
 		client_groups_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1742,14 +2288,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.5.210615";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query client_groups_query(conn);
+		db::query client_groups_query(conn.Get());
 		client_groups_query.prepare("alter table groups add owner_id integer;");
 		client_groups_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1759,14 +2305,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.5.210626";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query group_rolled_query(conn);
+		db::query group_rolled_query(conn.Get());
 		group_rolled_query.prepare("CREATE TABLE \"group_rolled\" (\"id\" INTEGER NOT NULL PRIMARY KEY);");
 		group_rolled_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1776,14 +2322,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.6.211107";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query conference_rolled_query(conn);
+		db::query conference_rolled_query(conn.Get());
 		conference_rolled_query.prepare("CREATE TABLE \"conference_rolled\" (\"id\" INTEGER NOT NULL PRIMARY KEY);");
 		conference_rolled_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1793,14 +2339,14 @@ void Storage::UpdateDB()
 	{
 		currentDBVersion = "1.6.211122";
 
-		db::transaction writeTr(conn);
+		db::transaction writeTr(conn.Get());
 		writeTr.start();
 
-		db::query conference_rolled_query(conn);
+		db::query conference_rolled_query(conn.Get());
 		conference_rolled_query.prepare("alter table conference_members add grants integer;");
 		conference_rolled_query.step();
 
-		db::query upd_db_version_query(conn);
+		db::query upd_db_version_query(conn.Get());
 		upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
 		upd_db_version_query.step();
 
@@ -1810,14 +2356,14 @@ void Storage::UpdateDB()
     {
         currentDBVersion = "2.0.221122";
 
-        db::transaction writeTr(conn);
+        db::transaction writeTr(conn.Get());
         writeTr.start();
 
-        db::query insert_settings_query(conn);
+        db::query insert_settings_query(conn.Get());
         insert_settings_query.prepare("insert into settings (key, value) values ('my_client_id', '0')");
         insert_settings_query.step();
 
-        db::query upd_db_version_query(conn);
+        db::query upd_db_version_query(conn.Get());
         upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
         upd_db_version_query.step();
 
@@ -1827,17 +2373,17 @@ void Storage::UpdateDB()
     {
         currentDBVersion = "2.0.221204";
 
-        db::transaction writeTr(conn);
+        db::transaction writeTr(conn.Get());
         writeTr.start();
 
-        db::query alter_query(conn);
+        db::query alter_query(conn.Get());
         alter_query.prepare("alter table users add bio TEXT null;");
         alter_query.step();
 
         alter_query.prepare("alter table users add email TEXT null;");
         alter_query.step();
 
-        db::query upd_db_version_query(conn);
+        db::query upd_db_version_query(conn.Get());
         upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
         upd_db_version_query.step();
 
@@ -1847,14 +2393,96 @@ void Storage::UpdateDB()
     {
         currentDBVersion = "2.0.230304";
 
-        db::transaction writeTr(conn);
+        db::transaction writeTr(conn.Get());
         writeTr.start();
 
-        db::query insert_settings_query(conn);
+        db::query insert_settings_query(conn.Get());
         insert_settings_query.prepare("insert into settings (key, value) values ('show_number_on_contact_list', '0')");
         insert_settings_query.step();
 
-        db::query upd_db_version_query(conn);
+        db::query upd_db_version_query(conn.Get());
+        upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
+        upd_db_version_query.step();
+
+        writeTr.commit();
+    }
+    if (currentDBVersion == "2.0.230304")
+    {
+        currentDBVersion = "2.1.241018";
+
+        db::transaction writeTr(conn.Get());
+        writeTr.start();
+
+        CreateUnreadedCounters(conn.Get());
+        RebuildUnreadedCounters(conn);
+
+        db::query upd_db_version_query(conn.Get());
+        upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
+        upd_db_version_query.step();
+
+        writeTr.commit();
+    }
+    if (currentDBVersion == "2.1.241018")
+    {
+        currentDBVersion = "2.1.241019";
+
+        db::transaction writeTr(conn.Get());
+        writeTr.start();
+
+        /// The history is paginated by (dt, id), with id in the index the pages are read without sorting
+        db::query index_query(conn.Get());
+        index_query.prepare("DROP INDEX `messages_subscriber_id_dt_index`");
+        index_query.step();
+        index_query.prepare("DROP INDEX `messages_conference_tag_dt_index`");
+        index_query.step();
+        index_query.prepare("CREATE INDEX `messages_subscriber_id_dt_id_index` ON `messages` ( `subscriber_id`, `dt`, `id` )");
+        index_query.step();
+        index_query.prepare("CREATE INDEX `messages_conference_tag_dt_id_index` ON `messages` ( `conference_tag`, `dt`, `id` )");
+        index_query.step();
+
+        db::query upd_db_version_query(conn.Get());
+        upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
+        upd_db_version_query.step();
+
+        writeTr.commit();
+    }
+    if (currentDBVersion == "2.1.241019")
+    {
+        currentDBVersion = "2.1.241020";
+
+        db::transaction writeTr(conn.Get());
+        writeTr.start();
+
+        /// The index keeps own copy of the text, so deleting of a row which is not indexed yet is harmless
+        db::query fts_query(conn.Get());
+        if (fts_query.prepare("CREATE VIRTUAL TABLE `messages_fts` USING fts5(text_value, tokenize = 'unicode61 remove_diacritics 2')") == db::result::OK)
+        {
+            fts_query.step();
+            fts_query.prepare("CREATE TRIGGER `messages_fts_insert` AFTER INSERT ON `messages` BEGIN "
+                "insert into messages_fts (rowid, text_value) select new.id, new.text_value where new.text_value is not null; END");
+            fts_query.step();
+            fts_query.prepare("CREATE TRIGGER `messages_fts_delete` AFTER DELETE ON `messages` BEGIN "
+                "delete from messages_fts where rowid = old.id; END");
+            fts_query.step();
+            fts_query.prepare("CREATE TRIGGER `messages_fts_update` AFTER UPDATE OF `text_value` ON `messages` BEGIN "
+                "delete from messages_fts where rowid = old.id; "
+                "insert into messages_fts (rowid, text_value) select new.id, new.text_value where new.text_value is not null; END");
+            fts_query.step();
+
+            /// The existing messages are indexed by chunks in the background, see IndexOldMessages()
+            fts_query.prepare("insert into settings (key, value) select 'search_index_id', coalesce(max(id), 0) + 1 from messages");
+            fts_query.step();
+        }
+        else
+        {
+            auto errLog = spdlog::get("Error");
+            if (errLog)
+            {
+                errLog->error("Storage :: SQLite is built without FTS5, the messages search is disabled ({0})", conn.Get().get_error_message());
+            }
+        }
+
+        db::query upd_db_version_query(conn.Get());
         upd_db_version_query.prepare("update db_version set db_version = '" + currentDBVersion + "'");
         upd_db_version_query.step();
 
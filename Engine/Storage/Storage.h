@@ -10,7 +10,12 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
 #include <functional>
 
 #include <Common/Common.h>
@@ -21,11 +26,13 @@
 #include <Proto/Conference.h>
 #include <Proto/CmdContactList.h>
 
-namespace db { class connection; }
+#include <Storage/ChangeNotifier.h>
 
 namespace Storage
 {
 
+class Connection;
+
 /// Messages
 typedef std::vector<Proto::Message> Messages;
 
@@ -44,6 +51,63 @@ enum class MessageAction
 /// Conferences
 typedef std::vector<Proto::Conference> Conferences;
 
+/// Incremental changes of the lists, the messages are identified by the guids
+typedef ChangeSet<Proto::Member> ContactsChanges;
+typedef ChangeSet<Proto::Group> GroupsChanges;
+typedef ChangeSet<Proto::Conference> ConferencesChanges;
+typedef ChangeSet<Proto::Message, std::string> MessagesChanges;
+
+/// Position in the history, the messages are ordered by (dt, id)
+struct HistoryCursor
+{
+	int64_t dt = 0; /// 0 - from the newest message
+	int64_t id = 0;
+};
+
+enum class HistoryDirection
+{
+	Older = 0,
+	Newer
+};
+
+/// Immutable page of the history, the view keeps only the pages it shows
+struct MessagesPage
+{
+	Messages messages; /// From the newest to the oldest
+	HistoryCursor newest, oldest; /// Bounds of the page, to load the neighbor pages
+	bool more = false; /// There are more messages in the direction of the loading
+};
+
+typedef std::shared_ptr<const MessagesPage> MessagesPagePtr;
+
+/// Where to search, all the history if both are empty
+struct SearchScope
+{
+	int64_t subscriber = 0;
+	std::string conference;
+};
+
+/// Position in the search results, ordered by (rank, id)
+struct SearchCursor
+{
+	double rank = 0;
+	int64_t id = 0; /// 0 - from the best match
+};
+
+struct SearchResult
+{
+	Proto::Message message;
+	std::string snippet; /// Matched words are marked by <b></b>
+	double rank; /// bm25, the less is the better
+};
+
+struct SearchPage
+{
+	std::vector<SearchResult> results;
+	SearchCursor next;
+	bool more = false;
+};
+
 class Storage
 {
 public:
@@ -52,6 +116,10 @@ public:
 
 	void Connect(std::string_view dbPath);
 	void SetMyClientId(int64_t id);
+
+	/// 0 - the changes are delivered at once by the changing thread, otherwise the changes
+	/// of the interval (the frame of the UI) are merged and delivered by the notifier thread
+	void SetNotifyInterval(std::chrono::milliseconds interval);
     
 	/// Messages and calls API
 	void AddMessage(const Proto::Message &message);
@@ -59,9 +127,20 @@ public:
 
     std::vector<int64_t> GetAbsentContacts(const Messages &messages);
 
+	/// Compare the unreaded counters with the full scan of messages, rebuild them if differ.
+	/// Called on connect, returns false if the counters were rebuilt
+	bool CheckUnreadedCounters();
+
 	size_t LoadMessages(int64_t start, int64_t subscriber, std::string_view conference, uint32_t limit);
 	size_t LoadNextMessages(int32_t count);
 
+	/// Keyset pagination of the history of the contact or the conference.
+	/// Doesn't touch the loaded messages and their mutex, can be called from any thread
+	MessagesPagePtr LoadHistoryPage(int64_t subscriber, std::string_view conference, const HistoryCursor &from, HistoryDirection direction, uint32_t limit);
+
+	/// Full text search by the words of the query, the last word is matched as a prefix
+	SearchPage SearchMessages(std::string_view query, const SearchScope &scope, uint32_t limit, const SearchCursor &cursor = SearchCursor());
+
 	Messages GetUndeliveredMessages();
 
 	uint64_t GetLastMessageDT();
@@ -72,6 +151,10 @@ public:
     std::string SubscribeMessagesReceiver(std::function<void(MessageAction, const Messages &messages)> receiver);
     void UnsubscribeMessagesReceiver(std::string_view subscriberId);
 
+	std::string SubscribeMessagesChanges(std::function<void(const MessagesChanges &changes)> receiver);
+	void UnsubscribeMessagesChanges(std::string_view subscriberId);
+	Snapshot<Proto::Message> GetMessagesSnapshot();
+
 	/// ContactList API
 	void UpdateContacts(Proto::CONTACT_LIST::SortType sortType, bool showNumbers, const Contacts &contacts);
     void DeleteContact(int64_t clientId);
@@ -89,6 +172,11 @@ public:
     std::string SubscribeContactsReceiver(std::function<void(const Contacts &contacts)> receiver);
     void UnsubscribeContactsReceiver(std::string_view subscriberId);
 
+	/// Only the inserted, updated and removed contacts instead of the whole list
+	std::string SubscribeContactsChanges(std::function<void(const ContactsChanges &changes)> receiver);
+	void UnsubscribeContactsChanges(std::string_view subscriberId);
+	Snapshot<Proto::Member> GetContactsSnapshot();
+
 	/// GroupList API
 	void UpdateGroups(const Groups &groups);
 	void ClearGroups();
@@ -104,6 +192,10 @@ public:
     std::string SubscribeGroupsReceiver(std::function<void(const Groups &groups)> receiver);
     void UnsubscribeGroupsReceiver(std::string_view subscriberId);
 
+	std::string SubscribeGroupsChanges(std::function<void(const GroupsChanges &changes)> receiver);
+	void UnsubscribeGroupsChanges(std::string_view subscriberId);
+	Snapshot<Proto::Group> GetGroupsSnapshot();
+
 	/// Conferences API
 	void UpdateConferences(const Conferences &conferences);
 
@@ -120,12 +212,27 @@ public:
     std::string SubscribeConferencesReceiver(std::function<void(const Conferences &conferences)> receiver);
     void UnsubscribeConferencesReceiver(std::string_view subscriberId);
 
+	std::string SubscribeConferencesChanges(std::function<void(const ConferencesChanges &changes)> receiver);
+	void UnsubscribeConferencesChanges(std::string_view subscriberId);
+	Snapshot<Proto::Conference> GetConferencesSnapshot();
+
 private:
 	std::string dbPath;
 
+	/// Indexing of the messages stored before the full text search was added, runs after connecting
+	std::thread searchIndexer;
+	std::atomic<bool> searchIndexerRunned;
+
+	static const size_t STATEMENTS_CACHE_SIZE = 64;
+
+	/// One long-lived connection per calling thread (UI, network), each with own statements cache
+	std::mutex connectionsMutex;
+	std::map<std::thread::id, std::unique_ptr<Connection>> connections;
+
 	int64_t myClientId;
 	
-	int64_t messagesStart, messagesEnd;
+	int64_t messagesStart;
+	HistoryCursor messagesEnd;
 	int64_t messageSubscriber;
 	int32_t messagesLimit;
 	std::string messagesConference;
@@ -146,18 +253,41 @@ private:
 	Conferences conferences;
     std::map<std::string, std::function<void(const Conferences &conferences)>> conferencesReceivers;
 
+	ChangeNotifier<Proto::Message, std::string> messagesChanges;
+	ChangeNotifier<Proto::Member> contactsChanges;
+	ChangeNotifier<Proto::Group> groupsChanges;
+	ChangeNotifier<Proto::Conference> conferencesChanges;
+
+	/// Delivers the merged changes once per the interval
+	std::thread notifier;
+	std::mutex notifierMutex;
+	std::condition_variable notifierCV;
+	std::chrono::milliseconds notifyInterval;
+	bool notifierRunned, notifierWaked;
+
     Proto::CONTACT_LIST::SortType contactSortType;
     int32_t showNumbers;
 
+	Connection &GetConnection();
+	void ReleaseConnection();
+
+	void StopNotifier();
+	void RunNotifier();
+	void WakeNotifier();
+
+	void StartSearchIndexer();
+	void StopSearchIndexer();
+	void IndexOldMessages();
+
 	void UpdateDB();
 
-	size_t LoadMessages(int64_t start);
+	size_t LoadMessages(const HistoryCursor &from);
 
     void UpdateUnreadedContacts();
 	void UpdateUnreadedConferences();
 
-    int32_t CalcUnreadedContact(db::connection &conn, int64_t clientId);
-    int32_t CalcUnreadedConference(db::connection &conn, std::string_view tag);
+    int32_t CalcUnreadedContact(Connection &conn, int64_t clientId);
+    int32_t CalcUnreadedConference(Connection &conn, std::string_view tag);
 
     Proto::CONTACT_LIST::SortType GetContactSortType();
 
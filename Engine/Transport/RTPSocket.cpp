@@ -13,6 +13,8 @@
 
 #include <Transport/UDPSocket.h>
 
+#include <Common/Trace.h>
+
 #include <mt/thread_priority.h>
 
 #include <spdlog/spdlog.h>
@@ -85,6 +87,8 @@ public:
 
         uint8_t sendBuf[UDPSocket::MAX_DATAGRAM_SIZE] = { 0 };
         uint32_t serializedSize = UDPSocket::MAX_DATAGRAM_SIZE;
+
+        const auto traceBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
         
         switch (packet_.GetType())
         {
@@ -105,6 +109,12 @@ public:
         }
 
         socket.Send(sendBuf, serializedSize, address ? *address : defaultAddress, 0);
+
+        if (traceBegin != 0 && packet_.GetType() == PacketType::RTP)
+        {
+            const auto &header = static_cast<const Transport::RTPPacket*>(&packet_)->rtpHeader;
+            Common::Trace::Record(Common::Trace::Stage::Send, Common::Trace::GetKind(header.pt), header.ssrc, header.ts, traceBegin, Common::Trace::Now());
+        }
     }
 
 private:
@@ -116,9 +126,16 @@ private:
         {
             case PacketType::RTP:
             {
+                const auto traceBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
+
                 Transport::RTPPacket rtpPacket;
                 if (rtpReceiver != nullptr && rtpPacket.Parse(data, size))
                 {
+                    if (traceBegin != 0)
+                    {
+                        Common::Trace::Record(Common::Trace::Stage::Receive, Common::Trace::GetKind(rtpPacket.rtpHeader.pt), rtpPacket.rtpHeader.ssrc, rtpPacket.rtpHeader.ts, traceBegin, Common::Trace::Now());
+                    }
+
                     if (RTPSocket::WITH_TRACES)
                     {
                         sysLog->trace("RTPSocket[{0}] receive RTP packet, size: {1}, from: {2}, socket port: {3}",
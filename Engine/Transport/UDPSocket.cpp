@@ -18,6 +18,12 @@ UDPSocket::UDPSocket(std::function<void(const uint8_t *data, uint16_t size, cons
     bindedPort(0),
     thread(),
     runned(false),
+    sentPackets(Common::Metrics::Registry::Instance().GetCounter("udp_sent_packets_total", "Datagrams sent by the UDP sockets")),
+    sentBytes(Common::Metrics::Registry::Instance().GetCounter("udp_sent_bytes_total", "Bytes sent by the UDP sockets")),
+    sendErrors(Common::Metrics::Registry::Instance().GetCounter("udp_send_errors_total", "Failed sendto() calls")),
+    receivedPackets(Common::Metrics::Registry::Instance().GetCounter("udp_received_packets_total", "Datagrams received by the UDP sockets")),
+    receivedBytes(Common::Metrics::Registry::Instance().GetCounter("udp_received_bytes_total", "Bytes received by the UDP sockets")),
+    receiveErrors(Common::Metrics::Registry::Instance().GetCounter("udp_receive_errors_total", "Failed recvfrom() calls")),
     sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
 {}
 
@@ -166,8 +172,10 @@ void UDPSocket::Send(const uint8_t *data, uint16_t size, const Address &address,
             const int ret = sendto(netsocket, (const char*)data, size, 0, (sockaddr*)&address.v4addr, sizeof(sockaddr_in));
             if (ret == SOCKET_ERROR)
             {
+                sendErrors->Add();
                 errLog->critical("UDPSocket[{0}] Send() IPv4 error: {1}, receiver: {2}, socket port: {3}", 
                     netsocket, GET_LAST_ERROR, address.toString(), bindedPort);
+                return;
             }
         }
         break;
@@ -176,8 +184,10 @@ void UDPSocket::Send(const uint8_t *data, uint16_t size, const Address &address,
             const int ret = sendto(netsocket, (const char*)data, size, 0, (sockaddr*)&address.v6addr, sizeof(sockaddr_in6));
             if (ret == SOCKET_ERROR)
             {
+                sendErrors->Add();
                 errLog->critical("UDPSocket[{0}] Send() IPv6 error: {1}, receiver: {2}, socket port: {3}",
                     netsocket, GET_LAST_ERROR, address.toString(), bindedPort);
+                return;
             }
         }
         break;
@@ -185,6 +195,9 @@ void UDPSocket::Send(const uint8_t *data, uint16_t size, const Address &address,
         break;
     }
 
+    sentPackets->Add();
+    sentBytes->Add(size);
+
     if (WITH_TRACES)
     {
         sysLog->trace("UDPSocket[{0}] sended, size: {1}, to: {2}, socket port: {3}",
@@ -218,11 +231,18 @@ void UDPSocket::run()
         const int recvSize = recvfrom(netsocket, (char*)recvBuf, MAX_DATAGRAM_SIZE, 0, (struct sockaddr*)&senderAddr, &senderAddrSize);
         if (recvSize == SOCKET_ERROR || recvSize == 0)
         {
-            if (GET_LAST_ERROR != 0) errLog->critical("UDPSocket[{0}] recvfrom() error: {1}", netsocket, GET_LAST_ERROR);
+            if (GET_LAST_ERROR != 0)
+            {
+                receiveErrors->Add();
+                errLog->critical("UDPSocket[{0}] recvfrom() error: {1}", netsocket, GET_LAST_ERROR);
+            }
             
             continue;
         }
 
+        receivedPackets->Add();
+        receivedBytes->Add(recvSize);
+
         Address addr(&senderAddr);
 
         if (WITH_TRACES)
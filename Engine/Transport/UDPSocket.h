@@ -10,6 +10,8 @@
 #include <Transport/Address.h>
 #include <Transport/SockCommon.h>
 
+#include <Common/Metrics.h>
+
 #include <atomic>
 #include <functional>
 
@@ -48,6 +50,9 @@ private:
 
 	std::atomic<bool> runned;
 
+	std::shared_ptr<Common::Metrics::Counter> sentPackets, sentBytes, sendErrors,
+		receivedPackets, receivedBytes, receiveErrors;
+
 	std::shared_ptr<spdlog::logger> sysLog, errLog;
 
 	void run();
@@ -13,14 +13,20 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 #include <boost/asio/connect.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/stream.hpp>
 
 #include <mutex>
-#include <queue>
+#include <deque>
+#include <vector>
 #include <cstdlib>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <limits>
+#include <algorithm>
 
 #include <spdlog/spdlog.h>
 
@@ -32,44 +38,127 @@ using ws_timeout = boost::beast::websocket::stream_base::timeout;
 namespace Transport
 {
 
-class session : public std::enable_shared_from_this<session>
+static const size_t WRITE_POOL_SIZE = 32;
+static const size_t WRITE_POOL_MAX_BUFFER = 64 * 1024; /// Bigger buffers are freed, not to hold the memory of rare big messages
+static const size_t WRITE_QUEUE_WARNING_DEPTH = 1024;
+
+struct wire_counters
 {
-    tcp::resolver resolver_;
+    std::atomic<uint64_t> read, written;
+};
+
+/// Beast rate policy which doesn't limit anything, only counts the bytes really went through the socket,
+/// after the compression and the TLS, to know the compression ratio
+class wire_counter
+{
+    wire_counters *counters_ = nullptr;
+
+public:
+    void attach(wire_counters *counters)
+    {
+        counters_ = counters;
+    }
+
+    std::size_t available_read_bytes() const noexcept
+    {
+        return (std::numeric_limits<std::size_t>::max)();
+    }
+
+    std::size_t available_write_bytes() const noexcept
+    {
+        return (std::numeric_limits<std::size_t>::max)();
+    }
+
+    void transfer_read_bytes(std::size_t n) noexcept
+    {
+        if (counters_) counters_->read += n;
+    }
+
+    void transfer_write_bytes(std::size_t n) noexcept
+    {
+        if (counters_) counters_->written += n;
+    }
+
+    void on_timer()
+    {
+    }
+};
+
+using counted_stream = boost::beast::basic_stream<tcp, boost::asio::any_io_executor, wire_counter>;
 
+class session : public std::enable_shared_from_this<session>
+{
     boost::asio::io_context& ioc_;
 
-    websocket::stream<tcp::socket> plain_ws_;
+    /// All the handlers and the write queue work in it, so the callers of write() from any thread never touch the stream
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+
+    tcp::resolver resolver_;
+
+    websocket::stream<counted_stream> plain_ws_;
     ssl::context ctx;
-    websocket::stream<ssl::stream<tcp::socket>> ssl_ws_;
+    websocket::stream<ssl::stream<counted_stream>> ssl_ws_;
     
-    boost::beast::multi_buffer buffer_;
+    boost::beast::flat_buffer buffer_; /// Keeps the capacity of the biggest message, so the reading doesn't allocate
     std::string host_;
 
-    std::queue<std::string> write_queue_;
-    std::atomic<bool> writing_;
+    /// The front element is in flight and is owned by the queue until on_write
+    std::deque<std::string> write_queue_;
+    bool writing_;
+
+    std::mutex pool_mutex_;
+    std::vector<std::string> pool_;
+
+    std::atomic<size_t> queue_depth_, max_queue_depth_;
+    std::atomic<uint64_t> queued_bytes_, sent_messages_;
 
     ws_callback callback_;
 
     bool secure;
+    WSDeflate deflate_;
+
+    wire_counters wire_;
+    std::atomic<uint64_t> payload_read_, payload_written_;
 
     std::shared_ptr<spdlog::logger> sysLog, errLog;
 
 public:
     // Resolver and socket require an io_context
-    explicit session(boost::asio::io_context& ioc, ws_callback callback, bool secure_)
-        : resolver_(ioc),
-        ioc_(ioc),
-        plain_ws_(ioc),
+    explicit session(boost::asio::io_context& ioc, ws_callback callback, bool secure_, const WSDeflate &deflate)
+        : ioc_(ioc),
+        strand_(boost::asio::make_strand(ioc)),
+        resolver_(strand_),
+        plain_ws_(strand_),
         ctx(ssl::context::sslv23_client),
-        ssl_ws_(ioc, ctx),
+        ssl_ws_(strand_, ctx),
         buffer_(),
         host_(),
         write_queue_(),
         writing_(false),
+        pool_mutex_(),
+        pool_(),
+        queue_depth_(0), max_queue_depth_(0),
+        queued_bytes_(0), sent_messages_(0),
         callback_(callback),
         secure(secure_),
+        deflate_(deflate),
+        wire_(),
+        payload_read_(0), payload_written_(0),
         sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
     {
+        plain_ws_.next_layer().rate_policy().attach(&wire_);
+        ssl_ws_.next_layer().next_layer().rate_policy().attach(&wire_);
+
+        websocket::permessage_deflate pmd;
+        pmd.client_enable = deflate_.enabled;
+        pmd.client_max_window_bits = deflate_.windowBits;
+        pmd.server_max_window_bits = deflate_.windowBits;
+        pmd.client_no_context_takeover = !deflate_.contextTakeover;
+        pmd.server_no_context_takeover = !deflate_.contextTakeover;
+        pmd.memLevel = deflate_.memLevel;
+        pmd.msg_size_threshold = deflate_.threshold;
+        plain_ws_.set_option(pmd);
+        ssl_ws_.set_option(pmd);
     }
 
     // Start the asynchronous operation
@@ -102,7 +191,7 @@ public:
         
         // Make the connection on the IP address we get from a lookup
         boost::asio::async_connect(
-            secure ? ssl_ws_.next_layer().next_layer() : plain_ws_.next_layer(),
+            secure ? ssl_ws_.next_layer().next_layer().socket() : plain_ws_.next_layer().socket(),
             results.begin(),
             results.end(),
             std::bind(
@@ -237,13 +326,16 @@ public:
             return errLog->warn("WebSocket::session::on_read :: Stopped io context, ignore");
         }
         
-        auto readed(buffers_to_string(buffer_.data()));
+        payload_read_ += buffer_.size();
+
+        /// The message is valid only during the callback
+        callback_(WSMethod::Message, std::string_view(static_cast<const char*>(buffer_.data().data()), buffer_.size()));
         buffer_.consume(buffer_.size());
-        callback_(WSMethod::Message, readed);
 
         do_read();
     }
 
+    /// Can be called from any thread, the message is copied to the pooled buffer here
     void write(std::string_view message)
     {
         if (WebSocket::WITH_TRACES)
@@ -255,19 +347,36 @@ public:
         {
             return errLog->warn("WebSocket::write to stopped io context");
         }
-        
-        write_queue_.push(std::string(message));
-        if (!writing_)
+
+        auto buffer = acquire_buffer();
+        buffer.assign(message.data(), message.size());
+
+        queued_bytes_ += message.size();
+        auto depth = ++queue_depth_;
+        auto max_depth = max_queue_depth_.load();
+        while (depth > max_depth && !max_queue_depth_.compare_exchange_weak(max_depth, depth));
+        if (depth == WRITE_QUEUE_WARNING_DEPTH)
         {
-            writing_ = true;
-            do_write();
+            errLog->warn("WebSocket::write :: the write queue reached {0} messages, the receiver is too slow", depth);
         }
+
+        boost::asio::post(strand_,
+            [self = shared_from_this(), buffer = std::move(buffer)]() mutable
+            {
+                self->write_queue_.emplace_back(std::move(buffer));
+                if (!self->writing_)
+                {
+                    self->writing_ = true;
+                    self->do_write();
+                }
+            });
     }
 
     void do_write()
     {
-        std::string message = write_queue_.front();
-        write_queue_.pop();
+        const auto &message = write_queue_.front();
+
+        payload_written_ += message.size();
 
         if (secure)
         {
@@ -301,6 +410,12 @@ public:
     void on_write(boost::system::error_code ec,
         std::size_t bytes_transferred)
     {
+        /// The buffer is no longer used by the stream
+        queued_bytes_ -= write_queue_.front().size();
+        --queue_depth_;
+        release_buffer(std::move(write_queue_.front()));
+        write_queue_.pop_front();
+
         if (ec && !ioc_.stopped())
         {
             errLog->error("WebSocket::session :: on_write :: error: {0}", ec.message());
@@ -308,6 +423,8 @@ public:
             return;
         }
 
+        ++sent_messages_;
+
         if (WebSocket::WITH_TRACES)
         {
             sysLog->trace("WebSocket::on_write :: Perform writing, size; {0}", bytes_transferred);
@@ -331,11 +448,66 @@ public:
         }
     }
 
+    std::string acquire_buffer()
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (pool_.empty())
+        {
+            return std::string();
+        }
+        auto buffer = std::move(pool_.back());
+        pool_.pop_back();
+        return buffer;
+    }
+
+    void release_buffer(std::string &&buffer)
+    {
+        if (buffer.capacity() > WRITE_POOL_MAX_BUFFER)
+        {
+            return;
+        }
+
+        buffer.clear();
+
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (pool_.size() < WRITE_POOL_SIZE)
+        {
+            pool_.emplace_back(std::move(buffer));
+        }
+    }
+
+    WSQueueStats get_queue_stats() const
+    {
+        return WSQueueStats{ queue_depth_, max_queue_depth_, queued_bytes_, sent_messages_ };
+    }
+
+    WSTrafficStats get_traffic_stats() const
+    {
+        return WSTrafficStats{ payload_written_, wire_.written, payload_read_, wire_.read };
+    }
+
+    void log_traffic_stats()
+    {
+        auto stats = get_traffic_stats();
+        sysLog->info("WebSocket::session :: deflate: {0}, sent: {1} -> {2} bytes ({3:.2f}), received: {4} <- {5} bytes ({6:.2f})",
+            deflate_.enabled ? "Y" : "N",
+            stats.sentPayload, stats.sentWire, stats.sentPayload != 0 ? static_cast<double>(stats.sentWire) / stats.sentPayload : 0.0,
+            stats.receivedPayload, stats.receivedWire, stats.receivedPayload != 0 ? static_cast<double>(stats.receivedWire) / stats.receivedPayload : 0.0);
+    }
+
     void close()
+    {
+        boost::asio::post(strand_, std::bind(&session::do_close, shared_from_this()));
+    }
+
+    void do_close()
     {
         writing_ = false;
 
-        sysLog->trace("WebSocket::session :: close :: Perform async_close");
+        sysLog->trace("WebSocket::session :: close :: Perform async_close, write queue max depth: {0}, sent: {1}",
+            max_queue_depth_.load(), sent_messages_.load());
+
+        log_traffic_stats();
 
         if (secure)
         {
@@ -386,6 +558,7 @@ class WebSocketImpl
     ws_callback callback;
 
     bool secure;
+    WSDeflate deflate;
     
     std::string address, port;
 
@@ -395,10 +568,11 @@ class WebSocketImpl
 
     std::shared_ptr<spdlog::logger> sysLog;
 public:
-    WebSocketImpl(std::string_view url, ws_callback callback_)
-        : ioc(),
+    WebSocketImpl(std::string_view url, ws_callback callback_, const WSDeflate &deflate_)
+        : ioc(1),
         callback(callback_),
         secure(false),
+        deflate(deflate_),
         address(), port(),
         session_(),
         thread(),
@@ -422,7 +596,7 @@ public:
             }
 
             thread = std::thread([this] {
-                session_ = std::make_shared<session>(ioc, callback, secure);
+                session_ = std::make_shared<session>(ioc, callback, secure, deflate);
                 session_->run(address.c_str(), port.c_str());
 
                 sysLog->trace("WebSocketImpl :: started secure: {0}", secure ? "Y" : "N");
@@ -442,6 +616,24 @@ public:
         }
     }
 
+    WSQueueStats GetQueueStats()
+    {
+        if (session_)
+        {
+            return session_->get_queue_stats();
+        }
+        return WSQueueStats{ 0, 0, 0, 0 };
+    }
+
+    WSTrafficStats GetTrafficStats()
+    {
+        if (session_)
+        {
+            return session_->get_traffic_stats();
+        }
+        return WSTrafficStats{ 0, 0, 0, 0 };
+    }
+
     ~WebSocketImpl()
     {
         if (session_ && session_->is_connected())
@@ -469,7 +661,8 @@ public:
 
 WebSocket::WebSocket(ws_callback callback_)
     : impl(),
-      callback(callback_)
+      callback(callback_),
+      deflate()
 {
 }
 
@@ -484,7 +677,23 @@ void WebSocket::Connect(std::string_view url)
     {
         impl.reset(nullptr);
     }
-    impl = std::unique_ptr<WebSocketImpl>(new WebSocketImpl(url, callback));
+    impl = std::unique_ptr<WebSocketImpl>(new WebSocketImpl(url, callback, deflate));
+}
+
+void WebSocket::SetDeflate(const WSDeflate &deflate_)
+{
+    deflate = deflate_;
+
+    /// Beast throws on the values out of the zlib ranges, that would happen on the io thread
+    deflate.windowBits = std::clamp(deflate_.windowBits, 9, 15);
+    deflate.memLevel = std::clamp(deflate_.memLevel, 1, 9);
+
+    if (deflate.windowBits != deflate_.windowBits || deflate.memLevel != deflate_.memLevel)
+    {
+        auto errLog = spdlog::get("Error");
+        if (errLog) errLog->error("WebSocket :: Deflate window bits {0} and memory level {1} are out of 9...15 and 1...9, {2} and {3} are used",
+            deflate_.windowBits, deflate_.memLevel, deflate.windowBits, deflate.memLevel);
+    }
 }
 
 void WebSocket::Send(std::string_view message)
@@ -500,6 +709,24 @@ void WebSocket::Disconnect()
     impl.reset(nullptr);
 }
 
+WSQueueStats WebSocket::GetQueueStats()
+{
+    if (impl)
+    {
+        return impl->GetQueueStats();
+    }
+    return WSQueueStats{ 0, 0, 0, 0 };
+}
+
+WSTrafficStats WebSocket::GetTrafficStats()
+{
+    if (impl)
+    {
+        return impl->GetTrafficStats();
+    }
+    return WSTrafficStats{ 0, 0, 0, 0 };
+}
+
 bool WebSocket::IsConnected()
 {
     if (impl)
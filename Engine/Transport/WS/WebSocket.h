@@ -8,6 +8,8 @@
 #pragma once
 
 #include <memory>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
 #include <functional>
 
@@ -22,6 +24,30 @@ enum class WSMethod
     Error
 };
 
+struct WSQueueStats
+{
+    size_t depth; /// Messages are waiting for the writing, including the one in flight
+    size_t maxDepth; /// Since the connection
+    uint64_t bytes; /// Size of the waiting messages
+    uint64_t sent; /// Messages were written since the connection
+};
+
+struct WSTrafficStats
+{
+    uint64_t sentPayload, sentWire; /// Messages size and the bytes were written to the socket after the deflate and the TLS
+    uint64_t receivedPayload, receivedWire;
+};
+
+/// permessage-deflate (RFC 7692) settings, the compression is offered only if enabled
+struct WSDeflate
+{
+    bool enabled = false;
+    int windowBits = 15; /// 9...15, LZ77 window of the both directions
+    int memLevel = 4; /// 1...9, zlib memory per compressor
+    size_t threshold = 1024; /// Smaller messages are sent uncompressed
+    bool contextTakeover = true; /// Keep the dictionary between the messages, better ratio for the memory per connection
+};
+
 using ws_callback = std::function<void(WSMethod method, std::string_view message)>;
 
 class WebSocketImpl;
@@ -32,17 +58,25 @@ public:
     WebSocket(ws_callback callback);
     ~WebSocket();
 
+    /// Applied by the next Connect()
+    void SetDeflate(const WSDeflate &deflate);
+
     void Connect(std::string_view url);
+    /// Thread safe, the message is copied
     void Send(std::string_view message);
     void Disconnect();
 
     bool IsConnected();
 
+    WSQueueStats GetQueueStats();
+    WSTrafficStats GetTrafficStats();
+
     static constexpr bool WITH_TRACES = false;
         
 private:
     std::unique_ptr<WebSocketImpl> impl;
     ws_callback callback;
+    WSDeflate deflate;
 };
 
 }
@@ -25,6 +25,7 @@
 #include <queue>
 
 #include <Common/Base64.h>
+#include <Common/Metrics.h>
 
 #include <spdlog/spdlog.h>
 
@@ -45,6 +46,9 @@ class WSMSocketImpl
 
     std::mutex queueMutex;
     std::queue<std::string> offlineQueue;
+
+    std::shared_ptr<Common::Metrics::Counter> sentMessages, sentBytes, receivedMessages, receivedBytes, errors;
+    std::shared_ptr<Common::Metrics::Gauge> offlineDepth;
     
     std::shared_ptr<spdlog::logger> sysLog, errLog;
 
@@ -55,6 +59,12 @@ public:
         webSocket(std::bind(&WSMSocketImpl::OnWebSocket, this, std::placeholders::_1, std::placeholders::_2)),
         rtpReceiver(nullptr), rtcpReceiver(nullptr),
         queueMutex(), offlineQueue(),
+        sentMessages(Common::Metrics::Registry::Instance().GetCounter("wsm_sent_messages_total", "Media messages sent by the WebSocket media sockets")),
+        sentBytes(Common::Metrics::Registry::Instance().GetCounter("wsm_sent_bytes_total", "Bytes of the media sent by the WebSocket media sockets")),
+        receivedMessages(Common::Metrics::Registry::Instance().GetCounter("wsm_received_messages_total", "Media messages received by the WebSocket media sockets")),
+        receivedBytes(Common::Metrics::Registry::Instance().GetCounter("wsm_received_bytes_total", "Bytes of the media received by the WebSocket media sockets")),
+        errors(Common::Metrics::Registry::Instance().GetCounter("wsm_errors_total", "WebSocket errors and refused media sessions")),
+        offlineDepth(Common::Metrics::Registry::Instance().GetGauge("wsm_offline_queue_messages", "Messages waiting for the connection")),
         sysLog(spdlog::get("System")), errLog(spdlog::get("Error"))
     {
     }
@@ -126,11 +136,14 @@ public:
                 if (webSocket.IsConnected())
                 {
                     webSocket.Send(cmd);
+                    sentMessages->Add();
+                    sentBytes->Add(serializedSize);
                 }
                 else
                 {
                     std::lock_guard<std::mutex> lock(queueMutex);
                     offlineQueue.push(cmd);
+                    offlineDepth->Set(offlineQueue.size());
                 }
 
                 if (WSMSocket::WITH_TRACES)
@@ -156,11 +169,14 @@ public:
                     if (webSocket.IsConnected())
                     {
                         webSocket.Send(cmd);
+                        sentMessages->Add();
+                        sentBytes->Add(serializedSize);
                     }
                     else
                     {
                         std::lock_guard<std::mutex> lock(queueMutex);
                         offlineQueue.push(cmd);
+                        offlineDepth->Set(offlineQueue.size());
                     }
 
                     if (WSMSocket::WITH_TRACES)
@@ -211,10 +227,13 @@ private:
                             {
                                 webSocket.Send(offlineQueue.front());
                                 offlineQueue.pop();
+                                sentMessages->Add();
                             }
+                            offlineDepth->Set(0);
                         }
                         else
                         {
+                            errors->Add();
                             errLog->error("WSMSocket :: can't make the ws media session, [MEDIA FAIL]");
                         }
                     }
@@ -226,6 +245,9 @@ private:
 
                         auto data = Common::fromBase64(cmd.data);
 
+                        receivedMessages->Add();
+                        receivedBytes->Add(data.size());
+
                         switch (cmd.media_type)
                         {
                             case Proto::MEDIA::MediaType::RTP:
@@ -271,6 +293,7 @@ private:
                 sysLog->info("WSMSocket :: WebSocket closed (message: \"{0}\")", message);
             break;
             case Transport::WSMethod::Error:
+                errors->Add();
                 errLog->error("WSMSocket :: WebSocket error (message: \"{0}\")", message);
             break;
         }
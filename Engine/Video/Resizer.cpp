@@ -8,6 +8,8 @@
 #include <Video/Resizer.h>
 #include <Transport/RTP/RTPPacket.h>
 
+#include <Common/Trace.h>
+
 #include <memory>
 
 namespace Video
@@ -83,6 +85,8 @@ void Resizer::Send(const Transport::IPacket &packet_, const Transport::Address *
 		return;
 	}
 
+	Common::Trace::Span span(Common::Trace::Stage::Resize, Common::Trace::Kind::Video, packet.rtpHeader.ssrc, packet.rtpHeader.ts);
+
 	const uint8_t* data = packet.payload;
 	const IppiSize srcSz = { rv.width, rv.height };
 
@@ -108,6 +112,9 @@ void Resizer::Send(const Transport::IPacket &packet_, const Transport::Address *
 	Transport::RTPPacket rtp = packet;
 	rtp.payload = scaleBuffer.get();
 	rtp.payloadSize = width * height * 4;
+
+	span.End();
+
 	receiver->Send(rtp);
 }
 
@@ -14,6 +14,8 @@
 #include <thread>
 
 #include <Common/Common.h>
+#include <Common/TimeMeter.h>
+#include <Common/Trace.h>
 
 #include <new>
 #include <ippcc.h>
@@ -34,7 +36,10 @@ VP8DecoderImpl::VP8DecoderImpl()
 	outputType(Video::ColorSpace::RGB24),
 	produceBuffer(),
 	codec(),
-	cfg()
+	cfg(),
+	decodeTime(Common::Metrics::Registry::Instance().GetHistogram("codec_decode_time_us", "Time of the decoding of the frame", { { "codec", "vp8" } })),
+	decodeErrors(Common::Metrics::Registry::Instance().GetCounter("codec_decode_errors_total", "Frames failed to decode", { { "codec", "vp8" } })),
+	keyFrameRequests(Common::Metrics::Registry::Instance().GetCounter("codec_key_frame_requests_total", "Key frames requested by the decoder", { { "codec", "vp8" } }))
 {
 }
 
@@ -154,9 +159,25 @@ bool VP8DecoderImpl::IsStarted()
 	return runned;
 }
 
+bool VP8DecoderImpl::Decode(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader& header)
+{
+	Common::Trace::Span span(Common::Trace::Stage::Decode, Common::Trace::Kind::Video, header.ssrc, header.ts);
+	Common::TimeMeter timeMeter;
+	const auto res = vpx_codec_decode(&codec, data, length, NULL, 0);
+	decodeTime->Record(timeMeter.Measure());
+	span.End();
+
+	if (res != VPX_CODEC_OK)
+	{
+		decodeErrors->Add();
+		return false;
+	}
+	return true;
+}
+
 void VP8DecoderImpl::DecodeRGB32(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader& header)
 {
-	if (!runned || vpx_codec_decode(&codec, data, length, NULL, 0) != VPX_CODEC_OK)
+	if (!runned || !Decode(data, length, header))
 	{
 		DieCodec(&codec, "vp8 decoder failed to decode frame");
 		return;
@@ -187,7 +208,7 @@ void VP8DecoderImpl::DecodeRGB32(const uint8_t *data, uint32_t length, const Tra
 
 void VP8DecoderImpl::DecodeRGB24(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader& header)
 {
-	if (!runned || vpx_codec_decode(&codec, data, length, NULL, 0) != VPX_CODEC_OK)
+	if (!runned || !Decode(data, length, header))
 	{
 		DieCodec(&codec, "vp8 decoder failed to decode frame");
 		return;
@@ -219,7 +240,7 @@ void VP8DecoderImpl::DecodeRGB24(const uint8_t *data, uint32_t length, const Tra
 
 void VP8DecoderImpl::DecodeI420(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader& header)
 {
-	if (!runned || vpx_codec_decode(&codec, data, length, NULL, 0) != VPX_CODEC_OK)
+	if (!runned || !Decode(data, length, header))
 	{
 		DieCodec(&codec, "vp8 decoder failed to decode frame");
 		return;
@@ -271,6 +292,7 @@ void VP8DecoderImpl::ForceKeyFrame(uint32_t seq, uint32_t ts)
 	{
 		callback->ForceKeyFrame(seq);
 		keyFrameForceTime = ts;
+		keyFrameRequests->Add();
 	}
 }
 
@@ -16,6 +16,8 @@
 #include <vpx/vpx_decoder.h>
 #include <vpx/vp8dx.h>
 
+#include <Common/Metrics.h>
+
 namespace Video
 {
 	class VP8DecoderImpl : public IDecoder, public Transport::ISocket
@@ -57,6 +59,11 @@ namespace Video
 		vpx_codec_ctx_t      codec;
 		vpx_codec_dec_cfg_t  cfg;
 
+		std::shared_ptr<Common::Metrics::Histogram> decodeTime;
+		std::shared_ptr<Common::Metrics::Counter> decodeErrors, keyFrameRequests;
+
+		bool Decode(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader& header);
+
 		void DecodeRGB32(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader&);
 		void DecodeRGB24(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader&);
 		void DecodeI420(const uint8_t *data, uint32_t length, const Transport::RTPPacket::RTPHeader&);
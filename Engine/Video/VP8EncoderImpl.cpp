@@ -14,6 +14,8 @@
 #include <string.h>
 
 #include <Common/Common.h>
+#include <Common/TimeMeter.h>
+#include <Common/Trace.h>
 
 namespace Video
 {
@@ -44,7 +46,11 @@ VP8EncoderImpl::VP8EncoderImpl()
 	screenContent(false),
 	codec(),
 	cfg(),
-	raw()
+	raw(),
+	encodeTime(Common::Metrics::Registry::Instance().GetHistogram("codec_encode_time_us", "Time of the encoding of the frame", { { "codec", "vp8" } })),
+	encodeErrors(Common::Metrics::Registry::Instance().GetCounter("codec_encode_errors_total", "Frames failed to encode", { { "codec", "vp8" } })),
+	encodedBytes(Common::Metrics::Registry::Instance().GetCounter("codec_encoded_bytes_total", "Bytes produced by the encoder", { { "codec", "vp8" } })),
+	keyFrames(Common::Metrics::Registry::Instance().GetCounter("codec_key_frames_total", "Key frames produced by the encoder", { { "codec", "vp8" } }))
 {
 }
 
@@ -225,10 +231,15 @@ void VP8EncoderImpl::EncodeFrame(vpx_image_t *img, const Transport::RTPPacket::R
 	}
 
 	const vpx_codec_cx_pkt_t *pkt = NULL;
+	Common::Trace::Span span(Common::Trace::Stage::Encode, Common::Trace::Kind::Video, header.ssrc, header.ts);
+	Common::TimeMeter timeMeter;
 	const vpx_codec_err_t res = vpx_codec_encode(&codec, img, header.seq, 1, flags, VPX_DL_REALTIME);
+	encodeTime->Record(timeMeter.Measure());
+	span.End();
 
 	if (res != VPX_CODEC_OK)
 	{
+		encodeErrors->Add();
 		DieCodec(&codec, "Failed to encode frame");
 	}
 
@@ -237,7 +248,11 @@ void VP8EncoderImpl::EncodeFrame(vpx_image_t *img, const Transport::RTPPacket::R
 	{
 		if (pkt->kind == VPX_CODEC_CX_FRAME_PKT)
 		{
-			//const int keyframe = (pkt->data.frame.flags & VPX_FRAME_IS_KEY) != 0;
+			if ((pkt->data.frame.flags & VPX_FRAME_IS_KEY) != 0)
+			{
+				keyFrames->Add();
+			}
+			encodedBytes->Add(pkt->data.frame.sz);
 
 			Transport::RTPPacket packet;
 			packet.rtpHeader = header;
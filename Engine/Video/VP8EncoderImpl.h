@@ -11,6 +11,8 @@
 #include <Transport/ISocket.h>
 #include <Transport/RTP/RTPPacket.h>
 
+#include <Common/Metrics.h>
+
 #include <vpx/vpx_encoder.h>
 #include <vpx/vp8cx.h>
 
@@ -56,6 +58,9 @@ private:
 	vpx_codec_ctx_t codec;
 	vpx_codec_enc_cfg_t cfg;
 	vpx_image_t raw;
+
+	std::shared_ptr<Common::Metrics::Histogram> encodeTime;
+	std::shared_ptr<Common::Metrics::Counter> encodeErrors, encodedBytes, keyFrames;
 	
 	void EncodeFrame(vpx_image_t *img, const Transport::RTPPacket::RTPHeader&);
 	void DieCodec(vpx_codec_ctx_t *ctx, const char *s);
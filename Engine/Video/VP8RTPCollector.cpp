@@ -15,6 +15,7 @@
 
 #include <Common/BitHelpers.h>
 #include <Common/CRC32.h>
+#include <Common/Trace.h>
 
 #include <Common/Common.h>
 
@@ -29,7 +30,12 @@ VP8RTPCollector::VP8RTPCollector()
 	size(0),
 	header(),
 	lastPacketSeq(0), firstFramePacketSeq(0), currentFrameSeq(0),
-	lastCRC32(0)
+	lastCRC32(0),
+	frameBegin(0),
+	metricsSSRC(0),
+	completedFrames(),
+	droppedFrames(),
+	overflows()
 {
 }
 
@@ -41,6 +47,7 @@ void VP8RTPCollector::Reset()
 	firstFramePacketSeq = 0;
 	currentFrameSeq = 0;
 	lastCRC32 = 0;
+	frameBegin = 0;
 }
 
 void VP8RTPCollector::SetReceiver(Transport::ISocket *receiver_)
@@ -103,6 +110,11 @@ void VP8RTPCollector::Process(const Transport::IPacket &packet_)
 	}
 	lastPacketSeq = packet.rtpHeader.seq;
 
+	if (packet.rtpHeader.ssrc != metricsSSRC || !completedFrames)
+	{
+		UpdateMetrics(packet.rtpHeader.ssrc);
+	}
+
 	uint16_t firstTwoOctets = *reinterpret_cast<const uint16_t*>(packet.payload);
 	uint8_t payloadDescriptorSize = GetPayloadDescriptorSize(firstTwoOctets);
 		
@@ -114,11 +126,17 @@ void VP8RTPCollector::Process(const Transport::IPacket &packet_)
 		if (size != 0 && lastCRC32 == Common::crc32(0, buffer.get(), size)) // The next frame is coming, check the buffer
 		{
 			SendBuffer();
+			completedFrames->Add();
+		}
+		else if (size != 0)
+		{
+			droppedFrames->Add(); /// Some packets of the frame were lost
 		}
 
 		lastCRC32 = packet.rtpHeader.eX[0]; // Set the last crc for next first packet
 		header = packet.rtpHeader;
 		size = 0;
+		frameBegin = Common::Trace::Enabled() ? Common::Trace::Now() : 0;
 	}
 
 	if (packet.rtpHeader.eX[1] == currentFrameSeq && packet.payloadSize > payloadDescriptorSize)
@@ -133,6 +151,7 @@ void VP8RTPCollector::Process(const Transport::IPacket &packet_)
 		}
 		else
 		{
+			overflows->Add();
 			DBGTRACE("VP8RTPCollector the output buffer is overflow\n");
 		}
 	}
@@ -148,7 +167,24 @@ void VP8RTPCollector::SendBuffer()
 	packet.payload = buffer.get();
 	packet.payloadSize = size;
 
+	/// The frame is completed by the first packet of the next one, so the span includes the waiting for it
+	if (frameBegin != 0)
+	{
+		Common::Trace::Record(Common::Trace::Stage::Collect, Common::Trace::Kind::Video, header.ssrc, header.ts, frameBegin, Common::Trace::Now());
+	}
+
 	receiver->Send(packet);
 }
 
+void VP8RTPCollector::UpdateMetrics(uint32_t ssrc)
+{
+	auto labels = Common::Metrics::StreamLabels("video", ssrc);
+	auto &registry = Common::Metrics::Registry::Instance();
+
+	completedFrames = registry.GetCounter("vp8_collector_frames_total", "Frames assembled from the RTP packets", labels);
+	droppedFrames = registry.GetCounter("vp8_collector_dropped_frames_total", "Frames dropped as incomplete", labels);
+	overflows = registry.GetCounter("vp8_collector_overflows_total", "Packets not fitted to the frame buffer", labels);
+	metricsSSRC = ssrc;
+}
+
 }
@@ -13,6 +13,8 @@
 #include <Transport/ISocket.h>
 #include <Transport/RTP/RTPPacket.h>
 
+#include <Common/Metrics.h>
+
 namespace Video
 {
 
@@ -40,9 +42,16 @@ private:
 
 	uint32_t lastCRC32;
 
+	uint64_t frameBegin; /// Trace time of the first packet of the frame
+
+	uint32_t metricsSSRC;
+	std::shared_ptr<Common::Metrics::Counter> completedFrames, droppedFrames, overflows;
+
 	void Process(const Transport::IPacket &packet);
 
 	void SendBuffer();
+
+	void UpdateMetrics(uint32_t ssrc);
 };
 
 }
@@ -11,6 +11,7 @@
 #include <Common/BitHelpers.h>
 #include <Common/CRC32.h>
 #include <Common/ShortSleep.h>
+#include <Common/Trace.h>
 
 #include <memory.h>
 
@@ -61,6 +62,9 @@ void VP8RTPSplitter::Send(const Transport::IPacket &packet_, const Transport::Ad
 
 	const Transport::RTPPacket &inputPacket = *static_cast<const Transport::RTPPacket*>(&packet_);
 
+	/// Includes the pacing of the packets and the next stages of the each packet
+	Common::Trace::Span span(Common::Trace::Stage::Split, Common::Trace::Kind::Video, inputPacket.rtpHeader.ssrc, inputPacket.rtpHeader.ts);
+
 	SetBit(buffer[0], 3); /// Set the S flag
 
 	uint32_t crc32data = Common::crc32(0, inputPacket.payload, inputPacket.payloadSize);
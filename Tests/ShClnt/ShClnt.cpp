@@ -13,6 +13,7 @@
 #include <Storage/Storage.h>
 
 #include <Common/Logger.h>
+#include <Common/MetricsServer.h>
 
 #include <wui/config/config.hpp>
 
@@ -27,7 +28,7 @@ int main(int argc, char* argv[])
 {
 	if (argc < 5)
 	{
-		std::cout << "Usage: ShClnt server address login password conference file name" << std::endl;
+		std::cout << "Usage: ShClnt server address login password conference file name [metrics port or unix socket path]" << std::endl;
 		return 0;
 	}
 
@@ -37,7 +38,16 @@ int main(int argc, char* argv[])
 	std::string conference = argv[4];
 	std::string fileName = argv[5];
 
-	Common::CreateLogger(Common::GetLogFileName("ShClnt-" + login));
+	auto logFileName = Common::GetLogFileName("ShClnt-" + login);
+	Common::CreateLogger(logFileName);
+
+	/// Each bot dumps its metrics next to its log, so the fleet is watched without the endpoints
+	Common::MetricsServer metricsServer;
+	if (argc > 6)
+	{
+		metricsServer.Start(argv[6]);
+	}
+	metricsServer.StartDump(logFileName.substr(0, logFileName.rfind('.')) + ".metrics.json", std::chrono::seconds(10));
 
     Storage::Storage storage;
     Processor::MemberList memberList;
@@ -73,6 +83,7 @@ int main(int argc, char* argv[])
 	}
 
 	processor.Stop();
+	metricsServer.Stop();
 
 	io.stop();
 	t.join();